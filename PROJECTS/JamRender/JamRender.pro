@@ -0,0 +1,87 @@
+QT += core concurrent
+QT -= gui
+
+TARGET = jamtaba-render
+CONFIG -= app_bundle #in MAC create just a binary, not a complete bundle
+CONFIG += c++11
+CONFIG += console
+
+# the jamtaba-render executable is generated in the Standalone folder
+macx:DESTDIR = $$OUT_PWD/../Standalone/Jamtaba2.app/Contents/MacOS
+linux:DESTDIR = $$OUT_PWD/../Standalone
+win32{
+    CONFIG(debug, debug|release) {
+        DESTDIR = $$OUT_PWD/../Standalone/debug
+    } else {
+        DESTDIR = $$OUT_PWD/../Standalone/release
+    }
+}
+
+TEMPLATE = app
+
+ROOT_PATH = "../.."
+SOURCE_PATH = $$ROOT_PATH/src
+
+INCLUDEPATH += $$SOURCE_PATH/Common
+INCLUDEPATH += $$SOURCE_PATH/JamRender
+INCLUDEPATH += $$ROOT_PATH/libs/includes/ogg
+INCLUDEPATH += $$ROOT_PATH/libs/includes/vorbis
+
+VPATH       += $$SOURCE_PATH/Common
+VPATH       += $$SOURCE_PATH
+
+DEFINES += OV_EXCLUDE_STATIC_CALLBACKS  #avoid ogg static callback warnings
+
+HEADERS += JamRender/JamRenderer.h
+HEADERS += recorder/JamRecorder.h
+HEADERS += recorder/RecordingWriter.h
+HEADERS += audio/vorbis/VorbisDecoder.h
+HEADERS += audio/SamplesBufferResampler.h
+HEADERS += file/WaveFileWriter.h
+HEADERS += log/Logging.h
+
+SOURCES += JamRender/main.cpp
+SOURCES += JamRender/JamRenderer.cpp
+SOURCES += recorder/JamRecorder.cpp
+SOURCES += recorder/RecordingWriter.cpp
+SOURCES += audio/vorbis/VorbisDecoder.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/SamplesBufferResampler.cpp
+SOURCES += audio/Resampler.cpp
+SOURCES += file/WaveFileWriter.cpp
+SOURCES += log/logging.cpp
+
+win32{
+    !contains(QMAKE_TARGET.arch, x86_64) {
+        LIBS_PATH = "static/win32-msvc"
+    } else {
+        LIBS_PATH = "static/win64-msvc"
+    }
+
+    win32-msvc*{#all msvc compilers
+        #windows XP support
+        QMAKE_LFLAGS_WINDOWS = /SUBSYSTEM:CONSOLE,5.01
+
+        #supressing warning about missing .pdb files
+        QMAKE_LFLAGS += /ignore:4099
+    }
+
+    LIBS += -L$$PWD/../../libs/$$LIBS_PATH -lvorbisfile -lvorbis -logg
+}
+
+macx{
+    LIBS_PATH = "static/mac64"
+    LIBS += -L$$PWD/../../libs/$$LIBS_PATH -lvorbisfile -lvorbis -logg
+    LIBS += -dead_strip
+}
+
+linux{
+    contains(QMAKE_HOST.arch, x86_64) {
+        LIBS_PATH = "static/linux64"
+    } else {
+        LIBS_PATH = "static/linux32"
+    }
+
+    LIBS += -L$$PWD/../../libs/$$LIBS_PATH -lvorbisfile -lvorbis -logg
+}
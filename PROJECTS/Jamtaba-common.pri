@@ -49,8 +49,10 @@ HEADERS += midi/MidiDriver.h
 HEADERS += midi/MidiMessage.h
 HEADERS += looper/Looper.h
 HEADERS += looper/LooperLayer.h
+HEADERS += looper/LooperPagePool.h
 HEADERS += looper/LooperStates.h
 HEADERS += looper/LooperPersistence.h
+HEADERS += looper/LoopLibrary.h
 HEADERS += audio/core/AudioDriver.h
 HEADERS += audio/core/AudioNode.h
 HEADERS += audio/core/LocalInputNode.h
@@ -59,6 +61,7 @@ HEADERS += audio/core/AudioNodeProcessor.h
 HEADERS += audio/core/AudioMixer.h
 HEADERS += audio/core/SamplesBuffer.h
 HEADERS += audio/core/AudioPeak.h
+HEADERS += audio/core/PeaksPyramid.h
 HEADERS += audio/core/Plugins.h
 HEADERS += audio/core/Filters.h
 HEADERS += audio/core/PluginDescriptor.h
@@ -68,6 +71,7 @@ HEADERS += audio/vorbis/VorbisEncoder.h
 HEADERS += audio/RoomStreamerNode.h
 HEADERS += audio/NinjamTrackNode.h
 HEADERS += audio/MetronomeTrackNode.h
+HEADERS += audio/TransportClock.h
 HEADERS += audio/SamplesBufferResampler.h
 HEADERS += audio/SamplesBufferRecorder.h
 HEADERS += audio/Mp3Decoder.h
@@ -76,6 +80,7 @@ HEADERS += video/FFMpegMuxer.h
 HEADERS += video/FFMpegDemuxer.h
 HEADERS += video/VideoFrameGrabber.h
 HEADERS += video/VideoWidget.h
+HEADERS += video/VideoScaler.h
 HEADERS += file/FileReader.h
 HEADERS += file/FileReaderFactory.h
 HEADERS += file/WaveFileReader.h
@@ -86,6 +91,7 @@ HEADERS += file/FileUtils.h
 HEADERS += recorder/JamRecorder.h
 HEADERS += recorder/ReaperProjectGenerator.h
 HEADERS += recorder/ClipSortLogGenerator.h
+HEADERS += recorder/RecordingWriter.h
 HEADERS += loginserver/LoginService.h
 HEADERS += loginserver/Version.h
 HEADERS += loginserver/MainChat.h
@@ -115,13 +121,17 @@ HEADERS += gui/MetronomePanel.h
 HEADERS += gui/BusyDialog.h
 HEADERS += gui/chat/ChatPanel.h
 HEADERS += gui/chat/ChatMessagePanel.h
+HEADERS += gui/chat/ChatMessagesModel.h
+HEADERS += gui/chat/ChatMessagesView.h
 HEADERS += gui/chat/NinjamChatMessageParser.h
 HEADERS += gui/chat/ChatTextEditor.h
 HEADERS += gui/chat/EmojiWidget.h
 HEADERS += gui/chat/EmojiManager.h
+HEADERS += gui/chat/EmojiMatcher.h
 HEADERS += gui/screensaver/ScreensaverBlocker.h
 HEADERS += gui/Highligther.h
 HEADERS += gui/InactivityDetector.h
+HEADERS += gui/RepaintScheduler.h
 HEADERS += gui/TrackGroupView.h
 HEADERS += gui/LocalTrackGroupView.h
 HEADERS += gui/intervalProgress/IntervalProgressDisplay.h
@@ -137,6 +147,7 @@ HEADERS += gui/widgets/PeakMeter.h
 HEADERS += gui/widgets/WavePeakPanel.h
 HEADERS += gui/widgets/UserNameLineEdit.h
 HEADERS += gui/widgets/MapWidget.h
+HEADERS += gui/widgets/MapTileCache.h
 HEADERS += gui/widgets/MapMarker.h
 HEADERS += gui/widgets/MultiStateButton.h
 HEADERS += gui/widgets/BlinkableButton.h
@@ -161,10 +172,13 @@ HEADERS += gui/ThemeLoader.h
 HEADERS += Utils.h
 HEADERS += Configurator.h
 HEADERS += persistence/Settings.h
+HEADERS += persistence/SettingsWriter.h
 HEADERS += persistence/UsersDataCache.h
 HEADERS += persistence/CacheHeader.h
 HEADERS += log/Logging.h
+HEADERS += log/StartupProfiler.h
 HEADERS += UploadIntervalData.h
+HEADERS += UploadBitrateController.h
 HEADERS += performance/PerformanceMonitor.h
 HEADERS += upnp/UPnPManager.h
 
@@ -175,9 +189,11 @@ SOURCES += midi/MidiDriver.cpp
 SOURCES += midi/MidiMessage.cpp
 SOURCES += looper/Looper.cpp
 SOURCES += looper/LooperLayer.cpp
+SOURCES += looper/LooperPagePool.cpp
 SOURCES += looper/LooperStates.cpp
 SOURCES += file/WaveFileWriter.cpp
 SOURCES += looper/LooperPersistence.cpp
+SOURCES += looper/LoopLibrary.cpp
 SOURCES += audio/core/AudioDriver.cpp
 SOURCES += audio/core/AudioNode.cpp
 SOURCES += audio/core/LocalInputNode.cpp
@@ -190,17 +206,20 @@ SOURCES += audio/core/Plugins.cpp
 SOURCES += audio/Mp3Decoder.cpp
 SOURCES += audio/NinjamTrackNode.cpp
 SOURCES += audio/MetronomeTrackNode.cpp
+SOURCES += audio/TransportClock.cpp
 SOURCES += audio/core/SamplesBuffer.cpp
 SOURCES += audio/core/PluginDescriptor.cpp
 SOURCES += audio/SamplesBufferResampler.cpp
 SOURCES += audio/vorbis/VorbisDecoder.cpp
 SOURCES += audio/vorbis/VorbisEncoder.cpp
 SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/PeaksPyramid.cpp
 SOURCES += audio/Resampler.cpp
 SOURCES += video/FFMpegMuxer.cpp
 SOURCES += video/FFMpegDemuxer.cpp
 SOURCES += video/VideoFrameGrabber.cpp
 SOURCES += video/VideoWidget.cpp
+SOURCES += video/VideoScaler.cpp
 SOURCES += file/FileReaderFactory.cpp
 SOURCES += file/WaveFileReader.cpp
 SOURCES += file/OggFileReader.cpp
@@ -209,6 +228,7 @@ SOURCES += file/FileUtils.cpp
 SOURCES += recorder/JamRecorder.cpp
 SOURCES += recorder/ReaperProjectGenerator.cpp
 SOURCES += recorder/ClipSortLogGenerator.cpp
+SOURCES += recorder/RecordingWriter.cpp
 SOURCES += ninjam/Ninjam.cpp
 SOURCES += ninjam/client/ServerInfo.cpp
 SOURCES += ninjam/client/Service.cpp
@@ -235,13 +255,17 @@ SOURCES += gui/MetronomePanel.cpp
 SOURCES += gui/BusyDialog.cpp
 SOURCES += gui/IconFactory.cpp
 SOURCES += gui/InactivityDetector.cpp
+SOURCES += gui/RepaintScheduler.cpp
 SOURCES += gui/LooperWindow.cpp
 SOURCES += gui/widgets/LooperWavePanel.cpp
 SOURCES += gui/chat/ChatPanel.cpp
 SOURCES += gui/chat/ChatMessagePanel.cpp
+SOURCES += gui/chat/ChatMessagesModel.cpp
+SOURCES += gui/chat/ChatMessagesView.cpp
 SOURCES += gui/chat/ChatTextEditor.cpp
 SOURCES += gui/chat/EmojiWidget.cpp
 SOURCES += gui/chat/EmojiManager.cpp
+SOURCES += gui/chat/EmojiMatcher.cpp
 SOURCES += gui/chat/NinjamChatMessageParser.cpp
 win32:SOURCES += gui/screensaver/WindowsScreensaverBlocker.cpp
 linux:SOURCES += gui/screensaver/LinuxScreensaverBlocker.cpp
@@ -266,6 +290,7 @@ SOURCES += gui/widgets/IntervalChunksDisplay.cpp
 SOURCES += gui/widgets/MarqueeLabel.cpp
 SOURCES += gui/widgets/MapMarker.cpp
 SOURCES += gui/widgets/MapWidget.cpp
+SOURCES += gui/widgets/MapTileCache.cpp
 SOURCES += gui/widgets/MultiStateButton.cpp
 SOURCES += gui/widgets/BlinkableButton.cpp
 SOURCES += gui/widgets/BoostSpinBox.cpp
@@ -283,14 +308,17 @@ SOURCES += gui/UsersColorsPool.cpp
 SOURCES += gui/GuiUtils.cpp
 SOURCES += gui/ThemeLoader.cpp
 SOURCES += log/logging.cpp
+SOURCES += log/StartupProfiler.cpp
 SOURCES += loginserver/LoginService.cpp
 SOURCES += loginserver/Version.cpp
 SOURCES += loginserver/MainChat.cpp
 SOURCES += Configurator.cpp
 SOURCES += persistence/UsersDataCache.cpp
 SOURCES += persistence/Settings.cpp
+SOURCES += persistence/SettingsWriter.cpp
 SOURCES += persistence/CacheHeader.cpp
 SOURCES += UploadIntervalData.cpp
+SOURCES += UploadBitrateController.cpp
 SOURCES += upnp/UPnPManager.cpp
 
 #multiplatform implementations
@@ -8,6 +8,8 @@ mac {
 
 SUBDIRS += Standalone
 
+SUBDIRS += JamRender # offline jam renderer (jamtaba-render)
+
 include(../translations/translations.pri)
 
 win32 {
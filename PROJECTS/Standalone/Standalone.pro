@@ -36,6 +36,7 @@ HEADERS += vst/VstPlugin.h
 HEADERS += vst/VstHost.h
 HEADERS += vst/VstLoader.h
 HEADERS += PluginFinder.h
+HEADERS += PluginScanCache.h
 HEADERS += vst/VstPluginFinder.h
 HEADERS += vst/Utils.h
 HEADERS += Libs/SingleApplication/singleapplication.h
@@ -59,6 +60,7 @@ SOURCES += midi/RtMidiDriver.cpp
 SOURCES += vst/VstPlugin.cpp
 SOURCES += vst/VstHost.cpp
 SOURCES += PluginFinder.cpp
+SOURCES += PluginScanCache.cpp
 SOURCES += vst/VstPluginFinder.cpp
 SOURCES += vst/Utils.cpp
 SOURCES += vst/VstLoader.cpp
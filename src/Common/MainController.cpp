@@ -12,8 +12,11 @@
 #include "audio/core/LocalInputNode.h"
 #include "audio/core/LocalInputGroup.h"
 #include "audio/RoomStreamerNode.h"
+#include "audio/TransportClock.h"
+#include "looper/LooperPagePool.h"
 #include "ninjam/client/Service.h"
 #include "recorder/JamRecorder.h"
+#include "recorder/RecordingWriter.h"
 #include "recorder/ReaperProjectGenerator.h"
 #include "recorder/ClipSortLogGenerator.h"
 #include "gui/MainWindow.h"
@@ -25,6 +28,7 @@
 #include <QByteArray>
 #include <QDateTime>
 #include <QSize>
+#include <QApplication>
 
 using ninjam::client::Service;
 using ninjam::client::ServerInfo;
@@ -33,6 +37,7 @@ using persistence::LocalInputTrackSettings;
 using controller::MainController;
 
 const quint8 MainController::CAMERA_FPS = 10;
+const int MainController::SETTINGS_SAVE_DELAY = 3000;
 const QSize MainController::MAX_VIDEO_SIZE(320, 240); // max video resolution in pixels
 
 const QString MainController::CRASH_FLAG_STRING = "JamTaba closed without crash :)";
@@ -51,21 +56,43 @@ MainController::MainController(const Settings &settings) :
     started(false),
     masterGain(1),
     usersDataCache(Configurator::getInstance()->getCacheDir()),
+    loopLibrary(Configurator::getInstance()->getCacheDir()),
     lastInputTrackID(0),
     lastFrameTimeStamp(0),
+    recordingDroppedBytes(0),
     emojiManager(":/emoji/emoji.json", ":/emoji/icons")
 {
     QDir cacheDir = Configurator::getInstance()->getCacheDir();
 
+    this->settings.setWriter(&settingsWriter);
+
+    settingsSaveTimer.setSingleShot(true);
+    settingsSaveTimer.setInterval(SETTINGS_SAVE_DELAY);
+    connect(&settingsSaveTimer, &QTimer::timeout, [=]() {
+        if (mainWindow)
+            saveLastUserSettings(mainWindow->getInputsSettings());
+    });
+
     // Register known JamRecorders here:
     jamRecorders.append(new recorder::JamRecorder(new recorder::ReaperProjectGenerator()));
     jamRecorders.append(new recorder::JamRecorder(new recorder::ClipSortLogGenerator()));
 
+    for (auto jamRecorder : jamRecorders)
+        jamRecorder->setContinuousTrackFiles(settings.isRecordingContinuousTrackFiles());
+
     connect(&videoEncoder, &FFMpegMuxer::dataEncoded, this, &MainController::enqueueVideoDataToUpload);
 
+    cameraTimer.setInterval(1000 / (CAMERA_FPS * 2)); // polling faster than the camera frame rate
+    connect(&cameraTimer, &QTimer::timeout, this, &MainController::requestCameraFrame);
+
     for (auto emojiCode: settings.getRecentEmojis())
         emojiManager.addRecent(emojiCode);
 
+    quint64 looperMemoryBudget = static_cast<quint64>(settings.getLooperMemoryBudget()) * 1024 * 1024; // MB to bytes
+    audio::LooperPagePool::getInstance()->setMemoryBudget(looperMemoryBudget);
+
+    loopLibrary.setLoopsDir(settings.getLooperSavePath());
+
     connect(&loginService, &login::LoginService::roomsListAvailable, [=](const QList<login::RoomInfo> &publicRooms){
         for (const auto & room : publicRooms) {
             for (const auto & user : room.getUsers()) {
@@ -116,7 +143,60 @@ void MainController::setVideoProperties(const QSize &resolution)
          bestResolution = MainController::MAX_VIDEO_SIZE;
 
     videoEncoder.setVideoResolution(bestResolution);
-    videoEncoder.setVideoFrameRate(CAMERA_FPS);
+    videoEncoder.setVideoFrameRate(getUploadQuality().cameraFps);
+}
+
+UploadQuality MainController::getUserUploadQuality() const
+{
+    return UploadQuality{settings.getEncodingQuality(), static_cast<uint>(FFMpegMuxer::VideoQualityLow), CAMERA_FPS};
+}
+
+UploadQuality MainController::getUploadQuality() const
+{
+    return uploadBitrateController.getQuality(getUserUploadQuality());
+}
+
+float MainController::getUploadEncodingQuality() const
+{
+    return getUploadQuality().vorbisQuality;
+}
+
+void MainController::adaptUploadQuality()
+{
+    if (!ninjamService || !ninjamController || !ninjamController->isPreparedForTransmit())
+        return;
+
+    const UploadQuality oldQuality = getUploadQuality();
+
+    auto decision = uploadBitrateController.update(ninjamService->getUploadQueuedBytes(), ninjamService->getTotalUploadTransferRate());
+    if (decision == UploadBitrateController::KeepQuality)
+        return;
+
+    const UploadQuality newQuality = getUploadQuality();
+
+    qCDebug(jtCore) << "Upload queue delay" << uploadBitrateController.getQueueDelay() << "ms, upload quality level" << uploadBitrateController.getLevel()
+                    << "vorbis:" << newQuality.vorbisQuality << "video:" << newQuality.videoBitRate << "fps:" << newQuality.cameraFps;
+
+    if (newQuality.vorbisQuality != oldQuality.vorbisQuality)
+        ninjamController->scheduleEncodersRecreation(); // the new audio quality is used in the next interval
+
+    // the video encoder is reopened with the new settings in the next interval
+    videoEncoder.setVideoBitRate(newQuality.videoBitRate);
+    videoEncoder.setVideoFrameRate(newQuality.cameraFps);
+
+    emit uploadQualityChanged(uploadBitrateController.getLevel(), decision == UploadBitrateController::DecreaseQuality);
+}
+
+void MainController::checkRecordingWriter()
+{
+    const recorder::RecordingWriter::Metrics metrics = recorder::RecordingWriter::getInstance()->getMetrics();
+    if (metrics.queueDepth > 0)
+        qCDebug(jtCore) << "Recording queue:" << metrics.queueDepth << "writes," << metrics.queuedBytes << "bytes, last write latency:" << metrics.lastWriteLatency << "ms";
+
+    if (metrics.droppedBytes > recordingDroppedBytes)
+        emit recordingDataDropped(metrics.droppedBytes - recordingDroppedBytes);
+
+    recordingDroppedBytes = metrics.droppedBytes;
 }
 
 QSize MainController::getVideoResolution() const
@@ -221,7 +301,6 @@ void MainController::setupNinjamControllerSignals()
     connect(controller, &NinjamController::startingNewInterval, this, &MainController::handleNewNinjamInterval);
     connect(controller, &NinjamController::currentBpiChanged, this, &MainController::updateBpi);
     connect(controller, &NinjamController::currentBpmChanged, this, &MainController::updateBpm);
-    connect(controller, &NinjamController::startProcessing, this, &MainController::requestCameraFrame);
 }
 
 void MainController::connectInNinjamServer(const ServerInfo &server)
@@ -230,6 +309,11 @@ void MainController::connectInNinjamServer(const ServerInfo &server)
 
     stopNinjamController();
 
+    // every jam starts with the quality choosed by the user
+    uploadBitrateController.reset();
+    videoEncoder.setVideoBitRate(getUserUploadQuality().videoBitRate);
+    videoEncoder.setVideoFrameRate(CAMERA_FPS);
+
     auto newNinjamController = createNinjamController();
     ninjamController.reset(newNinjamController);
 
@@ -245,6 +329,8 @@ void MainController::connectInNinjamServer(const ServerInfo &server)
 
     newNinjamController->start(server);
 
+    cameraTimer.start();
+
     if (settings.isSaveMultiTrackActivated()) {
         QString userName = getUserName();
         QDir recordBasePath = QDir(settings.getRecordingPath());
@@ -269,33 +355,46 @@ QMap<int, bool> MainController::getXmitChannelsFlags() const
 
 void MainController::handleNewNinjamInterval()
 {
+    adaptUploadQuality(); // the video settings are applied in the interval starting now
+
     // TODO move the jamRecorder to NinjamController?
     if (settings.isSaveMultiTrackActivated()) {
         for (auto jamRecorder : jamRecorders)
             jamRecorder->newInterval();
+
+        checkRecordingWriter();
     }
 
-    if (mainWindow->cameraIsActivated())
+    if (mainWindow->cameraIsActivated()) {
         videoEncoder.startNewInterval();
+        grabCameraFrame(); // the first frame in the interval
+    }
 }
 
-void MainController::processCapturedFrame(int frameID, const QImage &frame)
+void MainController::processCapturedFrame(int frameID, const QVideoFrame &frame, bool flipVertically)
 {
     Q_UNUSED(frameID);
 
     if (ninjamController && ninjamController->isPreparedForTransmit())
-        videoEncoder.encodeImage(frame); // video encoder will emit a signal when video frame is encoded
+        videoEncoder.encodeFrame(frame, flipVertically); // video encoder will emit a signal when video frame is encoded
+}
+
+void MainController::requestCameraFrame()
+{
+    // polling the transport clock, the audio thread is not signaling every processed block
+    if (!audio::TransportClock::getInstance()->read().playing)
+        return;
+
+    if (canGrabNewFrameFromCamera())
+        grabCameraFrame();
 }
 
-void MainController::requestCameraFrame(int intervalPosition)
+void MainController::grabCameraFrame()
 {
     if (isPlayingInNinjamRoom() && mainWindow->cameraIsActivated()) {
-        bool isFirstPart = intervalPosition == 0;
-        if (isFirstPart || canGrabNewFrameFromCamera()) {
-            static int frameID = 0;
-            processCapturedFrame(frameID++, mainWindow->pickCameraFrame());
-            lastFrameTimeStamp = QDateTime::currentMSecsSinceEpoch();
-        }
+        static int frameID = 0;
+        processCapturedFrame(frameID++, mainWindow->pickCameraFrame(), mainWindow->cameraFrameIsFlipped());
+        lastFrameTimeStamp = QDateTime::currentMSecsSinceEpoch();
     }
 }
 
@@ -303,7 +402,7 @@ uint MainController::getFramesPerInterval() const
 {
     auto intervalTimeInSeconds = ninjamController->getSamplesPerInterval()/getSampleRate();
 
-    return intervalTimeInSeconds * CAMERA_FPS;
+    return intervalTimeInSeconds * getUploadQuality().cameraFps;
 }
 
 void MainController::updateBpi(int newBpi)
@@ -539,6 +638,8 @@ bool MainController::addTrack(long trackID, audio::AudioNode *trackNode)
 void MainController::storeChatFontSizeOffset(qint8 fontSizeOffset)
 {
     settings.storeChatFontSizeOffset(fontSizeOffset);
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeMultiTrackRecordingStatus(bool savingMultiTracks)
@@ -549,6 +650,8 @@ void MainController::storeMultiTrackRecordingStatus(bool savingMultiTracks)
     }
 
     settings.setSaveMultiTrack(savingMultiTracks);
+
+    scheduleSettingsSave();
 }
 
 QMap<QString, QString> MainController::getJamRecoders() const
@@ -581,6 +684,8 @@ void MainController::storeJamRecorderStatus(const QString &writerId, bool status
     }
 
     settings.setJamRecorderActivated(writerId, status);
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeMultiTrackRecordingPath(const QString &newPath)
@@ -590,6 +695,8 @@ void MainController::storeMultiTrackRecordingPath(const QString &newPath)
         for (auto jamRecorder : jamRecorders)
             jamRecorder->setRecordPath(newPath);
     }
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeDirNameDateFormat(const QString &newDateFormat)
@@ -600,28 +707,47 @@ void MainController::storeDirNameDateFormat(const QString &newDateFormat)
         for (auto jamRecorder : jamRecorders)
             jamRecorder->setDirNameDateFormat(dateFormat);
     }
+
+    scheduleSettingsSave();
+}
+
+void MainController::storeRecordingContinuousTrackFiles(bool continuousTrackFiles)
+{
+    settings.setRecordingContinuousTrackFiles(continuousTrackFiles);
+    for (auto jamRecorder : jamRecorders)
+        jamRecorder->setContinuousTrackFiles(continuousTrackFiles); // restart the recording if running
+
+    scheduleSettingsSave();
 }
 
 void MainController::storePrivateServerSettings(const QString &server, int serverPort, const QString &password)
 {
     settings.addPrivateServer(server, serverPort, password);
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeMetronomeSettings(float metronomeGain, float metronomePan, bool metronomeMuted)
 {
     settings.setMetronomeSettings(metronomeGain, metronomePan, metronomeMuted);
+
+    scheduleSettingsSave();
 }
 
 void MainController::setBuiltInMetronome(const QString &metronomeAlias)
 {
     settings.setBuiltInMetronome(metronomeAlias);
     recreateMetronome();
+
+    scheduleSettingsSave();
 }
 
 void MainController::setCustomMetronome(const QString &primaryBeatFile, const QString &offBeatFile, const QString &accentBeatFile)
 {
     settings.setCustomMetronome(primaryBeatFile, offBeatFile, accentBeatFile);
     recreateMetronome();
+
+    scheduleSettingsSave();
 }
 
 void MainController::recreateMetronome()
@@ -633,11 +759,15 @@ void MainController::recreateMetronome()
 void MainController::storeIntervalProgressShape(int shape)
 {
     settings.setIntervalProgressShape(shape);
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeWindowSettings(bool maximized, const QPointF &location, const QSize &size)
 {
     settings.setWindowSettings(maximized, location, size);
+
+    scheduleSettingsSave();
 }
 
 void MainController::storeIOSettings(int firstIn, int lastIn, int firstOut, int lastOut, QString audioInputDevice, QString audioOutputDevice,
@@ -645,6 +775,8 @@ void MainController::storeIOSettings(int firstIn, int lastIn, int firstOut, int
 {
     settings.setAudioSettings(firstIn, lastIn, firstOut, lastOut, audioInputDevice, audioOutputDevice);
     settings.setMidiSettings(midiInputsStatus);
+
+    scheduleSettingsSave();
 }
 
 void MainController::removeTrack(long trackID)
@@ -667,6 +799,12 @@ void MainController::setAllLoopersStatus(bool activated)
         inputTrack->getLooper()->setActivated(activated);
 }
 
+void MainController::prepareLoopers(uint samplesPerInterval)
+{
+    for (auto inputTrack : inputTracks.values())
+        inputTrack->getLooper()->prepareLayers(samplesPerInterval);
+}
+
 void MainController::doAudioProcess(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, int sampleRate)
 {
     auto incommingMidi = pullMidiMessagesFromDevices();
@@ -895,6 +1033,8 @@ MainController::~MainController()
     for (auto jamRecorder : jamRecorders)
         delete jamRecorder;
 
+    recorder::RecordingWriter::getInstance()->stop(); // all recorded intervals are written before exit
+
     audioIntervalsToUpload.clear();
 
     qCDebug(jtCore()) << "cleaning jamRecorders done!";
@@ -906,6 +1046,8 @@ MainController::~MainController()
 
 void MainController::saveLastUserSettings(const persistence::LocalInputTrackSettings &inputsSettings)
 {
+    settingsSaveTimer.stop();
+
     if (inputsSettings.isValid()) { // avoid save empty settings
         settings.setRecentEmojis(emojiManager.getRecents());
         settings.storeMasterGain(Utils::poweredGainToLinear(getMasterGain()));
@@ -915,8 +1057,15 @@ void MainController::saveLastUserSettings(const persistence::LocalInputTrackSett
 
 // -------------------------      PRESETS   ----------------------------
 
+void MainController::scheduleSettingsSave()
+{
+    settingsSaveTimer.start(); // restarting the timer in each change
+}
+
 QStringList MainController::getPresetList()
 {
+    settingsWriter.waitForWrites(); // the preset saved just now is listed
+
     return Configurator::getInstance()->getPresetFilesNames(false);
 }
 
@@ -1068,7 +1217,8 @@ bool MainController::setTheme(const QString &themeName)
     QString themeCSS = theme::Loader::loadCSS(themeDir, themeName);
 
     if (!themeCSS.isEmpty()) {
-        setCSS(themeCSS);
+        if (!qApp || qApp->styleSheet() != themeCSS) // setting the application stylesheet re-polish all widgets
+            setCSS(themeCSS);
         settings.setTheme(themeName);
         emit themeChanged();
         return true;
@@ -1101,12 +1251,16 @@ void MainController::stopNinjamController()
 
     audioIntervalsToUpload.clear();
 
+    cameraTimer.stop();
+
     videoEncoder.finish(); // release memory used by video encoder
 }
 
 void MainController::setTranslationLanguage(const QString &languageCode)
 {
     settings.setTranslation(languageCode);
+
+    scheduleSettingsSave();
 }
 
 QString MainController::getSuggestedUserName()
@@ -1131,6 +1285,8 @@ void MainController::storeMeteringSettings(bool showingMaxPeaks, quint8 meterOpt
 {
     settings.storeMeterOption(meterOption);
     settings.storeMeterShowingMaxPeaks(showingMaxPeaks);
+
+    scheduleSettingsSave();
 }
 
 audio::LocalInputNode *MainController::getInputTrackInGroup(quint8 groupIndex, quint8 trackIndex) const
@@ -1144,7 +1300,7 @@ audio::LocalInputNode *MainController::getInputTrackInGroup(quint8 groupIndex, q
 
 bool MainController::canGrabNewFrameFromCamera() const
 {
-    static const quint64 timeBetweenFrames = 1000/CAMERA_FPS;
+    const quint64 timeBetweenFrames = 1000 / getUploadQuality().cameraFps;
 
     const quint64 now = QDateTime::currentMSecsSinceEpoch();
 
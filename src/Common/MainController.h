@@ -2,12 +2,16 @@
 #define MAIN_CONTROLLER_H
 
 #include <QScopedPointer>
+#include <QTimer>
 #include <QImage>
 
 #include "UploadIntervalData.h"
+#include "UploadBitrateController.h"
 #include "loginserver/LoginService.h"
 #include "persistence/Settings.h"
+#include "persistence/SettingsWriter.h"
 #include "persistence/UsersDataCache.h"
+#include "looper/LoopLibrary.h"
 #include "audio/core/AudioMixer.h"
 #include "midi/MidiDriver.h"
 #include "video/FFMpegMuxer.h"
@@ -83,6 +87,10 @@ public:
     long getTotalDownloadTransferRate() const;
     long getDownloadTransferRate(const QString userFullName, quint8 channelIndex) const;
 
+    float getUploadEncodingQuality() const; // the user encoding quality reduced when the upload is congested
+    int getUploadQualityLevel() const; // zero when using the user quality
+    qint64 getUploadQueueDelay() const; // in milliseconds
+
     void setVideoProperties(const QSize &resolution);
 
     QSize getVideoResolution() const;
@@ -98,6 +106,7 @@ public:
     virtual std::vector<midi::MidiMessage> pullMidiMessagesFromPlugins() = 0;     // pull midi messages generated by plugins. This function can be called many times in each audio processing cicle because every VSTi can be a midi messages generator, and we need get the generated messages after call the plugin 'process' function.
 
     void saveLastUserSettings(const LocalInputTrackSettings &inputsSettings);
+    void scheduleSettingsSave(); // the settings are saved when not changed for some time
 
     // presets
     virtual Preset loadPreset(const QString &name);     // one preset
@@ -216,6 +225,7 @@ public:
     bool isMultiTrackRecordingActivated() const;
     void storeMultiTrackRecordingPath(const QString &newPath);
     void storeDirNameDateFormat(const QString &newDateFormat);
+    void storeRecordingContinuousTrackFiles(bool continuousTrackFiles);
 
     void storeJamRecorderStatus(const QString &writerId, bool status);
 
@@ -263,6 +273,8 @@ public:
     // to remembering ninjamers controls (pan, level, gain, boost)
     UsersDataCache *getUsersDataCache();     // TODO hide this from callers. Create a function in mainController to update the CacheEntries, so MainController is used as a Façade.
 
+    audio::LoopLibrary *getLoopLibrary();
+
     bool userIsBlockedInChat(const QString &userName) const;
 
     void storeMeteringSettings(bool showingMaxPeaks, quint8 meterOption);
@@ -285,6 +297,7 @@ public:
     quint8 getLooperBitDepth() const;
 
     void setAllLoopersStatus(bool activated);
+    void prepareLoopers(uint samplesPerInterval); // allocate the loopers storage for the next intervals
 
     // collapse settings
     void setLocalChannelsCollapsed(bool collapsed);
@@ -304,12 +317,16 @@ public:
     void setPublicChatActivated(bool activated);
 
     const static QSize MAX_VIDEO_SIZE;
+    const static quint8 CAMERA_FPS;
+    const static int SETTINGS_SAVE_DELAY; // milliseconds
 
 signals:
     void themeChanged();
     void userBlockedInChat(const QString &userName);
     void userUnblockedInChat(const QString &userName);
     void ipResolved(const QString &ip);
+    void uploadQualityChanged(int level, bool qualityDecreased);
+    void recordingDataDropped(qint64 droppedBytes); // the disk is too slow, recorded data was dropped in the last interval
 
 public slots:
     virtual void setSampleRate(int newSampleRate);
@@ -323,7 +340,7 @@ public slots:
     void blockUserInChat(const QString &userNameToBlock);
     void unblockUserInChat(const QString &userNameToUnblock);
 
-    void processCapturedFrame(int frameID, const QImage &frame);
+    void processCapturedFrame(int frameID, const QVideoFrame &frame, bool flipVertically);
 
     virtual void connectInNinjamServer(const ServerInfo &server);
 
@@ -344,6 +361,8 @@ protected:
     QScopedPointer<controller::NinjamController> ninjamController;
 
     Settings settings;
+    persistence::SettingsWriter settingsWriter; // config and presets files are written in background
+    QTimer settingsSaveTimer; // coalescing the settings changes in one write
 
     QMap<int, LocalInputNode *> inputTracks;
 
@@ -398,14 +417,25 @@ private:
 
     UsersDataCache usersDataCache;
 
-    int lastInputTrackID;     // used to generate a unique key/ID for each input track
+    audio::LoopLibrary loopLibrary; // indexed saved loops, updated when the looper folder is changed
 
-    const static quint8 CAMERA_FPS;
+    int lastInputTrackID;     // used to generate a unique key/ID for each input track
 
     bool canGrabNewFrameFromCamera() const;
 
     quint64 lastFrameTimeStamp;
 
+    QTimer cameraTimer; // the camera frames are grabbed at the camera rate, not in every audio block
+    void grabCameraFrame();
+
+    UploadBitrateController uploadBitrateController; // adapt the encoding quality to the measured upload
+    UploadQuality getUserUploadQuality() const;
+    UploadQuality getUploadQuality() const;
+    void adaptUploadQuality();
+
+    qint64 recordingDroppedBytes; // recorded data dropped by the recording writer, the user is warned when it grows
+    void checkRecordingWriter();
+
     void recreateMetronome();
 
     uint getFramesPerInterval() const;
@@ -431,7 +461,7 @@ protected slots:
     // TODO move this slot to NinjamController
     virtual void handleNewNinjamInterval();
 
-    void requestCameraFrame(int intervalPosition);
+    void requestCameraFrame();
 
 };
 
@@ -485,6 +515,11 @@ inline UsersDataCache *MainController::getUsersDataCache()
     return &usersDataCache;
 }
 
+inline audio::LoopLibrary *MainController::getLoopLibrary()
+{
+    return &loopLibrary;
+}
+
 inline bool MainController::userNameWasChoosed() const
 {
     return !settings.getUserName().isEmpty();
@@ -535,6 +570,16 @@ inline float MainController::getEncodingQuality() const
     return settings.getEncodingQuality();
 }
 
+inline int MainController::getUploadQualityLevel() const
+{
+    return uploadBitrateController.getLevel();
+}
+
+inline qint64 MainController::getUploadQueueDelay() const
+{
+    return uploadBitrateController.getQueueDelay();
+}
+
 inline int MainController::getInputTracksCount() const
 {
     return inputTracks.size();     // return the individual tracks (subchannels) count
@@ -583,11 +628,13 @@ inline int MainController::getLastTracksLayout() const
 inline void MainController::storeTracksLayoutOrientation(quint8 layout)
 {
     settings.storeTracksLayoutOrientation(layout);
+    scheduleSettingsSave();
 }
 
 inline void MainController::storeTracksSize(bool usingNarrowedTracks)
 {
     settings.storeTracksSize(usingNarrowedTracks);
+    scheduleSettingsSave();
 }
 
 inline bool MainController::isUsingNarrowedTracks() const
@@ -598,6 +645,7 @@ inline bool MainController::isUsingNarrowedTracks() const
 inline void MainController::storeWaveDrawingMode(quint8 drawingMode)
 {
     settings.storeWaveDrawingMode(drawingMode);
+    scheduleSettingsSave();
 }
 
 inline quint8 MainController::getLastWaveDrawingMode() const
@@ -613,6 +661,7 @@ inline void MainController::setMainWindow(MainWindow *mainWindow)
 inline void MainController::storeLooperBitDepth(quint8 bitDepth)
 {
     settings.setLooperBitDepth(bitDepth);
+    scheduleSettingsSave();
 }
 
 inline quint8 MainController::getLooperBitDepth() const
@@ -623,21 +672,26 @@ inline quint8 MainController::getLooperBitDepth() const
 inline void MainController::storeLooperPreferredLayerCount(quint8 layersCount)
 {
     settings.setLooperPreferredLayersCount(layersCount);
+    scheduleSettingsSave();
 }
 
 inline void MainController::storeLooperPreferredMode(quint8 looperMode)
 {
     settings.setLooperPreferredMode(looperMode);
+    scheduleSettingsSave();
 }
 
 inline void MainController::storeLooperAudioEncodingFlag(bool encodeAudioWhenSaving)
 {
     settings.setLooperAudioEncodingFlag(encodeAudioWhenSaving);
+    scheduleSettingsSave();
 }
 
 inline void MainController::storeLooperFolder(const QString &newLooperFolder)
 {
     settings.setLooperFolder(newLooperFolder);
+    loopLibrary.setLoopsDir(settings.getLooperSavePath());
+    scheduleSettingsSave();
 }
 
 inline quint8 MainController::getLooperPreferedLayersCount() const
@@ -659,6 +713,7 @@ inline void MainController::storeRemoteUserRememberSettings(bool boost, bool lev
                                                             bool mute, bool lowCut)
 {
     settings.setRemoteUserRememberingSettings(boost, level, pan, mute, lowCut);
+    scheduleSettingsSave();
 }
 
 inline void MainController::storeCollapsibleSectionsRememberSettings(bool localChannels,
@@ -666,6 +721,7 @@ inline void MainController::storeCollapsibleSectionsRememberSettings(bool localC
                                                                      bool chatSection)
 {
     settings.setCollapsileSectionsRememberingSettings(localChannels, bottomSection, chatSection);
+    scheduleSettingsSave();
 }
 } // namespace
 
@@ -14,6 +14,7 @@
 #include "audio/NinjamTrackNode.h"
 #include "audio/MetronomeTrackNode.h"
 #include "audio/Resampler.h"
+#include "audio/TransportClock.h"
 #include "audio/SamplesBufferRecorder.h"
 #include "audio/vorbis/VorbisEncoder.h"
 #include "audio/vorbis/Vorbis.h"
@@ -230,8 +231,25 @@ private:
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+class NinjamController::EncodingQualityChangedEvent : public SchedulableEvent
+{
+public:
+    explicit EncodingQualityChangedEvent(NinjamController *controller) :
+        SchedulableEvent(controller)
+    {
+    }
+
+    void process()
+    {
+        controller->recreateEncoders();
+    }
+};
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 NinjamController::NinjamController(controller::MainController *mainController) :
     intervalPosition(0),
+    intervalIndex(0),
     samplesInInterval(0),
     mainController(mainController),
     metronomeTrackNode(createMetronomeTrackNode(mainController->getSampleRate())),
@@ -292,8 +310,6 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
 
     do
     {
-        emit startProcessing(intervalPosition); // vst host time line is updated with this event
-
         int samplesToProcessInThisStep
             = (std::min)((int)(samplesInInterval - intervalPosition),
                          totalSamplesToProcess - offset);
@@ -319,6 +335,8 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
             emit intervalBeatChanged(currentBeat);
         }
 
+        publishTransportState(currentBeat, sampleRate); // the plugins read the sample accurate position in this step
+
         // +++++++++++ MAIN AUDIO OUTPUT PROCESS +++++++++++++++
         bool isLastPart = intervalPosition + samplesToProcessInThisStep >= samplesInInterval;
         //for (NinjamTrackNode *track : trackNodes)
@@ -359,10 +377,27 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
         offset += samplesToProcessInThisStep;
         this->intervalPosition = (this->intervalPosition + samplesToProcessInThisStep)
                                  % samplesInInterval;
+        if (this->intervalPosition == 0)
+            intervalIndex++;
     }
     while (samplesProcessed < totalSamplesToProcess);
 }
 
+void NinjamController::publishTransportState(int currentBeat, int sampleRate)
+{
+    audio::TransportState state;
+    state.playing = true;
+    state.intervalIndex = intervalIndex;
+    state.samplePosition = intervalPosition;
+    state.samplesInInterval = samplesInInterval;
+    state.beat = currentBeat;
+    state.bpm = currentBpm;
+    state.bpi = currentBpi;
+    state.sampleRate = sampleRate;
+
+    audio::TransportClock::getInstance()->publish(state);
+}
+
 audio::MetronomeTrackNode *NinjamController::createMetronomeTrackNode(int sampleRate)
 {
     audio::SamplesBuffer firstBeatBuffer(2);
@@ -417,7 +452,11 @@ void NinjamController::stop(bool emitDisconnectedSignal)
 {
     if (isRunning())
     {
-        this->running = false;
+        {
+            QMutexLocker locker(&mutex); // the audio thread is the transport writer, waiting the current block
+            this->running = false;
+            audio::TransportClock::getInstance()->stop();
+        }
 
         // store metronome settings
         auto metronomeTrack = mainController->getTrackNode(METRONOME_TRACK_ID);
@@ -504,6 +543,7 @@ void NinjamController::start(const ServerInfo &server)
     // schedule an update in internal attributes
     scheduledEvents.append(new BpiChangeEvent(this, server.getBpi()));
     scheduledEvents.append(new BpmChangeEvent(this, server.getBpm()));
+    mainController->prepareLoopers(computeTotalSamplesInInterval(server.getBpm(), server.getBpi())); // the loopers storage is not allocated in the audio thread
     preparedForTransmit = false; // the xmit start after the first interval is received
     emit preparingTransmission();
 
@@ -532,6 +572,7 @@ void NinjamController::start(const ServerInfo &server)
                                     mainController->getSettings().getMetronomePan());
 
         this->intervalPosition = lastBeat = 0;
+        this->intervalIndex = 0;
 
         auto ninjamService = mainController->getNinjamService();
         connect(ninjamService, &Service::serverBpmChanged, this,
@@ -771,7 +812,15 @@ long NinjamController::getSamplesPerBeat()
 
 long NinjamController::computeTotalSamplesInInterval()
 {
-    double intervalPeriod = 60000.0 / currentBpm * currentBpi;
+    return computeTotalSamplesInInterval(currentBpm, currentBpi);
+}
+
+long NinjamController::computeTotalSamplesInInterval(int bpm, int bpi) const
+{
+    if (bpm <= 0)
+        return 0; // the server tempo is not received yet
+
+    double intervalPeriod = 60000.0 / bpm * bpi;
     return (long)(mainController->getSampleRate() * intervalPeriod / 1000.0);
 }
 
@@ -816,12 +865,13 @@ void NinjamController::scheduleBpiChangeEvent(quint16 newBpi, quint16 oldBpi)
 {
     Q_UNUSED(oldBpi);
     scheduledEvents.append(new BpiChangeEvent(this, newBpi));
+    mainController->prepareLoopers(computeTotalSamplesInInterval(currentBpm, newBpi));
 }
 
 void NinjamController::scheduleBpmChangeEvent(quint16 newBpm)
 {
-    Q_UNUSED(newBpm)
     scheduledEvents.append(new BpmChangeEvent(this, newBpm));
+    mainController->prepareLoopers(computeTotalSamplesInInterval(newBpm, currentBpi));
 }
 
 void NinjamController::handleIntervalCompleted(const User &user, quint8 channelIndex,
@@ -866,6 +916,11 @@ void NinjamController::scheduleEncoderChangeForChannel(int channelIndex, bool vo
     scheduledEvents.append(new InputChannelChangedEvent(this, channelIndex, voiceChatActivated));
 }
 
+void NinjamController::scheduleEncodersRecreation()
+{
+    scheduledEvents.append(new EncodingQualityChangedEvent(this));
+}
+
 QByteArray NinjamController::encode(const audio::SamplesBuffer &buffer, uint channelIndex)
 {
     QMutexLocker locker(&encodersMutex);
@@ -902,7 +957,7 @@ void NinjamController::recreateEncoderForChannel(int channelIndex, bool voiceCha
             delete encoders[channelIndex];
 
         int sampleRate = mainController->getSampleRate();
-        float encodingQuality = voiceChannelActivated ? vorbis::EncoderQualityLow : mainController->getEncodingQuality();
+        float encodingQuality = voiceChannelActivated ? vorbis::EncoderQualityLow : mainController->getUploadEncodingQuality();
 
         encoders[channelIndex] = new vorbis::Encoder(maxChannelsForEncoding, sampleRate, encodingQuality);
     }
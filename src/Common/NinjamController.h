@@ -65,6 +65,7 @@ public:
     QByteArray encodeLastPartOfInterval(uint channelIndex);
 
     void scheduleEncoderChangeForChannel(int channelIndex, bool voiceChatActivated);
+    void scheduleEncodersRecreation(); // encoding quality changed, the new encoders are used in the next interval
     void removeEncoder(int groupChannelIndex);
 
     void scheduleXmitChange(int channelID, bool transmiting);     // schedule the change for the next interval
@@ -91,7 +92,6 @@ signals:
 
     void intervalBeatChanged(int intervalBeat);
     void startingNewInterval();
-    void startProcessing(int intervalPosition);
     void channelAdded(const User &user, const UserChannel &channel, long channelID);
     void channelRemoved(const User &user, const UserChannel &channel, long channelID);
     void channelChanged(const User &user, const UserChannel &channel, long channelID); // emmited when channel name or flags (intervalic or voice chat channel) changes
@@ -115,6 +115,7 @@ signals:
 
 protected:
     long intervalPosition;
+    qint64 intervalIndex; // intervals since the controller was started
     long samplesInInterval;
 
     QMap<QString, NinjamTrackNode *> trackNodes;     // the other users channels
@@ -139,6 +140,7 @@ private:
     QMutex encodersMutex;
 
     long computeTotalSamplesInInterval();
+    long computeTotalSamplesInInterval(int bpm, int bpi) const;
     long getSamplesPerBeat();
 
     void processScheduledChanges();
@@ -152,6 +154,7 @@ private:
     AudioEncoder *getEncoder(quint8 channelIndex);
 
     void handleNewInterval();
+    void publishTransportState(int currentBeat, int sampleRate);
     void recreateEncoderForChannel(int channelIndex, bool voiceChannelActivated);
 
     void setXmitStatus(int channelID, bool transmiting);
@@ -162,6 +165,7 @@ private:
     class BpiChangeEvent;
     class BpmChangeEvent;
     class InputChannelChangedEvent;    // user change the channel input selection from mono to stereo or vice-versa, or user added a new channel, both cases requires a new encoder in next interval
+    class EncodingQualityChangedEvent; // the upload quality was adapted to the available upload bandwidth
     QList<SchedulableEvent *> scheduledEvents;
 
     class EncodingThread;
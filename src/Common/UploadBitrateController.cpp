@@ -0,0 +1,82 @@
+#include "UploadBitrateController.h"
+#include "audio/vorbis/Vorbis.h"
+
+UploadBitrateController::UploadBitrateController()
+{
+    reset();
+}
+
+void UploadBitrateController::reset()
+{
+    level = 0;
+    lastQueuedBytes = 0;
+    queueDelay = 0;
+    growingIntervals = 0;
+    clearIntervals = 0;
+}
+
+UploadBitrateController::Decision UploadBitrateController::update(qint64 queuedBytes, qint64 uploadRate)
+{
+    if (queuedBytes <= 0)
+        queueDelay = 0;
+    else
+        queueDelay = queuedBytes * 1000 / qMax(uploadRate, qint64(1)); // nothing uploaded and bytes in the queue is a congested link
+
+    const bool queueIsGrowing = queuedBytes > lastQueuedBytes;
+    lastQueuedBytes = queuedBytes;
+
+    if (queueDelay >= CONGESTED_QUEUE_DELAY) {
+        growingIntervals = clearIntervals = 0;
+        if (level < MAX_LEVEL) {
+            level++;
+            return DecreaseQuality;
+        }
+        return KeepQuality;
+    }
+
+    if (queueDelay <= CLEAR_QUEUE_DELAY) {
+        growingIntervals = 0;
+        if (level > 0 && ++clearIntervals >= CLEAR_INTERVALS_TO_INCREASE) {
+            clearIntervals = 0;
+            level--;
+            return IncreaseQuality;
+        }
+        return KeepQuality;
+    }
+
+    // the queue is not empty but is not congested yet, watching the trend
+    clearIntervals = 0;
+    growingIntervals = queueIsGrowing ? growingIntervals + 1 : 0;
+    if (growingIntervals >= GROWING_INTERVALS_TO_DECREASE && level < MAX_LEVEL) {
+        growingIntervals = 0;
+        level++;
+        return DecreaseQuality;
+    }
+
+    return KeepQuality;
+}
+
+UploadQuality UploadBitrateController::getQuality(const UploadQuality &userQuality) const
+{
+    UploadQuality quality(userQuality);
+
+    switch (level) {
+    case 0:
+        break;
+    case 1:
+        quality.vorbisQuality = qMin(userQuality.vorbisQuality, vorbis::EncoderQualityNormal);
+        quality.videoBitRate = userQuality.videoBitRate * 3 / 4;
+        break;
+    case 2:
+        quality.vorbisQuality = qMin(userQuality.vorbisQuality, vorbis::EncoderQualityLow);
+        quality.videoBitRate = userQuality.videoBitRate / 2;
+        quality.cameraFps = qMax(1, userQuality.cameraFps / 2);
+        break;
+    default:
+        quality.vorbisQuality = qMin(userQuality.vorbisQuality, vorbis::EncoderQualityLow);
+        quality.videoBitRate = userQuality.videoBitRate / 4;
+        quality.cameraFps = qMax(1, userQuality.cameraFps / 5);
+    }
+
+    return quality;
+}
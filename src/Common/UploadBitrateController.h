@@ -0,0 +1,74 @@
+#ifndef UPLOAD_BITRATE_CONTROLLER_H
+#define UPLOAD_BITRATE_CONTROLLER_H
+
+#include <QtGlobal>
+
+struct UploadQuality // encoding settings used in one interval
+{
+    float vorbisQuality;
+    uint videoBitRate;
+    quint8 cameraFps;
+};
+
+/**
+    Congestion control for the uploaded intervals.
+
+    Once per interval the controller looks at the bytes waiting in the socket send queue and the
+    measured upload rate. The queue delay (queued bytes / upload rate) tells how late our intervals
+    are arriving in the server. When the queue is congested, or is growing in consecutive intervals,
+    the encoding quality is decreased one level for the next interval. After some intervals with an
+    empty queue the quality is increased one level, until the quality choosed by the user.
+ */
+
+class UploadBitrateController
+{
+public:
+    UploadBitrateController();
+
+    enum Decision
+    {
+        KeepQuality,
+        DecreaseQuality,
+        IncreaseQuality
+    };
+
+    Decision update(qint64 queuedBytes, qint64 uploadRate); // called in each new interval, upload rate in bytes per second
+
+    void reset(); // back to the user quality, called when a new jam is started
+
+    int getLevel() const; // zero is the quality choosed by the user
+    bool isQualityReduced() const;
+    qint64 getQueueDelay() const; // in milliseconds, measured in the last interval
+
+    UploadQuality getQuality(const UploadQuality &userQuality) const; // the user quality reduced to the current level
+
+    static const int MAX_LEVEL = 3;
+    static const qint64 CONGESTED_QUEUE_DELAY = 1000; // in milliseconds
+    static const qint64 CLEAR_QUEUE_DELAY = 100;
+    static const int GROWING_INTERVALS_TO_DECREASE = 2;
+    static const int CLEAR_INTERVALS_TO_INCREASE = 4;
+
+private:
+    int level;
+    qint64 lastQueuedBytes;
+    qint64 queueDelay;
+    int growingIntervals; // consecutive intervals with the queue growing
+    int clearIntervals; // consecutive intervals with the queue (almost) empty
+};
+
+inline int UploadBitrateController::getLevel() const
+{
+    return level;
+}
+
+inline bool UploadBitrateController::isQualityReduced() const
+{
+    return level > 0;
+}
+
+inline qint64 UploadBitrateController::getQueueDelay() const
+{
+    return queueDelay;
+}
+
+#endif
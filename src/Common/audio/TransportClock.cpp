@@ -0,0 +1,102 @@
+#include "TransportClock.h"
+
+#include <chrono>
+#include <thread>
+
+using audio::TransportClock;
+using audio::TransportState;
+
+TransportState::TransportState() :
+    playing(false),
+    intervalIndex(0),
+    samplePosition(0),
+    samplesInInterval(0),
+    beat(0),
+    bpm(120),
+    bpi(16),
+    sampleRate(44100),
+    timestamp(0)
+{
+
+}
+
+double TransportState::getPositionInQuarterNotes() const
+{
+    if (sampleRate <= 0)
+        return 0.0;
+
+    return static_cast<double>(samplePosition) / sampleRate * bpm / 60.0;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+TransportClock *TransportClock::getInstance()
+{
+    static TransportClock instance; // thread safe initialization in C++11
+    return &instance;
+}
+
+TransportClock::TransportClock() :
+    sequence(0)
+{
+    publish(TransportState());
+}
+
+void TransportClock::publish(const TransportState &state)
+{
+    const quint32 currentSequence = sequence.load(std::memory_order_relaxed);
+    sequence.store(currentSequence + 1, std::memory_order_relaxed); // readers will retry
+    std::atomic_thread_fence(std::memory_order_release);
+
+    playing.store(state.playing, std::memory_order_relaxed);
+    intervalIndex.store(state.intervalIndex, std::memory_order_relaxed);
+    samplePosition.store(state.samplePosition, std::memory_order_relaxed);
+    samplesInInterval.store(state.samplesInInterval, std::memory_order_relaxed);
+    beat.store(state.beat, std::memory_order_relaxed);
+    bpm.store(state.bpm, std::memory_order_relaxed);
+    bpi.store(state.bpi, std::memory_order_relaxed);
+    sampleRate.store(state.sampleRate, std::memory_order_relaxed);
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    timestamp.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), std::memory_order_relaxed);
+
+    sequence.store(currentSequence + 2, std::memory_order_release);
+}
+
+void TransportClock::stop()
+{
+    TransportState state = read();
+    state.playing = false;
+    state.samplePosition = 0;
+    state.beat = 0;
+
+    publish(state);
+}
+
+TransportState TransportClock::read() const
+{
+    TransportState state;
+
+    forever {
+        const quint32 sequenceBefore = sequence.load(std::memory_order_acquire);
+        if (sequenceBefore & 1) {
+            std::this_thread::yield(); // the audio thread is publishing
+            continue;
+        }
+
+        state.playing = playing.load(std::memory_order_relaxed);
+        state.intervalIndex = intervalIndex.load(std::memory_order_relaxed);
+        state.samplePosition = samplePosition.load(std::memory_order_relaxed);
+        state.samplesInInterval = samplesInInterval.load(std::memory_order_relaxed);
+        state.beat = beat.load(std::memory_order_relaxed);
+        state.bpm = bpm.load(std::memory_order_relaxed);
+        state.bpi = bpi.load(std::memory_order_relaxed);
+        state.sampleRate = sampleRate.load(std::memory_order_relaxed);
+        state.timestamp = timestamp.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == sequenceBefore)
+            return state;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef TRANSPORT_CLOCK_H
+#define TRANSPORT_CLOCK_H
+
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace audio {
+
+struct TransportState
+{
+    TransportState();
+
+    bool playing;
+    qint64 intervalIndex; // intervals since the jam started
+    qint64 samplePosition; // position in the current interval
+    qint64 samplesInInterval;
+    int beat; // current beat in the interval
+    int bpm;
+    int bpi;
+    int sampleRate;
+    qint64 timestamp; // steady clock nanoseconds when the state was published
+
+    double getPositionInQuarterNotes() const; // VST ppqPos
+};
+
+/**
+ * The jam transport shared by the audio thread and the other threads.
+ *
+ * The audio thread (the only writer) publishes the state at the start of each processed block,
+ * sample accurate. Readers never block the writer: read() retries while a new state is being
+ * published (a sequence lock). The VST host reads the clock inside the audio callback, the GUI
+ * and the camera poll it in their own timers instead of receiving Qt signals in every block.
+ */
+
+class TransportClock
+{
+public:
+    static TransportClock *getInstance();
+
+    void publish(const TransportState &state); // audio thread only
+    void stop(); // publish a stopped transport
+
+    TransportState read() const; // any thread
+
+private:
+    TransportClock();
+
+    std::atomic<quint32> sequence; // odd while the state is being published
+
+    std::atomic<bool> playing;
+    std::atomic<qint64> intervalIndex;
+    std::atomic<qint64> samplePosition;
+    std::atomic<qint64> samplesInInterval;
+    std::atomic<int> beat;
+    std::atomic<int> bpm;
+    std::atomic<int> bpi;
+    std::atomic<int> sampleRate;
+    std::atomic<qint64> timestamp;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,131 @@
+#include "PeaksPyramid.h"
+
+#include <algorithm>
+
+using audio::PeaksPyramid;
+
+PeaksPyramid::PeaksPyramid() :
+    samples(0)
+{
+
+}
+
+PeaksPyramid::Block PeaksPyramid::merge(const Block &a, const Block &b)
+{
+    return Block{qMin(a.min, b.min), qMax(a.max, b.max)};
+}
+
+void PeaksPyramid::resize(uint samples)
+{
+    this->samples = samples;
+
+    const uint blocks = (samples + SAMPLES_PER_BLOCK - 1) / SAMPLES_PER_BLOCK;
+    if (levels.empty())
+        levels.resize(1);
+
+    levels[0].resize(blocks, Block{0, 0});
+
+    rebuildUpperLevels();
+}
+
+void PeaksPyramid::rebuildUpperLevels()
+{
+    levels.resize(1);
+
+    while (levels.back().size() > 1) {
+        const std::vector<Block> &children = levels.back();
+        std::vector<Block> parents((children.size() + 1) / 2);
+        for (uint p = 0; p < parents.size(); ++p) {
+            const uint firstChild = p * 2;
+            parents[p] = (firstChild + 1 < children.size()) ? merge(children[firstChild], children[firstChild + 1]) : children[firstChild];
+        }
+
+        levels.push_back(std::move(parents));
+    }
+}
+
+void PeaksPyramid::clear()
+{
+    for (auto &level : levels)
+        std::fill(level.begin(), level.end(), Block{0, 0});
+}
+
+void PeaksPyramid::copyBlocks(const PeaksPyramid &other)
+{
+    const uint blocks = qMin(getBlocksCount(), other.getBlocksCount());
+    if (!blocks)
+        return;
+
+    std::copy(other.levels[0].begin(), other.levels[0].begin() + blocks, levels[0].begin());
+
+    updateParents(0, blocks - 1);
+}
+
+void PeaksPyramid::setBlock(uint blockIndex, float minValue, float maxValue)
+{
+    if (levels.empty() || blockIndex >= levels[0].size())
+        return;
+
+    levels[0][blockIndex] = Block{minValue, maxValue};
+}
+
+void PeaksPyramid::updateParents(uint firstBlock, uint lastBlock)
+{
+    for (uint l = 1; l < levels.size(); ++l) {
+        const std::vector<Block> &children = levels[l - 1];
+        std::vector<Block> &parents = levels[l];
+
+        firstBlock /= 2;
+        lastBlock = qMin(lastBlock / 2, static_cast<uint>(parents.size() - 1));
+
+        for (uint p = firstBlock; p <= lastBlock; ++p) {
+            const uint firstChild = p * 2;
+            parents[p] = (firstChild + 1 < children.size()) ? merge(children[firstChild], children[firstChild + 1]) : children[firstChild];
+        }
+    }
+}
+
+void PeaksPyramid::getMinMax(uint from, uint samples, float &minValue, float &maxValue) const
+{
+    minValue = maxValue = 0;
+
+    if (!samples || levels.empty() || from >= this->samples)
+        return;
+
+    uint first = from / SAMPLES_PER_BLOCK;
+    uint last = qMin((from + samples - 1) / SAMPLES_PER_BLOCK, getBlocksCount() - 1);
+
+    Block result = levels[0][first];
+
+    // classic bottom-up segment tree query, at most 2 blocks are merged in each level
+    for (uint l = 0; l < levels.size() && first <= last; ++l) {
+        const std::vector<Block> &level = levels[l];
+        if (first == last) {
+            result = merge(result, level[first]);
+            break;
+        }
+
+        if (first & 1)
+            result = merge(result, level[first++]);
+
+        if (!(last & 1))
+            result = merge(result, level[last--]);
+
+        if (first > last)
+            break;
+
+        first /= 2;
+        last /= 2;
+    }
+
+    minValue = result.min;
+    maxValue = result.max;
+}
+
+float PeaksPyramid::getMaxPeak(uint from, uint samples) const
+{
+    float minValue, maxValue;
+    getMinMax(from, samples, minValue, maxValue);
+
+    return qMax(qAbs(minValue), qAbs(maxValue));
+}
@@ -0,0 +1,71 @@
+#ifndef PEAKS_PYRAMID_H
+#define PEAKS_PYRAMID_H
+
+#include <QtGlobal>
+#include <vector>
+
+namespace audio {
+
+/**
+ * Multi-resolution min/max peaks (a mipmap) for audio displays.
+ *
+ * The first level stores the min and max sample values for each block of SAMPLES_PER_BLOCK
+ * samples, and each next level merges 2 blocks of the previous level. The owner updates the
+ * first level blocks when samples are written and calls updateParents() to refresh the upper
+ * levels, so the cost of an update is proportional to the written samples. Any range query
+ * visits at most 2 blocks per level, so peaks for a widget can be computed in O(pixels)
+ * regardless of the audio lenght.
+ *
+ * Range queries have block resolution: a range partially covering a block uses the entire block,
+ * so the owner computes the partial blocks in the range edges from the samples when exact peaks
+ * are needed. resize() reallocates the levels, a pyramid being read in other threads is not resized.
+ */
+
+class PeaksPyramid
+{
+public:
+    static const uint SAMPLES_PER_BLOCK = 64;
+
+    PeaksPyramid();
+
+    void resize(uint samples); // keep the first level content and rebuild the upper levels
+    void clear(); // zero all blocks
+    void copyBlocks(const PeaksPyramid &other); // copy the blocks of a smaller (or same size) pyramid, no allocations
+
+    uint getBlocksCount() const;
+    uint getSamples() const;
+
+    void setBlock(uint blockIndex, float minValue, float maxValue);
+    void updateParents(uint firstBlock, uint lastBlock); // update the upper levels after some setBlock() calls
+
+    void getMinMax(uint from, uint samples, float &minValue, float &maxValue) const;
+    float getMaxPeak(uint from, uint samples) const; // absolute max value
+
+private:
+    struct Block
+    {
+        float min;
+        float max;
+    };
+
+    std::vector<std::vector<Block>> levels;
+    uint samples;
+
+    void rebuildUpperLevels();
+
+    static Block merge(const Block &a, const Block &b);
+};
+
+inline uint PeaksPyramid::getSamples() const
+{
+    return samples;
+}
+
+inline uint PeaksPyramid::getBlocksCount() const
+{
+    return levels.empty() ? 0 : levels[0].size();
+}
+
+} // namespace
+
+#endif // PEAKS_PYRAMID_H
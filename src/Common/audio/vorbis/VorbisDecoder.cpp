@@ -8,6 +8,7 @@
 #include "audio/core/SamplesBuffer.h"
 #include <vorbis/vorbisfile.h>
 #include <QThread>
+#include <QIODevice>
 #include "log/Logging.h"
 
 using vorbis::Decoder;
@@ -15,7 +16,8 @@ using vorbis::Decoder;
 Decoder::Decoder() :
       internalBuffer(2, 4096),
       initialized(false),
-      vorbisInput()
+      vorbisInput(),
+      inputDevice(nullptr)
 {
     vorbisFile.vi = nullptr;
 }
@@ -55,6 +57,11 @@ int Decoder::getSampleRate() const
 
 //+++++++++++++++++++++++++++++++++++++++++++
 size_t Decoder::consumeTo(void *oggOutBuffer, size_t bytesToConsume){
+    if (inputDevice) {
+        qint64 bytesRead = inputDevice->read(static_cast<char *>(oggOutBuffer), static_cast<qint64>(bytesToConsume));
+        return bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+    }
+
     size_t len = qMin( bytesToConsume, (size_t)vorbisInput.size());
     if (len > 0) {
         memcpy(oggOutBuffer, vorbisInput.data(), len);
@@ -136,6 +143,12 @@ void Decoder::setInputData(const QByteArray &vorbisData)
     //qDebug() << "Input data setted to " << vorbisData.left(32);
 }
 
+void Decoder::setInputDevice(QIODevice *device)
+{
+    vorbisInput.clear();
+    inputDevice = device;
+}
+
 void Decoder::addInputData(const QByteArray &vorbisData)
 {
     vorbisInput.append(vorbisData);
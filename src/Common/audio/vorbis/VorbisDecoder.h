@@ -5,6 +5,8 @@
 #include "audio/core/SamplesBuffer.h"
 #include <QByteArray>
 
+class QIODevice;
+
 namespace vorbis {
 
 class Decoder
@@ -30,6 +32,8 @@ public:
 
     void addInputData(const QByteArray &vorbisData);
 
+    void setInputDevice(QIODevice *device); // stream the input from a device (a file) instead of buffered data
+
     bool initialize();
 
     bool isFinished() const { return finished; }
@@ -42,6 +46,7 @@ private:
     OggVorbis_File vorbisFile;
     bool initialized;
     QByteArray vorbisInput;
+    QIODevice *inputDevice;
     static size_t readOgg(void *oggOutBuffer, size_t size, size_t nmemb, void *decoderInstance);
 
     size_t consumeTo(void *oggOutBuffer, size_t bytesToConsume);
@@ -1,9 +1,29 @@
 #include "FileUtils.h"
 
 #include <QRegularExpression>
+#include <QFile>
+#include <QDir>
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <cstdio>
+#endif
 
 QString file::sanitizeFileName(QString &fileName)
 {
     static const QRegularExpression regex("[\\\\/:*\?\"<>|]");
     return fileName.replace(regex, "_");
 }
+
+bool file::replaceFile(const QString &sourcePath, const QString &destinationPath)
+{
+    // QFile::rename fails when the destination exists, and removing the destination before renaming is not atomic
+#ifdef Q_OS_WIN
+    const QString source = QDir::toNativeSeparators(sourcePath);
+    const QString destination = QDir::toNativeSeparators(destinationPath);
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(source.utf16()), reinterpret_cast<LPCWSTR>(destination.utf16()), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(QFile::encodeName(sourcePath).constData(), QFile::encodeName(destinationPath).constData()) == 0;
+#endif
+}
@@ -7,6 +7,9 @@ namespace file {
 
 QString sanitizeFileName(QString &fileName);
 
+// atomically rename sourcePath over destinationPath. The destination is never missing: it is the old or the new file if something fails
+bool replaceFile(const QString &sourcePath, const QString &destinationPath);
+
 }
 
 #endif
@@ -17,7 +17,7 @@ bool OggFileReader::read(const QString &filePath, SamplesBuffer &outBuffer, quin
     }
 
     vorbis::Decoder decoder;
-    decoder.setInputData(oggFile.readAll());
+    decoder.setInputDevice(&oggFile); // streaming, the file is not entirely loaded in memory
     decoder.initialize(); // read the ogg headers from file
     sampleRate = decoder.getSampleRate();
     if (decoder.isMono())
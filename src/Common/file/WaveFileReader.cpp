@@ -141,14 +141,11 @@ bool WaveFileReader::read(const QString &filePath, audio::SamplesBuffer &outBuff
         return false; // Done, out buffer is not changed
     }
 
-    // Read in the whole thing
-    QByteArray wavFileContent = wavFile.readAll();
-
     // Define the header components
     char fileType[4];
     quint32 fileSize;
     char waveName[4];
-    char fmtName[3];
+    char fmtName[4];
     quint32 fmtLength;
     quint16 fmtType;
     quint16 channels;
@@ -158,8 +155,8 @@ bool WaveFileReader::read(const QString &filePath, audio::SamplesBuffer &outBuff
     char dataHeader[4];
     quint32 dataSize = 0;
 
-    // Create a data stream to analyze the data
-    QDataStream stream(&wavFileContent, QIODevice::ReadOnly);
+    // Create a data stream to analyze the data, streaming from the file
+    QDataStream stream(&wavFile);
     stream.setByteOrder(QDataStream::LittleEndian);
 
     // Now pop off the appropriate data into each header field defined above
@@ -177,19 +174,28 @@ bool WaveFileReader::read(const QString &filePath, audio::SamplesBuffer &outBuff
         return false;
     }
 
+    // skip the chunks before "fmt " (the JUNK/ds64 chunk reserved by WaveFileWriter, for example)
     stream.readRawData((char *)fmtName, 4); // "fmt"
+    stream >> fmtLength;  // Format length
+    while (QString::fromLocal8Bit(fmtName, 4) != "fmt " && !stream.atEnd()) {
+        stream.skipRawData(fmtLength + (fmtLength & 1)); // chunks are word aligned
+        stream.readRawData((char *)fmtName, 4);
+        stream >> fmtLength;
+    }
+
     if (QString::fromLocal8Bit(fmtName, 4) != "fmt ") {
         qCritical() << "Error loading " << filePath << ", 'fmt' chunk not founded!";
         return false;
     }
 
-    stream >> fmtLength;  // Format length
     stream >> fmtType;    // Format type
     stream >> channels;   // Number of channels
     stream >> sampleRate; // Sample rate
     stream >> sampleRateXBitsPerSampleXChanngelsDivEight; // (Sample Rate * BitsPerSample * Channels) / 8
     stream >> bitsPerSampleXChannelsDivEightPointOne; // (BitsPerSample * Channels) / 8.1
     stream >> bitsPerSample; // Bits per sample
+    if (fmtLength > 16)
+        stream.skipRawData(fmtLength - 16); // extensible format fields
     while (QString::fromLocal8Bit(dataHeader, 4) != "data" && !stream.atEnd()) {
         stream.readRawData((char *)dataHeader, 4); // "data" header
         stream >> dataSize; // Data Size
@@ -1,58 +1,119 @@
 #include "WaveFileWriter.h"
 
-#include <QFile>
 #include <QDebug>
 #include <QDataStream>
-#include <QThread>
 #include <climits>
 
 using audio::WaveFileWriter;
 using audio::SamplesBuffer;
 
-void WaveFileWriter::write(const QString &filePath, const SamplesBuffer &buffer, quint32 sampleRate, quint8 bitDepth)
+WaveFileWriter::WaveFileWriter() :
+    channels(0),
+    bitDepth(16),
+    dataChunkSize(0),
+    ds64Reserved(false),
+    dataChunkSizePosition(0),
+    failed(false)
 {
-    QFile wavFile(filePath);
+
+}
+
+WaveFileWriter::~WaveFileWriter()
+{
+    close();
+}
+
+bool WaveFileWriter::write(const QString &filePath, const SamplesBuffer &buffer, quint32 sampleRate, quint8 bitDepth)
+{
+    if (!open(filePath, buffer.getChannels(), sampleRate, bitDepth, buffer.getFrameLenght()))
+        return false;
+
+    append(buffer);
+
+    return close();
+}
+
+bool WaveFileWriter::open(const QString &filePath, quint8 channels, quint32 sampleRate, quint8 bitDepth, qint64 totalFrames)
+{
+    close();
+
+    wavFile.setFileName(filePath);
     if (!wavFile.open(QFile::WriteOnly)) {
         qCritical() << "Failed to create WAV file ..." << filePath;
-        return;
+        return false;
     }
 
-    const uint samples = buffer.getFrameLenght();
-    const uint dataChunkSize = buffer.getChannels() * buffer.getFrameLenght() * bitDepth/8;// bytes per sample
-    const uint fileSize = dataChunkSize + 44; // WAVE HEADER is 44 bytes
+    this->channels = channels;
+    this->bitDepth = bitDepth;
+    this->dataChunkSize = 0;
+    this->failed = false;
 
+    // files with known size are regular WAV files when possible (the loops are read by the previous versions)
+    const quint64 dataSize = static_cast<quint64>(qMax<qint64>(totalFrames, 0)) * channels * (bitDepth / 8);
+    this->ds64Reserved = totalFrames < 0 || dataSize + 44 - 8 > MAX_RIFF_SIZE;
+
+    writeHeader(sampleRate);
+
+    return true;
+}
+
+void WaveFileWriter::writeHeader(quint32 sampleRate)
+{
     QDataStream out(&wavFile);
     out.setByteOrder(QDataStream::LittleEndian);
 
     // RIFF chunk
     out.writeRawData("RIFF", 4);
-    out << quint32(fileSize - 8); // Placeholder for the RIFF chunk size (filled by close())
+    out << quint32(0); // Placeholder for the RIFF chunk size (filled by close())
     out.writeRawData("WAVE", 4);
 
+    if (ds64Reserved) { // replaced by the ds64 chunk in close() if the file is bigger than 4 GB
+        out.writeRawData("JUNK", 4);
+        out << quint32(DS64_CHUNK_SIZE);
+        out.writeRawData(QByteArray(DS64_CHUNK_SIZE, 0).constData(), DS64_CHUNK_SIZE);
+    }
+
     const quint8 sampleSize = bitDepth;
     // Format description chunk
     out.writeRawData("fmt ", 4);
     out << quint32(16); // "fmt " chunk size (always 16 for PCM)
     out << quint16(bitDepth == 16 ? 1 : 3); // data format (1 => PCM, 3 => IEEE float) http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
-    out << quint16(buffer.getChannels());
+    out << quint16(channels);
     out << quint32(sampleRate);
-    out << quint32(sampleRate * buffer.getChannels() * sampleSize / 8 ); // bytes per second
-    out << quint16(buffer.getChannels() * sampleSize / 8); // Block align
+    out << quint32(sampleRate * channels * sampleSize / 8 ); // bytes per second
+    out << quint16(channels * sampleSize / 8); // Block align
     out << quint16(sampleSize); // Significant Bits Per Sample
 
     // Data chunk
     out.writeRawData("data", 4);
-    out << quint32(dataChunkSize); // Placeholder for the data chunk size (filled by close())
+    dataChunkSizePosition = wavFile.pos();
+    out << quint32(0); // Placeholder for the data chunk size (filled by close())
+
+    if (out.status() != QDataStream::Ok) {
+        qCritical() << "Error writing the WAV header" << wavFile.fileName() << wavFile.errorString();
+        failed = true;
+    }
+}
+
+bool WaveFileWriter::append(const SamplesBuffer &buffer)
+{
+    if (!isOpen() || failed)
+        return false;
+
+    QDataStream out(&wavFile);
+    out.setByteOrder(QDataStream::LittleEndian);
 
     //write interleaved samples
     if (bitDepth == 32)
         out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-    uint channels = buffer.getChannels();
+    const uint samples = buffer.getFrameLenght();
+    const uint bufferChannels = buffer.getChannels();
     for (uint s = 0; s < samples; ++s) {
         for (uint c = 0; c < channels; ++c) {
+            const float value = buffer.get(qMin(c, bufferChannels - 1), s); // mono buffers are duplicated in stereo files
             if (bitDepth == 16) {
-                int sample = buffer.get(c, s) * SHRT_MAX;
+                int sample = value * SHRT_MAX;
                 // hard clip
                 if (sample > SHRT_MAX)
                     sample = SHRT_MAX;
@@ -62,9 +123,80 @@ void WaveFileWriter::write(const QString &filePath, const SamplesBuffer &buffer,
                 out << quint16(sample);
             }
             else { // 32 bits
-                out << buffer.get(c, s);
+                out << value;
             }
         }
     }
 
+    dataChunkSize += static_cast<quint64>(channels) * samples * (bitDepth / 8); // bytes per sample
+
+    if (out.status() != QDataStream::Ok) { // disk full, for example
+        qCritical() << "Error writing the WAV file" << wavFile.fileName() << wavFile.errorString();
+        failed = true;
+    }
+
+    return !failed;
+}
+
+bool WaveFileWriter::close()
+{
+    if (!isOpen())
+        return false;
+
+    QDataStream out(&wavFile);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    const quint64 riffSize = dataChunkSizePosition + 4 + dataChunkSize - 8;
+
+    if (ds64Reserved && riffSize > MAX_RIFF_SIZE) { // RF64, the real sizes are stored in the ds64 chunk
+        if (wavFile.seek(0)) {
+            out.writeRawData("RF64", 4);
+            out << quint32(MAX_RIFF_SIZE);
+        }
+        else {
+            failed = true;
+        }
+
+        if (wavFile.seek(12)) {
+            out.writeRawData("ds64", 4);
+            out << quint32(DS64_CHUNK_SIZE);
+            out << quint64(riffSize);
+            out << quint64(dataChunkSize);
+            out << quint64(dataChunkSize / (channels * (bitDepth / 8))); // sample frames
+            out << quint32(0); // no table entries
+        }
+        else {
+            failed = true;
+        }
+
+        if (wavFile.seek(dataChunkSizePosition))
+            out << quint32(MAX_RIFF_SIZE);
+        else
+            failed = true;
+    }
+    else {
+        if (riffSize > MAX_RIFF_SIZE) {
+            qCritical() << "WAV file bigger than 4 GB without RF64 header" << wavFile.fileName();
+            failed = true;
+        }
+
+        if (wavFile.seek(4))
+            out << quint32(riffSize); // RIFF chunk size
+        else
+            failed = true;
+
+        if (wavFile.seek(dataChunkSizePosition))
+            out << quint32(dataChunkSize);
+        else
+            failed = true;
+    }
+
+    if (out.status() != QDataStream::Ok || !wavFile.flush()) {
+        qCritical() << "Error writing the WAV header" << wavFile.fileName() << wavFile.errorString();
+        failed = true;
+    }
+
+    wavFile.close();
+
+    return !failed;
 }
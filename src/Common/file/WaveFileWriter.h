@@ -3,16 +3,56 @@
 
 #include "FileReader.h"
 
+#include <QFile>
+
 namespace audio {
 
+/**
+ * The streamed files (open/append/close) can be longer than the 4 GB RIFF limit (long jams rendered
+ * by jamtaba-render), so a JUNK chunk is reserved after the RIFF header and replaced by a ds64 chunk
+ * when the file is closed with more than 4 GB, producing a RF64 file (EBU Tech 3306). Files smaller
+ * than 4 GB are regular WAV files.
+ */
+
 class WaveFileWriter
 {
 
 public:
-    void write(const QString &filePath, const SamplesBuffer &buffer, quint32 sampleRate, quint8 bitDepth);
+    WaveFileWriter();
+    ~WaveFileWriter();
+
+    bool write(const QString &filePath, const SamplesBuffer &buffer, quint32 sampleRate, quint8 bitDepth); // false if some write failed
+
+    // streaming API, used to write long files without keeping all samples in memory. The RF64 header is
+    // reserved when the total frames are unknown (-1) or the file will be bigger than 4 GB
+    bool open(const QString &filePath, quint8 channels, quint32 sampleRate, quint8 bitDepth, qint64 totalFrames = -1);
+    bool append(const SamplesBuffer &buffer);
+    bool close(); // fill the chunk sizes in the header, false if some write failed
+
+    bool isOpen() const;
 
+private:
+    QFile wavFile;
+    quint8 channels;
+    quint8 bitDepth;
+    quint64 dataChunkSize;
+    bool ds64Reserved;
+    qint64 dataChunkSizePosition;
+    bool failed; // some write failed since the file was opened
+
+    static const quint32 DS64_CHUNK_SIZE = 28; // RIFF size, data size, sample count (64 bits) and an empty table
+    static const quint64 MAX_RIFF_SIZE = 0xFFFFFFFF;
+
+    void writeHeader(quint32 sampleRate);
+
+    Q_DISABLE_COPY(WaveFileWriter)
 };
 
+inline bool WaveFileWriter::isOpen() const
+{
+    return wavFile.isOpen();
+}
+
 } // namespace
 
 #endif // WAVEFILEWHITER_H
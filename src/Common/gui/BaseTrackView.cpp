@@ -7,6 +7,7 @@
 #include "widgets/BoostSpinBox.h"
 #include "widgets/PeakMeter.h"
 #include "IconFactory.h"
+#include "GuiUtils.h"
 
 #include <QStyleOption>
 #include <QPainter>
@@ -263,21 +264,16 @@ void BaseTrackView::setToWide()
 
 void BaseTrackView::updateStyleSheet()
 {
-    style()->unpolish(this);
-    style()->polish(this);
+    gui::repolish(this);
 
-    style()->unpolish(levelSlider);
-    style()->polish(levelSlider);
+    gui::repolish(levelSlider);
     levelSlider->updateStyleSheet();
 
-    style()->unpolish(panSlider);
-    style()->polish(panSlider);
+    gui::repolish(panSlider);
 
-    style()->unpolish(muteButton);
-    style()->polish(muteButton);
+    gui::repolish(muteButton);
 
-    style()->unpolish(soloButton);
-    style()->polish(soloButton);
+    gui::repolish(soloButton);
 
     boostSpinBox->updateStyleSheet();
 
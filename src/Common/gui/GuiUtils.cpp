@@ -1,6 +1,7 @@
 #include "GuiUtils.h"
 
 #include <QWidget>
+#include <QStyle>
 #include <QString>
 #include <QDir>
 
@@ -51,3 +52,13 @@ void gui::clearLayout(QLayout *layout)
         delete item;
     }
 }
+
+void gui::repolish(QWidget *widget)
+{
+    if (!widget || !widget->testAttribute(Qt::WA_WState_Polished))
+        return;
+
+    QStyle *style = widget->style();
+    style->unpolish(widget);
+    style->polish(widget);
+}
@@ -4,6 +4,8 @@
 #include <QString>
 #include <QLayout>
 
+class QWidget;
+
 namespace gui {
 
     QString capitalize(const QString &string);
@@ -14,6 +16,10 @@ namespace gui {
 
     void clearLayout(QLayout *layout);
 
+    // re-apply the stylesheet after a dynamic property change. Widgets never showed are not polished yet, the
+    // property is used when the widget is polished in the first show, so the costly stylesheet matching is skipped
+    void repolish(QWidget *widget);
+
 } // namespace
 
 #endif
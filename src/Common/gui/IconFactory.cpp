@@ -4,6 +4,7 @@
 #include <QImage>
 #include <QPushButton>
 #include <QDir>
+#include <QPainter>
 
 QList<QIcon> IconFactory::getInstrumentIcons()
 {
@@ -142,6 +143,29 @@ QIcon IconFactory::createLooperResetIcon(const QColor &tintColor)
     return QIcon(QPixmap::fromImage(image));
 }
 
+QIcon IconFactory::createLoopThumbnailIcon(const QVector<float> &peaks, const QColor &tintColor)
+{
+    static const int WIDTH = 64;
+    static const int HEIGHT = 16;
+
+    QPixmap pixmap(WIDTH, HEIGHT);
+    pixmap.fill(Qt::transparent);
+
+    if (!peaks.isEmpty()) {
+        QPainter painter(&pixmap);
+        painter.setPen(tintColor);
+
+        const int center = HEIGHT / 2;
+        for (int x = 0; x < WIDTH; ++x) {
+            const float peak = peaks.at(x * peaks.size() / WIDTH);
+            const int peakHeight = qMax(1, static_cast<int>(peak * center));
+            painter.drawLine(x, center - peakHeight, x, center + peakHeight - 1);
+        }
+    }
+
+    return QIcon(pixmap);
+}
+
 QIcon IconFactory::createLooperSaveIcon(const QColor &tintColor)
 {
     QImage image(":/images/save.png");
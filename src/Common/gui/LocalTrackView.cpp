@@ -333,9 +333,7 @@ void LocalTrackView::updateStyleSheet()
 
     buttonLooper->setIcon(IconFactory::createLooperButtonIcon(getTintColor()));
 
-    style()->unpolish(buttonStereoInversion); // this is necessary to change the stereo inversion button colors when the transmit button is clicled
-    style()->polish(buttonStereoInversion);
+    gui::repolish(buttonStereoInversion); // this is necessary to change the stereo inversion button colors when the transmit button is clicled
 
-    style()->unpolish(buttonLooper);
-    style()->polish(buttonLooper);
+    gui::repolish(buttonLooper);
 }
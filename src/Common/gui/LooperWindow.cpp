@@ -7,6 +7,7 @@
 #include "persistence/Settings.h"
 #include "file/FileUtils.h"
 #include "IconFactory.h"
+#include "looper/LooperPagePool.h"
 //#include "looper/LooperPersistence.h"
 
 #include <QGridLayout>
@@ -18,6 +19,7 @@
 #include <QStandardItemModel>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
 
 using controller::MainController;
 using controller::NinjamController;
@@ -30,7 +32,9 @@ LooperWindow::LooperWindow(QWidget *parent, MainController *mainController) :
     ui(new Ui::LooperWindow),
     mainController(mainController),
     looper(nullptr),
-    currentBeat(-1)
+    currentBeat(-1),
+    memoryUsageLabel(new QLabel()),
+    progressDialog(nullptr)
 {
     setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint); // remove help/question marker
 
@@ -57,6 +61,10 @@ LooperWindow::LooperWindow(QWidget *parent, MainController *mainController) :
     ui->widgetBottom->layout()->setAlignment(ui->modeControlsLayout, Qt::AlignBottom);
     ui->widgetBottom->layout()->setAlignment(ui->layerControlsLayout, Qt::AlignBottom);
 
+    memoryUsageLabel->setObjectName(QStringLiteral("memoryUsageLabel"));
+    ui->widgetBottom->layout()->addWidget(memoryUsageLabel);
+    ui->widgetBottom->layout()->setAlignment(memoryUsageLabel, Qt::AlignBottom);
+    updateMemoryUsageLabel();
 
     QMenu *loadMenu = new QMenu();
     ui->loadButton->setMenu(loadMenu);
@@ -71,6 +79,9 @@ LooperWindow::LooperWindow(QWidget *parent, MainController *mainController) :
         float gain = Utils::linearGainToPower(value/100.0);
         looper->setMainGain(gain);
     });
+
+    connect(&saveWatcher, &QFutureWatcher<bool>::finished, this, &LooperWindow::finishSaving);
+    connect(&loadWatcher, &QFutureWatcher<audio::SamplesBuffer>::finished, this, &LooperWindow::finishLoading);
 }
 
 void LooperWindow::setTintColor(const QColor &color)
@@ -207,10 +218,37 @@ void LooperWindow::updateDrawings()
     // update peak meters
     AudioPeak lastPeak = looper->getLastPeak();
     ui->mainLevelSlider->setPeak(lastPeak.getLeftPeak(), lastPeak.getRightPeak(), lastPeak.getLeftRMS(), lastPeak.getRightRMS());
+
+    updateMemoryUsageLabel();
+}
+
+void LooperWindow::updateMemoryUsageLabel()
+{
+    auto pool = audio::LooperPagePool::getInstance();
+
+    static const qreal BYTES_PER_MB = 1024.0 * 1024.0;
+    qreal usedMemory = pool->getUsedMemory() / BYTES_PER_MB;
+    qreal memoryBudget = pool->getMemoryBudget() / BYTES_PER_MB;
+
+    QString text = tr("Memory: %1/%2 MB").arg(QString::number(usedMemory, 'f', 1)).arg(QString::number(memoryBudget, 'f', 0));
+    if (text == memoryUsageLabel->text())
+        return;
+
+    memoryUsageLabel->setText(text);
+
+    bool budgetExceeded = pool->budgetWasExceeded();
+    memoryUsageLabel->setProperty("budgetExceeded", budgetExceeded); // used in CSS
+    memoryUsageLabel->setToolTip(budgetExceeded ? tr("The looper memory budget was exceeded, some recorded audio was discarded!") : tr("Memory used by all loopers"));
+
+    style()->unpolish(memoryUsageLabel);
+    style()->polish(memoryUsageLabel);
 }
 
 void LooperWindow::detachCurrentLooper()
 {
+    finishSavingInBackground();
+    cancelLoading();
+
     if (looper) {
         disconnectLooperSignals();
         looper = nullptr;
@@ -447,6 +485,8 @@ void LooperWindow::resetAll()
     looper->resetLayersContent();
     resetLayersControls();
 
+    audio::LooperPagePool::getInstance()->resetBudgetExceededFlag();
+
     looper->setLoopName("");
 }
 
@@ -491,8 +531,8 @@ void LooperWindow::updateControls()
 
         updateMaxLayersControls();
 
-        ui->saveButton->setEnabled(looper->canSave());
-        ui->loadButton->setEnabled(looper->isStopped());
+        ui->saveButton->setEnabled(looper->canSave() && !isSavingOrLoading());
+        ui->loadButton->setEnabled(looper->isStopped() && !isSavingOrLoading());
 
         ui->resetButton->setEnabled(looper->isStopped() || looper->isPlaying());
 
@@ -625,6 +665,9 @@ void LooperWindow::deleteWavePanels()
 
 LooperWindow::~LooperWindow()
 {
+    finishSavingInBackground();
+    cancelLoading();
+
     delete ui;
 
     deleteWavePanels();
@@ -740,7 +783,7 @@ void LooperWindow::initializeControls()
 
 void LooperWindow::showSaveDialogs()
 {
-    if(!looper || !mainController->isPlayingInNinjamRoom())
+    if(!looper || !mainController->isPlayingInNinjamRoom() || isSavingOrLoading())
         return;
 
     QString loopFileName = looper->getLoopName();
@@ -776,16 +819,112 @@ void LooperWindow::showSaveDialogs()
     uint bpi = ninjamController->getCurrentBpi();
     quint8 bitDepth = mainController->getLooperBitDepth();
 
-    LoopSaver loopSaver(savePath, looper);
+    loopSaver.reset(new LoopSaver(savePath, looper));
 
     loopFileName = file::sanitizeFileName(loopFileName);
-    loopSaver.save(loopFileName, bpm, bpi, encodeInOggVorbis, vorbisQuality, sampleRate, bitDepth);
+    auto future = loopSaver->save(loopFileName, bpm, bpi, encodeInOggVorbis, vorbisQuality, sampleRate, bitDepth);
 
-    looper->setLoopName(loopFileName);
+    showProgressDialog(tr("Saving %1 ...").arg(loopFileName), loopSaver->getLayersCount());
+    connect(progressDialog, &QProgressDialog::canceled, [=](){
+        if (loopSaver)
+            loopSaver->cancel();
+    });
+
+    saveWatcher.setFuture(future);
 
     updateControls();
 }
 
+void LooperWindow::finishSaving()
+{
+    if (!loopSaver)
+        return;
+
+    hideProgressDialog();
+
+    bool saved = loopSaver->finishSaving();
+    if (saved)
+        mainController->getLoopLibrary()->update(); // overwritten json files are not always notified by the file system watcher
+
+    if (saved && looper)
+        looper->setLoopName(loopSaver->getLoopFileName());
+    else if (!loopSaver->isCanceled())
+        QMessageBox::warning(this, tr("Error saving the loop!"), tr("Can't save the loop '%1'").arg(loopSaver->getLoopFileName()));
+
+    loopSaver.reset();
+
+    if (looper)
+        updateControls();
+}
+
+bool LooperWindow::isSavingOrLoading() const
+{
+    return !loopSaver.isNull() || !loopLoader.isNull();
+}
+
+void LooperWindow::showProgressDialog(const QString &labelText, int layers)
+{
+    hideProgressDialog();
+
+    progressDialog = new QProgressDialog(labelText, tr("Cancel"), 0, layers, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(500); // fast saving/loading will not show the dialog
+    progressDialog->setValue(0);
+
+    connect(&saveWatcher, &QFutureWatcher<bool>::progressValueChanged, progressDialog, &QProgressDialog::setValue);
+    connect(&loadWatcher, &QFutureWatcher<audio::SamplesBuffer>::progressValueChanged, progressDialog, &QProgressDialog::setValue);
+}
+
+void LooperWindow::hideProgressDialog()
+{
+    if (progressDialog) {
+        progressDialog->disconnect(); // avoid the 'canceled' signal when the dialog is closed
+        progressDialog->close();
+        progressDialog->deleteLater();
+        progressDialog = nullptr;
+    }
+}
+
+void LooperWindow::finishSavingInBackground()
+{
+    if (!loopSaver)
+        return;
+
+    Q_ASSERT(mainController);
+
+    hideProgressDialog();
+
+    // the saver outlives the window, the looper can be deleted before the layers are saved
+    auto saver = loopSaver.take();
+    saver->detachLooper();
+
+    QFuture<bool> future = saveWatcher.future();
+    saveWatcher.setFuture(QFuture<bool>()); // stop watching the saver future, loopSaver is null in finishSaving()
+
+    auto loopLibrary = mainController->getLoopLibrary();
+    auto watcher = new QFutureWatcher<bool>();
+    connect(watcher, &QFutureWatcher<bool>::finished, loopLibrary, [=]() {
+        if (saver->finishSaving())
+            loopLibrary->update();
+        else if (!saver->isCanceled())
+            qCritical() << "Can't save the loop" << saver->getLoopFileName();
+
+        delete saver;
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(future);
+}
+
+void LooperWindow::cancelLoading()
+{
+    if (loopLoader) {
+        loopLoader->cancel();
+        loadWatcher.waitForFinished();
+        finishLoading();
+    }
+}
+
 QString LooperWindow::getOptionName(Looper::RecordingOption option)
 {
     switch (option) {
@@ -879,16 +1018,19 @@ void LooperWindow::showLoadMenu()
     quint16 currentBpm = ninjamController->getCurrentBpm();
 
     QString loopsDir = mainController->getSettings().getLooperSavePath();
-    QList<LoopInfo> loopsInfos = LoopLoader::loadLoopsInfo(loopsDir, currentBpm);
+    auto loopLibrary = mainController->getLoopLibrary();
+    QList<audio::LoopLibraryEntry> loops = loopLibrary->getLoops(currentBpm); // served from the library index, no json parsing here
 
-    QString matchedMenuText = (!loopsInfos.isEmpty()) ? (tr("%1 BPM loops").arg(currentBpm)) : (tr("No loops for %1 BPM").arg(currentBpm));
+    QString matchedMenuText = (!loops.isEmpty()) ? (tr("%1 BPM loops").arg(currentBpm)) : (tr("No loops for %1 BPM").arg(currentBpm));
     QMenu *bpmMatchedMenu = new QMenu(matchedMenuText);
     menu->addMenu(bpmMatchedMenu);
-    for (const LoopInfo &loopInfo : loopsInfos) {
-        QString loopString = loopInfo.toString();
-        QAction *action = bpmMatchedMenu->addAction(loopString);
+    for (const audio::LoopLibraryEntry &loop : loops) {
+        const LoopInfo loopInfo = loop.getLoopInfo();
+        const QString loopDir = QFileInfo(loop.getFilePath()).absolutePath();
+        QIcon thumbnail = IconFactory::createLoopThumbnailIcon(loop.getThumbnail(), tintColor);
+        QAction *action = bpmMatchedMenu->addAction(thumbnail, loopInfo.toString());
         connect(action, &QAction::triggered, [=](){
-            loadLoopInfo(loopsDir, loopInfo);
+            loadLoopInfo(loopDir, loopInfo);
         });
     }
 
@@ -999,24 +1141,52 @@ void LooperWindow::updateLayersControls()
 
 void LooperWindow::loadLoopInfo(const QString &loopDir, const LoopInfo &loopInfo)
 {
-    if (loopInfo.isValid()) {
+    if (isSavingOrLoading())
+        return;
 
-        ui->loopNameLabel->setText("");
+    if (loopInfo.isValid()) {
 
-        LoopLoader loader(loopDir);
+        loopLoader.reset(new LoopLoader(loopDir));
         uint currentSampleRate = mainController->getSampleRate();
         quint32 samplesPerInterval = mainController->getNinjamController()->getSamplesPerInterval();
-        loader.load(loopInfo, looper, currentSampleRate, samplesPerInterval);
+        auto future = loopLoader->load(loopInfo, currentSampleRate, samplesPerInterval);
+
+        showProgressDialog(tr("Loading %1 ...").arg(loopInfo.getName()), loopInfo.getLayersCount());
+        connect(progressDialog, &QProgressDialog::canceled, [=](){
+            if (loopLoader)
+                loopLoader->cancel();
+        });
+
+        loadWatcher.setFuture(future);
+
+        updateControls();
+    }
+    else {
+        qCritical() << "Can't load loop " << loopInfo.getName() << " in " << loopDir;
+    }
+}
+
+void LooperWindow::finishLoading()
+{
+    if (!loopLoader)
+        return;
+
+    hideProgressDialog();
+
+    if (looper && !loopLoader->isCanceled()) {
+        loopLoader->finishLoading(looper);
 
         updateLayersControls(); // update layers pan and gain after loading a loop
 
         updateModeComboBox();
 
-        ui->loopNameLabel->setText(loopInfo.getName());
+        ui->loopNameLabel->setText(loopLoader->getLoopInfo().getName());
 
         update();
     }
-    else {
-        qCritical() << "Can't load loop " << loopInfo.getName() << " in " << loopDir;
-    }
+
+    loopLoader.reset();
+
+    if (looper)
+        updateControls();
 }
@@ -9,6 +9,8 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QScopedPointer>
 
 #include "looper/Looper.h"
 #include "looper/LooperPersistence.h"
@@ -26,6 +28,8 @@ namespace Ui {
 class LooperWindow;
 }
 
+class QProgressDialog;
+
 using audio::Looper;
 using audio::LooperLayer;
 using audio::LooperState;
@@ -69,6 +73,9 @@ private slots:
 
     void showSaveDialogs();
 
+    void finishSaving();
+    void finishLoading();
+
 private:
     Ui::LooperWindow *ui;
     Looper *looper;
@@ -201,12 +208,29 @@ private:
 
     void updateButtons();
 
+    void updateMemoryUsageLabel();
+
     void connectLooperSignals();
     void disconnectLooperSignals();
 
     int currentBeat;
 
     QColor tintColor;
+
+    QLabel *memoryUsageLabel; // memory used by all loopers and the memory budget
+
+    // loops are saved and loaded in background, only one saving or loading at time
+    QScopedPointer<LoopSaver> loopSaver;
+    QScopedPointer<audio::LoopLoader> loopLoader;
+    QFutureWatcher<bool> saveWatcher;
+    QFutureWatcher<audio::SamplesBuffer> loadWatcher;
+    QProgressDialog *progressDialog;
+
+    bool isSavingOrLoading() const;
+    void showProgressDialog(const QString &labelText, int layers);
+    void hideProgressDialog();
+    void finishSavingInBackground(); // the loop is saved even if the looper is detached or the window is closed
+    void cancelLoading(); // cancel and wait
 };
 
 Q_DECLARE_METATYPE(audio::Looper::RecordingOption)
@@ -16,6 +16,7 @@
 #include "chords/ChordProgressionCreationDialog.h"
 #include "widgets/BlinkableButton.h"
 #include "InactivityDetector.h"
+#include "RepaintScheduler.h"
 #include "IconFactory.h"
 #include "ThemeLoader.h"
 #include "Highligther.h"
@@ -27,6 +28,7 @@
 #include "UsersColorsPool.h"
 #include "screensaver/ScreensaverBlocker.h"
 #include "log/Logging.h"
+#include "log/StartupProfiler.h"
 #include "audio/core/LocalInputNode.h"
 #include "audio/RoomStreamerNode.h"
 #include "performance/PerformanceMonitor.h"
@@ -93,6 +95,7 @@ MainWindow::MainWindow(MainController *mainController, QWidget *parent) :
     screensaverBlocker(new ScreensaverBlocker()),
     usersColorsPool(new UsersColorsPool()),
     mainChat(new MainChat()),
+    repaintScheduler(new RepaintScheduler(this)),
     ninjamWindow(nullptr),
     roomToJump(nullptr),
     performanceMonitor(new PerformanceMonitor()),
@@ -332,12 +335,12 @@ void MainWindow::changeCameraStatus(bool activated)
     if (!videoFrameGrabber) {
         videoFrameGrabber = new CameraFrameGrabber(this);
 
-        connect(videoFrameGrabber, &CameraFrameGrabber::frameAvailable, [=](const QImage &frame) {
+        videoFrameGrabber->setFrameRate(MainController::CAMERA_FPS);
 
-            if (mainController && !mainController->isPlayingInNinjamRoom()) {
-                if (cameraView)
-                    cameraView->setCurrentFrame(frame);
-            }
+        connect(videoFrameGrabber, &CameraFrameGrabber::frameAvailable, [=]() {
+
+            if (mainController && !mainController->isPlayingInNinjamRoom())
+                updateCameraPreview();
 
         });
     }
@@ -424,22 +427,32 @@ bool MainWindow::cameraIsActivated() const
     return cameraView && cameraView->isActivated();
 }
 
-QImage MainWindow::pickCameraFrame() const
+void MainWindow::updateCameraPreview() const
 {
-    if (videoFrameGrabber && cameraView) {
-        auto frame = videoFrameGrabber->grab();
-        cameraView->setCurrentFrame(frame);
+    if (!videoFrameGrabber || !cameraView || !cameraView->isActivated())
+        return;
 
-        // scale the grabed frame if is bigger than MAX_VIDEO_SIZE. This is necessary because some cameras
-        // have only big resolutions, and we have problems sensing big resolution videos to ninjam servers.
+    // the camera frame is converted straight to the preview size
+    QSize previewSize = cameraView->getScaledFrameSize(videoFrameGrabber->grabFrame().size());
+    cameraView->setCurrentFrame(videoFrameGrabber->grab(previewSize));
+}
 
-        if (frame.width() > MainController::MAX_VIDEO_SIZE.width())
-            return frame.scaled(mainController->getVideoResolution(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+QVideoFrame MainWindow::pickCameraFrame() const
+{
+    if (videoFrameGrabber && cameraView) {
+        updateCameraPreview();
 
-        return frame;
+        // the frame is encoded in the camera native pixel format. Frames bigger than MAX_VIDEO_SIZE (some cameras
+        // have only big resolutions) are scaled to the video resolution by the encoder.
+        return videoFrameGrabber->grabFrame();
     }
 
-    return QImage();
+    return QVideoFrame();
+}
+
+bool MainWindow::cameraFrameIsFlipped() const
+{
+    return videoFrameGrabber && videoFrameGrabber->isFlippedVertically();
 }
 
 void MainWindow::initializeMeteringOptions()
@@ -647,7 +660,30 @@ void MainWindow::initializeGuiRefreshTimer()
     else if (refreshRate > MAX_REFRESH_RATE)
         refreshRate = MAX_REFRESH_RATE;
 
-    timerID = startTimer(1000/refreshRate); // timer used to animate audio peaks, midi activity, public room wave audio plot, etc.
+    // used to animate audio peaks, midi activity, public room wave audio plot, etc.
+    repaintScheduler->setFrameRate(refreshRate);
+    initializeRepaintSources();
+    repaintScheduler->start();
+}
+
+void MainWindow::initializeRepaintSources()
+{
+    connect(repaintScheduler, &RepaintScheduler::frameStarted, this, &MainWindow::processGuiFrame);
+
+    // local input tracks are updated even when the window is minimized, the plugins idle is called here
+    repaintScheduler->addSource(this, [this]() {
+        for (TrackGroupView *channel : localGroupChannels)
+            channel->updateGuiElements();
+    }, true);
+
+    repaintScheduler->addSource(ui.masterFader, [this]() {
+        if (!mainController)
+            return;
+
+        auto masterPeak = mainController->getMasterPeak();
+        ui.masterFader->setPeak(masterPeak.getLeftPeak(), masterPeak.getRightPeak(),
+                                masterPeak.getLeftRMS(), masterPeak.getRightRMS());
+    });
 }
 
 void MainWindow::initialize()
@@ -662,6 +698,7 @@ void MainWindow::initialize()
     initializeGuiRefreshTimer();
 
     if (qApp->styleSheet().isEmpty()) { // allow custom stylesheet via app arguments
+        StartupSpan span("theme");
         QString themeName = mainController->getTheme();
         QString themesDir = Configurator::getInstance()->getThemesDir().absolutePath();
         if(!theme::Loader::canLoad(themesDir, themeName))
@@ -671,7 +708,10 @@ void MainWindow::initialize()
 
     showBusyDialog(tr("Loading rooms list ..."));
 
-    doWindowInitialization();
+    {
+        StartupSpan span("window initialization");
+        doWindowInitialization();
+    }
 
     auto localChannels = getLocalChannels<LocalTrackGroupView *>();
     Q_ASSERT(!localChannels.isEmpty());
@@ -689,7 +729,10 @@ void MainWindow::initialize()
         setBottomCollapsedStatus(settings.isBottomSectionCollapsed());
 
     auto publicChatActivated = settings.publicChatIsActivated();
-    createMainChat(publicChatActivated);
+    {
+        StartupSpan span("main chat");
+        createMainChat(publicChatActivated);
+    }
 
 }
 
@@ -986,6 +1029,9 @@ void MainWindow::openLooperWindow(uint trackID)
         if (!looperWindow) {
             looperWindow = new LooperWindow(this, mainController);
             looperWindows.insert(trackID, looperWindow);
+            repaintScheduler->addSource(looperWindow, [looperWindow]() {
+                looperWindow->updateDrawings(); // sound waves, only when the looper window is visible
+            });
             looperWindow->setTintColor(getTintColor());
         }
 
@@ -1310,6 +1356,12 @@ void MainWindow::enterInRoom(const login::RoomInfo &roomInfo)
     qCDebug(jtGUI) << "creating NinjamRoomWindow...";
     ninjamWindow.reset(createNinjamWindow(roomInfo, mainController));
 
+    // tracks and metronome peaks are not updated when the ninjam tab is hidden
+    repaintScheduler->addSource(ninjamWindow.data(), [this]() {
+        if (mainController && mainController->isPlayingInNinjamRoom())
+            ninjamWindow->updatePeaks();
+    });
+
     auto tabText = QString("%1 [%2]").arg(roomInfo.getName()).arg(roomInfo.getPort());
     auto index = ui.contentTabWidget->addTab(ninjamWindow.data(), tabText);
     ui.contentTabWidget->setCurrentIndex(index);
@@ -1922,6 +1974,38 @@ void MainWindow::sendChatMessageToNinjamServer(const QString &msg)
         ninjamController->sendChatMessage(msg);
 }
 
+void MainWindow::showFeedbackAboutUploadQuality(int qualityLevel, bool qualityDecreased)
+{
+    // the transmit label can be styled in themes when the upload quality is reduced
+    transmitTransferRateLabel->setProperty("uploadQualityReduced", qualityLevel > 0);
+    style()->unpolish(transmitTransferRateLabel);
+    style()->polish(transmitTransferRateLabel);
+
+    auto chatPanel = ui.chatTabWidget->getNinjamServerChat();
+    if (!chatPanel)
+        return;
+
+    QString message;
+    if (qualityDecreased)
+        message = tr("Your upload is too slow, the audio and video quality was reduced in the next intervals");
+    else if (qualityLevel > 0)
+        message = tr("Your upload is better, the audio and video quality was increased in the next intervals");
+    else
+        message = tr("Your upload is fine, using your audio and video quality again");
+
+    chatPanel->addMessage(mainController->getUserName(), JAMTABA_CHAT_BOT_NAME, message);
+}
+
+void MainWindow::showFeedbackAboutDroppedRecording(qint64 droppedBytes)
+{
+    auto chatPanel = ui.chatTabWidget->getNinjamServerChat();
+    if (!chatPanel)
+        return;
+
+    QString message = tr("Your disk is too slow, %1 KB of the multi track recording was lost in the last interval").arg(qMax(droppedBytes / 1024, qint64(1)));
+    chatPanel->addMessage(mainController->getUserName(), JAMTABA_CHAT_BOT_NAME, message);
+}
+
 void MainWindow::showFeedbackAboutBlockedUserInChat(const QString &userFullName)
 {
     // remote all blocked user messages
@@ -2083,22 +2167,11 @@ void MainWindow::setInputTracksPreparingStatus(bool preparing)
     }
 }
 
-void MainWindow::timerEvent(QTimerEvent *)
+void MainWindow::processGuiFrame()
 {
     if (!mainController)
         return;
 
-    // update local input track peaks
-    for (TrackGroupView *channel : localGroupChannels)
-        channel->updateGuiElements();
-
-    // update metronome peaks
-    if (mainController->isPlayingInNinjamRoom()) {
-        // update tracks peaks
-        if (ninjamWindow)
-            ninjamWindow->updatePeaks();
-    }
-
     // update cpu and RAM usage
     qint64 now = QDateTime::currentMSecsSinceEpoch();
     if (now - lastPerformanceMonitorUpdate >= PERFORMANCE_MONITOR_REFRESH_TIME) {
@@ -2122,6 +2195,12 @@ void MainWindow::timerEvent(QTimerEvent *)
 
                    performanceMonitorLabel->setVisible(showMemmory || showBattery);
 
+                   performanceMonitorLabel->setToolTip(tr("GUI: %1 ms per frame (max %2 ms) at %3 fps")
+                                                       .arg(QString::number(repaintScheduler->getAverageFrameTime(), 'f', 2))
+                                                       .arg(QString::number(repaintScheduler->getMaxFrameTime(), 'f', 2))
+                                                       .arg(repaintScheduler->getCurrentFrameRate()));
+                   repaintScheduler->resetMaxFrameTime();
+
                }
 
         lastPerformanceMonitorUpdate = now;
@@ -2148,18 +2227,6 @@ void MainWindow::timerEvent(QTimerEvent *)
         }
     }
 
-    // update looper window sound waves
-    for (auto looperWindow : looperWindows.values()) {
-        if (looperWindow && looperWindow->isVisible()) {
-            looperWindow->updateDrawings();
-        }
-    }
-
-    // update master peaks
-    auto masterPeak = mainController->getMasterPeak();
-    ui.masterFader->setPeak(masterPeak.getLeftPeak(), masterPeak.getRightPeak(),
-                            masterPeak.getLeftRMS(), masterPeak.getRightRMS());
-
     // update all blinkable buttons
     BlinkableButton::updateAllBlinkableButtons();
 
@@ -2180,6 +2247,12 @@ void MainWindow::timerEvent(QTimerEvent *)
             QString transmitText = QString("%1 %2 Kbps")
                                             .arg(tr("Uploading"))
                                             .arg(transmitTransferRate);
+            const int uploadQualityLevel = mainController->getUploadQualityLevel();
+            if (uploadQualityLevel > 0)
+                transmitText += "\n" + tr("Quality reduced (level %1 of %2), %3 ms waiting to upload")
+                                                .arg(uploadQualityLevel)
+                                                .arg(UploadBitrateController::MAX_LEVEL)
+                                                .arg(mainController->getUploadQueueDelay());
             transmitTransferRateLabel->setToolTip(transmitText);
             transmitIcon->setToolTip(transmitTransferRateLabel->toolTip());
 
@@ -2284,7 +2357,7 @@ MainWindow::~MainWindow()
 
     mainController = nullptr;
 
-    killTimer(timerID);
+    repaintScheduler->stop();
     qCDebug(jtGUI) << "Main frame timer killed!";
     qCDebug(jtGUI) << "MainWindow destructor finished.";
 }
@@ -2427,6 +2500,8 @@ void MainWindow::setupPreferencesDialogSignals(PreferencesDialog *dialog)
 
     connect(dialog, &PreferencesDialog::jamDateFormatChanged, this, &MainWindow::setJamDirectoryDateFormat);
 
+    connect(dialog, &PreferencesDialog::continuousTrackFilesChanged, mainController, &MainController::storeRecordingContinuousTrackFiles);
+
     connect(dialog, &PreferencesDialog::builtInMetronomeSelected, this, &MainWindow::setBuiltInMetronome);
 
     connect(dialog, &PreferencesDialog::customMetronomeSelected, this, &MainWindow::setCustomMetronome);
@@ -2852,6 +2927,8 @@ void MainWindow::setupSignals()
 
     connect(mainController, &MainController::userBlockedInChat, this, &MainWindow::showFeedbackAboutBlockedUserInChat);
     connect(mainController, &MainController::userUnblockedInChat, this, &MainWindow::showFeedbackAboutUnblockedUserInChat);
+    connect(mainController, &MainController::uploadQualityChanged, this, &MainWindow::showFeedbackAboutUploadQuality);
+    connect(mainController, &MainController::recordingDataDropped, this, &MainWindow::showFeedbackAboutDroppedRecording);
 
     ui.contentTabWidget->installEventFilter(this);
 
@@ -29,6 +29,7 @@ class ScreensaverBlocker;
 class PerformanceMonitor;
 class TextEditorModifier;
 class PrivateServerWindow;
+class RepaintScheduler;
 
 namespace login {
 class RoomInfo;
@@ -107,7 +108,8 @@ public:
 
     virtual TextEditorModifier *createTextEditorModifier() = 0;
 
-    QImage pickCameraFrame() const;
+    QVideoFrame pickCameraFrame() const; // camera frame in native pixel format, the preview is updated
+    bool cameraFrameIsFlipped() const;
 
     bool cameraIsActivated() const;
 
@@ -133,6 +135,8 @@ public slots:
 
     void showFeedbackAboutBlockedUserInChat(const QString &userFullName);
     void showFeedbackAboutUnblockedUserInChat(const QString &userFullName);
+    void showFeedbackAboutUploadQuality(int qualityLevel, bool qualityDecreased);
+    void showFeedbackAboutDroppedRecording(qint64 droppedBytes);
 
     void addNinjamServerChatMessage(const User &, const QString &message);
     void addPrivateChatMessage(const User &, const QString &message);
@@ -182,7 +186,6 @@ protected:
 
     void closeEvent(QCloseEvent *) override;
     void changeEvent(QEvent *) override;
-    void timerEvent(QTimerEvent *) override;
     void resizeEvent(QResizeEvent *) override;
 
     virtual void doWindowInitialization();
@@ -270,6 +273,8 @@ protected slots:
 
 private slots:
 
+    void processGuiFrame(); // non visual tasks executed in all GUI frames
+
     void showJamtabaCurrentVersion();
 
     void refreshPublicRoomsList(const QList<login::RoomInfo> &publicRooms);
@@ -376,7 +381,8 @@ private:
 
     void wireNinjamSignals();
 
-    int timerID; // timer used to refresh the entire GUI: animations, peak meters, etc
+    RepaintScheduler *repaintScheduler; // used to refresh the entire GUI: animations, peak meters, etc
+    void initializeRepaintSources();
     static const quint8 DEFAULT_REFRESH_RATE;
     static const quint8 MAX_REFRESH_RATE;
 
@@ -421,6 +427,7 @@ private:
     void initializeGuiRefreshTimer();
 
     void initializeCameraWidget();
+    void updateCameraPreview() const;
 
     QCamera::FrameRateRange getBestSupportedFrameRate() const;
     QSize getBestCameraResolution(const QList<QSize> resolutions) const;
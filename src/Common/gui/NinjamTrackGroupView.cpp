@@ -7,10 +7,8 @@
 #include "MainWindow.h"
 
 #include <QMenu>
-#include <QDateTime>
 #include <QLayout>
 #include <QStackedLayout>
-#include <QtConcurrent>
 
 const uint NinjamTrackGroupView::MAX_WIDTH_IN_GRID_LAYOUT = 350;
 const uint NinjamTrackGroupView::MAX_HEIGHT_IN_GRID_LAYOUT = 210;
@@ -26,6 +24,8 @@ NinjamTrackGroupView::NinjamTrackGroupView(MainController *mainController, long
     mainController(mainController),
     userIP(initialValues.getUserIP()),
     tracksLayoutEnum(TracksLayout::VerticalLayout),
+    videoDecoder(nullptr),
+    nextVideoDecoder(nullptr),
     videoFrameRate(10),
     intervalsWithoutReceiveVideo(0)
 {
@@ -131,26 +131,30 @@ void NinjamTrackGroupView::addVideoInterval(const QByteArray &encodedVideoData)
         }
     }
 
-    FFMpegDemuxer *videoDecoder = new FFMpegDemuxer(this, encodedVideoData);
-    connect(videoDecoder, &FFMpegDemuxer::imagesDecoded, this, [=](QList<QImage> images, uint frameRate){
-        if (!images.isEmpty()) {
-            videoFrameRate = frameRate;
-            decodedImages << images;
+    deleteVideoDecoder(nextVideoDecoder); // keep just the last received interval
 
-            videoDecoder->deleteLater();
-        }
-    });
+    // the first frames are decoded now, the other frames are decoded just in time when the interval is played
+    nextVideoDecoder = new FFMpegDemuxer(this, encodedVideoData);
+    nextVideoDecoder->start();
+}
 
-    QtConcurrent::run(videoDecoder, &FFMpegDemuxer::decode);
+void NinjamTrackGroupView::deleteVideoDecoder(FFMpegDemuxer *&decoder)
+{
+    if (decoder) {
+        delete decoder; // the decoding worker is stopped in destructor
+        decoder = nullptr;
+    }
 }
 
 void NinjamTrackGroupView::startVideoStream()
 {
-    lastVideoRender = 0;
+    videoClock.start();
 
-    if (!decodedImages.isEmpty()) {
-        while (decodedImages.size() > 1)
-            decodedImages.removeFirst(); // keep just the last decoded interval
+    deleteVideoDecoder(videoDecoder);
+
+    if (nextVideoDecoder) {
+        videoDecoder = nextVideoDecoder;
+        nextVideoDecoder = nullptr;
     }
     else {
         intervalsWithoutReceiveVideo++;
@@ -463,25 +467,23 @@ void NinjamTrackGroupView::updateGuiElements()
     userNameLabel->updateMarquee();
 
     // video
-    if (!decodedImages.isEmpty()) {
-        quint64 now = QDateTime::currentMSecsSinceEpoch();
-
-        quint64 timePerFrame = 1000 / videoFrameRate;
-        quint64 diff = now - lastVideoRender;
-        if (diff >= timePerFrame) { // time to show a new video frame?
-            lastVideoRender = now - (diff % timePerFrame);
-            auto &currentImages = decodedImages.first();
-            if (!currentImages.isEmpty()) {
-                updateVideoFrame(currentImages.takeFirst());
-            }
-            else {
-                decodedImages.removeFirst(); // avoid show the last received frame forever
-            }
-        }
+    if (videoDecoder) {
+        if (videoDecoder->getFrameRate() > 0)
+            videoFrameRate = videoDecoder->getFrameRate();
+
+        // the frame index is computed from the interval position
+        uint frameIndex = videoClock.elapsed() * videoFrameRate / 1000;
+        QSize frameSize = videoWidget->getScaledFrameSize(videoDecoder->getVideoSize());
+        QImage frame = videoDecoder->takeFrame(frameIndex, frameSize); // converted and scaled in one pass
+        if (!frame.isNull())
+            updateVideoFrame(frame);
+        else if (videoDecoder->isFinished())
+            deleteVideoDecoder(videoDecoder); // avoid show the last received frame forever
     }
 }
 
 NinjamTrackGroupView::~NinjamTrackGroupView()
 {
-    //
+    deleteVideoDecoder(nextVideoDecoder);
+    deleteVideoDecoder(videoDecoder);
 }
@@ -8,6 +8,7 @@
 
 #include <QLabel>
 #include <QBoxLayout>
+#include <QElapsedTimer>
 
 namespace controller {
 class MainController;
@@ -17,6 +18,8 @@ namespace persistence {
 class CacheEntry;
 }
 
+class FFMpegDemuxer;
+
 enum class TracksLayout
 {
     VerticalLayout,
@@ -73,11 +76,14 @@ private:
 
     VideoWidget *videoWidget;
     QByteArray encodedVideoData;
-    quint64 lastVideoRender;
-    QList<QList<QImage>> decodedImages;
+    FFMpegDemuxer *videoDecoder; // decoding and showing the last received interval
+    FFMpegDemuxer *nextVideoDecoder; // decoding the interval received in the current interval
+    QElapsedTimer videoClock; // interval position used to pace the video frames
     uint videoFrameRate;
     uint intervalsWithoutReceiveVideo;
 
+    void deleteVideoDecoder(FFMpegDemuxer *&decoder);
+
     void setupHorizontalLayout();
     void setupVerticalLayout();
     void setupGridLayout();
@@ -1,4 +1,5 @@
 #include "NinjamTrackView.h"
+#include "GuiUtils.h"
 
 #include <QLineEdit>
 #include <QLabel>
@@ -203,11 +204,9 @@ QString NinjamTrackView::getLowCutStateText() const
 
 void NinjamTrackView::updateStyleSheet()
 {
-    style()->unpolish(buttonLowCut);
-    style()->polish(buttonLowCut);
+    gui::repolish(buttonLowCut);
 
-    style()->unpolish(buttonReceive);
-    style()->polish(buttonReceive);
+    gui::repolish(buttonReceive);
 
     BaseTrackView::updateStyleSheet();
 }
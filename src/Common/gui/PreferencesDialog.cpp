@@ -11,6 +11,7 @@
 
 PreferencesDialog::PreferencesDialog(QWidget *parent) :
     QDialog(parent),
+    continuousTrackFilesCheckBox(nullptr),
     ui(new Ui::PreferencesDialog)
 {
     ui->setupUi(this);
@@ -85,6 +86,12 @@ void PreferencesDialog::initialize(PreferencesTab initialTab, const persistence:
         jamRecorderCheckBoxes[myCheckBox] = jamRecorder;
     }
 
+    continuousTrackFilesCheckBox = new QCheckBox(this);
+    continuousTrackFilesCheckBox->setObjectName("continuousTrackFilesCheckBox");
+    continuousTrackFilesCheckBox->setText(tr("Record each track in a single file (chained Ogg)"));
+    continuousTrackFilesCheckBox->setToolTip(tr("Append all intervals of a track in one file instead of one file per interval"));
+    ui->layoutRecorders->addWidget(continuousTrackFilesCheckBox);
+
     QDateTime now = QDateTime::currentDateTime();
     Qt::DateFormat dateFormat;
     QString nowString;
@@ -183,6 +190,8 @@ void PreferencesDialog::accept()
         emit jamRecorderStatusChanged(jamMetaDataWriterID, checkBox->isChecked());
     }
 
+    emit continuousTrackFilesChanged(continuousTrackFilesCheckBox->isChecked());
+
     bool rememberingBoost = ui->checkBoxRememberBoost->isChecked();
     bool rememberingLevel = ui->checkBoxRememberLevel->isChecked();
     bool rememberingPan = ui->checkBoxRememberPan->isChecked();
@@ -325,6 +334,8 @@ void PreferencesDialog::populateMultiTrackRecordingTab()
         ((QRadioButton *)myRadioButton)->setChecked(QString::compare(recordingSettings.dirNameDateFormat, jamDateFormatRadioButtons[myRadioButton]) == 0);
     }
 
+    continuousTrackFilesCheckBox->setChecked(recordingSettings.continuousTrackFiles);
+
     QDir recordDir(recordingSettings.recordingPath);
     ui->recordPathLineEdit->setText(recordDir.absolutePath());
 }
@@ -40,6 +40,7 @@ signals:
     void jamRecorderStatusChanged(const QString &writerId, bool status);
     void recordingPathSelected(const QString &newRecordingPath);
     void jamDateFormatChanged(QString dateFormat);
+    void continuousTrackFilesChanged(bool continuousTrackFiles);
     void encodingQualityChanged(float newEncodingQuality);
     void looperAudioEncodingFlagChanged(bool savingEncodedAudio);
     void looperWaveFilesBitDepthChanged(quint8 bitDepth);
@@ -74,6 +75,7 @@ private:
     QString openAudioFileBrowser(const QString caption);
     QMap<QCheckBox *, QString> jamRecorderCheckBoxes;
     QMap<const QRadioButton *, QString> jamDateFormatRadioButtons;
+    QCheckBox *continuousTrackFilesCheckBox;
     static QString getAudioFilesFilter();
 
 protected:
@@ -0,0 +1,139 @@
+#include "RepaintScheduler.h"
+#include "log/Logging.h"
+
+#include <QWidget>
+#include <QEvent>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+const quint8 RepaintScheduler::BACKGROUND_FRAME_RATE = 4; // keep the screensaver blocker and the plugins idle working
+
+RepaintScheduler::RepaintScheduler(QWidget *window) :
+    QObject(window),
+    window(window),
+    frameRate(30),
+    currentFrameRate(30),
+    averageFrameTime(0),
+    maxFrameTime(0)
+{
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &RepaintScheduler::processFrame);
+
+    window->installEventFilter(this);
+
+    updateFrameRate();
+}
+
+void RepaintScheduler::addSource(QWidget *widget, const ValueSource &source, bool pollWhenHidden)
+{
+    Q_ASSERT(widget);
+
+    sources.push_back(Source{QPointer<QWidget>(widget), source, pollWhenHidden});
+}
+
+void RepaintScheduler::removeSources(QWidget *widget)
+{
+    sources.erase(std::remove_if(sources.begin(), sources.end(), [widget](const Source &source) {
+        return source.widget == widget;
+    }), sources.end());
+}
+
+void RepaintScheduler::start()
+{
+    updateFrameRate();
+    timer.start();
+}
+
+void RepaintScheduler::stop()
+{
+    timer.stop();
+}
+
+void RepaintScheduler::setFrameRate(quint8 framesPerSecond)
+{
+    if (!framesPerSecond)
+        return;
+
+    frameRate = framesPerSecond;
+
+    updateFrameRate();
+}
+
+void RepaintScheduler::updateFrameRate()
+{
+    const bool inBackground = window->isMinimized() || !window->isVisible();
+
+    const quint8 newFrameRate = inBackground ? qMin(frameRate, BACKGROUND_FRAME_RATE) : frameRate;
+    if (newFrameRate == currentFrameRate && timer.interval() == 1000/newFrameRate)
+        return;
+
+    currentFrameRate = newFrameRate;
+    timer.setInterval(1000/currentFrameRate);
+
+    qCDebug(jtGUI) << "GUI frame rate changed to" << currentFrameRate << "fps";
+}
+
+bool RepaintScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == window) {
+        switch (event->type()) {
+        case QEvent::Show:
+        case QEvent::Hide:
+        case QEvent::WindowStateChange:
+            updateFrameRate();
+            break;
+        default:
+            break;
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void RepaintScheduler::processFrame()
+{
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    emit frameStarted();
+
+    const size_t sourcesCount = sources.size(); // sources added while polling are polled in the next frame
+    bool hasDeletedWidgets = false;
+    for (size_t i = 0; i < sourcesCount && i < sources.size(); ++i) {
+        const Source &source = sources[i];
+        if (!source.widget) {
+            hasDeletedWidgets = true;
+            continue;
+        }
+
+        if (source.pollWhenHidden || source.widget->isVisible()) {
+            const ValueSource poll = source.poll; // a source can register new sources
+            poll();
+        }
+    }
+
+    if (hasDeletedWidgets) {
+        sources.erase(std::remove_if(sources.begin(), sources.end(), [](const Source &source) {
+            return source.widget.isNull();
+        }), sources.end());
+    }
+
+    const qreal frameTime = frameTimer.nsecsElapsed() / 1000000.0;
+
+    averageFrameTime = averageFrameTime > 0 ? (averageFrameTime * 0.9 + frameTime * 0.1) : frameTime;
+
+    if (frameTime > maxFrameTime)
+        maxFrameTime = frameTime;
+}
+
+QRect RepaintScheduler::getLevelsRect(const QRectF &lane, qreal origin, int level1, int level2, Qt::Orientation orientation, int margin)
+{
+    const int from = qMin(level1, level2) - margin;
+    const int to = qMax(level1, level2) + margin;
+
+    if (orientation == Qt::Vertical) // levels growing from bottom to top
+        return QRectF(lane.left(), origin - to, lane.width(), to - from).toAlignedRect();
+
+    return QRectF(origin + from, lane.top(), to - from, lane.height()).toAlignedRect();
+}
@@ -0,0 +1,110 @@
+#ifndef _REPAINT_SCHEDULER_
+#define _REPAINT_SCHEDULER_
+
+#include <QObject>
+#include <QTimer>
+#include <QPointer>
+#include <QRect>
+
+#include <functional>
+#include <vector>
+
+class QWidget;
+
+/**
+    Frame clock of the GUI animations: peak meters, looper waves, video, etc.
+
+    Widgets register the functions reading their values (the value sources) and the sources are
+    polled in every frame. A source is skipped while its widget is not visible (a hidden tab, a
+    closed looper window) and the widgets are expected to invalidate only the pixels changed by
+    the new values, so the GUI thread stays idle when nothing is moving.
+
+    The frame rate drops to BACKGROUND_FRAME_RATE while the window is minimized or hidden. The
+    time spent polling the sources is measured and reported by getAverageFrameTime().
+ */
+
+class RepaintScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void()> ValueSource;
+
+    explicit RepaintScheduler(QWidget *window);
+
+    void addSource(QWidget *widget, const ValueSource &source, bool pollWhenHidden = false);
+    void removeSources(QWidget *widget);
+
+    void start();
+    void stop();
+
+    void setFrameRate(quint8 framesPerSecond);
+    quint8 getFrameRate() const; // the frame rate used when the window is visible
+    quint8 getCurrentFrameRate() const;
+
+    qreal getAverageFrameTime() const; // in milliseconds
+    qreal getMaxFrameTime() const; // in milliseconds, since the last resetMaxFrameTime()
+    void resetMaxFrameTime();
+
+    // the part of a meter lane between two levels (pixels from the origin of the lane axis)
+    static QRect getLevelsRect(const QRectF &lane, qreal origin, int level1, int level2, Qt::Orientation orientation, int margin = 1);
+
+    static const quint8 BACKGROUND_FRAME_RATE;
+
+signals:
+    void frameStarted(); // emitted before polling the sources, used by non visual tasks
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void processFrame();
+
+private:
+    struct Source
+    {
+        QPointer<QWidget> widget;
+        ValueSource poll;
+        bool pollWhenHidden;
+    };
+
+    std::vector<Source> sources;
+
+    QWidget *window;
+    QTimer timer;
+
+    quint8 frameRate;
+    quint8 currentFrameRate;
+
+    qreal averageFrameTime;
+    qreal maxFrameTime;
+
+    void updateFrameRate();
+};
+
+inline quint8 RepaintScheduler::getFrameRate() const
+{
+    return frameRate;
+}
+
+inline quint8 RepaintScheduler::getCurrentFrameRate() const
+{
+    return currentFrameRate;
+}
+
+inline qreal RepaintScheduler::getAverageFrameTime() const
+{
+    return averageFrameTime;
+}
+
+inline qreal RepaintScheduler::getMaxFrameTime() const
+{
+    return maxFrameTime;
+}
+
+inline void RepaintScheduler::resetMaxFrameTime()
+{
+    maxFrameTime = 0;
+}
+
+#endif
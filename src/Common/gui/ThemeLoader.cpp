@@ -7,6 +7,8 @@
 
 using theme::Loader;
 
+QHash<QString, QString> Loader::cache;
+
 QStringList Loader::getAvailableThemes(QString themesDir)
 {
     QDir baseDir(themesDir);
@@ -40,6 +42,11 @@ bool Loader::canLoad(const QString &themesDir, const QString &themeName)
 
 QString Loader::loadCSS(QString themeDir, QString themeName)
 {
+    const QString cacheKey = QDir(themeDir).absoluteFilePath(themeName);
+    auto cachedCSS = cache.constFind(cacheKey);
+    if (cachedCSS != cache.constEnd())
+        return cachedCSS.value(); // the theme fonts are already loaded
+
     // first load the common CSS shared by all themes
     QString commonCSSDir(":/css/");
     QString commonCSSName("common");
@@ -58,7 +65,65 @@ QString Loader::loadCSS(QString themeDir, QString themeName)
 
     loadFonts(themeDir, themeName);
 
-    return commonCss + themeCss;
+    QString css = minimizeCSS(commonCss + themeCss);
+
+    cache.insert(cacheKey, css);
+
+    return css;
+}
+
+void Loader::clearCache()
+{
+    cache.clear();
+}
+
+QString Loader::minimizeCSS(const QString &css)
+{
+    static const QString separators("{};,");
+
+    QString minimized;
+    minimized.reserve(css.size());
+
+    const QChar *data = css.constData();
+    const int size = css.size();
+
+    QChar quote; // not null inside strings, the strings are copied without changes
+    bool pendingSpace = false;
+    for (int i = 0; i < size; ++i) {
+        const QChar c = data[i];
+
+        if (!quote.isNull()) {
+            minimized.append(c);
+            if (c == quote)
+                quote = QChar();
+            continue;
+        }
+
+        if (c == '/' && i + 1 < size && data[i + 1] == '*') {
+            int commentEnd = css.indexOf("*/", i + 2);
+            i = commentEnd >= 0 ? commentEnd + 1 : size;
+            pendingSpace = true; // the comment can be separating two words
+            continue;
+        }
+
+        if (c.isSpace()) {
+            pendingSpace = true;
+            continue;
+        }
+
+        // spaces are necessary only between words ('QWidget #name', 'QWidget :hover', '1px solid')
+        if (pendingSpace && !minimized.isEmpty() && !separators.contains(minimized.at(minimized.size() - 1)) && !separators.contains(c))
+            minimized.append(' ');
+
+        pendingSpace = false;
+
+        if (c == '"' || c == '\'')
+            quote = c;
+
+        minimized.append(c);
+    }
+
+    return minimized;
 }
 
 void Loader::loadFonts(QString themesDir, const QString &themeName)
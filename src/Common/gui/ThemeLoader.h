@@ -2,9 +2,16 @@
 #define THEME_LOADER_H
 
 #include <QString>
+#include <QHash>
 
 namespace theme {
 
+/**
+    The theme CSS is merged with the common CSS, the image paths are resolved and the comments and
+    spaces are removed only in the first load. The processed stylesheet is cached, switching back to
+    a loaded theme doesn't read the CSS files again and Qt parses a smaller stylesheet.
+ */
+
 class Loader { // TODO a namespace? and about the private functions?
 
 public:
@@ -12,7 +19,12 @@ public:
     static QStringList getAvailableThemes(QString themesDir);
     static bool canLoad(const QString &themesDir, const QString &themeName);
 
+    static QString minimizeCSS(const QString &css); // remove comments and unnecessary spaces
+    static void clearCache();
+
 private:
+    static QHash<QString, QString> cache; // processed CSS by theme path
+
     static QStringList getThemeSectionNames();
     static QString loadThemeCSSFiles(QString themeDir, const QString &themeName);
 
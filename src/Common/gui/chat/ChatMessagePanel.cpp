@@ -1,37 +1,22 @@
 #include "ChatMessagePanel.h"
 #include "ui_ChatMessagePanel.h"
-#include "log/Logging.h"
-#include "EmojiManager.h"
+#include "ChatMessagesModel.h"
 #include "ninjam/client/User.h"
 
-#include <QTime>
 #include <QPainter>
-#include <QDebug>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
-#include <QRegularExpression>
-
-ChatMessagePanel::ChatMessagePanel(QWidget *parent, const QString &userFullName, const QString &msg,
-                                   const QColor &backgroundColor, const QColor &textColor,
-                                   bool showTranslationButton, bool showBlockButton, Emojifier *emojifier) :
+#include <QUrl>
+
+ChatMessagePanel::ChatMessagePanel(QWidget *parent) :
     QFrame(parent),
     ui(new Ui::ChatMessagePanel),
-    userFullName(userFullName),
-    emojifier(emojifier),
-    backgroundColor(backgroundColor),
+    messageId(0),
     showArrow(true),
-    arrowSide(ChatMessagePanel::LeftSide)
+    arrowSide(ChatMessagePanel::LeftSide),
+    textColor(Qt::black),
+    fontSizeOffset(0)
 {
     ui->setupUi(this);
 
-    if (emojifier)
-        emojifiedText = emojifier->emojify(msg.toHtmlEscaped());
-    else
-        emojifiedText = msg;
-
-    initialize(userFullName, msg, showTranslationButton, showBlockButton);
-
     connect(ui->blockButton, &QPushButton::clicked, this, &ChatMessagePanel::fireBlockingUserSignal);
 
     setBackgroundRole(QPalette::NoRole);
@@ -43,6 +28,54 @@ ChatMessagePanel::ChatMessagePanel(QWidget *parent, const QString &userFullName,
     adjustContentMargins();
 }
 
+void ChatMessagePanel::setMessage(const ChatMessage &message)
+{
+    messageId = message.id;
+    userFullName = message.authorFullName;
+    backgroundColor = message.backgroundColor;
+
+    if (message.textColor != textColor) { // style sheets are expensive, the panels are reused for every visible message
+        textColor = message.textColor;
+        setStyleSheet(QString("color: %1;").arg(textColor.name()));
+    }
+
+    const bool hasUserName = !userFullName.isEmpty();
+    if (hasUserName)
+        ui->labelUserName->setText(ninjam::client::extractUserName(userFullName));
+    ui->labelUserName->setVisible(hasUserName);
+
+    ui->translateButton->setVisible(message.showTranslationButton);
+    ui->translateButton->setChecked(message.showingTranslation);
+
+    ui->blockButton->setVisible(message.showBlockButton);
+
+    if (!message.image.isNull()) {
+        showImage(message.image, message.imageLink);
+    }
+    else {
+        ui->labelMessage->setMinimumWidth(0);
+        ui->labelMessage->setText(message.showingTranslation ? message.translatedHtml : message.html);
+    }
+
+    showArrow = message.showArrow;
+    arrowSide = (showArrow && message.localUser) ? ChatMessagePanel::RightSide : ChatMessagePanel::LeftSide;
+
+    buildPainterPath();
+
+    adjustContentMargins();
+
+    update();
+}
+
+void ChatMessagePanel::setMessageMaximumWidth(int maxWidth)
+{
+    if (ui->labelMessage->maximumWidth() == maxWidth)
+        return;
+
+    ui->labelMessage->setMaximumWidth(maxWidth);
+    ui->labelMessage->updateWidth();
+}
+
 bool ChatMessagePanel::event(QEvent *e)
 {
     if (e->type() == QEvent::Polish) {
@@ -77,6 +110,11 @@ QString ChatMessagePanel::buildFontStyleSheet(const FontDetails &fontDetails, qi
 
 void ChatMessagePanel::setFontSizeOffset(qint8 sizeOffset)
 {
+    if (sizeOffset == fontSizeOffset)
+        return;
+
+    fontSizeOffset = sizeOffset;
+
     ensurePolished(); // compute original fonts size and unit (px or pt)
 
     ui->labelMessage->setStyleSheet(buildFontStyleSheet(originalMessageFont, sizeOffset));
@@ -179,8 +217,6 @@ void ChatMessagePanel::resizeEvent(QResizeEvent *ev)
     QFrame::resizeEvent(ev);
 
     buildPainterPath();
-
-    ui->labelMessage->setMaximumWidth(parentWidget()->width() - 30);
 }
 
 void ChatMessagePanel::paintEvent(QPaintEvent *)
@@ -215,109 +251,17 @@ void ChatMessagePanel::changeEvent(QEvent *e)
     QWidget::changeEvent(e);
 }
 
-void ChatMessagePanel::initialize(const QString &userFullName, const QString &msg, bool showTranslationButton, bool showBlockButton)
+void ChatMessagePanel::showImage(const QImage &image, const QString &link)
 {
-    if (!userFullName.isEmpty() && !userFullName.isNull()) {
-        ui->labelUserName->setText(ninjam::client::extractUserName(userFullName));
-    }
-    else {
-        ui->labelUserName->setVisible(false);
-    }
-
-    ui->translateButton->setVisible(showTranslationButton);
-
-    ui->blockButton->setVisible(showBlockButton);
-
-    setMessageLabelText(emojifiedText);
-
-    originalText = msg;
-}
+    const int imageWidth = qMin(image.width(), static_cast<int>(ui->labelMessage->maximumWidth() * 0.85));
 
-bool linkIsImage(const QString &link)
-{
-    static auto acceptedFormats = QStringList() << ".png" << "gif" << "jpg" << "jpeg";
-
-    for (auto extension : acceptedFormats) {
-        if (link.endsWith(extension, Qt::CaseInsensitive))
-            return true;
-    }
-
-    return false;
-}
-
-bool messageContainsDownloadableImageLink(const QString &message)
-{
-    QRegularExpression regex("((?:https?|ftp|www)://\\S+)");
-    auto matcher = regex.match(message);
-    if (matcher.hasMatch()) {
-        auto links = matcher.capturedTexts();
-        if (!links.isEmpty()) {
-            auto link = links.first();
-            if (linkIsImage(link)) {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-void ChatMessagePanel::setMessageLabelText(const QString &msg)
-{
-    QString newMessage(msg);
-    newMessage = newMessage.replace(QRegExp("<.+?>"), ""); // scape html tags
-    newMessage = newMessage.replace("\n", "<br/>");
-
-   if (messageContainsDownloadableImageLink(msg)) {
-       downloadImage(msg);
-       ui->translateButton->setVisible(false); // images are not translatable
-   }
-   else {
-        newMessage = replaceLinksInString(newMessage);
-        ui->labelMessage->setText(newMessage);
-   }
-}
-
-void ChatMessagePanel::downloadImage(const QString &link)
-{
-
-    auto nam = new QNetworkAccessManager(this);
-    nam->get(QNetworkRequest(QUrl(QString(link).replace("https:", "http:")))); // trying download from https using simple http
-
-    connect(nam, &QNetworkAccessManager::finished, [=](QNetworkReply *reply)
-    {
-        auto imageData = reply->readAll();
-        if (parentWidget()) {
-            int bestWidth = parentWidget()->width() * 0.85;
-            auto image = QImage::fromData(imageData);
-            if (!image.isNull()) {
-                insertImage(image.scaledToWidth(bestWidth, Qt::SmoothTransformation), link);
-            }
-            else {
-                ui->labelMessage->setText(replaceLinksInString(link));
-            }
-        }
-
-        nam->deleteLater();
-        reply->deleteLater();
-    });
-}
-
-void ChatMessagePanel::insertImage(const QImage &image, const QString &link)
-{
     auto document = ui->labelMessage->document();
     document->addResource(QTextDocument::ImageResource, QUrl("image"), image);
 
-    ui->labelMessage->append(QString("<a href=\"%1\"><img src=\"image\" /></a>").arg(link));
+    ui->labelMessage->setText(QString("<a href=\"%1\"><img src=\"image\" width=\"%2\" /></a>").arg(link).arg(imageWidth));
     ui->labelMessage->clearFocus();
 
-    ui->labelMessage->setMinimumWidth(image.width() + 10);
-}
-
-QString ChatMessagePanel::replaceLinksInString(const QString &string)
-{
-    static QString regex = "((?:https?|ftp|www)://\\S+)";
-    return QString(string).replace(QRegExp(regex), "<a href=\"\\1\">\\1</a>");
+    ui->labelMessage->setMinimumWidth(imageWidth + 10);
 }
 
 ChatMessagePanel::~ChatMessagePanel()
@@ -325,101 +269,12 @@ ChatMessagePanel::~ChatMessagePanel()
     delete ui;
 }
 
-void ChatMessagePanel::translate()
-{
-    emit startingTranslation();
-
-    auto httpClient = new QNetworkAccessManager(this);
-    QString encodedText(QUrl::toPercentEncoding(originalText));
-    QString url = QString("http://translate.googleapis.com/translate_a/single?client=gtx&sl=auto&tl=%1&dt=t&q=%2")
-            .arg(preferredTargetTranslationLanguage)
-            .arg(encodedText);
-
-    QNetworkRequest req;
-    req.setUrl(QUrl(url));
-    req.setOriginatingObject(this);
-    req.setRawHeader("User-Agent", "Mozilla/5.0 (Windows NT 6.3; WOW64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/46.0.2490.71 Safari/537.36");
-
-    qCDebug(jtGUI) << "Translating:" << url;
-
-    QNetworkReply *reply = httpClient->get(req);
-
-    QObject::connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(handleTranslationError(QNetworkReply::NetworkError)));
-
-    QObject::connect(httpClient, SIGNAL(finished(QNetworkReply *)), this, SLOT(handleAvailableTranslation(QNetworkReply *)));
-
-    //ui->labelMessage->setText("..."); // translating
-}
-
 void ChatMessagePanel::on_translateButton_clicked()
 {
-    if (ui->translateButton->isChecked()) {
-        if (translatedText.isEmpty()) {
-            translate();
-        }
-        else {
-            setMessageLabelText("<i>" + translatedText + "</i>");
-        }
-    }
-    else {
-        setMessageLabelText(emojifiedText);
-    }
+    emit translationToggled(ui->translateButton->isChecked());
 }
 
 void ChatMessagePanel::fireBlockingUserSignal()
 {
     emit blockingUser(userFullName);
 }
-
-void ChatMessagePanel::setPrefferedTranslationLanguage(const QString &targetLanguage)
-{
-    preferredTargetTranslationLanguage = targetLanguage;
-}
-
-void ChatMessagePanel::handleTranslationError(QNetworkReply::NetworkError)
-{
-    auto sender = qobject_cast<QNetworkReply *>(QObject::sender());
-    if (!sender)
-        return;
-
-    qCritical() << "Translation error:" << sender->errorString();
-
-    setTranslatedMessage(tr("Translation error!"));
-
-    emit translationFinished();
-}
-
-void ChatMessagePanel::handleAvailableTranslation(QNetworkReply *reply)
-{
-    auto messagePanel = qobject_cast<ChatMessagePanel *>(reply->request().originatingObject());
-    if (!messagePanel)
-        return;
-
-    if (reply->error() == QNetworkReply::NoError) {
-
-        QString downloadedData(reply->readAll());
-
-        int startSlash = downloadedData.indexOf(QRegExp("\""));
-        int endSlash = downloadedData.indexOf(QRegExp("\""), startSlash + 1);
-
-        QString translatedText = downloadedData.mid(startSlash+1, endSlash - startSlash - 1);
-        if (translatedText.isEmpty())
-            translatedText = "translation error!";
-
-        messagePanel->setTranslatedMessage(translatedText);
-    }
-
-    if (reply->manager())
-        reply->manager()->deleteLater();
-
-    reply->deleteLater();
-
-    emit translationFinished();
-}
-
-void ChatMessagePanel::setTranslatedMessage(const QString &translatedMessage)
-{
-    ui->translateButton->setChecked(true);
-    translatedText = emojifier ? emojifier->emojify(translatedMessage) : translatedMessage;
-    setMessageLabelText("<i>" + translatedText + "</i>");
-}
@@ -2,28 +2,33 @@
 #define CHATMESSAGEPANEL_H
 
 #include <QFrame>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QPainterPath>
 
 namespace Ui {
 class ChatMessagePanel;
 }
 
-class Emojifier;
+struct ChatMessage;
+
+/**
+    The widget showing one chat message. The panels are reused by ChatMessagesView, a panel
+    shows a different message every time setMessage() is called.
+ */
 
 class ChatMessagePanel : public QFrame
 {
     Q_OBJECT
 
 public:
-    ChatMessagePanel(QWidget *parent, const QString &userFullName, const QString &msg, const QColor &backgroundColor,
-                     const QColor &textColor, bool showTranslationButton, bool showBlockButton, Emojifier *emojifier = nullptr);
+    explicit ChatMessagePanel(QWidget *parent);
     ~ChatMessagePanel();
-    void setPrefferedTranslationLanguage(const QString &targetLanguage);
-    void translate();
+
+    void setMessage(const ChatMessage &message);
+    quint64 getMessageId() const;
     QString getUserFullName() const;
 
     void setFontSizeOffset(qint8 sizeOffset);
+    void setMessageMaximumWidth(int maxWidth);
 
     enum ArrowSide
     {
@@ -35,8 +40,7 @@ public:
     void setArrowSide(ArrowSide side);
 
 signals:
-    void startingTranslation();
-    void translationFinished();
+    void translationToggled(bool showTranslation);
     void blockingUser(const QString &userFullName);
 
 protected:
@@ -49,15 +53,11 @@ protected:
 private slots:
     void on_translateButton_clicked();
     void fireBlockingUserSignal();
-    void handleAvailableTranslation(QNetworkReply *);
-    void handleTranslationError(QNetworkReply::NetworkError);
 
 private:
-    QString originalText;
-    QString translatedText;
-    QString emojifiedText;
     Ui::ChatMessagePanel *ui;
-    QString preferredTargetTranslationLanguage;
+
+    quint64 messageId;
 
     QPainterPath painterPath;
     QPainterPath shadowPath;
@@ -65,6 +65,9 @@ private:
     ArrowSide arrowSide;
 
     QColor backgroundColor;
+    QColor textColor;
+
+    qint8 fontSizeOffset;
 
     struct FontDetails
     {
@@ -81,20 +84,9 @@ private:
 
     QString userFullName;
 
-    Emojifier *emojifier;
-
-    static QString replaceLinksInString(const QString &string);
-
-    void initialize(const QString &userFullName, const QString &msg, bool showTranslationButton, bool showBlockButton);
-
-    void setTranslatedMessage(const QString &translatedMessage);
-
-    void setMessageLabelText(const QString &msg);
-
     void adjustContentMargins();
 
-    void downloadImage(const QString &link);
-    void insertImage(const QImage &image, const QString &link);
+    void showImage(const QImage &image, const QString &link);
 
     static FontDetails getFontDetails(const QFont &f);
 
@@ -106,4 +98,9 @@ inline QString ChatMessagePanel::getUserFullName() const
     return userFullName;
 }
 
+inline quint64 ChatMessagePanel::getMessageId() const
+{
+    return messageId;
+}
+
 #endif // CHATMESSAGEPANEL_H
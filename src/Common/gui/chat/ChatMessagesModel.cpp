@@ -0,0 +1,312 @@
+#include "ChatMessagesModel.h"
+#include "EmojiManager.h"
+#include "log/Logging.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QRegExp>
+#include <QUrl>
+
+static const int MAX_IMAGE_WIDTH = 800; // bigger images are scaled down when downloaded
+
+ChatMessagesModel::ChatMessagesModel(int maxMessages, Emojifier *emojifier, QObject *parent) :
+    QAbstractListModel(parent),
+    maxMessages(qMax(1, maxMessages)),
+    lastMessageId(0),
+    emojifier(emojifier),
+    networkManager(nullptr)
+{
+
+}
+
+int ChatMessagesModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return messages.size();
+}
+
+QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= messages.size())
+        return QVariant();
+
+    const ChatMessage &message = messages.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return message.showingTranslation ? message.translatedHtml : message.html;
+    case Qt::ToolTipRole:
+        return message.authorFullName;
+    case Qt::BackgroundRole:
+        return message.backgroundColor;
+    case Qt::ForegroundRole:
+        return message.textColor;
+    default:
+        return QVariant();
+    }
+}
+
+int ChatMessagesModel::findRow(quint64 messageId) const
+{
+    for (int row = messages.size() - 1; row >= 0; --row) { // recent messages are the most used
+        if (messages.at(row).id == messageId)
+            return row;
+    }
+
+    return -1;
+}
+
+int ChatMessagesModel::addMessage(const ChatMessage &message, bool emojify)
+{
+    ChatMessage newMessage(message);
+    newMessage.id = ++lastMessageId;
+    newMessage.widget = nullptr;
+
+    QString text = newMessage.text;
+    if (emojify && emojifier)
+        text = emojifier->emojify(text.toHtmlEscaped());
+
+    if (isDownloadableImageLink(text)) {
+        auto matcher = QRegularExpression("((?:https?|ftp|www)://\\S+)").match(text);
+        newMessage.imageLink = matcher.captured(1);
+        newMessage.showTranslationButton = false; // images are not translatable
+    }
+    else {
+        newMessage.html = renderMessage(text);
+    }
+
+    appendMessage(newMessage);
+
+    if (!newMessage.imageLink.isEmpty())
+        downloadImage(newMessage.id, newMessage.imageLink);
+
+    return messages.size() - 1;
+}
+
+int ChatMessagesModel::addWidget(QWidget *widget)
+{
+    Q_ASSERT(widget);
+
+    ChatMessage message;
+    message.id = ++lastMessageId;
+    message.widget = widget;
+    message.showArrow = false;
+
+    const quint64 messageId = message.id;
+    connect(widget, &QObject::destroyed, this, [=]() {
+        int row = findRow(messageId);
+        if (row >= 0)
+            removeMessage(row);
+    });
+
+    appendMessage(message);
+
+    return messages.size() - 1;
+}
+
+void ChatMessagesModel::appendMessage(const ChatMessage &message)
+{
+    if (messages.size() >= maxMessages)
+        removeMessage(0); // discard the oldest message
+
+    beginInsertRows(QModelIndex(), messages.size(), messages.size());
+    messages.append(message);
+    endInsertRows();
+}
+
+void ChatMessagesModel::removeMessage(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    ChatMessage message = messages.takeAt(row);
+    endRemoveRows();
+
+    if (message.widget) {
+        message.widget->disconnect(this); // the row is already removed
+        message.widget->deleteLater();
+    }
+}
+
+void ChatMessagesModel::removeMessagesFrom(const QString &authorFullName)
+{
+    for (int row = messages.size() - 1; row >= 0; --row) {
+        if (messages.at(row).authorFullName == authorFullName)
+            removeMessage(row);
+    }
+}
+
+void ChatMessagesModel::clear()
+{
+    beginResetModel();
+
+    for (const auto &message : messages) {
+        if (message.widget) {
+            message.widget->disconnect(this);
+            message.widget->deleteLater();
+        }
+    }
+
+    messages.clear();
+
+    endResetModel();
+}
+
+void ChatMessagesModel::messageChanged(int row)
+{
+    const QModelIndex messageIndex = index(row);
+    emit dataChanged(messageIndex, messageIndex);
+}
+
+QString ChatMessagesModel::renderMessage(const QString &text)
+{
+    static const QRegExp HTML_TAGS("<.+?>");
+
+    QString html(text);
+    html.replace(HTML_TAGS, ""); // scape html tags
+    html.replace("\n", "<br/>");
+
+    return replaceLinksInString(html);
+}
+
+QString ChatMessagesModel::replaceLinksInString(const QString &string)
+{
+    static const QRegExp LINKS("((?:https?|ftp|www)://\\S+)");
+
+    return QString(string).replace(LINKS, "<a href=\"\\1\">\\1</a>");
+}
+
+bool ChatMessagesModel::isDownloadableImageLink(const QString &text)
+{
+    static const QRegularExpression LINKS("((?:https?|ftp|www)://\\S+)");
+    static const QStringList IMAGE_FORMATS = QStringList() << ".png" << "gif" << "jpg" << "jpeg";
+
+    auto matcher = LINKS.match(text);
+    if (!matcher.hasMatch())
+        return false;
+
+    auto link = matcher.captured(1);
+    for (const auto &extension : IMAGE_FORMATS) {
+        if (link.endsWith(extension, Qt::CaseInsensitive))
+            return true;
+    }
+
+    return false;
+}
+
+QNetworkAccessManager *ChatMessagesModel::getNetworkManager()
+{
+    if (!networkManager)
+        networkManager = new QNetworkAccessManager(this);
+
+    return networkManager;
+}
+
+void ChatMessagesModel::downloadImage(quint64 messageId, const QString &link)
+{
+    auto reply = getNetworkManager()->get(QNetworkRequest(QUrl(QString(link).replace("https:", "http:")))); // trying download from https using simple http
+
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        int row = findRow(messageId);
+        if (row >= 0) {
+            ChatMessage &message = messages[row];
+            auto image = QImage::fromData(reply->readAll());
+            if (!image.isNull()) {
+                if (image.width() > MAX_IMAGE_WIDTH)
+                    image = image.scaledToWidth(MAX_IMAGE_WIDTH, Qt::SmoothTransformation);
+                message.image = image;
+            }
+            else {
+                message.html = replaceLinksInString(link);
+            }
+
+            messageChanged(row);
+        }
+
+        reply->deleteLater();
+    });
+}
+
+void ChatMessagesModel::setTranslationLanguage(const QString &languageCode)
+{
+    translationLanguage = languageCode;
+}
+
+void ChatMessagesModel::setShowingTranslation(int row, bool showTranslation)
+{
+    if (row < 0 || row >= messages.size())
+        return;
+
+    ChatMessage &message = messages[row];
+    if (showTranslation && message.translatedHtml.isEmpty()) {
+        translate(row);
+        return;
+    }
+
+    if (message.showingTranslation != showTranslation) {
+        message.showingTranslation = showTranslation;
+        messageChanged(row);
+    }
+}
+
+void ChatMessagesModel::translate(int row)
+{
+    if (row < 0 || row >= messages.size())
+        return;
+
+    emit startingTranslation();
+
+    const ChatMessage &message = messages.at(row);
+    const quint64 messageId = message.id;
+
+    QString encodedText(QUrl::toPercentEncoding(message.text));
+    QString url = QString("http://translate.googleapis.com/translate_a/single?client=gtx&sl=auto&tl=%1&dt=t&q=%2")
+            .arg(translationLanguage)
+            .arg(encodedText);
+
+    QNetworkRequest req;
+    req.setUrl(QUrl(url));
+    req.setRawHeader("User-Agent", "Mozilla/5.0 (Windows NT 6.3; WOW64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/46.0.2490.71 Safari/537.36");
+
+    qCDebug(jtGUI) << "Translating:" << url;
+
+    auto reply = getNetworkManager()->get(req);
+
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        if (reply->error() == QNetworkReply::NoError) {
+            QString downloadedData(reply->readAll());
+
+            int startSlash = downloadedData.indexOf(QRegExp("\""));
+            int endSlash = downloadedData.indexOf(QRegExp("\""), startSlash + 1);
+
+            QString translatedText = downloadedData.mid(startSlash + 1, endSlash - startSlash - 1);
+            if (translatedText.isEmpty())
+                translatedText = "translation error!";
+
+            setTranslatedText(messageId, translatedText);
+        }
+        else {
+            qCritical() << "Translation error:" << reply->errorString();
+            setTranslatedText(messageId, tr("Translation error!"));
+        }
+
+        reply->deleteLater();
+
+        emit translationFinished();
+    });
+}
+
+void ChatMessagesModel::setTranslatedText(quint64 messageId, const QString &translatedText)
+{
+    int row = findRow(messageId);
+    if (row < 0)
+        return; // message discarded while translating
+
+    ChatMessage &message = messages[row];
+    QString text = emojifier ? emojifier->emojify(translatedText) : translatedText;
+    message.translatedHtml = renderMessage("<i>" + text + "</i>");
+    message.showingTranslation = true;
+
+    messageChanged(row);
+}
@@ -0,0 +1,115 @@
+#ifndef CHAT_MESSAGES_MODEL_H
+#define CHAT_MESSAGES_MODEL_H
+
+#include <QAbstractListModel>
+#include <QColor>
+#include <QImage>
+#include <QPointer>
+#include <QWidget>
+#include <QList>
+
+class Emojifier;
+class QNetworkAccessManager;
+
+struct ChatMessage
+{
+    quint64 id = 0;
+
+    QString authorFullName;
+    QString text; // the original text, used to translate
+    QString html; // rendered text (emojis and links), built once when the message is added
+    QString translatedHtml;
+    bool showingTranslation = false;
+
+    QColor backgroundColor;
+    QColor textColor = Qt::black;
+
+    bool showTranslationButton = false;
+    bool showBlockButton = false;
+    bool showArrow = true;
+    bool localUser = false; // local user messages are showed in right side
+
+    QString imageLink;
+    QImage image; // null while downloading
+
+    QPointer<QWidget> widget; // vote, chord progression and server invite buttons are showed as widgets
+
+    bool isWidget() const;
+};
+
+inline bool ChatMessage::isWidget() const
+{
+    return !widget.isNull();
+}
+
+/**
+    The chat history. The messages are stored in a bounded ring, when the history is full the
+    oldest message (or button) is discarded. The rendered text and the downloaded images are
+    cached in the messages, so the views can recreate the message widgets at any time.
+ */
+
+class ChatMessagesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    ChatMessagesModel(int maxMessages, Emojifier *emojifier, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    const ChatMessage &getMessage(int row) const;
+    int findRow(quint64 messageId) const; // -1 when the message was discarded
+
+    int getMaxMessages() const;
+
+    int addMessage(const ChatMessage &message, bool emojify = true); // return the message row
+    int addWidget(QWidget *widget); // the widget row is removed when the widget is destroyed
+
+    void removeMessagesFrom(const QString &authorFullName);
+    void clear();
+
+    void setTranslationLanguage(const QString &languageCode);
+    void translate(int row);
+    void setShowingTranslation(int row, bool showTranslation);
+
+    static QString renderMessage(const QString &text);
+
+signals:
+    void startingTranslation();
+    void translationFinished();
+
+private:
+    QList<ChatMessage> messages;
+    int maxMessages;
+    quint64 lastMessageId;
+
+    Emojifier *emojifier;
+    QNetworkAccessManager *networkManager;
+
+    QString translationLanguage;
+
+    void appendMessage(const ChatMessage &message);
+    void removeMessage(int row);
+    void messageChanged(int row);
+
+    QNetworkAccessManager *getNetworkManager();
+
+    void downloadImage(quint64 messageId, const QString &link);
+    void setTranslatedText(quint64 messageId, const QString &translatedText);
+
+    static bool isDownloadableImageLink(const QString &text);
+    static QString replaceLinksInString(const QString &string);
+};
+
+inline int ChatMessagesModel::getMaxMessages() const
+{
+    return maxMessages;
+}
+
+inline const ChatMessage &ChatMessagesModel::getMessage(int row) const
+{
+    return messages.at(row);
+}
+
+#endif
@@ -0,0 +1,385 @@
+#include "ChatMessagesView.h"
+#include "ChatMessagesModel.h"
+#include "ChatMessagePanel.h"
+
+#include <QScrollBar>
+#include <QSet>
+
+const int ChatMessagesView::ROW_SPACING = 6;
+const int ChatMessagesView::OVERSCAN = 200;
+const int ChatMessagesView::ESTIMATED_ROW_HEIGHT = 40;
+
+ChatMessagesView::ChatMessagesView(QWidget *parent) :
+    QScrollArea(parent),
+    model(nullptr),
+    content(new QWidget()),
+    createdPanels(0),
+    fontSizeOffset(0),
+    layoutScheduled(false),
+    layingOut(false),
+    stickToBottom(true),
+    rowsTopDirty(false),
+    scrollCorrection(0)
+{
+    content->setObjectName("scrollContent");
+
+    setWidgetResizable(false); // the content size is computed using the rows height
+    setWidget(content);
+}
+
+void ChatMessagesView::setModel(ChatMessagesModel *model)
+{
+    if (this->model)
+        disconnect(this->model, nullptr, this, nullptr);
+
+    this->model = model;
+
+    if (model) {
+        connect(model, &ChatMessagesModel::rowsInserted, this, &ChatMessagesView::handleRowsInserted);
+        connect(model, &ChatMessagesModel::rowsAboutToBeRemoved, this, &ChatMessagesView::handleRowsAboutToBeRemoved);
+        connect(model, &ChatMessagesModel::dataChanged, this, &ChatMessagesView::handleDataChanged);
+        connect(model, &ChatMessagesModel::modelReset, this, &ChatMessagesView::handleModelReset);
+    }
+
+    handleModelReset();
+}
+
+void ChatMessagesView::setFontSizeOffset(qint8 offset)
+{
+    if (offset == fontSizeOffset)
+        return;
+
+    fontSizeOffset = offset;
+
+    for (auto panel : panels)
+        panel->setFontSizeOffset(offset); // recycled panels are updated when reused
+
+    invalidateRowsGeometry();
+}
+
+void ChatMessagesView::invalidateRowsGeometry()
+{
+    for (auto &row : rows)
+        row.measuredWidth = -1; // the old height is used as estimative
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::scrollToBottom()
+{
+    stickToBottom = true;
+
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::handleRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+
+    for (int row = first; row <= last; ++row) {
+        rows.insert(row, Row{-1, ESTIMATED_ROW_HEIGHT, 0, -1, true});
+
+        QWidget *widget = model->getMessage(row).widget;
+        if (widget) {
+            widget->setParent(content);
+            widget->hide();
+        }
+    }
+
+    rowsTopDirty = true;
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+
+    const int scrollValue = verticalScrollBar()->value();
+
+    for (int row = last; row >= first; --row) {
+        const ChatMessage &message = model->getMessage(row);
+        if (message.widget)
+            message.widget->hide();
+        else
+            recyclePanel(message.id);
+
+        const Row &geometry = rows.at(row);
+        if (!stickToBottom && geometry.top >= 0 && geometry.top < scrollValue)
+            scrollCorrection += geometry.height + ROW_SPACING; // the oldest messages are discarded while the user is reading the history
+
+        rows.removeAt(row);
+    }
+
+    rowsTopDirty = true;
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row() && row < rows.size(); ++row)
+        rows[row].dirty = true;
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::handleModelReset()
+{
+    for (auto messageId : panels.keys())
+        recyclePanel(messageId);
+
+    shownWidgets.clear();
+    rows.clear();
+    scrollCorrection = 0;
+
+    const int rowCount = model ? model->rowCount() : 0;
+    if (rowCount > 0)
+        handleRowsInserted(QModelIndex(), 0, rowCount - 1);
+
+    rowsTopDirty = true;
+    stickToBottom = true;
+
+    scheduleLayout();
+}
+
+void ChatMessagesView::scheduleLayout()
+{
+    if (layoutScheduled)
+        return;
+
+    layoutScheduled = true;
+
+    QMetaObject::invokeMethod(this, "layoutRows", Qt::QueuedConnection); // many messages can be added at same time
+}
+
+void ChatMessagesView::resizeEvent(QResizeEvent *ev)
+{
+    QScrollArea::resizeEvent(ev);
+
+    layoutRows();
+}
+
+void ChatMessagesView::showEvent(QShowEvent *ev)
+{
+    QScrollArea::showEvent(ev);
+
+    layoutRows(); // hidden views are not laid out
+}
+
+void ChatMessagesView::scrollContentsBy(int dx, int dy)
+{
+    QScrollArea::scrollContentsBy(dx, dy);
+
+    if (layingOut)
+        return;
+
+    stickToBottom = verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+
+    layoutRows();
+}
+
+void ChatMessagesView::updateRowsTop()
+{
+    int top = 0;
+    for (auto &row : rows) {
+        row.top = top;
+        top += row.height + ROW_SPACING;
+    }
+
+    rowsTopDirty = false;
+}
+
+int ChatMessagesView::findRowAt(int y) const
+{
+    if (rows.isEmpty())
+        return -1;
+
+    int low = 0;
+    int high = rows.size() - 1;
+    while (low < high) { // the last row starting before y
+        int middle = (low + high + 1) / 2;
+        if (rows.at(middle).top <= y)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    return low;
+}
+
+int ChatMessagesView::getContentHeight() const
+{
+    if (rows.isEmpty())
+        return 0;
+
+    return rows.last().top + rows.last().height;
+}
+
+void ChatMessagesView::layoutRows()
+{
+    layoutScheduled = false;
+
+    if (!model || layingOut || !isVisible())
+        return;
+
+    layingOut = true;
+
+    if (rowsTopDirty)
+        updateRowsTop();
+
+    QScrollBar *scrollBar = verticalScrollBar();
+
+    if (scrollCorrection) {
+        scrollBar->setValue(scrollBar->value() - scrollCorrection);
+        scrollCorrection = 0;
+    }
+
+    const int width = viewport()->width();
+    const int height = viewport()->height();
+
+    // the first visible row is used as anchor, the scroll position is kept when the rows above it are measured again
+    const int anchorRow = stickToBottom ? -1 : findRowAt(scrollBar->value());
+    const int anchorOffset = anchorRow >= 0 ? scrollBar->value() - rows.at(anchorRow).top : 0;
+
+    int firstRow = 0;
+    int lastRow = -1;
+    for (int pass = 0; pass < 3; ++pass) { // the measured rows can change the visible rows
+        int viewTop = stickToBottom ? qMax(0, getContentHeight() - height) : scrollBar->value();
+        if (anchorRow >= 0)
+            viewTop = rows.at(anchorRow).top + anchorOffset;
+
+        firstRow = qMax(0, findRowAt(viewTop - OVERSCAN));
+        lastRow = findRowAt(viewTop + height + OVERSCAN);
+
+        bool heightChanged = false;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            if (measureRow(row, width))
+                heightChanged = true;
+        }
+
+        if (!heightChanged)
+            break;
+
+        updateRowsTop();
+    }
+
+    content->resize(width, getContentHeight());
+
+    if (stickToBottom)
+        scrollBar->setValue(scrollBar->maximum());
+    else if (anchorRow >= 0)
+        scrollBar->setValue(rows.at(anchorRow).top + anchorOffset);
+
+    // showing the visible rows and recycling the others
+    QSet<quint64> visibleMessages;
+    QList<QPointer<QWidget>> visibleWidgets;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const ChatMessage &message = model->getMessage(row);
+        const Row &geometry = rows.at(row);
+
+        QWidget *widget = message.widget;
+        if (widget)
+            visibleWidgets.append(widget);
+        else
+            widget = panels.value(message.id);
+
+        if (!widget)
+            continue;
+
+        const bool rightSide = message.isWidget() || message.localUser;
+        const int x = rightSide ? width - geometry.width : 0;
+        widget->setGeometry(x, geometry.top, geometry.width, geometry.height);
+        widget->show();
+
+        visibleMessages.insert(message.id);
+    }
+
+    for (auto messageId : panels.keys()) {
+        if (!visibleMessages.contains(messageId))
+            recyclePanel(messageId);
+    }
+
+    for (auto &widget : shownWidgets) {
+        if (widget && !visibleWidgets.contains(widget))
+            widget->hide();
+    }
+    shownWidgets = visibleWidgets;
+
+    layingOut = false;
+}
+
+bool ChatMessagesView::measureRow(int row, int width)
+{
+    Row &geometry = rows[row];
+    const ChatMessage &message = model->getMessage(row);
+
+    const bool needMeasure = geometry.dirty || geometry.measuredWidth != width;
+
+    QWidget *widget = message.widget;
+    if (!widget) {
+        ChatMessagePanel *panel = panels.value(message.id);
+        if (!panel || needMeasure) { // the panel is updated only when a different message or width is showed
+            if (!panel)
+                panel = getPanel(message.id);
+
+            panel->setMaximumWidth(qMax(0, width - 20));
+            panel->setMessageMaximumWidth(qMax(0, width - 30));
+            panel->setMessage(message);
+        }
+        widget = panel;
+    }
+
+    geometry.dirty = false;
+
+    if (!needMeasure)
+        return false;
+
+    widget->ensurePolished();
+    const QSize size = widget->sizeHint().boundedTo(QSize(qMin(width, widget->maximumWidth()), QWIDGETSIZE_MAX));
+
+    const bool heightChanged = size.height() != geometry.height;
+
+    geometry.width = size.width();
+    geometry.height = size.height();
+    geometry.measuredWidth = width;
+
+    return heightChanged;
+}
+
+ChatMessagePanel *ChatMessagesView::getPanel(quint64 messageId)
+{
+    ChatMessagePanel *panel = nullptr;
+    if (!recycledPanels.isEmpty()) {
+        panel = recycledPanels.takeLast();
+    }
+    else {
+        panel = new ChatMessagePanel(content);
+        createdPanels++;
+
+        connect(panel, &ChatMessagePanel::blockingUser, this, &ChatMessagesView::blockingUser);
+
+        connect(panel, &ChatMessagePanel::translationToggled, this, [=](bool showTranslation) {
+            if (model)
+                model->setShowingTranslation(model->findRow(panel->getMessageId()), showTranslation);
+        });
+    }
+
+    panel->setFontSizeOffset(fontSizeOffset);
+
+    panels.insert(messageId, panel);
+
+    return panel;
+}
+
+void ChatMessagesView::recyclePanel(quint64 messageId)
+{
+    auto panel = panels.take(messageId);
+    if (!panel)
+        return;
+
+    panel->hide();
+    recycledPanels.append(panel);
+}
@@ -0,0 +1,103 @@
+#ifndef CHAT_MESSAGES_VIEW_H
+#define CHAT_MESSAGES_VIEW_H
+
+#include <QScrollArea>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+
+class ChatMessagesModel;
+class ChatMessagePanel;
+
+/**
+    Virtualized view of the chat messages. Only the messages intersecting the viewport have a
+    ChatMessagePanel, the panels are reused when the view is scrolled. The rows height is
+    measured when the message is showed and cached until the view width, the font size or the
+    message are changed, so scrolling and resizing cost is proportional to the visible messages.
+
+    The view keeps the last message visible (auto scroll) while the scroll bar is in the bottom.
+ */
+
+class ChatMessagesView : public QScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit ChatMessagesView(QWidget *parent = nullptr);
+
+    void setModel(ChatMessagesModel *model);
+
+    void setFontSizeOffset(qint8 offset);
+
+    void scrollToBottom();
+    void invalidateRowsGeometry(); // all rows are measured again when showed
+
+    int getCreatedPanels() const;
+
+signals:
+    void blockingUser(const QString &userFullName);
+
+protected:
+    void resizeEvent(QResizeEvent *ev) override;
+    void showEvent(QShowEvent *ev) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void handleRowsInserted(const QModelIndex &parent, int first, int last);
+    void handleRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void handleDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void handleModelReset();
+
+    void layoutRows();
+
+private:
+    struct Row
+    {
+        int top; // -1 until the row is laid out
+        int height; // estimated until the row is measured
+        int width;
+        int measuredWidth; // -1 when the row need be measured
+        bool dirty; // message changed, the panel need be updated
+    };
+
+    ChatMessagesModel *model;
+    QWidget *content;
+
+    QList<Row> rows;
+
+    QHash<quint64, ChatMessagePanel *> panels; // the panels showing the visible messages, by message id
+    QList<ChatMessagePanel *> recycledPanels;
+    int createdPanels;
+
+    QList<QPointer<QWidget>> shownWidgets; // the visible vote, chords and invite buttons
+
+    qint8 fontSizeOffset;
+
+    bool layoutScheduled;
+    bool layingOut;
+    bool stickToBottom;
+    bool rowsTopDirty;
+    int scrollCorrection; // height of the rows removed above the viewport
+
+    void scheduleLayout();
+
+    void updateRowsTop();
+    int findRowAt(int y) const;
+    int getContentHeight() const;
+
+    bool measureRow(int row, int width); // return true if the row height is changed
+
+    ChatMessagePanel *getPanel(quint64 messageId);
+    void recyclePanel(quint64 messageId);
+
+    static const int ROW_SPACING;
+    static const int OVERSCAN; // pixels laid out above and below the viewport
+    static const int ESTIMATED_ROW_HEIGHT;
+};
+
+inline int ChatMessagesView::getCreatedPanels() const
+{
+    return createdPanels;
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "ChatPanel.h"
 #include "ui_ChatPanel.h"
-#include "ChatMessagePanel.h"
+#include "ChatMessagesModel.h"
+#include "ChatMessagesView.h"
 #include "EmojiWidget.h"
 #include "EmojiManager.h"
 #include "gui/TextEditorModifier.h"
@@ -8,7 +9,6 @@
 #include "ninjam/client/User.h"
 
 #include <QWidget>
-#include <QScrollBar>
 #include <QDebug>
 #include <QKeyEvent>
 #include <QWidget>
@@ -38,17 +38,16 @@ ChatPanel::ChatPanel(const QStringList &botNames, UsersColorsPool *colorsPool,
     on(false)
 {
     ui->setupUi(this);
-    QVBoxLayout *contentLayout = new QVBoxLayout(ui->scrollContent);
-    contentLayout->setContentsMargins(0, 0, 0, 0);
-    ui->scrollContent->setLayout(contentLayout);
+
+    messagesModel = new ChatMessagesModel(MAX_MESSAGES, emojiManager, this);
+    ui->chatScroll->setModel(messagesModel);
+    ui->chatScroll->setFontSizeOffset(ChatPanel::fontSizeOffset);
 
     ui->topicLabel->setVisible(false);
 
     // disable blue border when QLineEdit has focus in mac
     ui->chatText->setAttribute(Qt::WA_MacShowFocusRect, 0);
 
-    previousVerticalScrollBarMaxValue = ui->chatScroll->verticalScrollBar()->value();
-
     emojiWidget = new EmojiWidget(emojiManager, this);
     emojiWidget->setVisible(false);
     qobject_cast<QVBoxLayout *>(layout())->insertWidget(layout()->count()-2, emojiWidget);
@@ -62,8 +61,6 @@ ChatPanel::ChatPanel(const QStringList &botNames, UsersColorsPool *colorsPool,
         chatInputModifier->modify(ui->chatText, finishEditorPressingReturnKey);
     }
 
-    ui->scrollContent->installEventFilter(this);
-
     setupSignals();
 
     instances.append(this);
@@ -274,17 +271,13 @@ void ChatPanel::setupSignals()
 {
     connect(ui->chatText, &QLineEdit::returnPressed, this, &ChatPanel::sendNewMessage);
 
-    connect(ui->chatText, &QLineEdit::returnPressed, [=]() {
-        // auto scroll when user is typing new messages
-        int scrollValue = ui->chatScroll->verticalScrollBar()->value();
-        int scrollMaximum = ui->chatScroll->verticalScrollBar()->maximum();
-        if (scrollValue < scrollMaximum) { // need auto scroll?
-            ui->chatScroll->verticalScrollBar()->setValue(scrollMaximum);
-        }
-    });
+    // auto scroll when user is typing new messages
+    connect(ui->chatText, &QLineEdit::returnPressed, ui->chatScroll, &ChatMessagesView::scrollToBottom);
 
-    // this event is used to auto scroll down when new messages are added
-    connect(ui->chatScroll->verticalScrollBar(), &QScrollBar::rangeChanged, this, &ChatPanel::autoScroll);
+    connect(messagesModel, &ChatMessagesModel::startingTranslation, this, &ChatPanel::showTranslationProgressFeedback);
+    connect(messagesModel, &ChatMessagesModel::translationFinished, this, &ChatPanel::hideTranslationProgressFeedback);
+
+    connect(ui->chatScroll, &ChatMessagesView::blockingUser, this, &ChatPanel::userBlockingChatMessagesFrom);
 
     connect(ui->buttonClear, &QPushButton::clicked, this, &ChatPanel::clearMessages);
 
@@ -315,9 +308,7 @@ void ChatPanel::setFontSizeOffset(qint8 sizeOffset)
 
 void ChatPanel::setMessagesFontSizeOffset(qint8 offset)
 {
-    auto messages = ui->scrollContent->findChildren<ChatMessagePanel *>();
-    for (auto msg : messages)
-        msg->setFontSizeOffset(offset);
+    ui->chatScroll->setFontSizeOffset(offset); // only the visible messages are updated
 }
 
 void ChatPanel::increaseFontSize()
@@ -338,15 +329,6 @@ void ChatPanel::decreaseFontSize()
     }
 }
 
-bool ChatPanel::eventFilter(QObject *o, QEvent *e)
-{
-    if (o == ui->scrollContent && e->type() == QEvent::Resize) {
-        ui->scrollContent->setMaximumWidth(ui->chatScroll->viewport()->width());
-    }
-
-    return QWidget::eventFilter(o, e);
-}
-
 void ChatPanel::setTintColor(const QColor &color)
 {
     emojiAction->setIcon(IconFactory::createChatEmojiIcon(color, on));
@@ -402,23 +384,23 @@ void ChatPanel::showEvent(QShowEvent *ev)
 
 void ChatPanel::createServerInviteButton(const QString &serverIP, quint16 serverPort)
 {
-    auto inviteButton = new ServerInviteButton(serverIP, serverPort, this);
+    auto inviteButton = new ServerInviteButton(serverIP, serverPort);
 
     inviteButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
-    ui->scrollContent->layout()->addWidget(inviteButton);
-    ui->scrollContent->layout()->setAlignment(inviteButton, Qt::AlignRight);
     connect(inviteButton, &QPushButton::clicked, [=](){
         emit userAcceptingServerInvite(serverIP, serverPort);
     });
+
+    messagesModel->addWidget(inviteButton);
 }
 
 void ChatPanel::createVoteButton(const QString &voteType, quint32 value, quint32 expireTime)
 {
     QPushButton *voteButton = new NinjamVoteButton(voteType, value, expireTime);
     voteButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
-    ui->scrollContent->layout()->addWidget(voteButton);
-    ui->scrollContent->layout()->setAlignment(voteButton, Qt::AlignRight);
     connect(voteButton, &QPushButton::clicked, this, &ChatPanel::confirmVote);
+
+    messagesModel->addWidget(voteButton);
 }
 
 void ChatPanel::addBpiVoteConfirmationMessage(quint32 newBpiValue, quint32 expireTime)
@@ -439,8 +421,7 @@ void ChatPanel::confirmVote()
     else if (voteButton->isBpmVote())
         emit userConfirmingVoteToBpmChange(voteButton->getVoteValue());
 
-    voteButton->parentWidget()->layout()->removeWidget(voteButton);
-    voteButton->deleteLater();
+    voteButton->deleteLater(); // the chat row is removed when the button is destroyed
 }
 
 // ++++++++++++++++++++++++++++++++++
@@ -453,9 +434,9 @@ void ChatPanel::addChordProgressionConfirmationMessage(const ChordProgression &p
     QPushButton *chordProgressionButton = new ChordProgressionConfirmationButton(buttonText,
                                                                                  progression);
     chordProgressionButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
-    ui->scrollContent->layout()->addWidget(chordProgressionButton);
-    ui->scrollContent->layout()->setAlignment(chordProgressionButton, Qt::AlignRight);
     connect(chordProgressionButton, &QPushButton::clicked, this, &ChatPanel::confirmChordProgression);
+
+    messagesModel->addWidget(chordProgressionButton);
 }
 
 // +++++++++++++++++++++++++++++++
@@ -466,26 +447,9 @@ void ChatPanel::confirmChordProgression()
 
     emit userConfirmingChordProgression(chordProgressionButton->getChordProgression());
 
-    chordProgressionButton->parentWidget()->layout()->removeWidget(chordProgressionButton);
     chordProgressionButton->deleteLater();
 }
 
-// +++++++++++++++
-void ChatPanel::autoScroll(int min, int max)
-{
-    Q_UNUSED(min)
-
-
-    // used to auto scroll down to keep the last added message visible
-
-    int currentValue = ui->chatScroll->verticalScrollBar()->value();
-    if (currentValue >= previousVerticalScrollBarMaxValue) { // avoid auto scroll if the vertical scroll bar is not in max value position (use is scrolling up)
-        ui->chatScroll->verticalScrollBar()->setValue(max + 10);
-    }
-
-    previousVerticalScrollBarMaxValue = max;
-}
-
 void ChatPanel::sendNewMessage()
 {
     QString messageText = ui->chatText->text();
@@ -497,11 +461,7 @@ void ChatPanel::sendNewMessage()
 
 void ChatPanel::updateMessagesGeometry()
 {
-    QList<ChatMessagePanel *> messages = ui->scrollContent->findChildren<ChatMessagePanel *>();
-    foreach (ChatMessagePanel *msg, messages) {
-        msg->setMaximumWidth(ui->chatScroll->viewport()->width() - 20);
-        msg->updateGeometry();
-    }
+    ui->chatScroll->invalidateRowsGeometry();
 }
 
 void ChatPanel::showTranslationProgressFeedback()
@@ -520,11 +480,14 @@ void ChatPanel::hideTranslationProgressFeedback()
 
 void ChatPanel::addLastChordsMessage(const QString &userName, const QString &message, QColor textColor, QColor backgroundColor)
 {
-    ChatMessagePanel *msgPanel = new ChatMessagePanel(ui->scrollContent, userName, message,
-                                                      backgroundColor, textColor, false, false);
-
-    addMessagePanelInLayout(msgPanel, Qt::AlignLeft);
+    ChatMessage chatMessage;
+    chatMessage.authorFullName = userName;
+    chatMessage.text = message;
+    chatMessage.backgroundColor = backgroundColor;
+    chatMessage.textColor = textColor;
 
+    bool emojify = false;
+    messagesModel->addMessage(chatMessage, emojify);
 }
 
 void ChatPanel::addMessage(const QString &localUserName, const QString &msgAuthorFullName, const QString &msgText, bool showTranslationButton, bool showBlockButton)
@@ -537,33 +500,21 @@ void ChatPanel::addMessage(const QString &localUserName, const QString &msgAutho
     bool isBot = backgroundColor == BOT_COLOR;
     bool isLocalUser = ninjam::client::extractUserName(msgAuthorFullName) == localUserName;
 
-    QColor textColor = Qt::black;
-    QColor userNameBackgroundColor = backgroundColor;
-
-    ChatMessagePanel *msgPanel = new ChatMessagePanel(this, fullName, msgText,
-                                                      userNameBackgroundColor, textColor, showTranslationButton, showBlockButton, emojiManager);
-
-    connect(msgPanel, &ChatMessagePanel::startingTranslation, this, &ChatPanel::showTranslationProgressFeedback);
-    connect(msgPanel, &ChatMessagePanel::translationFinished, this, &ChatPanel::hideTranslationProgressFeedback);
-
-    connect(msgPanel, &ChatMessagePanel::blockingUser, this, &ChatPanel::userBlockingChatMessagesFrom);
-
-    msgPanel->setPrefferedTranslationLanguage(autoTranslationLanguage);
-    msgPanel->setShowArrow(!isBot);
-    if (!isBot && isLocalUser) // local user messages are showed in right side
-        msgPanel->setArrowSide(ChatMessagePanel::RightSide);
-
-    Qt::Alignment alignment = Qt::AlignLeft;
-    if (isLocalUser)
-        alignment = Qt::AlignRight;
-
-    addMessagePanelInLayout(msgPanel, alignment);
+    ChatMessage message;
+    message.authorFullName = fullName;
+    message.text = msgText;
+    message.backgroundColor = backgroundColor;
+    message.textColor = Qt::black;
+    message.showTranslationButton = showTranslationButton;
+    message.showBlockButton = showBlockButton;
+    message.showArrow = !isBot;
+    message.localUser = isLocalUser; // local user messages are showed in right side
 
-    msgPanel->setFontSizeOffset(ChatPanel::fontSizeOffset);
+    int row = messagesModel->addMessage(message);
 
     bool canAutoTranslate = autoTranslating && !isLocalUser; // local user messages are not auto translated
     if (canAutoTranslate)
-        msgPanel->translate(); // request the auto translation
+        messagesModel->translate(row); // request the auto translation
 
     if (!isVisible()) {
         setUnreadedMessages(unreadedMessages + 1);
@@ -579,19 +530,6 @@ void ChatPanel::setUnreadedMessages(uint unreaded)
     }
 }
 
-void ChatPanel::addMessagePanelInLayout(ChatMessagePanel *msgPanel, Qt::Alignment alignment)
-{
-    ui->scrollContent->layout()->addWidget(msgPanel);
-    if (ui->scrollContent->layout()->count() > MAX_MESSAGES) {
-        // remove the first widget
-        QList<ChatMessagePanel *> panels = ui->scrollContent->findChildren<ChatMessagePanel *>();
-        ui->scrollContent->layout()->removeWidget(panels.first());
-        delete panels.first();
-    }
-    ui->scrollContent->layout()->setAlignment(Qt::AlignTop);
-    ui->scrollContent->layout()->setAlignment(msgPanel, Qt::AlignTop | alignment);
-}
-
 // +++++++++++++++++++++++++++++++++++=
 QColor ChatPanel::getUserColor(const QString &userName)
 {
@@ -612,31 +550,12 @@ ChatPanel::~ChatPanel()
 
 void ChatPanel::removeMessagesFrom(const QString &userFullName)
 {
-    // remove message panels from user 'userName'
-    auto panels = ui->scrollContent->findChildren<ChatMessagePanel *>();
-    for (auto msgPanel : panels) {
-        if (msgPanel->getUserFullName() == userFullName) {
-            ui->scrollContent->layout()->removeWidget(msgPanel);
-            msgPanel->deleteLater();
-        }
-    }
+    messagesModel->removeMessagesFrom(userFullName);
 }
 
 void ChatPanel::clearMessages()
 {
-    // remove message panels
-    QList<ChatMessagePanel *> panels = ui->scrollContent->findChildren<ChatMessagePanel *>();
-    foreach (ChatMessagePanel *msgPanel, panels) {
-        ui->scrollContent->layout()->removeWidget(msgPanel);
-        msgPanel->deleteLater();
-    }
-
-    // remove Vote and 'load chords' buttons
-    QList<QPushButton *> buttons = ui->scrollContent->findChildren<QPushButton *>();
-    foreach (QPushButton *button, buttons) {
-        ui->scrollContent->layout()->removeWidget(button);
-        button->deleteLater();
-    }
+    messagesModel->clear(); // messages, vote and 'load chords' buttons
 }
 
 void ChatPanel::setPreferredTranslationLanguage(const QString &targetLanguage)
@@ -647,10 +566,7 @@ void ChatPanel::setPreferredTranslationLanguage(const QString &targetLanguage)
     }
     if (languageCode != autoTranslationLanguage) {
         autoTranslationLanguage = languageCode;
-        QList<ChatMessagePanel *> panels = ui->scrollContent->findChildren<ChatMessagePanel *>();
-        foreach (ChatMessagePanel *msgPanel, panels) {
-            msgPanel->setPrefferedTranslationLanguage(languageCode);
-        }
+        messagesModel->setTranslationLanguage(languageCode);
     }
 }
 
@@ -19,7 +19,7 @@ namespace login {
 struct Location;
 }
 
-class ChatMessagePanel;
+class ChatMessagesModel;
 class EmojiWidget;
 class EmojiManager;
 class TextEditorModifier;
@@ -85,7 +85,6 @@ signals:
 
 private slots:
     void sendNewMessage();
-    void autoScroll(int min, int max);
     void clearMessages();
 
     void confirmVote();
@@ -105,7 +104,6 @@ private slots:
 protected:
     void changeEvent(QEvent *) override;
     void showEvent(QShowEvent *) override;
-    bool eventFilter(QObject *, QEvent *) override;
 
 private:
     Ui::ChatPanel *ui;
@@ -118,9 +116,9 @@ private:
 
     QString remoteUserFulName; // used in private chats only
 
-    static const int MAX_MESSAGES = 50;
+    static const int MAX_MESSAGES = 300; // messages and buttons, the oldest are discarded
 
-    int previousVerticalScrollBarMaxValue;
+    ChatMessagesModel *messagesModel;
 
     QString autoTranslationLanguage;
 
@@ -145,8 +143,6 @@ private:
 
     QColor getUserColor(const QString &userName);
 
-    void addMessagePanelInLayout(ChatMessagePanel *msgPanel, Qt::Alignment alignment);
-
     void createVoteButton(const QString &voteType, quint32 value, quint32 expireTime);
 
     void setUnreadedMessages(uint unreaded);
@@ -215,7 +211,7 @@ public:
         QString label = tr("Vote - change %1 to %2 ").arg(voteType).arg(QString::number(voteValue));
         setText(label);
 
-        QTimer::singleShot(expireTime * 1000, this, SLOT(hide()));
+        QTimer::singleShot(expireTime * 1000, this, SLOT(deleteLater())); // the chat row is removed when the button is destroyed
     }
 
     inline int getVoteValue() const
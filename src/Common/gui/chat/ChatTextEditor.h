@@ -11,8 +11,7 @@ public:
     QSize sizeHint() const override;
     QSize minimumSizeHint() const override;
 
-private slots:
-    void updateWidth();
+    void updateWidth(); // called when the text or the maximum width is changed
 
 private:
     quint32 computeBestWidth() const;
@@ -8,7 +8,9 @@
 #include <QFile>
 #include <QDateTime>
 #include <QStandardItemModel>
-#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrent>
+
+#include "log/StartupProfiler.h"
 
 const uint EmojiManager::ICONS_SIZE = 24;
 
@@ -23,8 +25,6 @@ const QStringList EmojiManager::categories = QStringList()
         << "Objects"
         << "Symbols";
 
-const QMap<QString, QString> EmojiManager::combinationsMap = EmojiManager::getCombinationsMap();
-
 
 Emoji::Emoji(const QString &name, const QString category, uint sortOrder, const QString &unifiedCode) :
     name(name),
@@ -51,6 +51,11 @@ QString EmojiManager::getEmojiIconUrl(const Emoji &emoji) const
 }
 
 QString EmojiManager::getEmojiIconUrl(const QString &emojiName) const
+{
+    return getEmojiIconUrl(iconsPath, emojiName);
+}
+
+QString EmojiManager::getEmojiIconUrl(const QString &iconsPath, const QString &emojiName)
 {
     return QString("%1/%2.png")
             .arg(iconsPath)
@@ -59,12 +64,14 @@ QString EmojiManager::getEmojiIconUrl(const QString &emojiName) const
 
 QAbstractItemModel *EmojiManager::getDataModel(int completeRole)
 {
+    waitForData();
+
     QStandardItemModel *model = new QStandardItemModel();
     model->setColumnCount(1);
-    model->setRowCount(generalMap.count());
+    model->setRowCount(data.generalMap.count());
 
     int row = 0;
-    for (const Emoji &emoji : generalMap.values()) {
+    for (const Emoji &emoji : data.generalMap.values()) {
         QString prettyName = QString(emoji.name).replace("_", " ");
         QStandardItem* item = new QStandardItem(prettyName);
         item->setIcon(QPixmap(getEmojiIconUrl(emoji)));
@@ -84,34 +91,46 @@ bool emojiLessThan(const Emoji &e1, const Emoji &e2)
 
  bool EmojiManager::codeIsEmoji(uint code) const
  {
-     return generalMap.contains(code);
+     waitForData();
+
+     return data.generalMap.contains(code);
  }
 
  EmojiManager::EmojiManager(const QString &emojisJsonPath, const QString &emojiIconsPath) :
+     loaded(false),
      iconsPath(emojiIconsPath)
  {
-     loadData(emojisJsonPath);
+     loading = QtConcurrent::run(&EmojiManager::loadData, emojisJsonPath, emojiIconsPath);
  }
 
-QString EmojiManager::emojify(const QString &string)
+void EmojiManager::waitForData() const
 {
-    QString replacedString(string);
+    if (loaded)
+        return;
 
-    for (const QString &combination : combinationsMap.keys())
-        replacedString.replace(QRegularExpression(combination), emojiCodeToUtf8(combinationsMap[combination]));
+    data = loading.result(); // blocking if the emojis are not loaded yet
+    loaded = true;
 
-    QVector<uint> codes = replacedString.toUcs4();
-    QString newString;
-    for (uint code : codes) {
-        if (!EmojiManager::codeIsEmoji(code)) {
-            newString.append(QString::fromUcs4(&code, 1));
-        }
-        else{
-            Emoji emoji = getByCode(code);
-            newString.append(QString("<img src=%1>").arg(getEmojiIconUrl(emoji)));
-        }
-    }
-     return newString;
+    for (const QString &emojiCode : pendingRecents)
+        addRecentEmoji(emojiCode);
+
+    pendingRecents.clear();
+}
+
+void EmojiManager::buildMatcher(EmojiData &data, const QString &iconsPath)
+{
+    QMap<uint, QString> icons;
+    for (auto i = data.generalMap.constBegin(); i != data.generalMap.constEnd(); ++i)
+        icons.insert(i.key(), QString("<img src=%1>").arg(getEmojiIconUrl(iconsPath, i.value().name)));
+
+    data.matcher.build(getShortcuts(), icons);
+}
+
+QString EmojiManager::emojify(const QString &string)
+{
+    waitForData();
+
+    return data.matcher.emojify(string);
 }
 
 QStringList EmojiManager::getCategories() const
@@ -121,11 +140,16 @@ QStringList EmojiManager::getCategories() const
 
 QList<Emoji> EmojiManager::getByCategory(const QString &category) const
 {
-    return categorizedMap[category];
+    waitForData();
+
+    return data.categorizedMap.value(category);
 }
 
-void EmojiManager::loadData(const QString &jsonPath)
+EmojiManager::EmojiData EmojiManager::loadData(const QString &jsonPath, const QString &iconsPath)
 {
+    StartupSpan span("emojis loading");
+
+    EmojiData data;
 
     QStringList skipCategories;
     skipCategories << "Flags";
@@ -133,7 +157,8 @@ void EmojiManager::loadData(const QString &jsonPath)
     QFile json(jsonPath);
     if (!json.open(QIODevice::ReadOnly)) {
         qCritical() << "Error loading emoji.json" << json.errorString();
-        return;
+        buildMatcher(data, iconsPath); // the shortcuts are replaced by the emoji characters
+        return data;
     }
 
     auto doc = QJsonDocument::fromJson(json.readAll());
@@ -146,7 +171,7 @@ void EmojiManager::loadData(const QString &jsonPath)
         QString name = emojiData.value("short_name").toString();
 
         // avoid emoji if the image is not founded in resources
-        if (!QFile(getEmojiIconUrl(name)).exists())
+        if (!QFile(getEmojiIconUrl(iconsPath, name)).exists())
             continue;
 
         QString category = emojiData.value("category").toString();
@@ -164,24 +189,30 @@ void EmojiManager::loadData(const QString &jsonPath)
         Emoji emoji(name, category, sortOrder, unifiedCode);
 
         if (!category.isEmpty()) {
-            categorizedMap[category] << emoji;
+            data.categorizedMap[category] << emoji;
             if (emoji.isMusical)
-                categorizedMap["Music"] << emoji;
+                data.categorizedMap["Music"] << emoji;
         }
 
-        generalMap.insert(code, emoji);
+        data.generalMap.insert(code, emoji);
     }
 
     //sort each loaded category
-    for (auto key : categorizedMap.keys()) {
-        auto &emojis = categorizedMap[key];
+    for (auto key : data.categorizedMap.keys()) {
+        auto &emojis = data.categorizedMap[key];
         qSort(emojis.begin(), emojis.end(), emojiLessThan);
     }
+
+    buildMatcher(data, iconsPath);
+
+    return data;
 }
 
 Emoji EmojiManager::getByCode(uint emojiCode) const
 {
-    return generalMap[emojiCode];
+    waitForData();
+
+    return data.generalMap.value(emojiCode);
 }
 
 QString EmojiManager::emojiCodeToUtf8(const QString &emojiCode)
@@ -200,45 +231,57 @@ QString EmojiManager::emojiCodeToUtf8(const QString &emojiCode)
 
 void EmojiManager::addRecent(const QString &emojiCode)
 {
-    Emoji emoji = getByCode(emojiCode.toInt(0, 16));
-
-    categorizedMap["Recent"].removeAll(emoji);
-    categorizedMap["Recent"].push_front(emoji);
-
     if (!recents.contains(emojiCode))
         recents << emojiCode;
+
+    if (loaded)
+        addRecentEmoji(emojiCode);
+    else
+        pendingRecents << emojiCode; // the recent emojis stored in settings are added while the emojis are loading
 }
 
-QMap<QString, QString> EmojiManager::getCombinationsMap()
-{
-    QMap<QString, QString> combinations;
-
-    combinations.insert(":\\)",   "1F600");
-    combinations.insert(":-\\)",  "1F600");
-    combinations.insert(":\\(",   "1F61E");
-    combinations.insert(":-\\(",  "1F61E");
-    combinations.insert(";\\)",   "1F609");
-    combinations.insert(";-\\)",  "1F609");
-    combinations.insert(":-o\\)", "1F632");
-    combinations.insert(":-O\\)", "1F632");
-    combinations.insert(":p",   "1F61B");
-    combinations.insert(":-p",  "1F61B");
-    combinations.insert(":P",   "1F61B");
-    combinations.insert(":-P",  "1F61B");
-    combinations.insert(":/\\)",  "1F615");
-    combinations.insert(":-/\\)", "1F615");
-    combinations.insert(":D",   "1F603");
-    combinations.insert(":-D\\)", "1F603");
-    combinations.insert(":@",   "1F620");
-    combinations.insert(":-@\\)", "1F620");
-    combinations.insert(":y",   "1F44D");
-    combinations.insert(":n",   "1F44E");
-    combinations.insert(":\\+1",  "1F44D");
-    combinations.insert(":-1",  "1F44E");
-    combinations.insert(":\\*",   "1F617");
-    combinations.insert(":-\\*",  "1F617");
-    combinations.insert(":'\\(",  "1F622");
-    combinations.insert(":'-\\(", "1F622");
-
-    return combinations;
+void EmojiManager::addRecentEmoji(const QString &emojiCode) const
+{
+    Emoji emoji = data.generalMap.value(emojiCode.toInt(0, 16));
+
+    auto &recentEmojis = data.categorizedMap["Recent"];
+    recentEmojis.removeAll(emoji);
+    recentEmojis.push_front(emoji);
+}
+
+QList<EmojiMatcher::Shortcut> EmojiManager::getShortcuts()
+{
+    bool standalone = true; // '+1' and '-1' are not replaced inside numbers and words
+
+    return QList<EmojiMatcher::Shortcut>()
+            << EmojiMatcher::Shortcut{":)",    "1F600", false}
+            << EmojiMatcher::Shortcut{":-)",   "1F600", false}
+            << EmojiMatcher::Shortcut{":(",    "1F61E", false}
+            << EmojiMatcher::Shortcut{":-(",   "1F61E", false}
+            << EmojiMatcher::Shortcut{";)",    "1F609", false}
+            << EmojiMatcher::Shortcut{";-)",   "1F609", false}
+            << EmojiMatcher::Shortcut{":-o)",  "1F632", false}
+            << EmojiMatcher::Shortcut{":-O)",  "1F632", false}
+            << EmojiMatcher::Shortcut{":p",    "1F61B", false}
+            << EmojiMatcher::Shortcut{":-p",   "1F61B", false}
+            << EmojiMatcher::Shortcut{":P",    "1F61B", false}
+            << EmojiMatcher::Shortcut{":-P",   "1F61B", false}
+            << EmojiMatcher::Shortcut{":/)",   "1F615", false}
+            << EmojiMatcher::Shortcut{":-/)",  "1F615", false}
+            << EmojiMatcher::Shortcut{":D",    "1F603", false}
+            << EmojiMatcher::Shortcut{":-D)",  "1F603", false}
+            << EmojiMatcher::Shortcut{":@",    "1F620", false}
+            << EmojiMatcher::Shortcut{":-@)",  "1F620", false}
+            << EmojiMatcher::Shortcut{":y",    "1F44D", false}
+            << EmojiMatcher::Shortcut{"(y)",   "1F44D", false}
+            << EmojiMatcher::Shortcut{":+1",   "1F44D", false}
+            << EmojiMatcher::Shortcut{"+1",    "1F44D", standalone}
+            << EmojiMatcher::Shortcut{":n",    "1F44E", false}
+            << EmojiMatcher::Shortcut{"(n)",   "1F44E", false}
+            << EmojiMatcher::Shortcut{":-1",   "1F44E", false}
+            << EmojiMatcher::Shortcut{"-1",    "1F44E", standalone}
+            << EmojiMatcher::Shortcut{":*",    "1F617", false}
+            << EmojiMatcher::Shortcut{":-*",   "1F617", false}
+            << EmojiMatcher::Shortcut{":'(",   "1F622", false}
+            << EmojiMatcher::Shortcut{":'-(",  "1F622", false};
 }
@@ -8,6 +8,9 @@
 #include <QList>
 #include <QPixmap>
 #include <QAbstractItemModel>
+#include <QFuture>
+
+#include "EmojiMatcher.h"
 
 class Emoji
 {
@@ -30,6 +33,12 @@ public:
     virtual QString emojify(const QString &string) = 0;
 };
 
+/**
+    The emojis are loaded (emoji.json parsing, icons checking and matcher building) in a
+    background thread when the manager is created, the first call needing the emojis waits
+    until the loading is finished.
+ */
+
 class EmojiManager : public Emojifier
 {
 public:
@@ -58,20 +67,35 @@ public:
 
 private:
 
-    void loadData(const QString &jsonPath);
+    struct EmojiData
+    {
+        QMap<QString, QList<Emoji>> categorizedMap; // the category as key
+        QMap<uint, Emoji> generalMap; // the emoji unicode as key
+        EmojiMatcher matcher;
+    };
 
-    QMap<QString, QList<Emoji>> categorizedMap; // the category as key
-    QMap<uint, Emoji> generalMap; // the emoji unicode as key
+    static EmojiData loadData(const QString &jsonPath, const QString &iconsPath); // running in a background thread
 
-    static const QStringList categories;
+    mutable QFuture<EmojiData> loading;
+    mutable bool loaded;
+    mutable EmojiData data;
+
+    mutable QStringList pendingRecents; // added to 'Recent' category when the loading is finished
 
-    static const QMap<QString, QString> combinationsMap;
+    void waitForData() const;
+    void addRecentEmoji(const QString &emojiCode) const;
+
+    static const QStringList categories;
 
     QString iconsPath;
 
     QStringList recents;
 
-    static QMap<QString, QString> getCombinationsMap();
+    static QString getEmojiIconUrl(const QString &iconsPath, const QString &emojiName);
+
+    static void buildMatcher(EmojiData &data, const QString &iconsPath);
+
+    static QList<EmojiMatcher::Shortcut> getShortcuts();
 
 };
 
@@ -0,0 +1,187 @@
+#include "EmojiMatcher.h"
+
+#include <QVarLengthArray>
+#include <QStringList>
+#include <QDebug>
+
+#include <algorithm>
+
+EmojiMatcher::EmojiMatcher() :
+    rootNodes(ASCII_TABLE_SIZE, -1)
+{
+
+}
+
+void EmojiMatcher::build(const QList<Shortcut> &shortcuts, const QMap<uint, QString> &emojiIcons)
+{
+    rootNodes.assign(ASCII_TABLE_SIZE, -1);
+    nodes.clear();
+    emojiCodes.clear();
+    emojiReplacements.clear();
+    replacements.clear();
+
+    // QMap is sorted by key, the codes table is ready for binary search
+    for (auto i = emojiIcons.constBegin(); i != emojiIcons.constEnd(); ++i) {
+        if (i.key() < ASCII_TABLE_SIZE)
+            continue; // ASCII characters are not emojis (the emojis using many code points are loaded with code zero)
+
+        emojiCodes.push_back(i.key());
+        emojiReplacements.push_back(addReplacement(i.value()));
+    }
+
+    for (const auto &shortcut : shortcuts) {
+        const QString &text = shortcut.text;
+        if (text.isEmpty() || text.at(0).unicode() >= ASCII_TABLE_SIZE) {
+            qWarning() << "Invalid emoji shortcut" << text;
+            continue;
+        }
+
+        // the shortcut is replaced by the emoji icon, or by the emoji characters if the icon is not available
+        QString replacement;
+        for (const auto &code : shortcut.emojiCode.split("-")) {
+            uint codePoint = code.toUInt(nullptr, 16);
+            replacement.append(emojiIcons.value(codePoint, QString::fromUcs4(&codePoint, 1)));
+        }
+
+        int parent = -1;
+        for (int i = 0; i < text.size(); ++i) {
+            const ushort character = text.at(i).unicode();
+            int node = (i == 0) ? rootNodes[character] : findChild(parent, character);
+            if (node < 0) {
+                node = static_cast<int>(nodes.size());
+                if (i == 0) {
+                    nodes.push_back(Node{character, -1, -1, -1, false});
+                    rootNodes[character] = node;
+                }
+                else {
+                    nodes.push_back(Node{character, -1, nodes[parent].firstChild, -1, false});
+                    nodes[parent].firstChild = node;
+                }
+            }
+            parent = node;
+        }
+
+        nodes[parent].replacement = addReplacement(replacement);
+        nodes[parent].standalone = shortcut.standalone;
+    }
+}
+
+int EmojiMatcher::addReplacement(const QString &replacement)
+{
+    replacements.append(replacement);
+
+    return replacements.size() - 1;
+}
+
+int EmojiMatcher::findChild(int node, ushort character) const
+{
+    for (int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling) {
+        if (nodes[child].character == character)
+            return child;
+    }
+
+    return -1;
+}
+
+int EmojiMatcher::findEmoji(uint code) const
+{
+    if (emojiCodes.empty() || code < emojiCodes.front() || code > emojiCodes.back())
+        return -1;
+
+    auto i = std::lower_bound(emojiCodes.begin(), emojiCodes.end(), code);
+    if (i == emojiCodes.end() || *i != code)
+        return -1;
+
+    return emojiReplacements[i - emojiCodes.begin()];
+}
+
+int EmojiMatcher::matchShortcut(const QString &text, int position, int &replacement) const
+{
+    const QChar *data = text.constData();
+    const int size = text.size();
+
+    int matchLength = 0; // the longest shortcut is used
+    int length = 1;
+    int node = rootNodes[data[position].unicode()];
+    while (node >= 0) {
+        const Node &n = nodes[node];
+        if (n.replacement >= 0) {
+            bool accepted = true;
+            if (n.standalone) {
+                const bool letterBefore = position > 0 && data[position - 1].isLetterOrNumber();
+                const bool letterAfter = position + length < size && data[position + length].isLetterOrNumber();
+                accepted = !letterBefore && !letterAfter;
+            }
+
+            if (accepted) {
+                matchLength = length;
+                replacement = n.replacement;
+            }
+        }
+
+        if (position + length >= size)
+            break;
+
+        node = findChild(node, data[position + length].unicode());
+        length++;
+    }
+
+    return matchLength;
+}
+
+QString EmojiMatcher::emojify(const QString &text) const
+{
+    const QChar *data = text.constData();
+    const int size = text.size();
+
+    // first step: find the matches and compute the HTML size
+    QVarLengthArray<Match, 32> matches;
+    int htmlSize = size;
+    int position = 0;
+    while (position < size) {
+        const ushort character = data[position].unicode();
+        int replacement = -1;
+        int length = 0;
+
+        if (character < ASCII_TABLE_SIZE) {
+            if (rootNodes[character] >= 0)
+                length = matchShortcut(text, position, replacement);
+        }
+        else if (QChar::isHighSurrogate(character)) {
+            if (position + 1 < size && QChar::isLowSurrogate(data[position + 1].unicode())) {
+                replacement = findEmoji(QChar::surrogateToUcs4(character, data[position + 1].unicode()));
+                length = 2;
+            }
+        }
+        else {
+            replacement = findEmoji(character);
+            length = 1;
+        }
+
+        if (replacement >= 0) {
+            matches.append(Match{position, length, replacement});
+            htmlSize += replacements.at(replacement).size() - length;
+            position += length;
+        }
+        else {
+            position++;
+        }
+    }
+
+    if (matches.isEmpty())
+        return text; // implicitly shared, no copy
+
+    // second step: write the HTML in a single allocation
+    QString html;
+    html.reserve(htmlSize);
+
+    int lastPosition = 0;
+    for (const auto &match : matches) {
+        html.append(data + lastPosition, match.position - lastPosition);
+        html.append(replacements.at(match.replacement));
+        lastPosition = match.position + match.length;
+    }
+    html.append(data + lastPosition, size - lastPosition);
+
+    return html;
+}
@@ -0,0 +1,77 @@
+#ifndef EMOJI_MATCHER_H
+#define EMOJI_MATCHER_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+
+#include <vector>
+
+/**
+    One pass emoji replacement used to render the chat messages.
+
+    The shortcuts (':)', ';-)', etc.) are stored in a trie indexed by the first character, so
+    the characters that can't start a shortcut are skipped with one table lookup. The emoji code
+    points are stored in a sorted table. Both tables are built once, when the emojis are loaded.
+    The message is scanned one time, the output size is computed from the matches and the HTML is
+    written in a single preallocated string.
+ */
+
+class EmojiMatcher
+{
+public:
+    struct Shortcut
+    {
+        QString text;
+        QString emojiCode; // the unified code, '1F600' for example
+        bool standalone; // matched only when not surrounded by letters or digits ('+1', '-1')
+    };
+
+    EmojiMatcher();
+
+    void build(const QList<Shortcut> &shortcuts, const QMap<uint, QString> &emojiIcons); // icon HTML by code point
+
+    QString emojify(const QString &text) const;
+
+    bool isEmpty() const;
+
+private:
+    struct Node
+    {
+        ushort character;
+        int firstChild; // -1 if the node is a leaf
+        int nextSibling;
+        int replacement; // -1 if the node is not the end of a shortcut
+        bool standalone;
+    };
+
+    struct Match
+    {
+        int position;
+        int length;
+        int replacement;
+    };
+
+    static const int ASCII_TABLE_SIZE = 128;
+
+    std::vector<int> rootNodes; // the first node for each ASCII character
+    std::vector<Node> nodes;
+
+    std::vector<uint> emojiCodes; // sorted
+    std::vector<int> emojiReplacements; // index in replacements, parallel to emojiCodes
+
+    QList<QString> replacements;
+
+    int addReplacement(const QString &replacement);
+    int findChild(int node, ushort character) const;
+    int findEmoji(uint code) const;
+
+    int matchShortcut(const QString &text, int position, int &replacement) const; // return the match length
+};
+
+inline bool EmojiMatcher::isEmpty() const
+{
+    return nodes.empty() && emojiCodes.empty();
+}
+
+#endif
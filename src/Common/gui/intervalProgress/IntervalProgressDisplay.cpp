@@ -26,6 +26,13 @@ IntervalProgressDisplay::PaintStrategy::~PaintStrategy()
 
 }
 
+QRectF IntervalProgressDisplay::PaintStrategy::getDirtyRect(const PaintContext &context, int previousBeat) const
+{
+    Q_UNUSED(previousBeat)
+
+    return QRectF(0, 0, context.width, context.height);
+}
+
 IntervalProgressDisplay::IntervalProgressDisplay(QWidget *parent) :
     QFrame(parent),
     paintMode(PaintShape::LINEAR),
@@ -67,8 +74,13 @@ void IntervalProgressDisplay::setShowAccents(bool showAccents)
 void IntervalProgressDisplay::setCurrentBeat(int beat)
 {
     if (beat != currentBeat) {
+        const int previousBeat = currentBeat;
         currentBeat = beat % beatsPerInterval;
-        update();
+
+        if (paintStrategy)
+            update(paintStrategy->getDirtyRect(createPaintContext(), previousBeat).toAlignedRect());
+        else
+            update();
     }
 }
 
@@ -124,9 +136,7 @@ void IntervalProgressDisplay::paintEvent(QPaintEvent *e)
     if (paintStrategy) {
         QPainter p(this);
         p.setRenderHint(QPainter::Antialiasing, true);
-        qreal elementsSize = getElementsSize(paintMode);
-        qreal fontSize = getFontSize(paintMode);
-        PaintContext paintContext(width(), height(), beatsPerInterval, currentBeat, isShowingAccents(), accentBeats, elementsSize, fontSize);
+        PaintContext paintContext = createPaintContext();
         QColor currentBeatColor = usingLowContrastColors ? Qt::lightGray : this->currentBeatColor;
         QBrush textBrush = palette().text(); //using the color defined in loaded stylesheet theme
         PaintColors paintColors(currentBeatColor, secondaryBeatsColor, accentsColor, currentAccentColor, disabledBeatsColor, textBrush, linesColor);
@@ -134,6 +144,13 @@ void IntervalProgressDisplay::paintEvent(QPaintEvent *e)
     }
 }
 
+IntervalProgressDisplay::PaintContext IntervalProgressDisplay::createPaintContext() const
+{
+    qreal elementsSize = getElementsSize(paintMode);
+    qreal fontSize = getFontSize(paintMode);
+    return PaintContext(width(), height(), beatsPerInterval, currentBeat, isShowingAccents(), accentBeats, elementsSize, fontSize);
+}
+
 qreal IntervalProgressDisplay::getFontSize(PaintShape paintMode) const
 {
     qreal baseFontSize = 8.0;
@@ -92,6 +92,9 @@ private:
         virtual ~PaintStrategy();
         virtual void paint(QPainter &p, const PaintContext &context, const PaintColors &colors) = 0;
 
+        // the area repainted when the current beat changes, the entire widget by default
+        virtual QRectF getDirtyRect(const PaintContext &context, int previousBeat) const;
+
     protected:
         QFont font;
     };
@@ -103,6 +106,7 @@ private:
     public:
         LinearPaintStrategy();
         void paint(QPainter &p, const PaintContext &context, const PaintColors &colors) override;
+        QRectF getDirtyRect(const PaintContext &context, int previousBeat) const override;
     private:
         qreal getHorizontalSpace(int width, qreal elementsSize, int totalPoinstToDraw, int initialXPos) const;
         void drawPoint(qreal x, qreal y, qreal size, QPainter &painter, int value, const QBrush &bgPaint, bool small);
@@ -141,6 +145,7 @@ private:
     };
 
     PaintStrategy *createPaintStrategy(PaintShape paintMode) const;
+    PaintContext createPaintContext() const;
     qreal getElementsSize(PaintShape paintMode) const;
     qreal getFontSize(PaintShape paintMode) const;
 
@@ -54,6 +54,21 @@ void IntervalProgressDisplay::LinearPaintStrategy::paint(QPainter &p, const Pain
     drawPoint(xPos, yPos, context.elementsSize, p, (context.currentBeat + 1), bgPaint, false);
 }
 
+QRectF IntervalProgressDisplay::LinearPaintStrategy::getDirtyRect(const PaintContext &context, int previousBeat) const
+{
+    if (context.currentBeat < previousBeat) // new interval, all beats are painted again
+        return PaintStrategy::getDirtyRect(context, previousBeat);
+
+    // only the previous and the current beat points (and the line between them) are changed
+    qreal initialXPos = context.elementsSize / 2.0 + 1;
+    qreal xSpace = getHorizontalSpace(context.width, context.elementsSize, context.beatsPerInterval, initialXPos+1);
+    const qreal margin = context.elementsSize / 2.0 + 2;
+    qreal left = initialXPos + (xSpace * previousBeat) - margin;
+    qreal right = initialXPos + (xSpace * context.currentBeat) + margin;
+
+    return QRectF(left, 0, right - left, context.height);
+}
+
 qreal IntervalProgressDisplay::LinearPaintStrategy::getHorizontalSpace(int width, qreal elementsSize, int totalPoinstToDraw, int initialXPos) const
 {
     return (qreal)(width - initialXPos - elementsSize/2) / (totalPoinstToDraw - 1);
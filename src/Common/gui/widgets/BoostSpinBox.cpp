@@ -1,4 +1,5 @@
 #include "BoostSpinBox.h"
+#include "gui/GuiUtils.h"
 
 #include <QToolTip>
 #include <QBoxLayout>
@@ -33,14 +34,11 @@ BoostSpinBox::BoostSpinBox(QWidget *parent) :
 
 void BoostSpinBox::updateStyleSheet()
 {
-    style()->unpolish(this);
-    style()->polish(this);
+    gui::repolish(this);
 
-    style()->unpolish(buttonDecrease);
-    style()->polish(buttonDecrease);
+    gui::repolish(buttonDecrease);
 
-    style()->unpolish(buttonIncrease);
-    style()->polish(buttonIncrease);
+    gui::repolish(buttonIncrease);
 }
 
 void BoostSpinBox::setOrientation(Qt::Orientation orientation)
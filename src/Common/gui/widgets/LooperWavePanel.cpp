@@ -10,6 +10,8 @@ LooperWavePanel::LooperWavePanel(audio::Looper *looper, quint8 layerIndex) :
       accumulatedSamples(0),
       samplesPerPixel(0),
       samplesPerInterval(0),
+      currentIntervalBeat(0),
+      paintedState(0),
       looper(looper),
       layerID(layerIndex)
 {
@@ -91,14 +93,52 @@ void LooperWavePanel::updateDrawings()
     if (!looper)
         return;
 
-    peaksArray = looper->getLayerPeaks(layerID, samplesPerPixel);
+    setPeaks(looper->getLayerPeaks(layerID, samplesPerPixel));
 
-    update();
+    const quint32 state = computePaintState();
+    if (state != paintedState) {
+        paintedState = state;
+        update();
+    }
+}
+
+quint32 LooperWavePanel::computePaintState() const
+{
+    const bool isCurrentLayer = looper->getCurrentLayerIndex() == layerID;
+
+    quint32 state = 0;
+    state |= canUseHighlightPainting()                          ? (1 << 0) : 0;
+    state |= looper->isPlaying()                                ? (1 << 1) : 0;
+    state |= (looper->isRecording() && isCurrentLayer)          ? (1 << 2) : 0;
+    state |= (looper->isWaitingToRecord() && isCurrentLayer)    ? (1 << 3) : 0;
+    state |= looper->getFocusedLayerIndex() == layerID          ? (1 << 4) : 0;
+    state |= looper->layerIsLocked(layerID)                     ? (1 << 5) : 0;
+    state |= looper->layerIsValid(layerID)                      ? (1 << 6) : 0;
+    state |= looper->isRecording()                              ? (1 << 7) : 0;
+    state |= looper->canSelectLayers()                          ? (1 << 8) : 0;
+    state |= looper->canClearLayer(layerID)                     ? (1 << 9) : 0;
+    state |= miniLockIcon.boundingRect().contains(lastMousePos) ? (1 << 10) : 0;
+    state |= discardIcon.boundingRect().contains(lastMousePos)  ? (1 << 11) : 0;
+
+    return state;
 }
 
 void LooperWavePanel::setCurrentBeat(quint8 currentIntervalBeat)
 {
+    if (currentIntervalBeat == this->currentIntervalBeat)
+        return;
+
+    // repainting the beats between the previous and the current beat, the recording rect is shrinked in new intervals
+    const quint8 firstBeat = qMin(currentIntervalBeat, this->currentIntervalBeat);
+    const quint8 lastBeat = qMax(currentIntervalBeat, this->currentIntervalBeat);
+
     this->currentIntervalBeat = currentIntervalBeat;
+
+    if (!beatsPerInterval)
+        return;
+
+    const qreal pixelsPerBeat = width()/static_cast<qreal>(beatsPerInterval);
+    update(QRectF(firstBeat * pixelsPerBeat, 0, (lastBeat - firstBeat + 1) * pixelsPerBeat, height()).toAlignedRect());
 }
 
 void LooperWavePanel::resizeEvent(QResizeEvent *event)
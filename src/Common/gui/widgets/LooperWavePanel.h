@@ -48,6 +48,9 @@ private:
 
     bool canUseHighlightPainting() const;
 
+    quint32 computePaintState() const; // everything painted over the peaks, except the current beat
+    quint32 paintedState;
+
     float lastMaxPeak;
     uint accumulatedSamples;
 
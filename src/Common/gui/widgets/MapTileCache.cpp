@@ -0,0 +1,113 @@
+#include "MapTileCache.h"
+#include "log/Logging.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QFutureWatcher>
+#include <QFile>
+#include <QCoreApplication>
+
+const int MapTileCache::MAX_COST = 16 * 1024; // 64 tiles with 256 x 256 pixels
+
+MapTileCache *MapTileCache::getInstance()
+{
+    static MapTileCache instance; // thread safe initialization in C++11
+    return &instance;
+}
+
+MapTileCache::MapTileCache() :
+    tiles(MAX_COST),
+    tilesDir(":/tiles/map/")
+{
+    // the instance is a static object destroyed after QApplication, the pixmaps are released in the
+    // QApplication destructor (the plugins delete qApp without quitting, aboutToQuit is not emitted)
+    qAddPostRoutine(&MapTileCache::releaseTiles);
+}
+
+void MapTileCache::releaseTiles()
+{
+    MapTileCache *instance = getInstance();
+
+    qDeleteAll(instance->findChildren<QFutureWatcher<QImage> *>()); // the decoded images are discarded
+
+    instance->tiles.clear();
+    instance->pendingTiles.clear();
+    instance->missingTiles.clear();
+}
+
+void MapTileCache::setTilesDir(const QString &tilesDir)
+{
+    if (this->tilesDir == tilesDir)
+        return;
+
+    this->tilesDir = tilesDir;
+
+    tiles.clear();
+    missingTiles.clear();
+}
+
+quint64 MapTileCache::getTileKey(int zoom, int x, int y)
+{
+    return (static_cast<quint64>(zoom) << 48) | (static_cast<quint64>(static_cast<quint32>(x)) << 24) | static_cast<quint32>(y);
+}
+
+QPixmap MapTileCache::getTile(int zoom, int x, int y)
+{
+    QPixmap *tile = tiles.object(getTileKey(zoom, x, y)); // the tile is moved to the top of LRU list
+    if (tile)
+        return *tile;
+
+    requestTile(zoom, x, y);
+
+    return QPixmap();
+}
+
+void MapTileCache::requestTile(int zoom, int x, int y)
+{
+    const quint64 key = getTileKey(zoom, x, y);
+    if (pendingTiles.contains(key) || missingTiles.contains(key))
+        return;
+
+    pendingTiles.insert(key);
+
+    const QString requestedTilesDir(tilesDir);
+    const QString path = QString(tilesDir + "%1/%2/%3.png").arg(zoom).arg(x).arg(y);
+
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [=]() {
+        pendingTiles.remove(key);
+        if (requestedTilesDir == tilesDir) // tiles dir not changed while decoding
+            insertTile(zoom, x, y, watcher->result());
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&MapTileCache::decodeTile, path));
+}
+
+void MapTileCache::insertTile(int zoom, int x, int y, const QImage &image)
+{
+    if (image.isNull()) {
+        missingTiles.insert(getTileKey(zoom, x, y)); // not requested again
+        return;
+    }
+
+    // QPixmap can be used only in GUI thread, the worker thread decode the image and the conversion is done here
+    auto tile = new QPixmap(QPixmap::fromImage(image));
+    const int cost = qMax(1, tile->width() * tile->height() * tile->depth() / 8 / 1024);
+    tiles.insert(getTileKey(zoom, x, y), tile, cost);
+
+    emit tileLoaded(zoom, x, y);
+}
+
+QImage MapTileCache::decodeTile(const QString &tilePath)
+{
+    if (!QFile::exists(tilePath)) {
+        qCritical() << "Tile not found:" << tilePath;
+        return QImage();
+    }
+
+    QImage image(tilePath);
+    if (image.isNull())
+        qCritical() << "Can't decode the tile" << tilePath;
+
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied); // fast painting
+}
@@ -0,0 +1,68 @@
+#ifndef _MAP_TILE_CACHE_H
+#define _MAP_TILE_CACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
+#include <QImage>
+#include <QString>
+
+/**
+    Map tiles shared by all MapWidgets.
+
+    Tiles are decoded on demand, only when a map needs to paint them. The PNG files are decoded
+    in the global thread pool and tileLoaded() is emitted (in the GUI thread) when the tile is
+    ready, so the maps can repaint. The cache is a LRU cache limited by MAX_COST (in KB), the
+    least recently painted tiles are discarded first. Tiles from different zoom levels can be
+    cached at same time. The cache is cleared in QApplication destructor, the pixmaps can't
+    outlive QApplication.
+ */
+
+class MapTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MapTileCache *getInstance();
+
+    QPixmap getTile(int zoom, int x, int y); // a null pixmap is returned (and the tile is requested) when the tile is not loaded
+
+    void setTilesDir(const QString &tilesDir); // the cache is cleared
+    QString getTilesDir() const;
+
+    int getCachedTiles() const;
+
+    static const int MAX_COST; // in KB
+
+signals:
+    void tileLoaded(int zoom, int x, int y);
+
+private:
+    MapTileCache();
+
+    QCache<quint64, QPixmap> tiles;
+    QSet<quint64> pendingTiles; // tiles being decoded
+    QSet<quint64> missingTiles; // tiles not found or not decoded
+
+    QString tilesDir;
+
+    void requestTile(int zoom, int x, int y);
+    void insertTile(int zoom, int x, int y, const QImage &image);
+
+    static quint64 getTileKey(int zoom, int x, int y);
+    static QImage decodeTile(const QString &tilePath);
+    static void releaseTiles(); // post routine, called in QApplication destructor
+};
+
+inline QString MapTileCache::getTilesDir() const
+{
+    return tilesDir;
+}
+
+inline int MapTileCache::getCachedTiles() const
+{
+    return tiles.count();
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "MapWidget.h"
+#include "MapTileCache.h"
 #include <QtCore>
 #include <QtWidgets>
 #include <QDebug>
@@ -10,20 +11,12 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-QString MapWidget::TILES_DIR = ":/tiles/map/";
 const int MapWidget::TILES_SIZE = 256; // tile size in pixels
 const qreal MapWidget::TEXT_MARGIM = 3;
 const int MapWidget::MARKER_POSITIONS = 8;
 bool MapWidget::usingNightMode = false;
 const int MapWidget::ZOOM = 1; // fixed zoom level
 
-QHash<QPoint, QPixmap> MapWidget::tilePixmaps;
-
-uint qHash(const QPoint& p)
-{
-    return p.x() * 17 ^ p.y();
-}
-
 QPointF tileForCoordinate(qreal lat, qreal lng, int zoom)
 {
     qreal zn = static_cast<qreal>(1 << zoom);
@@ -53,12 +46,16 @@ qreal getDistance(const QPointF &p1, const QPointF &p2)
 MapWidget::MapWidget(QWidget *parent) :
     QWidget(parent),
     blurActivated(false),
+    mapPixmapNightMode(false),
+    mapPixmapComplete(false),
     markerTextBackgroundColor(QColor(0, 0, 0, 120)),
     markerColor(Qt::red),
     markerTextColor(Qt::white),
     markerLineConnectorColor(QColor(0, 0, 0, 180))
 {
-    loadTiles();
+    // tiles are loaded when the map is painted the first time
+    connect(MapTileCache::getInstance(), &MapTileCache::tileLoaded, this, &MapWidget::handleTileLoaded);
+
     setCenter(QPointF(0, 0));
     installEventFilter(this);
     initializeCountryFont();
@@ -68,33 +65,38 @@ void MapWidget::setMarkerTextBackgroundColor(const QColor &color)
 {
     markerTextBackgroundColor = color;
 
-    update();
+    invalidateMapPixmap();
 }
 
 void MapWidget::setMarkerLineConnectorColor(const QColor &color)
 {
     markerLineConnectorColor = color;
 
-    update();
+    invalidateMapPixmap();
 }
 
 void MapWidget::setMarkerTextColor(const QColor &color)
 {
     markerTextColor = color;
 
-    update();
+    invalidateMapPixmap();
 }
 
 void MapWidget::setMarkerColor(const QColor &color)
 {
     markerColor = color;
 
-    update();
+    invalidateMapPixmap();
 }
 
 void MapWidget::setBlurMode(bool blurEnabled)
 {
+    if (blurActivated == blurEnabled)
+        return;
+
     this->blurActivated = blurEnabled;
+
+    invalidateMapPixmap();
 }
 
 void MapWidget::initializeCountryFont()
@@ -111,7 +113,7 @@ void MapWidget::initializeCountryFont()
 
 void MapWidget::setTilesDir(const QString &newDir)
 {
-    MapWidget::TILES_DIR = newDir;
+    MapTileCache::getInstance()->setTilesDir(newDir);
 }
 
 QPointF MapWidget::getCenterLatLong() const
@@ -262,19 +264,43 @@ void MapWidget::invalidate()
     // build a rect
     tilesRect = QRect(xs, ys, xe - xs + 1, ye - ys + 1);
 
+    invalidateMapPixmap();
+}
+
+void MapWidget::invalidateMapPixmap()
+{
+    mapPixmap = QPixmap();
+
     update();
 }
 
-void MapWidget::loadTiles()
+void MapWidget::handleTileLoaded(int zoom, int x, int y)
 {
-    int totalTiles = std::pow(2, ZOOM);
-    for (int x = 0; x < totalTiles; ++x) {
-        for (int y = 0; y < totalTiles; ++y) {
-            QPoint tp(x, y);
-            if (!tilePixmaps.contains(tp)) {
-                tilePixmaps.insert(tp, loadTile(ZOOM, x, y));
-            }
-        }
+    Q_UNUSED(x)
+    Q_UNUSED(y)
+
+    if (zoom == ZOOM && !mapPixmapComplete && !mapPixmap.isNull())
+        invalidateMapPixmap(); // rendering again with the new tile
+}
+
+void MapWidget::renderMapPixmap()
+{
+    const qreal pixelRatio = devicePixelRatioF();
+    mapPixmap = QPixmap(size() * pixelRatio);
+    mapPixmap.setDevicePixelRatio(pixelRatio);
+    mapPixmap.fill(Qt::transparent);
+    mapPixmapNightMode = MapWidget::usingNightMode;
+
+    QPainter p(&mapPixmap);
+    p.setFont(font());
+    p.setRenderHint(QPainter::Antialiasing, true);
+
+    mapPixmapComplete = drawMapTiles(p, rect());
+
+    drawPlayersMarkers(p);
+
+    if (blurActivated) {
+        p.fillRect(rect(), QColor(0, 0, 0, 140)); // draw a transparent black layer and create more contrast to show the sound wave
     }
 }
 
@@ -296,25 +322,16 @@ void MapWidget::resizeEvent(QResizeEvent *)
     if (!markers.isEmpty())
         updateMapPositionsCache();
 
-    setCenter(getCenterLatLong());
+    setCenter(getCenterLatLong()); // the map pixmap is rendered again in the new size
 }
 
-QPixmap MapWidget::loadTile(int zoomLevel, int x, int y)
+bool MapWidget::drawMapTiles(QPainter &p, const QRect &rect)
 {
-    QString path(MapWidget::TILES_DIR + "%1/%2/%3.png");
-    path = path.arg(zoomLevel).arg(x).arg(y);
-    QFile imageFile(path);
-    if (!imageFile.exists()) {
-        qCritical() << "Tile not found to zoom:" << zoomLevel << " x:" << x << " y:" << y;
-        return QPixmap();
-    }
-
-    return QPixmap(path);
-}
+    auto tileCache = MapTileCache::getInstance();
 
-void MapWidget::drawMapTiles(QPainter &p, const QRect &rect)
-{
-    int tiles = std::pow(2, ZOOM);
+    bool allTilesLoaded = true;
+    QRegion tilesRegion;
+    int tiles = 1 << ZOOM;
     for (int x = 0; x <= tilesRect.width(); ++x) {
         for (int y = 0; y <= tilesRect.height(); ++y) {
             QPoint tp(x + tilesRect.left(), y + tilesRect.top());
@@ -322,8 +339,13 @@ void MapWidget::drawMapTiles(QPainter &p, const QRect &rect)
             if (rect.intersects(box)) {
                 tp.setX((tp.x() + tiles) % tiles);
                 tp.setY((tp.y() + tiles) % tiles);
-                if (tilePixmaps.contains(tp)) {
-                    p.drawPixmap(box, tilePixmaps.value(tp));
+                QPixmap tile = tileCache->getTile(ZOOM, tp.x(), tp.y()); // only the visible tiles are decoded
+                if (!tile.isNull()) {
+                    p.drawPixmap(box, tile);
+                    tilesRegion += box;
+                }
+                else {
+                    allTilesLoaded = false;
                 }
             }
         }
@@ -332,9 +354,13 @@ void MapWidget::drawMapTiles(QPainter &p, const QRect &rect)
     if (MapWidget::usingNightMode) {
         QPainter::CompositionMode compositionMode = p.compositionMode();
         p.setCompositionMode(QPainter::CompositionMode_Difference);
+        p.setClipRegion(tilesRegion.intersected(rect)); // the areas without tiles are kept transparent
         p.fillRect(rect, Qt::white);
+        p.setClipping(false);
         p.setCompositionMode(compositionMode);
     }
+
+    return allTilesLoaded;
 }
 
 void MapWidget::enterEvent(QEvent *)
@@ -349,17 +375,16 @@ void MapWidget::leaveEvent(QEvent *)
 
 void MapWidget::paintEvent(QPaintEvent *event)
 {
+    Q_UNUSED(event)
+
+    if (mapPixmap.isNull() || mapPixmapNightMode != MapWidget::usingNightMode)
+        renderMapPixmap();
+
     QPainter p(this);
     p.setFont(font());
     p.setRenderHint(QPainter::Antialiasing, true);
 
-    drawMapTiles(p, event->rect());
-
-    drawPlayersMarkers(p);
-
-    if (blurActivated) {
-        p.fillRect(rect(), QColor(0, 0, 0, 140)); // draw a transparent black layer and create more contrast to show the sound wave
-    }
+    p.drawPixmap(0, 0, mapPixmap);
 
     if (underMouse()) {
         drawCountriesLegend(p);
@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include <QMap>
+#include <QPixmap>
 #include "MapMarker.h"
 #include <QMouseEvent>
 
@@ -41,7 +42,7 @@ protected:
 
     void changeEvent(QEvent *) override;
 private slots:
-    void loadTiles();
+    void handleTileLoaded(int zoom, int x, int y);
 
 private:
     static const int ZOOM;
@@ -50,16 +51,22 @@ private:
 
     QPoint offset;
     QRect tilesRect;
-    static QHash<QPoint, QPixmap> tilePixmaps; // tiles cache
 
     static bool usingNightMode;
 
     QList<MapMarker> markers;
 
+    // tiles, markers and blur layer rendered once per size, only the countries legend is painted in all paint events
+    QPixmap mapPixmap;
+    bool mapPixmapNightMode;
+    bool mapPixmapComplete; // all visible tiles were loaded when the pixmap was rendered
+
     void invalidate();
+    void invalidateMapPixmap();
+    void renderMapPixmap();
     QRect tileRect(const QPoint &tp) const;
 
-    void drawMapTiles(QPainter &p, const QRect &rect);
+    bool drawMapTiles(QPainter &p, const QRect &rect); // return false when some tile is not loaded yet
     void drawPlayersMarkers(QPainter &p);
     void drawMarker(const MapMarker &marker, QPainter &p, const QPointF &markerPosition, const QPointF &rectPosition, bool drawMarker);
 
@@ -74,8 +81,6 @@ private:
 
     void setCenter(QPointF latLong);
 
-    QPixmap loadTile(int zoomLevel, int x, int y);
-
     QPointF getCenterLatLong() const;
 
     QRectF computeMinimumRect(int ZOOM) const;
@@ -110,7 +115,6 @@ private:
 
     bool blurActivated;
 
-    static QString TILES_DIR;
     static const qreal TEXT_MARGIM;
     static const int TILES_SIZE;
     static const int MARKER_POSITIONS;
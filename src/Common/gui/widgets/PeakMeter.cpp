@@ -1,5 +1,7 @@
 #include "PeakMeter.h"
 #include "Utils.h"
+#include "gui/RepaintScheduler.h"
+#include "gui/GuiUtils.h"
 #include <QDebug>
 #include <QResizeEvent>
 #include <QDateTime>
@@ -46,8 +48,7 @@ BaseMeter::~BaseMeter()
 
 void BaseMeter::updateStyleSheet()
 {
-    style()->unpolish(this);
-    style()->polish(this);
+    gui::repolish(this);
 }
 
 void BaseMeter::resizeEvent(QResizeEvent * /*ev*/)
@@ -127,6 +128,8 @@ AudioMeter::AudioMeter(QWidget *parent) :
         currentRms[i] = 0.0f;
         lastMaxPeakTime[i] = 0;
     }
+
+    paintedLevels = computeMeterLevels();
 }
 
 void AudioMeter::setDrawSegments(bool drawSegments)
@@ -291,45 +294,112 @@ void AudioMeter::paintEvent(QPaintEvent *)
 
         const uint channels = stereo ? 2 : 1;
         const qreal rectSize = isVertical() ? height() : width();
-        QRectF drawRect(rect().adjusted(1, 1, 0, 0));
-
-        const int parallelSegments = getParallelSegments();
-
-        if (isVertical())
-            drawRect.setWidth(drawRect.width()/static_cast<qreal>(parallelSegments));
-        else
-            drawRect.setHeight(drawRect.height()/static_cast<qreal>(parallelSegments));
 
         for (uint i = 0; i < channels; ++i) {
+            const QRectF peakRect(getMeterLaneRect(i, false));
+
             if (paintingPeaks && currentPeak[i]) {
                 qreal peakPosition = getPeakPosition(currentPeak[i], rectSize, peakValuesOffset);
-                paintSegments(painter, drawRect, peakPosition, peakColors, drawSegments);
+                paintSegments(painter, peakRect, peakPosition, peakColors, drawSegments);
             }
 
             if (paintingMaxPeakMarker && maxPeak[i]) {
                 qreal maxPeakPosition = getPeakPosition(maxPeak[i], rectSize, peakValuesOffset);
-                paintMaxPeakMarker(painter, maxPeakPosition, drawRect);
+                paintMaxPeakMarker(painter, maxPeakPosition, peakRect);
             }
 
             if (paintingRMS && currentRms[i]) {
                 qreal rmsPosition = getPeakPosition(currentRms[i], rectSize, peakValuesOffset);
-
-                qreal rmsXOffset = (paintingPeaks && isVertical()) ? channels * drawRect.width() : 0;
-                qreal rmsYOffset = (paintingPeaks && !isVertical()) ? channels * drawRect.height() : 0;
-                paintSegments(painter, drawRect.translated(rmsXOffset, rmsYOffset), rmsPosition, rmsColors, drawSegments);
+                paintSegments(painter, getMeterLaneRect(i, true), rmsPosition, rmsColors, drawSegments);
             }
-
-            if (isVertical())
-                drawRect.translate(drawRect.width(), 0.0);
-            else
-                drawRect.translate(0.0, drawRect.height());
         }
 
         if (paintingDbMarkers)
             painter.drawPixmap(0.0, 0.0, dbMarkersPixmap);
    }
+}
 
-    updateInternalValues(); // compute decay and max peak
+QRectF AudioMeter::getMeterLaneRect(uint channel, bool rms) const
+{
+    const uint channels = stereo ? 2 : 1;
+    const qreal parallelSegments = getParallelSegments();
+
+    QRectF laneRect(rect().adjusted(1, 1, 0, 0));
+    if (isVertical())
+        laneRect.setWidth(laneRect.width()/parallelSegments);
+    else
+        laneRect.setHeight(laneRect.height()/parallelSegments);
+
+    const uint lane = (rms && paintingPeaks) ? (channels + channel) : channel; // RMS lanes are after the peak lanes
+
+    if (isVertical())
+        laneRect.translate(lane * laneRect.width(), 0.0);
+    else
+        laneRect.translate(0.0, lane * laneRect.height());
+
+    return laneRect;
+}
+
+AudioMeter::MeterLevels AudioMeter::computeMeterLevels() const
+{
+    const static qreal peakValuesOffset = MAX_SMOOTHED_LINEAR_VALUE - 1.0f;
+
+    const qreal rectSize = isVertical() ? height() : width();
+
+    MeterLevels levels;
+    for (uint i = 0; i < 2; ++i) {
+        // peaks and RMS are painted in segments, the max peak marker is painted in any pixel
+        levels.peak[i] = (paintingPeaks && currentPeak[i]) ? static_cast<int>(qMax(0.0, getPeakPosition(currentPeak[i], rectSize, peakValuesOffset))) / SEGMENTS_SIZE : 0;
+        levels.rms[i] = (paintingRMS && currentRms[i]) ? static_cast<int>(qMax(0.0, getPeakPosition(currentRms[i], rectSize, peakValuesOffset))) / SEGMENTS_SIZE : 0;
+        levels.maxPeak[i] = (paintingMaxPeakMarker && maxPeak[i]) ? qRound(getPeakPosition(maxPeak[i], rectSize, peakValuesOffset)) : -1;
+    }
+
+    levels.paintFlags = (paintingPeaks ? 1 : 0) | (paintingRMS ? 2 : 0) | (paintingMaxPeakMarker ? 4 : 0) | (stereo ? 8 : 0);
+
+    return levels;
+}
+
+void AudioMeter::invalidateMeterLevels()
+{
+    const MeterLevels levels = computeMeterLevels();
+    const MeterLevels previousLevels = paintedLevels;
+    paintedLevels = levels;
+
+    if (!isEnabled() || !isVisible())
+        return;
+
+    if (levels.paintFlags != previousLevels.paintFlags) { // the lanes layout changed
+        update();
+        return;
+    }
+
+    const uint channels = stereo ? 2 : 1;
+    QRect dirtyRect;
+    for (uint i = 0; i < channels; ++i) {
+        const QRectF peakRect(getMeterLaneRect(i, false));
+
+        if (levels.peak[i] != previousLevels.peak[i]) {
+            const qreal origin = isVertical() ? peakRect.height() : peakRect.left(); // same origin used in paintSegments
+            dirtyRect |= RepaintScheduler::getLevelsRect(peakRect, origin, previousLevels.peak[i] * SEGMENTS_SIZE, levels.peak[i] * SEGMENTS_SIZE, orientation);
+        }
+
+        if (levels.maxPeak[i] != previousLevels.maxPeak[i]) {
+            const qreal origin = isVertical() ? height() : peakRect.left(); // same origin used in paintMaxPeakMarker
+            for (int position : {previousLevels.maxPeak[i], levels.maxPeak[i]}) {
+                if (position >= 0)
+                    dirtyRect |= RepaintScheduler::getLevelsRect(peakRect, origin, position, position, orientation, MAX_PEAK_MARKER_SIZE + 1);
+            }
+        }
+
+        if (levels.rms[i] != previousLevels.rms[i]) {
+            const QRectF rmsRect(getMeterLaneRect(i, true));
+            const qreal origin = isVertical() ? rmsRect.height() : rmsRect.left();
+            dirtyRect |= RepaintScheduler::getLevelsRect(rmsRect, origin, previousLevels.rms[i] * SEGMENTS_SIZE, levels.rms[i] * SEGMENTS_SIZE, orientation);
+        }
+    }
+
+    if (!dirtyRect.isNull())
+        update(dirtyRect);
 }
 
 QSize AudioMeter::minimumSizeHint() const
@@ -432,6 +502,8 @@ std::vector<float> AudioMeter::createDBValues()
 
 void AudioMeter::setPeak(float peak, float rms)
 {
+    updateInternalValues(); // compute decay and max peak
+
     peak = limitFloatValue(peak, 0.0f, AudioMeter::MAX_LINEAR_VALUE);
     rms = limitFloatValue(rms, 0.0f, AudioMeter::MAX_LINEAR_VALUE);
 
@@ -446,12 +518,14 @@ void AudioMeter::setPeak(float peak, float rms)
     if (rms > currentRms[0] || rms > currentRms[1])
         currentRms[0] = currentRms[1] = rms;
 
-    update();
+    invalidateMeterLevels();
 }
 
 
 void AudioMeter::setPeak(float leftPeak, float rightPeak, float leftRms, float rightRms)
 {
+    updateInternalValues(); // compute decay and max peak
+
     leftPeak = limitFloatValue(leftPeak, 0.0f, AudioMeter::MAX_LINEAR_VALUE);
     rightPeak = limitFloatValue(rightPeak, 0.0f, AudioMeter::MAX_LINEAR_VALUE);
 
@@ -480,7 +554,7 @@ void AudioMeter::setPeak(float leftPeak, float rightPeak, float leftRms, float r
             currentRms[i] = rms[i];
     }
 
-    update();
+    invalidateMeterLevels();
 }
 
 void AudioMeter::setPaintMaxPeakMarker(bool paintMaxPeak)
@@ -521,7 +595,8 @@ bool AudioMeter::isPaintingRmsOnly()
 MidiActivityMeter::MidiActivityMeter(QWidget *parent) :
     BaseMeter(parent),
     midiActivityColor(Qt::red),
-    activityValue(0)
+    activityValue(0),
+    paintedSegments(0)
 {
 
 }
@@ -549,10 +624,36 @@ void MidiActivityMeter::paintEvent(QPaintEvent *)
     if (isEnabled()) {
         float value = (isVertical() ? height() : width()) * activityValue;
         paintSegments(painter, rect(), value, colors);
-        updateInternalValues();
     }
 }
 
+int MidiActivityMeter::computeSegments() const
+{
+    return static_cast<int>((isVertical() ? height() : width()) * activityValue) / SEGMENTS_SIZE;
+}
+
+void MidiActivityMeter::invalidateSegments()
+{
+    const int segments = computeSegments();
+    if (segments == paintedSegments)
+        return;
+
+    const int previousSegments = paintedSegments;
+    paintedSegments = segments;
+
+    if (isEnabled() && isVisible()) {
+        const QRectF meterRect(rect());
+        const qreal origin = isVertical() ? meterRect.height() : meterRect.left();
+        update(RepaintScheduler::getLevelsRect(meterRect, origin, previousSegments * SEGMENTS_SIZE, segments * SEGMENTS_SIZE, orientation));
+    }
+}
+
+void MidiActivityMeter::updateActivity()
+{
+    updateInternalValues();
+    invalidateSegments();
+}
+
 void MidiActivityMeter::updateInternalValues()
 {
     quint64 now = QDateTime::currentMSecsSinceEpoch();
@@ -576,7 +677,11 @@ void MidiActivityMeter::setSolidColor(const QColor &color)
 
 void MidiActivityMeter::setActivityValue(float value)
 {
+    updateInternalValues();
+
     this->activityValue = limitFloatValue(value);
+
+    invalidateSegments();
 }
 
 QSize MidiActivityMeter::minimumSizeHint() const
@@ -146,6 +146,21 @@ private:
 
     uint getParallelSegments() const;
 
+    QRectF getMeterLaneRect(uint channel, bool rms) const;
+
+    struct MeterLevels // quantized meter values, in pixels
+    {
+        int peak[2];
+        int rms[2];
+        int maxPeak[2];
+        quint8 paintFlags; // the lanes layout
+    };
+
+    MeterLevels paintedLevels; // the levels invalidated in the last update
+
+    MeterLevels computeMeterLevels() const;
+    void invalidateMeterLevels(); // repaint only the lane parts changed since the last update
+
     QColor interpolateColor(const QColor &start, const QColor &end, float ratio);
 
     static qreal getSmoothedLinearPeakValue(qreal linearValue);
@@ -173,6 +188,7 @@ public:
     explicit MidiActivityMeter(QWidget *parent);
     void setSolidColor(const QColor &color);
     void setActivityValue(float value);
+    void updateActivity(); // compute the decay and repaint the changed segments
 
     QSize minimumSizeHint() const override;
 
@@ -184,8 +200,11 @@ private:
     QColor midiActivityColor;
     std::vector<QColor> colors;
     float activityValue;
+    int paintedSegments;
 
     void updateInternalValues();
+    int computeSegments() const;
+    void invalidateSegments();
 
     static const int MIN_SIZE;
 };
@@ -1,4 +1,5 @@
 #include "Slider.h"
+#include "gui/RepaintScheduler.h"
 
 #include <QPainter>
 #include <QStyle>
@@ -42,8 +43,14 @@ AudioSlider::AudioSlider(QWidget *parent) :
 
     connect(this, &AudioSlider::valueChanged, this, &AudioSlider::showToolTip);
 
-    currentPeak[0] = currentPeak[1] = 0;
-    currentRms[0] = currentRms[1] = 0;
+    for (int i = 0; i < 2; ++i) {
+        currentPeak[i] = 0;
+        currentRms[i] = 0;
+        maxPeak[i] = 0;
+        lastMaxPeakTime[i] = 0;
+    }
+
+    paintedLevels = computeMeterLevels();
 }
 
 void AudioSlider::setShowMeterOnly(bool showMeterOnly)
@@ -93,6 +100,8 @@ bool AudioSlider::isPaintingRmsOnly()
 
 void AudioSlider::setPeak(float peak, float rms)
 {
+    updateInternalValues(); // compute decay and max peak
+
     auto maxLinearValue = Utils::linearGainToPower(getMaxLinearValue());
 
     peak = limitFloatValue(peak, 0.0f, maxLinearValue);
@@ -109,12 +118,14 @@ void AudioSlider::setPeak(float peak, float rms)
     if (rms > currentRms[0] || rms > currentRms[1])
         currentRms[0] = currentRms[1] = rms;
 
-    update();
+    invalidateMeterLevels();
 }
 
 
 void AudioSlider::setPeak(float leftPeak, float rightPeak, float leftRms, float rightRms)
 {
+    updateInternalValues(); // compute decay and max peak
+
     auto maxLinearValue = Utils::linearGainToPower(getMaxLinearValue());
 
     leftPeak = limitFloatValue(leftPeak, 0.0f, maxLinearValue);
@@ -145,7 +156,7 @@ void AudioSlider::setPeak(float leftPeak, float rightPeak, float leftRms, float
             currentRms[i] = rms[i];
     }
 
-    update();
+    invalidateMeterLevels();
 }
 
 
@@ -249,38 +260,25 @@ void AudioSlider::paintEvent(QPaintEvent *)
         const uint channels = stereo ? 2 : 1;
         const qreal rectSize = isVertical() ? height() : width();
 
-        QRectF drawRect(getGrooveRect());
-
-        const int parallelSegments = getParallelSegments();
-
-        if (isVertical())
-            drawRect.setWidth(drawRect.width()/static_cast<qreal>(parallelSegments));
-        else
-            drawRect.setHeight(drawRect.height()/static_cast<qreal>(parallelSegments));
+        const QRectF grooveRect(getGrooveRect());
 
         for (uint i = 0; i < channels; ++i) {
+            const QRectF peakRect(getMeterLaneRect(grooveRect, i, false));
+
             if (paintingPeaks && currentPeak[i]) {
                 qreal peakPosition = getPeakPosition(currentPeak[i], rectSize);
-                paintSegments(painter, drawRect, peakPosition, peakColors, drawSegments);
+                paintSegments(painter, peakRect, peakPosition, peakColors, drawSegments);
             }
 
             if (paintingMaxPeakMarker && maxPeak[i]) {
                 qreal maxPeakPosition = getPeakPosition(maxPeak[i], rectSize);
-                paintMaxPeakMarker(painter, maxPeakPosition, drawRect);
+                paintMaxPeakMarker(painter, maxPeakPosition, peakRect);
             }
 
             if (paintingRMS && currentRms[i]) {
                 qreal rmsPosition = getPeakPosition(currentRms[i], rectSize);
-
-                qreal rmsXOffset = (paintingPeaks && isVertical()) ? channels * drawRect.width() : 0;
-                qreal rmsYOffset = (paintingPeaks && !isVertical()) ? channels * drawRect.height() : 0;
-                paintSegments(painter, drawRect.translated(rmsXOffset, rmsYOffset), rmsPosition, rmsColors, drawSegments);
+                paintSegments(painter, getMeterLaneRect(grooveRect, i, true), rmsPosition, rmsColors, drawSegments);
             }
-
-            if (isVertical())
-                drawRect.translate(drawRect.width(), 0.0);
-            else
-                drawRect.translate(0.0, drawRect.height());
         }
     }
 
@@ -294,9 +292,98 @@ void AudioSlider::paintEvent(QPaintEvent *)
 
         paintSliderHandler(painter);
     }
+}
+
+QRectF AudioSlider::getMeterLaneRect(const QRectF &grooveRect, uint channel, bool rms) const
+{
+    const uint channels = stereo ? 2 : 1;
+    const qreal parallelSegments = getParallelSegments();
+
+    QRectF laneRect(grooveRect);
+    if (isVertical())
+        laneRect.setWidth(grooveRect.width()/parallelSegments);
+    else
+        laneRect.setHeight(grooveRect.height()/parallelSegments);
+
+    const uint lane = (rms && paintingPeaks) ? (channels + channel) : channel; // RMS lanes are after the peak lanes
+
+    if (isVertical())
+        laneRect.translate(lane * laneRect.width(), 0.0);
+    else
+        laneRect.translate(0.0, lane * laneRect.height());
+
+    return laneRect;
+}
+
+AudioSlider::MeterLevels AudioSlider::computeMeterLevels() const
+{
+    const qreal rectSize = isVertical() ? height() : width();
+
+    MeterLevels levels;
+    for (uint i = 0; i < 2; ++i) {
+        // peaks and RMS are painted in segments, the max peak marker is painted in any pixel
+        levels.peak[i] = (paintingPeaks && currentPeak[i]) ? static_cast<int>(qMax(0.0, getPeakPosition(currentPeak[i], rectSize))) / SEGMENTS_SIZE : 0;
+        levels.rms[i] = (paintingRMS && currentRms[i]) ? static_cast<int>(qMax(0.0, getPeakPosition(currentRms[i], rectSize))) / SEGMENTS_SIZE : 0;
+        levels.maxPeak[i] = (paintingMaxPeakMarker && maxPeak[i]) ? qRound(getPeakPosition(maxPeak[i], rectSize)) : -1;
+    }
+
+    levels.paintFlags = (paintingPeaks ? 1 : 0) | (paintingRMS ? 2 : 0) | (paintingMaxPeakMarker ? 4 : 0) | (stereo ? 8 : 0);
+
+    return levels;
+}
+
+void AudioSlider::invalidateMeterLevels()
+{
+    const MeterLevels levels = computeMeterLevels();
+    const MeterLevels previousLevels = paintedLevels;
+    paintedLevels = levels;
+
+    if (!isEnabled() || showSliderOnly || !isVisible())
+        return;
+
+    if (levels.paintFlags != previousLevels.paintFlags) { // the lanes layout changed
+        update();
+        return;
+    }
+
+    const uint channels = stereo ? 2 : 1;
+    const Qt::Orientation meterOrientation = orientation();
+    QRect dirtyRect;
+    QRectF grooveRect; // computed only when some level changed
+    for (uint i = 0; i < channels; ++i) {
+        const bool peakChanged = levels.peak[i] != previousLevels.peak[i];
+        const bool maxPeakChanged = levels.maxPeak[i] != previousLevels.maxPeak[i];
+        const bool rmsChanged = levels.rms[i] != previousLevels.rms[i];
+        if (!peakChanged && !maxPeakChanged && !rmsChanged)
+            continue;
+
+        if (grooveRect.isNull())
+            grooveRect = getGrooveRect();
+
+        const QRectF peakRect(getMeterLaneRect(grooveRect, i, false));
+
+        if (peakChanged) {
+            const qreal origin = isVertical() ? peakRect.height() : peakRect.left(); // same origin used in paintSegments
+            dirtyRect |= RepaintScheduler::getLevelsRect(peakRect, origin, previousLevels.peak[i] * SEGMENTS_SIZE, levels.peak[i] * SEGMENTS_SIZE, meterOrientation);
+        }
+
+        if (maxPeakChanged) {
+            const qreal origin = isVertical() ? height() : peakRect.left(); // same origin used in paintMaxPeakMarker
+            for (int position : {previousLevels.maxPeak[i], levels.maxPeak[i]}) {
+                if (position >= 0)
+                    dirtyRect |= RepaintScheduler::getLevelsRect(peakRect, origin, position, position, meterOrientation, MAX_PEAK_MARKER_SIZE + 1);
+            }
+        }
+
+        if (rmsChanged) {
+            const QRectF rmsRect(getMeterLaneRect(grooveRect, i, true));
+            const qreal origin = isVertical() ? rmsRect.height() : rmsRect.left();
+            dirtyRect |= RepaintScheduler::getLevelsRect(rmsRect, origin, previousLevels.rms[i] * SEGMENTS_SIZE, levels.rms[i] * SEGMENTS_SIZE, meterOrientation);
+        }
+    }
 
-    if (!showSliderOnly)
-        updateInternalValues(); // compute decay and max peak
+    if (!dirtyRect.isNull())
+        update(dirtyRect);
 }
 
 void AudioSlider::paintMaxPeakMarker(QPainter &painter, qreal maxPeakPosition, const QRectF &rect)
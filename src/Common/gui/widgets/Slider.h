@@ -87,7 +87,22 @@ private:
 
     uint getParallelSegments() const;
 
-    qreal getPeakPosition(qreal linearPeak, qreal rectSize);
+    qreal getPeakPosition(qreal linearPeak, qreal rectSize) const;
+
+    QRectF getMeterLaneRect(const QRectF &grooveRect, uint channel, bool rms) const;
+
+    struct MeterLevels // quantized meter values, in pixels
+    {
+        int peak[2];
+        int rms[2];
+        int maxPeak[2];
+        quint8 paintFlags; // the lanes layout
+    };
+
+    MeterLevels paintedLevels; // the levels invalidated in the last update
+
+    MeterLevels computeMeterLevels() const;
+    void invalidateMeterLevels(); // repaint only the lane parts changed since the last update
 
     void paintMaxPeakMarker(QPainter &painter, qreal maxPeakPosition, const QRectF &rect);
 
@@ -149,7 +164,7 @@ private:
     static const int MIN_SIZE;
 };
 
-inline qreal AudioSlider::getPeakPosition(qreal linearPeak, qreal rectSize)
+inline qreal AudioSlider::getPeakPosition(qreal linearPeak, qreal rectSize) const
 {
     qreal db = Utils::linearToDb(linearPeak) - getMaxDbValue();
     return Utils::poweredGainToLinear(Utils::dbToLinear(db)) * rectSize;
@@ -111,6 +111,45 @@ void WavePeakPanel::addPeak(float peak)
     update(); // repaint
 }
 
+void WavePeakPanel::setPeaks(const std::vector<float> &peaks)
+{
+    if (useAlphaInPreviousSamples && peaks.size() != peaksArray.size()) { // the alpha of all peaks is changed
+        peaksArray = peaks;
+        update();
+        return;
+    }
+
+    // comparing the peaks heights in pixels
+    const int panelHeight = height();
+    const size_t size = qMax(peaks.size(), peaksArray.size());
+    int firstChangedPeak = -1;
+    int lastChangedPeak = -1;
+    for (size_t i = 0; i < size; ++i) {
+        bool changed = i >= peaks.size() || i >= peaksArray.size();
+        if (!changed)
+            changed = static_cast<int>(peaks[i] * panelHeight) != static_cast<int>(peaksArray[i] * panelHeight);
+
+        if (changed) {
+            if (firstChangedPeak < 0)
+                firstChangedPeak = i;
+            lastChangedPeak = i;
+        }
+    }
+
+    peaksArray = peaks;
+
+    if (firstChangedPeak < 0)
+        return;
+
+    const int peakWidth = getPeaksWidth() + getPeaksPad();
+    const bool drawingBuildings = drawingMode == BUILDINGS || drawingMode == PIXELED_BUILDINGS;
+    const int rightOverflow = drawingBuildings ? (panelHeight / 4 + 1) : 1; // the mirrored buildings are inclined to right
+    const int left = firstChangedPeak * peakWidth - 1;
+    const int right = (lastChangedPeak + 1) * peakWidth + rightOverflow;
+
+    update(QRect(left, 0, right - left, panelHeight));
+}
+
 void WavePeakPanel::paintSoundWave(QPainter &painter, bool useAlpha)
 {
     size_t size = peaksArray.size();
@@ -41,6 +41,8 @@ protected:
     virtual int getPeaksPad() const;
     virtual int getPeaksWidth() const;
 
+    void setPeaks(const std::vector<float> &peaks); // only the changed peaks are repainted
+
     bool useAlphaInPreviousSamples;
 
     std::vector<float> peaksArray;
@@ -0,0 +1,128 @@
+#include "StartupProfiler.h"
+#include "Logging.h"
+
+#include <QMutexLocker>
+#include <QThread>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+StartupProfiler *StartupProfiler::getInstance()
+{
+    static StartupProfiler instance;
+
+    return &instance;
+}
+
+StartupProfiler::StartupProfiler() :
+    finished(false)
+{
+    timer.start();
+}
+
+qint64 StartupProfiler::elapsed() const
+{
+    return timer.nsecsElapsed() / 1000;
+}
+
+bool StartupProfiler::isFinished() const
+{
+    QMutexLocker locker(&mutex);
+
+    return finished;
+}
+
+void StartupProfiler::addSpan(const char *name, qint64 start, qint64 end)
+{
+    qCDebug(jtStartup) << name << "took" << (end - start) / 1000.0 << "ms";
+
+    QMutexLocker locker(&mutex);
+
+    if (!finished)
+        events.append(Event{name, start, end - start, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+
+void StartupProfiler::mark(const char *name)
+{
+    const qint64 now = elapsed();
+
+    qCInfo(jtStartup) << name << "at" << now / 1000.0 << "ms";
+
+    QMutexLocker locker(&mutex);
+
+    if (!finished)
+        events.append(Event{name, now, -1, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+
+void StartupProfiler::finish()
+{
+    QMutexLocker locker(&mutex);
+
+    if (finished)
+        return;
+
+    finished = true;
+
+    qCInfo(jtStartup) << "Startup summary:";
+    for (const Event &event : events) {
+        if (event.duration >= 0)
+            qCInfo(jtStartup) << "  " << event.name << "from" << event.start / 1000.0 << "ms, took" << event.duration / 1000.0 << "ms";
+        else
+            qCInfo(jtStartup) << "  " << event.name << "at" << event.start / 1000.0 << "ms";
+    }
+
+    const QString traceFile = QString::fromLocal8Bit(qgetenv("JAMTABA_STARTUP_TRACE"));
+    if (!traceFile.isEmpty())
+        writeTraceFile(traceFile);
+}
+
+void StartupProfiler::writeTraceFile(const QString &filePath) const
+{
+    QJsonArray traceEvents;
+    for (const Event &event : events) {
+        QJsonObject traceEvent;
+        traceEvent["name"] = QString::fromLatin1(event.name);
+        traceEvent["pid"] = 1;
+        traceEvent["tid"] = static_cast<qint64>(event.threadId);
+        traceEvent["ts"] = event.start;
+        if (event.duration >= 0) {
+            traceEvent["ph"] = QStringLiteral("X"); // complete event
+            traceEvent["dur"] = event.duration;
+        }
+        else {
+            traceEvent["ph"] = QStringLiteral("i"); // instant event
+            traceEvent["s"] = QStringLiteral("g");
+        }
+
+        traceEvents.append(traceEvent);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = QStringLiteral("ms");
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(jtStartup) << "Can't write the startup trace file" << filePath << file.errorString();
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    qCInfo(jtStartup) << "Startup trace written in" << filePath;
+}
+
+StartupSpan::StartupSpan(const char *name) :
+    name(name),
+    start(StartupProfiler::getInstance()->elapsed())
+{
+
+}
+
+StartupSpan::~StartupSpan()
+{
+    auto profiler = StartupProfiler::getInstance();
+
+    profiler->addSpan(name, start, profiler->elapsed());
+}
@@ -0,0 +1,68 @@
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QList>
+
+/**
+    Startup tracing. Named spans (audio driver, theme, main window, emojis loading, etc.) and
+    milestones ('audio started', 'first window shown') are collected with the elapsed time since
+    the application start. When the startup is finished a summary is written in the 'jt.Startup'
+    log category. If the JAMTABA_STARTUP_TRACE environment variable is defined the spans are also
+    written in this file using the Chrome trace event format (chrome://tracing or Perfetto).
+
+    Spans can be recorded in any thread.
+ */
+
+class StartupProfiler
+{
+public:
+    static StartupProfiler *getInstance();
+
+    qint64 elapsed() const; // microseconds since the application start
+
+    void addSpan(const char *name, qint64 start, qint64 end);
+    void mark(const char *name);
+
+    void finish(); // write the summary and the trace file, spans finished later are only logged
+
+    bool isFinished() const;
+
+private:
+    StartupProfiler();
+
+    struct Event
+    {
+        const char *name;
+        qint64 start; // microseconds
+        qint64 duration; // -1 for milestones
+        quintptr threadId;
+    };
+
+    QElapsedTimer timer;
+
+    mutable QMutex mutex;
+    QList<Event> events;
+    bool finished;
+
+    void writeTraceFile(const QString &filePath) const;
+};
+
+/**
+    Record the elapsed time between construction and destruction as a startup span.
+ */
+
+class StartupSpan
+{
+public:
+    explicit StartupSpan(const char *name);
+    ~StartupSpan();
+
+private:
+    const char *name;
+    qint64 start;
+};
+
+#endif
@@ -0,0 +1,396 @@
+#include "LoopLibrary.h"
+#include "file/FileReaderFactory.h"
+#include "file/FileReader.h"
+#include "persistence/CacheHeader.h"
+#include "log/Logging.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QDataStream>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+
+using audio::LoopLibrary;
+using audio::LoopLibraryEntry;
+using audio::LoopInfo;
+using audio::LoopLoader;
+using audio::SamplesBuffer;
+
+/**
+    - Revision 1: bpm, bpi, layers, sample rate and thumbnail
+*/
+static const quint32 LOOP_LIBRARY_REVISION = 1;
+
+const QString LoopLibrary::CACHE_FILE_NAME("loops_library.bin");
+
+QDataStream &operator<<(QDataStream &stream, const LoopLibraryEntry &entry)
+{
+    const LoopInfo loopInfo = entry.getLoopInfo();
+
+    stream << entry.getFilePath()
+           << entry.getLastModified()
+           << loopInfo.getName()
+           << loopInfo.getBpm()
+           << loopInfo.getBpi()
+           << loopInfo.getSampleRate()
+           << loopInfo.audioIsEncoded()
+           << loopInfo.getLooperMode();
+
+    const QList<audio::LoopLayerInfo> layers = loopInfo.getLayersInfo();
+    stream << static_cast<quint8>(layers.size());
+    for (const auto &layer : layers)
+        stream << layer.locked << layer.gain << layer.pan;
+
+    return stream << entry.getThumbnail();
+}
+
+QDataStream &operator>>(QDataStream &stream, LoopLibraryEntry &entry)
+{
+    QString filePath, name;
+    qint64 lastModified;
+    quint32 bpm, sampleRate;
+    quint16 bpi;
+    bool audioIsEncoded;
+    quint8 looperMode, layers;
+
+    stream >> filePath >> lastModified >> name >> bpm >> bpi >> sampleRate >> audioIsEncoded >> looperMode >> layers;
+
+    LoopInfo loopInfo(bpm, bpi, name, audioIsEncoded, looperMode);
+    loopInfo.setSampleRate(sampleRate);
+    for (quint8 l = 0; l < layers; ++l) {
+        bool locked;
+        float gain, pan;
+        stream >> locked >> gain >> pan;
+        loopInfo.addLayer(locked, gain, pan);
+    }
+
+    QVector<float> thumbnail;
+    stream >> thumbnail;
+
+    entry = LoopLibraryEntry(filePath, lastModified, loopInfo, thumbnail);
+
+    return stream;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+LoopLibraryEntry::LoopLibraryEntry() :
+    lastModified(0)
+{
+
+}
+
+LoopLibraryEntry::LoopLibraryEntry(const QString &filePath, qint64 lastModified, const LoopInfo &loopInfo, const QVector<float> &thumbnail) :
+    filePath(filePath),
+    lastModified(lastModified),
+    loopInfo(loopInfo),
+    thumbnail(thumbnail)
+{
+
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+LoopLibrary::LoopLibrary(const QDir &cacheDir, QObject *parent) :
+    QObject(parent),
+    cacheDir(cacheDir),
+    updatePending(false),
+    changedSinceLastWrite(false)
+{
+    updateTimer.setSingleShot(true);
+    updateTimer.setInterval(300);
+
+    indexWriteTimer.setSingleShot(true);
+    indexWriteTimer.setInterval(INDEX_WRITE_DELAY);
+
+    connect(&updateTimer, &QTimer::timeout, this, &LoopLibrary::startUpdate);
+    connect(&updateWatcher, &QFutureWatcher<Entries>::finished, this, &LoopLibrary::finishUpdate);
+    connect(&indexWriteTimer, &QTimer::timeout, this, &LoopLibrary::startIndexWrite);
+    connect(&indexWriteWatcher, &QFutureWatcher<bool>::finished, this, &LoopLibrary::finishIndexWrite);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &LoopLibrary::update);
+
+    loadIndexFromFile();
+}
+
+LoopLibrary::~LoopLibrary()
+{
+    updateWatcher.waitForFinished();
+    indexWriteWatcher.waitForFinished();
+
+    const bool lastWriteFailed = indexWriteWatcher.future().resultCount() > 0 && !indexWriteWatcher.result(); // finishIndexWrite() was not called yet
+    if (changedSinceLastWrite || lastWriteFailed)
+        writeIndexToFile(getIndexFilePath(), entries);
+}
+
+void LoopLibrary::setLoopsDir(const QString &loopsDir)
+{
+    if (this->loopsDir == loopsDir)
+        return;
+
+    if (!watcher.directories().isEmpty())
+        watcher.removePaths(watcher.directories());
+
+    this->loopsDir = loopsDir;
+
+    // entries from the previous folder are discarded in the next update
+    startUpdate();
+}
+
+void LoopLibrary::update()
+{
+    updateTimer.start(); // restarting the timer, notifications are coalesced
+}
+
+void LoopLibrary::startUpdate()
+{
+    if (loopsDir.isEmpty())
+        return;
+
+    if (watcher.directories().isEmpty() && QDir(loopsDir).exists())
+        watcher.addPath(loopsDir); // the loops folder is created when the first loop is saved
+
+    if (updateWatcher.isRunning()) {
+        updatePending = true;
+        return;
+    }
+
+    updatePending = false;
+    updateWatcher.setFuture(QtConcurrent::run(&LoopLibrary::indexLoops, loopsDir, entries));
+}
+
+void LoopLibrary::finishUpdate()
+{
+    setEntries(updateWatcher.result());
+
+    if (updatePending)
+        startUpdate();
+}
+
+void LoopLibrary::setEntries(const Entries &newEntries)
+{
+    bool changed = newEntries.size() != entries.size();
+    for (auto it = newEntries.constBegin(); !changed && it != newEntries.constEnd(); ++it) {
+        auto oldEntry = entries.constFind(it.key());
+        changed = oldEntry == entries.constEnd() || oldEntry.value().getLastModified() != it.value().getLastModified();
+    }
+
+    if (!changed)
+        return;
+
+    entries = newEntries;
+
+    bpmIndex.clear();
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it)
+        bpmIndex.insert(it.value().getLoopInfo().getBpm(), it.key());
+
+    changedSinceLastWrite = true;
+    indexWriteTimer.start(); // restarting the timer, the index is written when the library is stable
+
+    emit libraryChanged();
+}
+
+void LoopLibrary::startIndexWrite()
+{
+    if (!changedSinceLastWrite)
+        return;
+
+    if (indexWriteWatcher.isRunning()) {
+        indexWriteTimer.start(); // written again when the running write is finished
+        return;
+    }
+
+    changedSinceLastWrite = false;
+    indexWriteWatcher.setFuture(QtConcurrent::run(&LoopLibrary::writeIndexToFile, getIndexFilePath(), entries));
+}
+
+void LoopLibrary::finishIndexWrite()
+{
+    if (!indexWriteWatcher.result()) {
+        changedSinceLastWrite = true; // trying again in the next change or in the destructor
+        return;
+    }
+
+    qCDebug(jtCache) << "Loop library file written";
+}
+
+QList<LoopLibraryEntry> LoopLibrary::getLoops(quint32 bpm) const
+{
+    QList<LoopLibraryEntry> loops;
+    for (const QString &filePath : bpmIndex.values(bpm))
+        loops.append(entries.value(filePath));
+
+    std::sort(loops.begin(), loops.end(), [](const LoopLibraryEntry &e1, const LoopLibraryEntry &e2) {
+        return e1.getLoopInfo().getName().compare(e2.getLoopInfo().getName(), Qt::CaseInsensitive) < 0;
+    });
+
+    return loops;
+}
+
+QList<LoopLibraryEntry> LoopLibrary::getAllLoops() const
+{
+    return entries.values();
+}
+
+void LoopLibrary::mergeThumbnailPeaks(QVector<float> &thumbnail, const std::vector<float> &layerPeaks)
+{
+    const int peaks = qMin(thumbnail.size(), static_cast<int>(layerPeaks.size()));
+    for (int i = 0; i < peaks; ++i)
+        thumbnail[i] = qMin(1.0f, qMax(thumbnail[i], layerPeaks[i]));
+}
+
+LoopLibrary::Entries LoopLibrary::indexLoops(const QString &loopsDir, const Entries &knownEntries)
+{
+    Entries newEntries;
+
+    QDir dir(loopsDir);
+    QFileInfoList fileInfoList = dir.entryInfoList(QStringList("*.json"), QDir::NoDotAndDotDot | QDir::Files);
+    for (const QFileInfo &fileInfo : fileInfoList) {
+        const QString filePath = fileInfo.absoluteFilePath();
+        const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+        auto knownEntry = knownEntries.constFind(filePath);
+        if (knownEntry != knownEntries.constEnd() && knownEntry.value().getLastModified() == lastModified) {
+            newEntries.insert(filePath, knownEntry.value()); // unchanged loop, the json is not parsed again
+            continue;
+        }
+
+        LoopLibraryEntry entry = indexLoop(fileInfo);
+        if (entry.getLoopInfo().isValid())
+            newEntries.insert(filePath, entry);
+    }
+
+    return newEntries;
+}
+
+LoopLibraryEntry LoopLibrary::indexLoop(const QFileInfo &jsonFileInfo)
+{
+    QFile file(jsonFileInfo.absoluteFilePath());
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "Error indexing loop" << file.errorString();
+        return LoopLibraryEntry();
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    LoopInfo loopInfo = LoopLoader::loadLoopInfo(root, jsonFileInfo.baseName());
+    if (!loopInfo.isValid())
+        return LoopLibraryEntry();
+
+    QVector<float> thumbnail;
+    QJsonArray thumbnailArray = root["thumbnail"].toArray();
+    for (int i = 0; i < thumbnailArray.size(); ++i)
+        thumbnail.append(static_cast<float>(thumbnailArray.at(i).toDouble()));
+
+    if (thumbnail.isEmpty()) { // loop saved by an older version, decoding the layers just once
+        quint32 sampleRate = loopInfo.getSampleRate();
+        thumbnail = computeThumbnail(jsonFileInfo.absolutePath(), loopInfo, sampleRate);
+        loopInfo.setSampleRate(sampleRate);
+    }
+
+    qCDebug(jtCache) << "Loop indexed" << jsonFileInfo.absoluteFilePath();
+
+    return LoopLibraryEntry(jsonFileInfo.absoluteFilePath(), jsonFileInfo.lastModified().toMSecsSinceEpoch(), loopInfo, thumbnail);
+}
+
+QVector<float> LoopLibrary::computeThumbnail(const QString &loopsDir, const LoopInfo &loopInfo, quint32 &sampleRate)
+{
+    QVector<float> thumbnail(THUMBNAIL_PEAKS, 0.0f);
+
+    QDir audioDir(QDir(loopsDir).absoluteFilePath(loopInfo.getName()));
+    for (quint8 layer = 0; layer < loopInfo.getLayersCount(); ++layer) {
+        QString audioFileName("layer_" + QString::number(layer) + (loopInfo.audioIsEncoded() ? ".ogg" : ".wav"));
+        QString audioFilePath(audioDir.absoluteFilePath(audioFileName));
+        if (!QFile::exists(audioFilePath))
+            continue;
+
+        SamplesBuffer samples(2);
+        quint32 fileSampleRate = 0;
+        auto fileReader = FileReaderFactory::createFileReader(audioFilePath);
+        if (!fileReader || !fileReader->read(audioFilePath, samples, fileSampleRate))
+            continue;
+
+        if (!sampleRate)
+            sampleRate = fileSampleRate;
+
+        const uint frames = samples.getFrameLenght();
+        const uint samplesPerPeak = qMax(1u, (frames + THUMBNAIL_PEAKS - 1) / THUMBNAIL_PEAKS);
+        std::vector<float> layerPeaks;
+        for (uint start = 0; start < frames; start += samplesPerPeak) {
+            const uint end = qMin(start + samplesPerPeak, frames);
+            float peak = 0;
+            for (int c = 0; c < samples.getChannels(); ++c) {
+                const float *channel = samples.getSamplesArray(c);
+                for (uint s = start; s < end; ++s)
+                    peak = qMax(peak, qAbs(channel[s]));
+            }
+            layerPeaks.push_back(peak);
+        }
+
+        mergeThumbnailPeaks(thumbnail, layerPeaks);
+    }
+
+    return thumbnail;
+}
+
+QString LoopLibrary::getIndexFilePath() const
+{
+    return cacheDir.absoluteFilePath(CACHE_FILE_NAME);
+}
+
+void LoopLibrary::loadIndexFromFile()
+{
+    QFile cacheFile(getIndexFilePath());
+    if (!cacheFile.open(QFile::ReadOnly))
+        return;
+
+    QDataStream stream(&cacheFile);
+
+    CacheHeader cacheHeader;
+    stream >> cacheHeader;
+    if (!cacheHeader.isValid(LOOP_LIBRARY_REVISION)) {
+        qCritical() << "Invalid cache header when loading the loop library.";
+        return;
+    }
+
+    Entries loadedEntries;
+    stream >> loadedEntries;
+    if (stream.status() != QDataStream::Ok) {
+        qCritical() << "Error reading the loop library index, the loops will be indexed again.";
+        return;
+    }
+
+    setEntries(loadedEntries);
+    changedSinceLastWrite = false; // the loaded index is not written again
+    indexWriteTimer.stop();
+
+    qCDebug(jtCache) << "Loop library items loaded from file: " << entries.size();
+}
+
+bool LoopLibrary::writeIndexToFile(const QString &filePath, const Entries &entries)
+{
+    QSaveFile cacheFile(filePath); // the previous index is preserved if writing fails
+    if (!cacheFile.open(QFile::WriteOnly)) {
+        qCritical() << "Can't open the loop library file in" << filePath;
+        return false;
+    }
+
+    QDataStream stream(&cacheFile);
+
+    CacheHeader cacheHeader(LOOP_LIBRARY_REVISION);
+    stream << cacheHeader;
+
+    stream << entries;
+
+    if (stream.status() != QDataStream::Ok || !cacheFile.commit()) {
+        qCritical() << "Error writing the loop library file" << filePath << cacheFile.errorString();
+        return false;
+    }
+
+    qCDebug(jtCache) << entries.size() << " items stored in loop library file!";
+
+    return true;
+}
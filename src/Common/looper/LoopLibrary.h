@@ -0,0 +1,155 @@
+#ifndef _LOOP_LIBRARY_H_
+#define _LOOP_LIBRARY_H_
+
+#include "LooperPersistence.h"
+
+#include <QObject>
+#include <QMap>
+#include <QMultiHash>
+#include <QVector>
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QTimer>
+
+#include <vector>
+
+namespace audio {
+
+class LoopLibraryEntry
+{
+public:
+    LoopLibraryEntry();
+    LoopLibraryEntry(const QString &filePath, qint64 lastModified, const LoopInfo &loopInfo, const QVector<float> &thumbnail);
+
+    QString getFilePath() const; // the loop json file path
+    qint64 getLastModified() const; // json file modification time in ms since epoch
+    LoopInfo getLoopInfo() const;
+    QVector<float> getThumbnail() const; // mixed layers peaks, THUMBNAIL_PEAKS values in [0, 1]
+
+private:
+    QString filePath;
+    qint64 lastModified;
+    LoopInfo loopInfo;
+    QVector<float> thumbnail;
+};
+
+inline QString LoopLibraryEntry::getFilePath() const
+{
+    return filePath;
+}
+
+inline qint64 LoopLibraryEntry::getLastModified() const
+{
+    return lastModified;
+}
+
+inline LoopInfo LoopLibraryEntry::getLoopInfo() const
+{
+    return loopInfo;
+}
+
+inline QVector<float> LoopLibraryEntry::getThumbnail() const
+{
+    return thumbnail;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+/**
+ * Persistent index of the saved loops.
+ *
+ * The index is keyed by the loop json file path and stores the json modification time, the loop
+ * metadata (BPM, BPI, layers, sample rate) and a small peaks strip used to draw loop previews.
+ * The index is stored in the cache dir and loaded when the library is created, so queries are
+ * answered from memory. The loops folder is watched and only new or modified json files are
+ * parsed again, in the global thread pool. Loops saved by older versions have no thumbnail in
+ * the json file, the layers are decoded only once to compute the thumbnail and the result is
+ * cached in the index. The index file is rewritten in the global thread pool after the library
+ * changes, the writes are debounced.
+ */
+
+class LoopLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoopLibrary(const QDir &cacheDir, QObject *parent = nullptr);
+    ~LoopLibrary();
+
+    void setLoopsDir(const QString &loopsDir);
+    QString getLoopsDir() const;
+
+    QList<LoopLibraryEntry> getLoops(quint32 bpm) const;
+    QList<LoopLibraryEntry> getAllLoops() const;
+
+    bool isUpdating() const;
+    bool isWritingIndex() const;
+
+    static const int THUMBNAIL_PEAKS = 64;
+    static const int INDEX_WRITE_DELAY = 2000; // in milliseconds
+
+    static void mergeThumbnailPeaks(QVector<float> &thumbnail, const std::vector<float> &layerPeaks);
+
+public slots:
+    void update(); // schedule an incremental update, called when the loops folder is changed or a loop is saved
+
+signals:
+    void libraryChanged();
+
+private slots:
+    void startUpdate();
+    void finishUpdate();
+    void startIndexWrite();
+    void finishIndexWrite();
+
+private:
+    typedef QMap<QString, LoopLibraryEntry> Entries;
+
+    Entries entries;
+    QMultiHash<quint32, QString> bpmIndex; // bpm -> json file paths
+
+    QString loopsDir;
+    QDir cacheDir;
+
+    QFileSystemWatcher watcher;
+    QTimer updateTimer; // file system changes are coalesced, saving a loop generates many notifications
+    QFutureWatcher<Entries> updateWatcher;
+    bool updatePending; // update requested while a previous update is running
+
+    QTimer indexWriteTimer; // the index is written when the library is not changed for INDEX_WRITE_DELAY
+    QFutureWatcher<bool> indexWriteWatcher;
+    bool changedSinceLastWrite;
+
+    void setEntries(const Entries &newEntries);
+
+    void loadIndexFromFile();
+    QString getIndexFilePath() const;
+
+    static bool writeIndexToFile(const QString &filePath, const Entries &entries);
+
+    static Entries indexLoops(const QString &loopsDir, const Entries &knownEntries);
+    static LoopLibraryEntry indexLoop(const QFileInfo &jsonFileInfo);
+    static QVector<float> computeThumbnail(const QString &loopsDir, const LoopInfo &loopInfo, quint32 &sampleRate);
+
+    static const QString CACHE_FILE_NAME;
+};
+
+inline QString LoopLibrary::getLoopsDir() const
+{
+    return loopsDir;
+}
+
+inline bool LoopLibrary::isUpdating() const
+{
+    return updateWatcher.isRunning();
+}
+
+inline bool LoopLibrary::isWritingIndex() const
+{
+    return indexWriteTimer.isActive() || indexWriteWatcher.isRunning();
+}
+
+} // namespace
+
+#endif
@@ -6,6 +6,7 @@
 #include <QDebug>
 
 #include <cstring>
+#include <cmath>
 #include <vector>
 #include <QThread>
 
@@ -33,9 +34,15 @@ Looper::Looper(Looper::Mode initialMode, quint8 maxLayers) :
     mainGain(1.0),
     resetRequested(false),
     newMaxLayersRequested(0),
+    clearLayersRequested(0),
     state(new StoppedState()),
     mode(initialMode)
 {
+    static_assert(MAX_LOOP_LAYERS <= sizeof(LayersMask) * 8, "Looper layers mask is too small");
+
+    mixedPeaks[0] = mixedPeaks[1] = 0.0f;
+    mixedSquaredSums[0] = mixedSquaredSums[1] = 0.0f;
+
     // initialize
     for (int l = 0; l < MAX_LOOP_LAYERS; ++l) { // create all possible layers
         layers[l] = new LooperLayer();
@@ -230,7 +237,7 @@ void Looper::overdubInCurrentLayer(const SamplesBuffer &samples, uint samplesToM
 
 void Looper::mixCurrentLayerTo(SamplesBuffer &samples, uint samplesToMix)
 {
-    mixLayer(currentLayerIndex, samples, samplesToMix);
+    mixLayers(getLayerMask(currentLayerIndex), samples, samplesToMix);
 }
 
 bool Looper::currentLayerIsLocked() const
@@ -354,9 +361,8 @@ bool Looper::canClearLayer(quint8 layer) const
 void Looper::clearLayer(quint8 layer)
 {
     if (canClearLayer(layer)) {
-        layers[layer]->zero();
+        clearLayersRequested |= getLayerMask(layer); // the pages can't be released while the audio thread is reading them
         setChanged(true);
-        emit layerChanged(layer);
     }
 }
 
@@ -487,26 +493,62 @@ void Looper::addBuffer(const SamplesBuffer &samples)
 
 void Looper::mixToBuffer(SamplesBuffer &samples)
 {
-    if (!activated)
+    processChangeRequests();
+
+    if (!activated) {
+        LooperPagePool::getInstance()->finishAudioCycle();
         return;
+    }
 
     uint samplesToProcess = qMin(samples.getFrameLenght(), intervalLenght - intervalPosition);
-    AudioPeak peakBeforeMix = samples.computePeak();
-    state->mixTo(samples, samplesToProcess);
 
-    AudioPeak peakAfterMix = samples.computePeak();
+    // the looper peak is accumulated while mixing layers, no extra passes in the buffer
+    mixedPeaks[0] = mixedPeaks[1] = 0.0f;
+    mixedSquaredSums[0] = mixedSquaredSums[1] = 0.0f;
+
+    state->mixTo(samples, samplesToProcess);
 
     // always update intervalPosition to keep the execution in sync when 'play' is pressed
     if (intervalLenght)
         intervalPosition = (intervalPosition + samplesToProcess) % intervalLenght;
 
-    processChangeRequests();
+    if (samples.isMono()) {
+        mixedPeaks[1] = mixedPeaks[0];
+        mixedSquaredSums[1] = mixedSquaredSums[0];
+    }
+
+    float rms[2] = {0.0f, 0.0f};
+    if (samplesToProcess) {
+        rms[0] = std::sqrt(mixedSquaredSums[0] / samplesToProcess);
+        rms[1] = std::sqrt(mixedSquaredSums[1] / samplesToProcess);
+    }
+
+    lastPeak = AudioPeak(mixedPeaks[0], mixedPeaks[1], rms[0], rms[1]);
 
-    lastPeak = peakAfterMix - peakBeforeMix; // minus operator is overloaded in AudioPeak class
+    LooperPagePool::getInstance()->finishAudioCycle(); // the pages released before this point can be recycled
+}
+
+void Looper::processLayersChangeRequests()
+{
+    const quint8 layersToClear = clearLayersRequested.exchange(0);
+
+    for (quint8 l = 0; l < MAX_LOOP_LAYERS; ++l) {
+        bool layerChanged = layers[l]->processStorageChanges(); // loaded content published?
+
+        if (layersToClear & getLayerMask(l)) {
+            layers[l]->zero();
+            layerChanged = true;
+        }
+
+        if (layerChanged)
+            emit this->layerChanged(l);
+    }
 }
 
 void Looper::processChangeRequests()
 {
+    processLayersChangeRequests();
+
     // reset requested in last process cycle?
     if (resetRequested && !isRecording()) {
         for (uint l = 0; l < maxLayers; ++l) {
@@ -551,6 +593,8 @@ void Looper::startNewCycle(uint samplesInCycle)
 
     intervalPosition = 0;
 
+    processLayersChangeRequests(); // the bigger storage prepared for this cycle is published before the layers are resized
+
     bool isOverdubbing = getOption(Looper::Overdub);
     for (quint8 l = 0; l < MAX_LOOP_LAYERS; ++l) {
         layers[l]->prepareForNewCycle(samplesInCycle, isOverdubbing);
@@ -609,30 +653,124 @@ void Looper::setMode(Mode mode)
     }
 }
 
-void Looper::mixLayer(quint8 layerIndex, SamplesBuffer &samples, uint samplesToMix)
+Looper::LayersMask Looper::getLayerMask(quint8 layerIndex) const
 {
     if (layerIndex >= maxLayers)
-        return;
+        return 0;
 
-    LooperLayer *loopLayer = layers[layerIndex];
-    samplesToMix = qMin(samplesToMix, loopLayer->getAvailableSamples());
-    if (samplesToMix) {
-        loopLayer->mixTo(samples, samplesToMix, intervalPosition, mainGain); // mix buffered samples
-    }
+    return 1 << layerIndex;
 }
 
-void Looper::mixAllLayers(SamplesBuffer &samples, uint samplesToMix)
+Looper::LayersMask Looper::getAllLayersMask() const
 {
-    for (uint layer = 0; layer < maxLayers; ++layer)
-        mixLayer(layer, samples, samplesToMix);
+    LayersMask mask = 0;
+    for (quint8 layer = 0; layer < maxLayers; ++layer)
+        mask |= getLayerMask(layer);
+
+    return mask;
 }
 
-void Looper::mixLockedLayers(SamplesBuffer &samples, uint samplesToMix)
+Looper::LayersMask Looper::getLockedLayersMask() const
 {
-    for (uint layer = 0; layer < maxLayers; ++layer) {
-        if (layerIsLocked(layer)) {
-            mixLayer(layer, samples, samplesToMix);
+    LayersMask mask = 0;
+    for (quint8 layer = 0; layer < maxLayers; ++layer) {
+        if (layerIsLocked(layer))
+            mask |= getLayerMask(layer);
+    }
+
+    return mask;
+}
+
+void Looper::mixLayers(LayersMask layersMask, SamplesBuffer &samples, uint samplesToMix)
+{
+    struct MixedLayer
+    {
+        const LooperLayer *layer;
+        uint samples; // samples to mix in this layer
+        float gains[2];
+    };
+
+    MixedLayer mixedLayers[MAX_LOOP_LAYERS];
+    uint totalLayers = 0;
+    for (quint8 l = 0; l < maxLayers; ++l) {
+        const LooperLayer *layer = layers[l];
+        if (!(layersMask & getLayerMask(l)) || !layer->isAudible())
+            continue;
+
+        const uint layerSamples = qMin(samplesToMix, layer->getAvailableSamples());
+        if (!layerSamples)
+            continue;
+
+        const float layerGain = mainGain * layer->getGain();
+        mixedLayers[totalLayers++] = MixedLayer{layer, layerSamples, {layerGain * layer->getLeftGain(), layerGain * layer->getRightGain()}};
+    }
+
+    if (!totalLayers)
+        return;
+
+    const uint channels = samples.isMono() ? 1 : 2;
+    float *outChannels[] = {samples.getSamplesArray(0), samples.getSamplesArray(channels - 1)};
+
+    // layers are mixed in small blocks (not crossing page boundaries) in a stack buffer, then the block is added in the output buffer
+    static const uint BLOCK_SIZE = 256;
+    float mixedBlock[BLOCK_SIZE];
+
+    uint position = 0;
+    while (position < samplesToMix) {
+        const uint layerPosition = intervalPosition + position;
+        uint blockLenght = qMin(BLOCK_SIZE, samplesToMix - position);
+        blockLenght = qMin(blockLenght, LooperPagePool::SAMPLES_PER_PAGE - LooperPagePool::getPageOffset(layerPosition));
+        for (uint l = 0; l < totalLayers; ++l) {
+            if (position < mixedLayers[l].samples)
+                blockLenght = qMin(blockLenght, mixedLayers[l].samples - position); // the set of mixed layers is constant in each block
         }
+
+        for (uint c = 0; c < channels; ++c) {
+            bool blockIsEmpty = true;
+            for (uint l = 0; l < totalLayers; ++l) {
+                const MixedLayer &mixedLayer = mixedLayers[l];
+                if (position >= mixedLayer.samples)
+                    continue;
+
+                const float *layerSamples = mixedLayer.layer->getSamples(c, layerPosition);
+                if (!layerSamples)
+                    continue; // silence
+
+                const float gain = mixedLayer.gains[c];
+                if (blockIsEmpty) {
+                    for (uint s = 0; s < blockLenght; ++s)
+                        mixedBlock[s] = layerSamples[s] * gain;
+
+                    blockIsEmpty = false;
+                }
+                else {
+                    for (uint s = 0; s < blockLenght; ++s)
+                        mixedBlock[s] += layerSamples[s] * gain;
+                }
+            }
+
+            if (blockIsEmpty)
+                continue;
+
+            float *out = outChannels[c] + position;
+            float peak = mixedPeaks[c];
+            float squaredSum = 0.0f;
+            for (uint s = 0; s < blockLenght; ++s) {
+                const float value = mixedBlock[s];
+                out[s] += value;
+
+                const float abs = value < 0 ? -value : value;
+                if (abs > peak)
+                    peak = abs;
+
+                squaredSum += value * value;
+            }
+
+            mixedPeaks[c] = peak;
+            mixedSquaredSums[c] += squaredSum;
+        }
+
+        position += blockLenght;
     }
 }
 
@@ -748,9 +886,18 @@ bool Looper::canSave() const
     return false;
 }
 
-void Looper::setLayerSamples(quint8 layer, const SamplesBuffer &samples)
+void Looper::setLayerSamples(quint8 layer, const SamplesBuffer &samples, bool processChangeRequestNow)
 {
     if (layer < maxLayers) {
-        layers[layer]->setSamples(samples);
+        layers[layer]->setSamples(samples); // published in the next audio cycle
+
+        if (processChangeRequestNow)
+            processLayersChangeRequests();
     }
 }
+
+void Looper::prepareLayers(uint samplesInCycle)
+{
+    for (quint8 l = 0; l < MAX_LOOP_LAYERS; ++l)
+        layers[l]->prepareCapacity(samplesInCycle);
+}
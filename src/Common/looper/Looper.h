@@ -12,6 +12,8 @@
 #include <QMap>
 #include <QMutex>
 
+#include <atomic>
+
 #define MAX_LOOP_LAYERS 8
 
 namespace audio {
@@ -52,15 +54,16 @@ public:
 
     AudioPeak getLastPeak() const;
 
-    void setLayerSamples(quint8 layer, const SamplesBuffer &samples);
+    void setLayerSamples(quint8 layer, const SamplesBuffer &samples, bool processChangeRequestNow = false);
 
     void startNewCycle(uint samplesInCycle);
+    void prepareLayers(uint samplesInCycle); // non real time threads, allocate the layers storage before the cycle lenght change
 
     void selectLayer(quint8 layerIndex);
     bool canSelectLayers() const;
 
     void clearCurrentLayer();
-    void clearLayer(quint8 layer);
+    void clearLayer(quint8 layer); // the layer content is erased in the audio thread
     bool canClearLayer(quint8 layer) const;
     bool canLockLayer(quint8 layer) const;
 
@@ -181,7 +184,9 @@ private:
 
     bool resetRequested;
     quint8 newMaxLayersRequested;
+    std::atomic<quint8> clearLayersRequested; // layers mask
     void processChangeRequests();
+    void processLayersChangeRequests(); // clear the requested layers and publish the layers storage prepared in other threads
 
     void setCurrentLayer(quint8 newLayer);
 
@@ -201,9 +206,17 @@ private:
 
     Options modeOptions[3]; // 3 modes
 
-    void mixLayer(quint8 layerIndex, SamplesBuffer &samples, uint samplesToMix);
-    void mixAllLayers(SamplesBuffer &samples, uint samplesToMix);
-    void mixLockedLayers(SamplesBuffer &samples, uint samplesToMix);
+    typedef quint8 LayersMask; // one bit per layer
+
+    LayersMask getLayerMask(quint8 layerIndex) const;
+    LayersMask getAllLayersMask() const;
+    LayersMask getLockedLayersMask() const;
+
+    // mix all audible layers in the mask in a single pass, accumulating the looper peak
+    void mixLayers(LayersMask layersMask, SamplesBuffer &samples, uint samplesToMix);
+
+    float mixedPeaks[2]; // peaks and squared sums of the mixed layers in the current buffer
+    float mixedSquaredSums[2];
 
     void setState(LooperState *state);
 
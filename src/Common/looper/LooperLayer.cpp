@@ -1,20 +1,26 @@
 #include "LooperLayer.h"
+#include "LooperPagePool.h"
 #include "audio/core/SamplesBuffer.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include <QDebug>
-
-#include <QDebug>
+#include <QMutexLocker>
 
 using audio::LooperLayer;
+using audio::LooperPagePool;
 using audio::SamplesBuffer;
 
 LooperLayer::LooperLayer() :
-    lastSamplesPerPeak(0),
+    storage(new Storage()),
+    storageReaders(0),
+    pendingStorage(nullptr),
+    retiredStorage(nullptr),
+    requestedCapacity(0),
     availableSamples(0),
-    lastCacheComputationSample(0),
     lastCycleLenght(0),
+    pendingResize(0),
     locked(false),
     gain(1.0),
     pan(0),
@@ -23,11 +29,293 @@ LooperLayer::LooperLayer() :
     muteState(MuteState::Unmuted)
 {
     setPan(0); // center
+
+    LooperPagePool::getInstance()->addLayer(this);
 }
 
 LooperLayer::~LooperLayer()
 {
+    LooperPagePool::getInstance()->removeLayer(this); // the storage is not maintained after this point
+
+    Storage *currentStorage = storage.load();
+
+    releasePages(currentStorage);
+
+    delete currentStorage;
+
+    Storage *notPublishedStorage = pendingStorage.load();
+    if (notPublishedStorage) {
+        releasePages(notPublishedStorage); // loaded content
+        delete notPublishedStorage;
+    }
+
+    delete retiredStorage.load(); // the retired storage pages were moved to the current storage or released
+}
+
+LooperLayer::Storage::Storage() :
+    capacity(0),
+    loaded(false),
+    loadedSamples(0)
+{
+
+}
+
+LooperLayer::Storage::Storage(uint capacity) :
+    leftPages(LooperPagePool::getPagesCount(capacity), nullptr), // just pointers, the pages are committed when written
+    rightPages(LooperPagePool::getPagesCount(capacity), nullptr),
+    capacity(capacity),
+    loaded(false),
+    loadedSamples(0)
+{
+    peaksPyramid.resize(capacity);
+}
+
+LooperLayer::StorageReader::StorageReader(const LooperLayer &layer) :
+    layer(layer)
+{
+    // the reader is counted before the storage is loaded, so a storage replaced after this point is not deleted
+    layer.storageReaders.fetch_add(1);
+    storage = layer.storage.load();
+}
+
+LooperLayer::StorageReader::~StorageReader()
+{
+    layer.storageReaders.fetch_sub(1);
+}
+
+
+void LooperLayer::deleteRetiredStorage()
+{
+    Storage *retired = retiredStorage.load();
+    if (!retired || storageReaders.load() > 0)
+        return;
+
+    retiredStorage.store(nullptr); // the audio thread can replace the storage again
+
+    delete retired;
+}
+
+void LooperLayer::postStorage(Storage *newStorage)
+{
+    Storage *replacedStorage = pendingStorage.exchange(newStorage);
+    if (replacedStorage) { // not published by the audio thread
+        releasePages(replacedStorage);
+        delete replacedStorage;
+    }
+}
+
+void LooperLayer::prepareStorage(uint capacity)
+{
+    if (capacity <= storage.load()->capacity)
+        return;
+
+    // a loaded storage is not replaced, the capacity is requested again when the loaded storage is published
+    const Storage *notPublishedStorage = pendingStorage.load();
+    if (notPublishedStorage && (notPublishedStorage->loaded || notPublishedStorage->capacity >= capacity))
+        return;
+
+    postStorage(new Storage(capacity));
+}
+
+void LooperLayer::prepareCapacity(uint samples)
+{
+    QMutexLocker locker(&storageMutex);
+
+    deleteRetiredStorage();
+
+    prepareStorage(samples);
+}
+
+void LooperLayer::maintainStorage()
+{
+    QMutexLocker locker(&storageMutex);
+
+    deleteRetiredStorage();
+
+    const uint capacity = requestedCapacity.load();
+    if (capacity)
+        prepareStorage(capacity);
+}
+
+bool LooperLayer::processStorageChanges()
+{
+    if (retiredStorage.load())
+        return false; // the last replaced storage is not deleted yet
+
+    bool contentLoaded = false;
+    Storage *newStorage = pendingStorage.exchange(nullptr);
+    if (newStorage) {
+        Storage *currentStorage = storage.load();
+        if (newStorage->loaded) {
+            releasePages(currentStorage); // the loaded content is replacing the layer content
+            availableSamples = newStorage->loadedSamples;
+            pendingResize = 0;
+            contentLoaded = true;
+        }
+        else {
+            // the pages and the peaks are moved to the bigger storage, no allocations here
+            Q_ASSERT(newStorage->leftPages.size() >= currentStorage->leftPages.size());
+            std::copy(currentStorage->leftPages.begin(), currentStorage->leftPages.end(), newStorage->leftPages.begin());
+            std::copy(currentStorage->rightPages.begin(), currentStorage->rightPages.end(), newStorage->rightPages.begin());
+            newStorage->peaksPyramid.copyBlocks(currentStorage->peaksPyramid);
+        }
+
+        storage.store(newStorage);
+        retiredStorage.store(currentStorage); // deleted in the pool maintenance thread when no readers are using it
+    }
+
+    const uint capacity = storage.load()->capacity;
+    const uint neededCapacity = qMax(lastCycleLenght.load(), pendingResize);
+    requestedCapacity.store(neededCapacity > capacity ? neededCapacity : 0);
+
+    if (pendingResize && pendingResize <= capacity) {
+        const uint samplesPerCycle = pendingResize;
+        pendingResize = 0;
+        resize(samplesPerCycle);
+    }
+
+    return contentLoaded;
+}
+
+template <typename Function>
+void LooperLayer::forEachPageSpan(uint startPosition, uint samples, Function function) const
+{
+    uint processed = 0;
+    while (processed < samples) {
+        const uint position = startPosition + processed;
+        const uint pageIndex = LooperPagePool::getPageIndex(position);
+        const uint pageOffset = LooperPagePool::getPageOffset(position);
+        const uint spanLenght = qMin(LooperPagePool::SAMPLES_PER_PAGE - pageOffset, samples - processed);
+
+        function(pageIndex, pageOffset, processed, spanLenght);
+
+        processed += spanLenght;
+    }
+}
+
+bool LooperLayer::commitPage(Storage *storage, uint pageIndex, bool stereo, bool realTime)
+{
+    auto pool = LooperPagePool::getInstance();
+
+    float *&left = storage->leftPages[pageIndex];
+    float *&right = storage->rightPages[pageIndex];
+
+    if (!left) {
+        left = realTime ? pool->acquirePage() : pool->allocatePage();
+        if (!left)
+            return false;
+
+        right = left; // pages are shared until stereo material is written
+    }
+
+    if (stereo && right == left) { // un-share the page
+        float *newRightPage = realTime ? pool->acquirePage() : pool->allocatePage();
+        if (!newRightPage)
+            return false;
+
+        std::memcpy(newRightPage, left, LooperPagePool::PAGE_SIZE_IN_BYTES);
+        right = newRightPage;
+    }
+
+    return true;
+}
+
+void LooperLayer::releasePages(Storage *storage)
+{
+    auto pool = LooperPagePool::getInstance();
+    std::vector<float *> &leftPages = storage->leftPages;
+    std::vector<float *> &rightPages = storage->rightPages;
+    for (uint p = 0; p < leftPages.size(); ++p) {
+        if (rightPages[p] != leftPages[p])
+            pool->releasePage(rightPages[p]);
+
+        pool->releasePage(leftPages[p]);
+
+        leftPages[p] = nullptr;
+        rightPages[p] = nullptr;
+    }
+}
+
+void LooperLayer::writeSamples(Storage *storage, const float *left, const float *right, uint samples, uint startPosition, bool mixing, bool realTime)
+{
+    if (startPosition >= storage->capacity)
+        return;
+
+    samples = qMin(samples, storage->capacity - startPosition);
+
+    forEachPageSpan(startPosition, samples, [&](uint pageIndex, uint pageOffset, uint spanStart, uint spanLenght) {
+        const float *sourceLeft = left + spanStart;
+        const float *sourceRight = right ? (right + spanStart) : sourceLeft;
+
+        // stereo buffers carrying the same content in both channels are stored as mono
+        const bool stereoSpan = sourceRight != sourceLeft && std::memcmp(sourceLeft, sourceRight, spanLenght * sizeof(float)) != 0;
+
+        if (!commitPage(storage, pageIndex, stereoSpan, realTime))
+            return; // memory budget exhausted, this span will be silence
+
+        float *destLeft = storage->leftPages[pageIndex] + pageOffset;
+        float *destRight = storage->rightPages[pageIndex] + pageOffset;
+        const bool sharedPage = destLeft == destRight;
+
+        if (mixing) {
+            for (uint s = 0; s < spanLenght; ++s)
+                destLeft[s] += sourceLeft[s];
+
+            if (!sharedPage) {
+                for (uint s = 0; s < spanLenght; ++s)
+                    destRight[s] += sourceRight[s];
+            }
+        }
+        else {
+            const uint bytesToCopy = spanLenght * sizeof(float);
+            std::memcpy(destLeft, sourceLeft, bytesToCopy);
+            if (!sharedPage)
+                std::memcpy(destRight, sourceRight, bytesToCopy);
+        }
+    });
+
+    updatePeaks(storage, startPosition, samples);
+}
+
+void LooperLayer::updatePeaks(Storage *storage, uint startPosition, uint samples)
+{
+    static_assert(LooperPagePool::SAMPLES_PER_PAGE % PeaksPyramid::SAMPLES_PER_BLOCK == 0, "Peak blocks can't cross page boundaries");
+
+    if (!samples)
+        return;
 
+    const uint blockSize = PeaksPyramid::SAMPLES_PER_BLOCK;
+    const uint firstBlock = startPosition / blockSize;
+    const uint lastBlock = (startPosition + samples - 1) / blockSize;
+
+    for (uint block = firstBlock; block <= lastBlock; ++block) {
+        const uint blockStart = block * blockSize;
+        const uint blockLenght = qMin(blockSize, storage->capacity - blockStart);
+        const uint pageIndex = LooperPagePool::getPageIndex(blockStart);
+        const float *left = storage->leftPages[pageIndex];
+        const float *right = storage->rightPages[pageIndex];
+
+        float minValue = 0;
+        float maxValue = 0;
+        if (left) { // non committed pages are silence
+            const uint pageOffset = LooperPagePool::getPageOffset(blockStart);
+            for (uint s = pageOffset; s < pageOffset + blockLenght; ++s) {
+                minValue = qMin(minValue, left[s]);
+                maxValue = qMax(maxValue, left[s]);
+            }
+
+            if (right != left) {
+                for (uint s = pageOffset; s < pageOffset + blockLenght; ++s) {
+                    minValue = qMin(minValue, right[s]);
+                    maxValue = qMax(maxValue, right[s]);
+                }
+            }
+        }
+
+        storage->peaksPyramid.setBlock(block, minValue, maxValue);
+    }
+
+    storage->peaksPyramid.updateParents(firstBlock, lastBlock);
 }
 
 void LooperLayer::reset()
@@ -44,49 +332,35 @@ void LooperLayer::reset()
 
 void LooperLayer::zero()
 {
-    std::fill(leftChannel.begin(), leftChannel.end(), static_cast<float>(0));
-    std::fill(rightChannel.begin(), rightChannel.end(), static_cast<float>(0));
+    Storage *storage = this->storage.load();
+
+    releasePages(storage); // pages are recycled in the pool after the audio cycle, empty layers are not holding memory
 
     availableSamples = 0;
-    lastSamplesPerPeak = 0;
-    lastCacheComputationSample = 0;
-    peaksCache.clear();
+    pendingResize = 0;
+    storage->peaksPyramid.clear();
 }
 
 void LooperLayer::setSamples(const SamplesBuffer &samples)
 {
-    zero();
-
-    uint samplesToCopy = qMin(samples.getFrameLenght(), lastCycleLenght);
-    if (!samplesToCopy) {
-        return;
-    }
+    const uint cycleLenght = lastCycleLenght.load();
+    const uint samplesToCopy = qMin(samples.getFrameLenght(), cycleLenght);
 
-    uint bytesToCopy =  samplesToCopy * sizeof(float);
-
-    Q_ASSERT(leftChannel.capacity() >= samplesToCopy);
-    Q_ASSERT(rightChannel.capacity() >= samplesToCopy);
-
-    std::memcpy(&(leftChannel[0]), samples.getSamplesArray(0), bytesToCopy);
-    if (samples.isMono())
-        std::memcpy(&(rightChannel[0]), samples.getSamplesArray(0), bytesToCopy);
-    else
-        std::memcpy(&(rightChannel[0]), samples.getSamplesArray(1), bytesToCopy);
-
-    availableSamples = samplesToCopy;
+    // the loaded content is written in a new storage, the pages in use by the audio thread are released when this storage is published
+    Storage *loadedStorage = new Storage(cycleLenght);
+    loadedStorage->loaded = true;
+    loadedStorage->loadedSamples = samplesToCopy;
 
+    if (samplesToCopy) {
+        const float *right = samples.isMono() ? nullptr : samples.getSamplesArray(1);
+        writeSamples(loadedStorage, samples.getSamplesArray(0), right, samplesToCopy, 0, false, false); // loaded loops are not written in the audio thread
+    }
 
-    // rebuild peaks cache
-    lastCacheComputationSample = 0;
-    peaksCache.clear();
+    QMutexLocker locker(&storageMutex);
 
-    if (lastSamplesPerPeak) {
-        while (availableSamples - lastCacheComputationSample >= lastSamplesPerPeak) { // enough samples to cache a new max peak?
-            peaksCache.push_back(computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak));
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
+    deleteRetiredStorage();
 
+    postStorage(loadedStorage);
 }
 
 void LooperLayer::setPan(float pan)
@@ -115,173 +389,167 @@ void LooperLayer::setGain(float gain)
 
 void LooperLayer::prepareForNewCycle(uint samplesInNewCycle, bool isOverdubbing)
 {
+    Q_UNUSED(isOverdubbing) // overdubbed peaks are updated in each write
+
     if (samplesInNewCycle > lastCycleLenght)
         resize(samplesInNewCycle);
-
-    if (isOverdubbing)
-        lastCacheComputationSample = 0; // reset max peak cache position to compute overdub peaks correctly
+    else if (samplesInNewCycle < pendingResize)
+        pendingResize = 0; // the samples waiting a bigger storage are not played in the shorter cycle
 
     lastCycleLenght = samplesInNewCycle;
 }
 
 void LooperLayer::overdub(const SamplesBuffer &samples, uint samplesToMix, uint startPosition)
 {
-    if (!samples.isMono()) {
-        float *internalChannels[] = {&(leftChannel[startPosition]), &(rightChannel[startPosition])};
-        float *samplesArray[] = {samples.getSamplesArray(0), samples.getSamplesArray(1)};
-        for (uint s = 0; s < samplesToMix; ++s) {
-            internalChannels[0][s] += samplesArray[0][s]; // left channel
-            internalChannels[1][s] += samplesArray[1][s]; // right channel
-        }
-    }
-    else {
-        float *internalChannels[] = {&(leftChannel[startPosition]), &(rightChannel[startPosition])};
-        float *samplesArray = samples.getSamplesArray(0);
-        for (uint s = 0; s < samplesToMix; ++s) {
-            internalChannels[0][s] += samplesArray[s];
-        }
-    }
+    const float *right = samples.isMono() ? nullptr : samples.getSamplesArray(1);
+    writeSamples(storage.load(), samples.getSamplesArray(0), right, samplesToMix, startPosition, true, true);
 
     if (availableSamples < startPosition + samplesToMix)
         availableSamples = startPosition + samplesToMix;
-
-    // build peaks cache when overdubbing
-    if (lastSamplesPerPeak) {
-        const uint position = startPosition + samplesToMix;
-        while (position - lastCacheComputationSample >= lastSamplesPerPeak) { // enough samples to cache a new max peak?
-            const int peakIndex = (position/lastSamplesPerPeak) - 1;
-            float lastPeak = computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak);
-            if (peakIndex >= 0 && static_cast<uint>(peakIndex) < peaksCache.size())
-                peaksCache[peakIndex] = lastPeak;
-            else
-                peaksCache.push_back(lastPeak);
-
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
-}
-
-void LooperLayer::mixTo(SamplesBuffer &outBuffer, uint samplesToMix, uint intervalPosition, float looperMainGain)
-{
-    bool canMix = samplesToMix > 0 && (muteState == LooperLayer::Unmuted || muteState == LooperLayer::WaitingToMute);
-    if (canMix) {
-        float *internalChannels[] = {&(leftChannel[0]), &(rightChannel[0])};
-        const uint secondChannelIndex = (outBuffer.isMono()) ? 0 : 1;
-        float *bufferChannels[] = {outBuffer.getSamplesArray(0), outBuffer.getSamplesArray(secondChannelIndex)};
-        uint channels = outBuffer.getChannels();
-
-        const float mainGain = looperMainGain * gain;
-        const float finalLeftGain = mainGain * leftGain;
-        const float finalRightGain = mainGain * rightGain;
-        float gains[] = {finalLeftGain, finalRightGain};
-        for (uint c = 0; c < channels; ++c) {
-            for (uint s = 0; s < samplesToMix; ++s) {
-                const uint offset = s + intervalPosition;
-                bufferChannels[c][s] += internalChannels[c][offset] * gains[c];
-            }
-        }
-    }
 }
 
 void LooperLayer::append(const SamplesBuffer &samples, uint samplesToAppend, uint startPosition)
 {
-    int toAppend = qMin(static_cast<uint>(leftChannel.capacity() - startPosition), samplesToAppend);
+    Storage *storage = this->storage.load();
+    const uint capacity = storage->capacity;
+    int toAppend = startPosition < capacity ? qMin(capacity - startPosition, samplesToAppend) : 0;
 
     if (!toAppend) {
         qCritical() << "toAppend:" << toAppend;
         return;
     }
 
-    const uint sizeInBytes = toAppend * sizeof(float);
-
-    const int secondChannelIndex = samples.isMono() ? 0 : 1;
-    std::memcpy(&(leftChannel[0]) + startPosition, samples.getSamplesArray(0), sizeInBytes);
-    std::memcpy(&(rightChannel[0]) + startPosition, samples.getSamplesArray(secondChannelIndex), sizeInBytes);
+    const float *right = samples.isMono() ? nullptr : samples.getSamplesArray(1);
+    writeSamples(storage, samples.getSamplesArray(0), right, toAppend, startPosition, false, true);
 
     availableSamples += toAppend;
 
-    //Q_ASSERT(availableSamples <= leftChannel.capacity());
+    //Q_ASSERT(availableSamples <= capacity);
+}
 
-    // build peaks cache
-    if (lastSamplesPerPeak) {
-        if (lastCacheComputationSample < startPosition - lastSamplesPerPeak)
-            lastCacheComputationSample = startPosition;
+float LooperLayer::computeMaxPeak(uint from, uint samplesPerPeak) const
+{
+    StorageReader reader(*this);
 
-        while ((startPosition + samplesToAppend) - lastCacheComputationSample >= lastSamplesPerPeak && lastCacheComputationSample  < leftChannel.size()) { // enough samples to cache a new max peak?
-            peaksCache.push_back(computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak));
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
+    if (from >= availableSamples)
+        return 0;
+
+    return computeMaxPeak(reader.getStorage(), from, qMin(samplesPerPeak, availableSamples - from));
 }
 
-float LooperLayer::computeMaxPeak(uint from, uint samplesPerPeak) const
+float LooperLayer::computeMaxPeak(const Storage *storage, uint from, uint samples) const
 {
     float maxPeak = 0;
-    uint limit = qMin(samplesPerPeak, availableSamples - from);
-    for (uint i = 0; i < limit; ++i) {
-        const uint offset = from + i;
-        if (offset < leftChannel.size()) {
-            float peak = qMax(qAbs(leftChannel[offset]), qAbs(rightChannel[offset]));
+    if (from >= storage->capacity)
+        return maxPeak;
+
+    uint limit = qMin(samples, storage->capacity - from);
+    forEachPageSpan(from, limit, [&](uint pageIndex, uint pageOffset, uint spanStart, uint spanLenght) {
+        Q_UNUSED(spanStart)
+
+        const float *left = storage->leftPages[pageIndex];
+        const float *right = storage->rightPages[pageIndex];
+        if (!left)
+            return; // silence
+
+        for (uint i = pageOffset; i < pageOffset + spanLenght; ++i) {
+            float peak = qAbs(left[i]);
+            if (right != left)
+                peak = qMax(peak, qAbs(right[i]));
+
             if (peak > maxPeak) {
                 maxPeak = peak;
             }
         }
-    }
+    });
 
     return maxPeak;
 }
 
-std::vector<float> LooperLayer::getSamplesPeaks(uint samplesPerPeak)
+std::vector<float> LooperLayer::getSamplesPeaks(uint samplesPerPeak) const
 {
-    if (lastSamplesPerPeak == samplesPerPeak && !peaksCache.empty()) { // cache hit?
-        return peaksCache;
-    }
+    std::vector<float> peaks;
+    if (!samplesPerPeak)
+        return peaks;
+
+    StorageReader reader(*this); // the storage is not deleted while the peaks are computed
 
-    // compute all peaks
-    peaksCache.clear();
-    if (samplesPerPeak) {
-        for (uint i = 0; i < availableSamples; i += samplesPerPeak) {
-            float maxPeak = computeMaxPeak(i, samplesPerPeak);
-            peaksCache.push_back(maxPeak);
+    const uint samples = qMin(availableSamples, reader->capacity);
+    const uint blockSize = PeaksPyramid::SAMPLES_PER_BLOCK;
+
+    peaks.reserve(samples / samplesPerPeak + 1);
+
+    // the whole blocks are served from the peaks pyramid and only the partial blocks in the peak edges
+    // are read from pages, so the peaks are exact in any zoom level and the cost is not proportional to layer lenght
+    for (uint from = 0; from < samples; from += samplesPerPeak) {
+        const uint to = qMin(from + samplesPerPeak, samples);
+        const uint firstWholeBlockStart = (from + blockSize - 1) / blockSize * blockSize;
+        const uint lastWholeBlockEnd = to / blockSize * blockSize;
+
+        float peak = 0;
+        if (firstWholeBlockStart < lastWholeBlockEnd) {
+            peak = reader->peaksPyramid.getMaxPeak(firstWholeBlockStart, lastWholeBlockEnd - firstWholeBlockStart);
+            peak = qMax(peak, computeMaxPeak(reader.getStorage(), from, firstWholeBlockStart - from));
+            peak = qMax(peak, computeMaxPeak(reader.getStorage(), lastWholeBlockEnd, to - lastWholeBlockEnd));
         }
-        lastSamplesPerPeak = samplesPerPeak;
+        else {
+            peak = computeMaxPeak(reader.getStorage(), from, to - from); // less than 2 blocks
+        }
+
+        peaks.push_back(peak);
     }
 
-    return peaksCache;
+    return peaks;
 }
 
 void LooperLayer::resize(quint32 samplesPerCycle)
 {
-    if (samplesPerCycle > leftChannel.capacity())
-        leftChannel.resize(samplesPerCycle);
-
-    if (samplesPerCycle > rightChannel.capacity())
-        rightChannel.resize(samplesPerCycle);
+    Storage *storage = this->storage.load();
+    if (samplesPerCycle > storage->capacity) { // the bigger storage is allocated in the pool maintenance thread
+        pendingResize = samplesPerCycle;
+        requestedCapacity.store(samplesPerCycle);
+        return;
+    }
 
     if (availableSamples && samplesPerCycle > availableSamples) { // need copy samples?
         uint initialAvailableSamples = availableSamples;
         uint totalSamplesToCopy = samplesPerCycle - initialAvailableSamples;
         while (totalSamplesToCopy > 0){
             const uint samplesToCopy = qMin(totalSamplesToCopy, initialAvailableSamples);
-            const uint bytesToCopy = samplesToCopy * sizeof(float);
-            std::memcpy(&(leftChannel[availableSamples]), &(leftChannel[0]), bytesToCopy);
-            std::memcpy(&(rightChannel[availableSamples]), &(rightChannel[0]), bytesToCopy);
+
+            // copying page by page from the layer begin, non committed pages are silence and are not copied
+            forEachPageSpan(0, samplesToCopy, [&](uint pageIndex, uint pageOffset, uint spanStart, uint spanLenght) {
+                const float *left = storage->leftPages[pageIndex];
+                if (!left)
+                    return;
+
+                const float *right = storage->rightPages[pageIndex];
+                writeSamples(storage, left + pageOffset, (right != left) ? (right + pageOffset) : nullptr, spanLenght, availableSamples + spanStart, false, true);
+            });
+
             availableSamples += samplesToCopy;
             totalSamplesToCopy -= samplesToCopy;
         }
 
         Q_ASSERT(availableSamples == samplesPerCycle);
-
-        peaksCache.clear(); // invalidate peaks cache
     }
 }
 
 SamplesBuffer LooperLayer::getAllSamples() const
 {
-    SamplesBuffer buffer(2, availableSamples);
-    uint bytesToCopy = availableSamples * sizeof(float);
-    std::memcpy(buffer.getSamplesArray(0), &(leftChannel[0]), bytesToCopy);
-    std::memcpy(buffer.getSamplesArray(1), &(rightChannel[0]), bytesToCopy);
+    StorageReader reader(*this);
+
+    SamplesBuffer buffer(2, availableSamples); // zeroed buffer, non committed pages are silence
+
+    float *bufferChannels[] = {buffer.getSamplesArray(0), buffer.getSamplesArray(1)};
+    forEachPageSpan(0, qMin(availableSamples, reader->capacity), [&](uint pageIndex, uint pageOffset, uint spanStart, uint spanLenght) {
+        const float *pages[] = {reader->leftPages[pageIndex], reader->rightPages[pageIndex]};
+        const uint bytesToCopy = spanLenght * sizeof(float);
+        for (uint c = 0; c < 2; ++c) {
+            if (pages[c])
+                std::memcpy(bufferChannels[c] + spanStart, pages[c] + pageOffset, bytesToCopy);
+        }
+    });
 
     return buffer;
 }
@@ -1,8 +1,13 @@
 #ifndef _AUDIO_LOOPER_LAYER_
 #define _AUDIO_LOOPER_LAYER_
 
+#include "audio/core/PeaksPyramid.h"
+#include "LooperPagePool.h"
+
 #include <vector>
+#include <atomic>
 #include <QtGlobal>
+#include <QMutex>
 
 namespace audio {
 
@@ -24,12 +29,16 @@ public:
     float getLeftGain() const;
     float getRightGain() const;
 
-    void setSamples(const SamplesBuffer &samples);
+    void setSamples(const SamplesBuffer &samples); // non real time threads, the loaded content is published in the next processStorageChanges()
 
-    void zero();
+    void zero(); // audio thread only, the released pages can't be in use by the audio thread
 
     void reset();
 
+    void prepareCapacity(uint samples); // non real time threads, prepare a bigger storage for the next cycles
+    bool processStorageChanges(); // audio thread, publish the storage prepared in other threads. True if a loaded content was published
+    void maintainStorage(); // non real time threads, prepare the storage requested by the audio thread and delete the retired storage
+
     void overdub(const SamplesBuffer &samples, uint samplesToMix, uint startPosition);
     void append(const SamplesBuffer &samples, uint samplesToAppend, uint startPosition);
 
@@ -37,11 +46,12 @@ public:
 
     float computeMaxPeak(uint from, uint samplesPerPeak) const;
 
-    std::vector<float> getSamplesPeaks(uint samplesPerPeak);
+    std::vector<float> getSamplesPeaks(uint samplesPerPeak) const;
 
     SamplesBuffer getAllSamples() const;
 
-    void mixTo(SamplesBuffer &outBuffer, uint samplesToMix, uint intervalPosition, float looperMainGain);
+    // pointer to the samples stored in the page containing 'position', valid until the page end. Null pointer is silence
+    const float *getSamples(uint channel, uint position) const;
 
     void setLocked(bool locked);
     bool isLocked() const;
@@ -56,20 +66,67 @@ public:
     };
 
     bool isMuted() const;
+    bool isAudible() const; // unmuted or waiting to mute in next interval
     void setMuteState(MuteState newState);
     MuteState getMuteState() const;
 
     uint getAvailableSamples() const;
 
 private:
-    std::vector<float> leftChannel;
-    std::vector<float> rightChannel;
+    /**
+     * Page tables and peaks of the layer. The storages are allocated in non real time threads (bigger
+     * storages for longer cycles and storages with loaded content) and published by the audio thread
+     * in processStorageChanges(), so the audio thread never allocates memory and the GUI thread reading
+     * peaks or samples is never using reallocated vectors. The replaced storage is retired and deleted
+     * (in a non real time thread) when no StorageReader is using it.
+     */
+    struct Storage
+    {
+        Storage();
+        explicit Storage(uint capacity); // null pages and zeroed peaks
+
+        // layer samples are stored in fixed size pages committed in the first write. A null page is silence.
+        std::vector<float *> leftPages;
+        std::vector<float *> rightPages; // the right page is the same left page when the page content is mono
+
+        uint capacity; // in samples
+
+        PeaksPyramid peaksPyramid; // updated in every write, the wave panels are reading peaks in any zoom level
+
+        bool loaded; // the storage content is replacing the layer content, otherwise the current pages are moved to this storage
+        uint loadedSamples;
+    };
+
+    // used by the non audio threads to read the layer storage
+    class StorageReader
+    {
+    public:
+        explicit StorageReader(const LooperLayer &layer);
+        ~StorageReader();
+
+        Storage *getStorage() const;
+        Storage *operator->() const;
+
+    private:
+        const LooperLayer &layer;
+        Storage *storage;
+    };
+
+    std::atomic<Storage *> storage; // replaced only in the audio thread
+    mutable std::atomic<uint> storageReaders;
+
+    QMutex storageMutex; // protecting the pending storage creation and the retired storage deletion (non real time threads)
+    std::atomic<Storage *> pendingStorage; // created in non real time threads, taken by the audio thread
+    std::atomic<Storage *> retiredStorage; // replaced storage, the audio thread is not replacing the storage again until it is deleted
+    std::atomic<uint> requestedCapacity; // requested by the audio thread when the cycle is longer than the storage capacity
+
+    void prepareStorage(uint capacity); // storageMutex locked, post a bigger storage if the capacity is not prepared yet
+    void postStorage(Storage *newStorage); // storageMutex locked
+    void deleteRetiredStorage(); // storageMutex locked, delete the retired storage if no readers are using it
 
-    std::vector<float> peaksCache;
-    uint lastSamplesPerPeak;
     uint availableSamples;
-    uint lastCacheComputationSample;
-    uint lastCycleLenght;
+    std::atomic<uint> lastCycleLenght;
+    uint pendingResize; // cycle lenght waiting a bigger storage to copy the samples, used in the audio thread
     bool locked;
 
     float gain;
@@ -82,6 +139,19 @@ private:
 
     void resize(quint32 samplesPerCycle);
 
+    static bool commitPage(Storage *storage, uint pageIndex, bool stereo, bool realTime);
+    static void releasePages(Storage *storage); // the pages are recycled by the pool when the audio thread finish the current cycle
+
+    // write or mix (add) samples in pages. Right channel can be null to write mono material. Only the real time writes (audio thread) are lock free
+    void writeSamples(Storage *storage, const float *left, const float *right, uint samples, uint startPosition, bool mixing, bool realTime);
+
+    static void updatePeaks(Storage *storage, uint startPosition, uint samples);
+
+    float computeMaxPeak(const Storage *storage, uint from, uint samples) const; // exact peak reading the pages
+
+    template <typename Function>
+    void forEachPageSpan(uint startPosition, uint samples, Function function) const;
+
 };
 
 inline float LooperLayer::getLeftGain() const
@@ -109,6 +179,36 @@ inline bool LooperLayer::isMuted() const
     return muteState == MuteState::Muted;
 }
 
+inline bool LooperLayer::isAudible() const
+{
+    return muteState == MuteState::Unmuted || muteState == MuteState::WaitingToMute;
+}
+
+inline const float *LooperLayer::getSamples(uint channel, uint position) const
+{
+    const Storage *storage = this->storage.load(std::memory_order_acquire); // audio thread, the storage is not retired while mixing
+
+    if (position >= storage->capacity)
+        return nullptr;
+
+    const uint pageIndex = LooperPagePool::getPageIndex(position);
+    const float *page = (channel == 0) ? storage->leftPages[pageIndex] : storage->rightPages[pageIndex];
+    if (!page)
+        return nullptr;
+
+    return page + LooperPagePool::getPageOffset(position);
+}
+
+inline LooperLayer::Storage *LooperLayer::StorageReader::getStorage() const
+{
+    return storage;
+}
+
+inline LooperLayer::Storage *LooperLayer::StorageReader::operator->() const
+{
+    return storage;
+}
+
 inline float LooperLayer::getPan() const
 {
     return pan;
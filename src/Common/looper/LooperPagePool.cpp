@@ -0,0 +1,330 @@
+#include "LooperPagePool.h"
+#include "LooperLayer.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using audio::LooperPagePool;
+using audio::LooperLayer;
+
+LooperPagePool *LooperPagePool::getInstance()
+{
+    static LooperPagePool instance; // thread safe initialization in C++11
+    return &instance;
+}
+
+LooperPagePool::LooperPagePool() :
+    zeroedPages(RECYCLED_PAGES_CAPACITY),
+    releasedPages(RELEASED_PAGES_CAPACITY),
+    audioCycle(0),
+    lastFinishedCycle(0),
+    idleMaintenances(0),
+    memoryBudget(static_cast<quint64>(DEFAULT_MEMORY_BUDGET) * 1024 * 1024),
+    usedPages(0),
+    allocatedPages(0),
+    budgetExceeded(false),
+    maintenanceThread(this)
+{
+    pendingPages.reserve(256);
+
+    maintainPages(); // the reserve is ready before the first audio cycle
+
+    maintenanceThread.start(QThread::LowPriority);
+}
+
+LooperPagePool::~LooperPagePool()
+{
+    maintenanceThread.stop();
+
+    // the loopers are destroyed, all pages can be deleted
+    while (float *page = releasedPages.pop())
+        deletePage(page);
+
+    for (const PendingPage &pending : pendingPages)
+        deletePage(pending.page);
+
+    pendingPages.clear();
+
+    while (float *page = zeroedPages.pop())
+        deletePage(page);
+}
+
+float *LooperPagePool::acquirePage()
+{
+    float *page = zeroedPages.pop();
+    if (!page) {
+        if (!canAllocate())
+            budgetExceeded = true;
+
+        return nullptr; // the reserve is refilled in the maintenance thread
+    }
+
+    usedPages++;
+
+    return page;
+}
+
+float *LooperPagePool::allocatePage()
+{
+    float *page = zeroedPages.pop();
+    if (!page) {
+        QMutexLocker locker(&mutex);
+        page = newPage();
+        if (!page) {
+            budgetExceeded = true;
+            return nullptr;
+        }
+    }
+
+    usedPages++;
+
+    return page;
+}
+
+void LooperPagePool::releasePage(float *page)
+{
+    if (!page)
+        return;
+
+    Q_ASSERT(usedPages > 0);
+    usedPages--;
+
+    const bool released = releasedPages.push(page, audioCycle.load(std::memory_order_acquire));
+    Q_ASSERT(released); // the queue is sized for all pages allowed by the max memory budget
+    Q_UNUSED(released)
+}
+
+void LooperPagePool::addLayer(LooperLayer *layer)
+{
+    QMutexLocker locker(&layersMutex);
+
+    layers.push_back(layer);
+}
+
+void LooperPagePool::removeLayer(LooperLayer *layer)
+{
+    QMutexLocker locker(&layersMutex);
+
+    layers.erase(std::remove(layers.begin(), layers.end(), layer), layers.end());
+}
+
+void LooperPagePool::maintain()
+{
+    maintainPages();
+    maintainLayers();
+}
+
+void LooperPagePool::maintainLayers()
+{
+    QMutexLocker locker(&layersMutex);
+
+    for (LooperLayer *layer : layers)
+        layer->maintainStorage();
+}
+
+void LooperPagePool::maintainPages()
+{
+    QMutexLocker locker(&mutex);
+
+    quint64 releaseCycle = 0;
+    while (float *page = releasedPages.pop(&releaseCycle))
+        pendingPages.push_back({ page, releaseCycle });
+
+    // the pages released before the last audio cycle end are not used by the audio thread
+    const quint64 finishedCycle = audioCycle.load(std::memory_order_acquire);
+    if (finishedCycle != lastFinishedCycle) {
+        lastFinishedCycle = finishedCycle;
+        idleMaintenances = 0;
+    }
+    else if (idleMaintenances < AUDIO_STOPPED_MAINTENANCES) {
+        idleMaintenances++;
+    }
+
+    const bool audioStopped = idleMaintenances >= AUDIO_STOPPED_MAINTENANCES; // no audio cycles in the last second
+
+    size_t stillPending = 0;
+    for (const PendingPage &pending : pendingPages) {
+        if (audioStopped || pending.audioCycle < finishedCycle)
+            recyclePage(pending.page);
+        else
+            pendingPages[stillPending++] = pending;
+    }
+    pendingPages.resize(stillPending);
+
+    // the memory budget was reduced?
+    while (allocatedPages * PAGE_SIZE_IN_BYTES > memoryBudget) {
+        float *page = zeroedPages.pop();
+        if (!page)
+            break;
+
+        deletePage(page);
+    }
+
+    while (zeroedPages.size() < RESERVED_PAGES) {
+        float *page = newPage();
+        if (!page)
+            break; // budget exhausted
+
+        if (!zeroedPages.push(page)) {
+            deletePage(page);
+            break;
+        }
+    }
+}
+
+void LooperPagePool::recyclePage(float *page)
+{
+    if (allocatedPages * PAGE_SIZE_IN_BYTES > memoryBudget) { // budget was reduced, don't recycle this page
+        deletePage(page);
+        return;
+    }
+
+    std::memset(page, 0, PAGE_SIZE_IN_BYTES);
+
+    if (!zeroedPages.push(page))
+        deletePage(page); // too many recycled pages, the memory is given back
+}
+
+float *LooperPagePool::newPage()
+{
+    if (!canAllocate())
+        return nullptr;
+
+    float *page = new (std::nothrow) float[SAMPLES_PER_PAGE](); // zeroed
+    if (page)
+        allocatedPages++;
+
+    return page;
+}
+
+void LooperPagePool::deletePage(float *page)
+{
+    delete [] page;
+    allocatedPages--;
+}
+
+void LooperPagePool::releaseUnusedPages()
+{
+    QMutexLocker locker(&mutex);
+
+    while (float *page = zeroedPages.pop())
+        deletePage(page);
+}
+
+void LooperPagePool::setMemoryBudget(quint64 budgetInBytes)
+{
+    const quint64 maxBudget = static_cast<quint64>(MAX_MEMORY_BUDGET) * 1024 * 1024;
+    memoryBudget = qBound(static_cast<quint64>(PAGE_SIZE_IN_BYTES), budgetInBytes, maxBudget);
+
+    maintainPages(); // drop recycled pages until the allocated memory fits in the new budget
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+LooperPagePool::PageQueue::PageQueue(size_t capacity) :
+    cells(new Cell[capacity]),
+    mask(capacity - 1),
+    enqueuePosition(0),
+    dequeuePosition(0)
+{
+    Q_ASSERT((capacity & mask) == 0);
+
+    for (size_t i = 0; i < capacity; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool LooperPagePool::PageQueue::push(float *page, quint64 audioCycle)
+{
+    Cell *cell = nullptr;
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    forever {
+        cell = &cells[position & mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const qint64 difference = static_cast<qint64>(sequence) - static_cast<qint64>(position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0) {
+            return false; // full
+        }
+        else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->page = page;
+    cell->audioCycle = audioCycle;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+float *LooperPagePool::PageQueue::pop(quint64 *audioCycle)
+{
+    Cell *cell = nullptr;
+    size_t position = dequeuePosition.load(std::memory_order_relaxed);
+    forever {
+        cell = &cells[position & mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const qint64 difference = static_cast<qint64>(sequence) - static_cast<qint64>(position + 1);
+        if (difference == 0) {
+            if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0) {
+            return nullptr; // empty
+        }
+        else {
+            position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    float *page = cell->page;
+    if (audioCycle)
+        *audioCycle = cell->audioCycle;
+
+    cell->sequence.store(position + mask + 1, std::memory_order_release);
+
+    return page;
+}
+
+size_t LooperPagePool::PageQueue::size() const
+{
+    const size_t enqueued = enqueuePosition.load(std::memory_order_relaxed);
+    const size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+LooperPagePool::MaintenanceThread::MaintenanceThread(LooperPagePool *pool) :
+    pool(pool),
+    stopRequested(false)
+{
+
+}
+
+void LooperPagePool::MaintenanceThread::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true;
+        stopCondition.wakeAll();
+    }
+
+    wait();
+}
+
+void LooperPagePool::MaintenanceThread::run()
+{
+    QMutexLocker locker(&mutex);
+    while (!stopRequested) {
+        stopCondition.wait(&mutex, MAINTENANCE_PERIOD);
+
+        if (!stopRequested)
+            pool->maintain();
+    }
+}
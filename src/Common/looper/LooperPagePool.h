@@ -0,0 +1,215 @@
+#ifndef _AUDIO_LOOPER_PAGE_POOL_
+#define _AUDIO_LOOPER_PAGE_POOL_
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <vector>
+#include <atomic>
+#include <memory>
+
+namespace audio {
+
+class LooperLayer;
+
+/**
+ * Process wide pool of fixed size sample pages used by all looper layers.
+ *
+ * Layers commit pages only when a sample is written in the page region and give them back
+ * when the layer content is erased. The audio thread never allocates, locks or zeroes pages:
+ * a reserve of zeroed pages is kept in a lock free queue by a maintenance thread, and the
+ * released pages are recycled (zeroed and moved to the reserve) only after the audio thread
+ * finish the current cycle. The released pages are kept in another lock free queue, their
+ * memory is not touched until they are recycled. The total committed memory is limited by a
+ * memory budget; when the budget is exhausted acquirePage() returns nullptr and the layer
+ * treats the page as silence.
+ *
+ * The maintenance thread also allocates the bigger storages requested by the looper layers
+ * (see LooperLayer::maintainStorage), so the audio thread never allocates memory.
+ */
+
+class LooperPagePool
+{
+public:
+    static const uint SAMPLES_PER_PAGE = 4096; // power of 2, 16 KB per page
+    static const uint PAGE_SIZE_SHIFT = 12;
+    static const uint PAGE_OFFSET_MASK = SAMPLES_PER_PAGE - 1;
+    static const uint PAGE_SIZE_IN_BYTES = SAMPLES_PER_PAGE * sizeof(float);
+
+    static const quint32 DEFAULT_MEMORY_BUDGET = 512; // in MB
+    static const quint32 MAX_MEMORY_BUDGET = 2048; // in MB
+
+    static const uint RESERVED_PAGES = 256; // zeroed pages ready to use in the audio thread (4 MB)
+
+    static LooperPagePool *getInstance();
+
+    float *acquirePage(); // lock free (audio thread), return a zeroed page from the reserve or nullptr if the reserve or the memory budget is exhausted
+    float *allocatePage(); // non real time threads (loading loops), a zeroed page is allocated when the reserve is empty
+    void releasePage(float *page); // lock free, the page is recycled after the current audio cycle
+
+    void finishAudioCycle(); // called by the audio thread when the looper layers are not reading or writing pages
+
+    void maintain(); // recycle the released pages, refill the reserve and maintain the layers storage. Non real time threads only
+
+    void addLayer(LooperLayer *layer); // the layer storage is maintained in the maintenance thread
+    void removeLayer(LooperLayer *layer);
+
+    void releaseUnusedPages(); // free the recycled pages memory
+
+    void setMemoryBudget(quint64 budgetInBytes);
+    quint64 getMemoryBudget() const;
+
+    quint64 getUsedMemory() const; // memory in pages committed by looper layers
+    quint64 getAllocatedMemory() const; // used memory + recycled (free) pages
+
+    bool budgetWasExceeded() const; // true if some page was rejected since the last reset
+    void resetBudgetExceededFlag();
+
+    static inline uint getPageIndex(uint sampleIndex)
+    {
+        return sampleIndex >> PAGE_SIZE_SHIFT;
+    }
+
+    static inline uint getPageOffset(uint sampleIndex)
+    {
+        return sampleIndex & PAGE_OFFSET_MASK;
+    }
+
+    static inline uint getPagesCount(uint samples)
+    {
+        return (samples + PAGE_OFFSET_MASK) >> PAGE_SIZE_SHIFT;
+    }
+
+private:
+    LooperPagePool();
+    ~LooperPagePool();
+
+    LooperPagePool(const LooperPagePool &) = delete;
+    LooperPagePool &operator=(const LooperPagePool &) = delete;
+
+    /**
+     * Bounded lock free queue (many producers and consumers) storing the zeroed and the released pages.
+     * See http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+     */
+    class PageQueue
+    {
+    public:
+        explicit PageQueue(size_t capacity); // power of 2
+
+        bool push(float *page, quint64 audioCycle = 0); // false if the queue is full
+        float *pop(quint64 *audioCycle = nullptr); // nullptr if the queue is empty
+
+        size_t size() const; // approximated when used concurrently
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            float *page;
+            quint64 audioCycle; // the audio cycle running when the page was released
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        const size_t mask;
+        std::atomic<size_t> enqueuePosition;
+        std::atomic<size_t> dequeuePosition;
+    };
+
+    struct PendingPage
+    {
+        float *page;
+        quint64 audioCycle; // the audio cycle running when the page was released
+    };
+
+    class MaintenanceThread : public QThread
+    {
+    public:
+        explicit MaintenanceThread(LooperPagePool *pool);
+        void stop();
+
+    protected:
+        void run() override;
+
+    private:
+        LooperPagePool *pool;
+        QMutex mutex;
+        QWaitCondition stopCondition;
+        bool stopRequested;
+    };
+
+    static const size_t RECYCLED_PAGES_CAPACITY = 4096; // recycled pages above this limit are deleted
+
+    // all pages allowed by the max memory budget (3 MB of cells), releasePage() never find this queue full
+    static const size_t RELEASED_PAGES_CAPACITY = static_cast<size_t>(MAX_MEMORY_BUDGET) * 1024 * 1024 / PAGE_SIZE_IN_BYTES;
+    static const uint MAINTENANCE_PERIOD = 10; // in milliseconds
+    static const uint AUDIO_STOPPED_MAINTENANCES = 100; // the audio is stopped when no cycles are finished in 1 second
+
+    QMutex mutex; // protecting the allocations (maintenance and non real time threads only)
+
+    PageQueue zeroedPages;
+    PageQueue releasedPages;
+    std::vector<PendingPage> pendingPages; // released pages waiting the audio cycle end, used in the maintenance thread
+
+    std::atomic<quint64> audioCycle;
+    quint64 lastFinishedCycle; // used in the maintenance thread
+    uint idleMaintenances;
+
+    std::atomic<quint64> memoryBudget;
+    std::atomic<quint64> usedPages;
+    std::atomic<quint64> allocatedPages;
+    std::atomic<bool> budgetExceeded;
+
+    QMutex layersMutex;
+    std::vector<LooperLayer *> layers;
+
+    MaintenanceThread maintenanceThread;
+
+    void maintainPages();
+    void maintainLayers();
+    void recyclePage(float *page);
+    void deletePage(float *page);
+    float *newPage(); // allocate a zeroed page, nullptr if the budget is exhausted
+
+    bool canAllocate() const;
+};
+
+inline quint64 LooperPagePool::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+inline quint64 LooperPagePool::getUsedMemory() const
+{
+    return usedPages * PAGE_SIZE_IN_BYTES;
+}
+
+inline quint64 LooperPagePool::getAllocatedMemory() const
+{
+    return allocatedPages * PAGE_SIZE_IN_BYTES;
+}
+
+inline bool LooperPagePool::budgetWasExceeded() const
+{
+    return budgetExceeded;
+}
+
+inline void LooperPagePool::resetBudgetExceededFlag()
+{
+    budgetExceeded = false;
+}
+
+inline void LooperPagePool::finishAudioCycle()
+{
+    audioCycle.fetch_add(1, std::memory_order_release);
+}
+
+inline bool LooperPagePool::canAllocate() const
+{
+    return (allocatedPages + 1) * PAGE_SIZE_IN_BYTES <= memoryBudget;
+}
+
+} // namespace
+
+#endif
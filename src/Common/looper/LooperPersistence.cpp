@@ -1,24 +1,30 @@
 #include "LooperPersistence.h"
 #include "Looper.h"
+#include "LoopLibrary.h"
 #include "file/WaveFileWriter.h"
 #include "audio/vorbis/VorbisEncoder.h"
 #include "file/FileReaderFactory.h"
+#include "file/FileUtils.h"
 #include "audio/SamplesBufferResampler.h"
 #include "Utils.h"
 
 #include <QtConcurrent/QtConcurrent>
 #include <QJsonDocument>
+#include <QJsonArray>
 #include <QFileInfo>
+#include <QSaveFile>
 
 using audio::LoopInfo;
 using audio::LoopSaver;
 using audio::LoopLoader;
+using audio::LoopLibrary;
 using audio::Looper;
 using audio::SamplesBuffer;
 
 LoopInfo::LoopInfo(quint32 bpm, quint16 bpi, const QString &name, bool audioIsEncoded, quint8 mode) :
     bpm(bpm),
     bpi(bpi),
+    sampleRate(0),
     name(name),
     usingEncodedAudio(audioIsEncoded),
     looperMode(mode)
@@ -66,23 +72,59 @@ void LoopInfo::addLayer(bool isLocked, float gain, float pan)
 
 LoopSaver::LoopSaver(const QString &savePath, Looper *looper) :
     savePath(savePath),
-    looper(looper)
+    looper(looper),
+    canceled(false)
 {
 
 }
 
-QList<quint8> LoopSaver::getLockedLayers(Looper *looper)
+namespace {
+
+struct LayerSaveJob
+{
+    QString filePath;
+    SamplesBuffer samples;
+};
+
+// functor used to save the layers in QtConcurrent::mapped
+struct LayerSaver
 {
-    QList<quint8> lockedLayers;
-    for (int l = 0; l < looper->getLayers(); ++l) {
-        if (looper->layerIsLocked(l))
-            lockedLayers << l;
+    typedef bool result_type;
+
+    LayerSaver(bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth, const std::atomic<bool> *canceled, bool (*saveFunction)(const QString &, const SamplesBuffer &, bool, float, uint, quint8, const std::atomic<bool> &)) :
+        encodeInOggVorbis(encodeInOggVorbis),
+        vorbisQuality(vorbisQuality),
+        sampleRate(sampleRate),
+        bitDepth(bitDepth),
+        canceled(canceled),
+        saveFunction(saveFunction)
+    {
+
     }
-    return lockedLayers;
-}
 
-void LoopSaver::save(const QString &loopFileName, uint bpm, uint bpi, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth)
+    bool operator()(const LayerSaveJob &job) const
+    {
+        return saveFunction(job.filePath, job.samples, encodeInOggVorbis, vorbisQuality, sampleRate, bitDepth, *canceled);
+    }
+
+    bool encodeInOggVorbis;
+    float vorbisQuality;
+    uint sampleRate;
+    quint8 bitDepth;
+    const std::atomic<bool> *canceled;
+    bool (*saveFunction)(const QString &, const SamplesBuffer &, bool, float, uint, quint8, const std::atomic<bool> &);
+};
+
+} // namespace
+
+QFuture<bool> LoopSaver::save(const QString &loopFileName, uint bpm, uint bpi, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth)
 {
+    Q_ASSERT(!loopFileName.isEmpty());
+    Q_ASSERT(!savePath.isEmpty());
+
+    this->loopFileName = loopFileName;
+    canceled = false;
+
     QDir loopDir(QDir(savePath).absoluteFilePath(loopFileName));
     if (!loopDir.exists()) {
         if (!loopDir.mkpath(".")) {
@@ -90,85 +132,241 @@ void LoopSaver::save(const QString &loopFileName, uint bpm, uint bpi, bool encod
         }
     }
 
+    // looper settings are captured now, the user can change the looper while layers are saved
+    loopJson = QJsonObject();
+    loopJson["bpm"] = static_cast<int>(bpm);
+    loopJson["bpi"] = static_cast<int>(bpi);
+    loopJson["loopLenght"] = static_cast<int>(looper->getIntervalLenght());
+    loopJson["audioFormat"] = encodeInOggVorbis ? "ogg" : "wave";
+    loopJson["looperMode"] = static_cast<int>(looper->getMode());
+    loopJson["sampleRate"] = static_cast<int>(sampleRate);
+
+    QJsonArray layers;
+    for (quint8 l = 0; l < looper->getLayers(); ++l) {
+        QJsonObject layer;
+        layer["locked"] = looper->layerIsLocked(l);
+        layer["gain"] = Utils::poweredGainToLinear(looper->getLayerGain(l));
+        layer["pan"] = looper->getLayerPan(l);
+        layers.append(layer);
+    }
+    loopJson["layers"] = layers;
+
+    // thumbnail used by the loop library to draw previews without decoding the layers
+    QVector<float> thumbnail(LoopLibrary::THUMBNAIL_PEAKS, 0.0f);
+    const uint samplesPerPeak = qMax(1u, (looper->getIntervalLenght() + LoopLibrary::THUMBNAIL_PEAKS - 1) / LoopLibrary::THUMBNAIL_PEAKS);
+    for (quint8 l = 0; l < looper->getLayers(); ++l)
+        LoopLibrary::mergeThumbnailPeaks(thumbnail, looper->getLayerPeaks(l, samplesPerPeak));
+
+    QJsonArray thumbnailArray;
+    for (float peak : thumbnail)
+        thumbnailArray.append(static_cast<double>(peak));
+    loopJson["thumbnail"] = thumbnailArray;
+
+    QList<LayerSaveJob> jobs;
+    layersFilePaths.clear();
     QList<SamplesBuffer> layersSamples = looper->getLayersSamples();
     for (int layer = 0; layer < layersSamples.size(); ++layer) {
-        LoopSaver::saveSamplesToDisk(savePath,
-                                     loopFileName,
-                                     layersSamples.at(layer),
-                                     layer,
-                                     encodeInOggVorbis,
-                                     vorbisQuality,
-                                     sampleRate,
-                                     bitDepth);
+        QString fileName = "layer_" + QString::number(layer) + (encodeInOggVorbis ? ".ogg" : ".wav");
+        QString filePath = loopDir.absoluteFilePath(fileName);
+        layersFilePaths.append(filePath);
+        jobs.append(LayerSaveJob{getTemporaryFilePath(filePath), layersSamples.at(layer)});
     }
 
-    QFile jsonFile(QDir(savePath).absoluteFilePath(loopFileName) + ".json");
-    if (jsonFile.open(QIODevice::WriteOnly)) {
-        QJsonObject root;
-        root["bpm"] = static_cast<int>(bpm);
-        root["bpi"] = static_cast<int>(bpi);
-        root["loopLenght"] = static_cast<int>(looper->getIntervalLenght());
-        root["audioFormat"] = encodeInOggVorbis ? "ogg" : "wave";
-        root["looperMode"] = static_cast<int>(looper->getMode());
-
-        QJsonArray layers;
-        for (quint8 l = 0; l < looper->getLayers(); ++l) {
-            QJsonObject layer;
-            layer["locked"] = looper->layerIsLocked(l);
-            layer["gain"] = Utils::poweredGainToLinear(looper->getLayerGain(l));
-            layer["pan"] = looper->getLayerPan(l);
-            layers.append(layer);
+    future = QtConcurrent::mapped(jobs, LayerSaver(encodeInOggVorbis, vorbisQuality, sampleRate, bitDepth, &canceled, &LoopSaver::saveSamplesToDisk));
+
+    return future;
+}
+
+void LoopSaver::cancel()
+{
+    canceled = true; // stop the layers in progress
+    future.cancel(); // and the layers not started yet
+}
+
+bool LoopSaver::finishSaving()
+{
+    future.waitForFinished();
+
+    bool allLayersSaved = !canceled && !future.isCanceled();
+    for (int layer = 0; allLayersSaved && layer < layersFilePaths.size(); ++layer)
+        allLayersSaved = future.resultCount() > layer && future.resultAt(layer);
+
+    if (!allLayersSaved) { // discard the partial loop, the previous saved loop (if any) is preserved
+        for (const QString &filePath : layersFilePaths)
+            QFile::remove(getTemporaryFilePath(filePath));
+
+        return false;
+    }
+
+    // the layers are renamed over the previous files, a loop being overwritten never has missing layers
+    for (int layer = 0; layer < layersFilePaths.size(); ++layer) {
+        const QString &filePath = layersFilePaths.at(layer);
+        if (!file::replaceFile(getTemporaryFilePath(filePath), filePath)) {
+            qCritical() << "Error replacing the loop layer file" << filePath;
+            for (int l = layer; l < layersFilePaths.size(); ++l)
+                QFile::remove(getTemporaryFilePath(layersFilePaths.at(l)));
+
+            return false;
         }
-        root["layers"] = layers;
+    }
 
-        QJsonDocument doc(root);
-        jsonFile.write(doc.toJson());
-    } else {
+    QSaveFile jsonFile(QDir(savePath).absoluteFilePath(loopFileName) + ".json");
+    if (!jsonFile.open(QIODevice::WriteOnly)) {
         qCritical() << jsonFile.errorString();
+        return false;
     }
 
-    looper->setChanged(false);
+    QJsonDocument doc(loopJson);
+    jsonFile.write(doc.toJson());
+    if (!jsonFile.commit()) {
+        qCritical() << "Error writing the loop file" << jsonFile.fileName() << jsonFile.errorString();
+        return false;
+    }
+
+    if (looper)
+        looper->setChanged(false);
+
+    return true;
 }
 
-void LoopSaver::saveSamplesToDisk(const QString &savePath, const QString &loopFileName, const SamplesBuffer &buffer, quint8 layerIndex, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth)
+QString LoopSaver::getTemporaryFilePath(const QString &filePath)
 {
-    Q_ASSERT(!loopFileName.isEmpty() && !loopFileName.isNull());
-    Q_ASSERT(layerIndex < MAX_LOOP_LAYERS);
-    Q_ASSERT(!savePath.isEmpty());
+    return filePath + ".part";
+}
+
+bool LoopSaver::saveSamplesToDisk(const QString &filePath, const SamplesBuffer &buffer, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth, const std::atomic<bool> &canceled)
+{
+    Q_ASSERT(!filePath.isEmpty());
+
+    if (canceled)
+        return false;
+
+    // encoding and writing in chunks, the encoded layer is never entirely in memory
+    static const uint CHUNK_SIZE = 32768; // in samples
+    SamplesBuffer chunk(2, CHUNK_SIZE);
+    const uint totalSamples = buffer.getFrameLenght();
 
     if (!encodeInOggVorbis) {
         WaveFileWriter waveFileWriter;
-        QString filePath = QDir(savePath).absoluteFilePath(loopFileName +"/layer_" + QString::number(layerIndex) + ".wav");
-        waveFileWriter.write(filePath, buffer, sampleRate, bitDepth);
-    }
-    else {
-        vorbis::Encoder encoder(2, sampleRate, vorbisQuality);
-        QByteArray encodedData = encoder.encode(buffer);
-        encodedData.append(encoder.finishIntervalEncoding());
-        QString filePath = QDir(savePath).absoluteFilePath(loopFileName +"/layer_" + QString::number(layerIndex) + ".ogg");
-        QFile oggFile(filePath);
-        if (oggFile.open(QFile::WriteOnly)) {
-            oggFile.write(encodedData);
-        }
-        else {
+        if (!waveFileWriter.open(filePath, 2, sampleRate, bitDepth, totalSamples)) {
             qCritical() << "Can't write in the file " << filePath;
+            return false;
+        }
+
+        for (uint offset = 0; offset < totalSamples; offset += CHUNK_SIZE) {
+            if (canceled)
+                return false; // the partial file is removed in finishSaving()
+
+            const uint samplesToWrite = qMin(CHUNK_SIZE, totalSamples - offset);
+            chunk.setFrameLenght(samplesToWrite);
+            chunk.set(buffer, offset, samplesToWrite, 0);
+
+            if (!waveFileWriter.append(chunk)) {
+                qCritical() << "Error writing in the file " << filePath;
+                return false;
+            }
+        }
+
+        return waveFileWriter.close();
+    }
+
+    QFile oggFile(filePath);
+    if (!oggFile.open(QFile::WriteOnly)) {
+        qCritical() << "Can't write in the file " << filePath;
+        return false;
+    }
+
+    vorbis::Encoder encoder(2, sampleRate, vorbisQuality);
+    for (uint offset = 0; offset < totalSamples; offset += CHUNK_SIZE) {
+        if (canceled)
+            return false;
+
+        const uint samplesToEncode = qMin(CHUNK_SIZE, totalSamples - offset);
+        chunk.setFrameLenght(samplesToEncode);
+        chunk.set(buffer, offset, samplesToEncode, 0);
+
+        if (oggFile.write(encoder.encode(chunk)) < 0) {
+            qCritical() << "Error writing in the file " << filePath << oggFile.errorString();
+            return false;
         }
     }
+
+    return oggFile.write(encoder.finishIntervalEncoding()) >= 0;
 }
 
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
 LoopLoader::LoopLoader(const QString &loadPath) :
-    loadPath(loadPath)
+    loadPath(loadPath),
+    canceled(false)
 {
 
 }
 
-void LoopLoader::load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval)
+namespace {
+
+// functor used to load the layers in QtConcurrent::mapped
+struct LayerLoader
 {
-    if (!loopInfo.isValid())
-        return;
+    typedef SamplesBuffer result_type;
+
+    LayerLoader(const QString &loadPath, const QString &loopName, bool audioIsEncoded, uint currentSampleRate, quint32 samplesPerInterval, const std::atomic<bool> *canceled) :
+        loadPath(loadPath),
+        loopName(loopName),
+        audioIsEncoded(audioIsEncoded),
+        currentSampleRate(currentSampleRate),
+        samplesPerInterval(samplesPerInterval),
+        canceled(canceled)
+    {
+
+    }
+
+    SamplesBuffer operator()(quint8 layerIndex) const
+    {
+        SamplesBuffer samples(2, samplesPerInterval);
+        if (*canceled || !LoopLoader::loadLoopLayerSamples(loadPath, loopName, layerIndex, audioIsEncoded, currentSampleRate, samples))
+            samples.setFrameLenght(0);
+
+        return samples;
+    }
+
+    QString loadPath;
+    QString loopName;
+    bool audioIsEncoded;
+    uint currentSampleRate;
+    quint32 samplesPerInterval;
+    const std::atomic<bool> *canceled;
+};
+
+} // namespace
+
+QFuture<SamplesBuffer> LoopLoader::load(const LoopInfo &loopInfo, uint currentSampleRate, quint32 samplesPerInterval)
+{
+    this->loopInfo = loopInfo;
+    canceled = false;
+
+    QList<quint8> layers;
+    for (quint8 layer = 0; layer < loopInfo.getLayersCount(); ++layer)
+        layers.append(layer);
+
+    future = QtConcurrent::mapped(layers, LayerLoader(loadPath, loopInfo.getName(), loopInfo.audioIsEncoded(), currentSampleRate, samplesPerInterval, &canceled));
+
+    return future;
+}
+
+void LoopLoader::cancel()
+{
+    canceled = true;
+    future.cancel();
+}
+
+void LoopLoader::finishLoading(Looper *looper)
+{
+    future.waitForFinished();
+
+    if (!loopInfo.isValid() || canceled || future.isCanceled())
+        return; // looper content is not touched
 
     looper->setChanged(false);
     looper->setLoading(true);
@@ -177,12 +375,10 @@ void LoopLoader::load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate,
     looper->setMode(static_cast<Looper::Mode>(loopInfo.getLooperMode()));
     looper->setLayers(loopInfo.getLayersCount());
 
-    bool audioIsEncoded = loopInfo.audioIsEncoded();
     QList<LoopLayerInfo> layersInfo = loopInfo.getLayersInfo();
-    for (quint8 layer = 0; layer < layersInfo.size(); ++layer) {
-        SamplesBuffer samples(2, samplesPerInterval);
-        bool loadResult = LoopLoader::loadLoopLayerSamples(loadPath, loopInfo.getName(), layer, audioIsEncoded, currentSampleRate, samples);
-        if (loadResult) {
+    for (quint8 layer = 0; layer < layersInfo.size() && layer < future.resultCount(); ++layer) {
+        const SamplesBuffer samples = future.resultAt(layer);
+        if (!samples.isEmpty()) {
             looper->setLayerSamples(layer, samples);
             bool layerIsLocked = layersInfo.at(layer).locked;
             looper->setLayerLockedState(layer, layerIsLocked);
@@ -236,23 +432,6 @@ bool LoopLoader::loadLoopLayerSamples(const QString &loadPath, const QString &lo
     return LoopLoader::loadAudioFile(audioFilePath, currentSampleRate, out);
 }
 
-QList<LoopInfo> LoopLoader::loadLoopsInfo(const QString &loadPath, quint32 bpmToMatch)
-{
-    QList<LoopInfo> allInfos;
-
-    QDir loadDir(loadPath);
-    QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Files;
-    QFileInfoList fileInfoList = loadDir.entryInfoList(QStringList("*.json"), filters);
-    for (const QFileInfo &fileInfo : fileInfoList) {
-        QString loopFilePath = fileInfo.absoluteFilePath();
-        LoopInfo loopInfo = LoopLoader::loadLoopInfo(loopFilePath);
-        if (loopInfo.isValid() && loopInfo.getBpm() == bpmToMatch)
-            allInfos.append(loopInfo);
-    }
-
-    return allInfos;
-}
-
 LoopInfo LoopLoader::loadLoopInfo(const QString &loopFilePath)
 {
     QFile file(loopFilePath);
@@ -267,15 +446,19 @@ LoopInfo LoopLoader::loadLoopInfo(const QString &loopFilePath)
     }
 
     QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    QJsonObject root = doc.object();
 
+    return loadLoopInfo(doc.object(), QFileInfo(file).baseName());
+}
+
+LoopInfo LoopLoader::loadLoopInfo(const QJsonObject &root, const QString &loopName)
+{
     quint32 bpm = (root.contains("bpm") ? (root["bpm"].toInt()) : 0);
     quint16 bpi = (root.contains("bpi") ? (root["bpi"].toInt()) : 0);
     bool audioIsEncoded = root.contains("audioFormat") && root["audioFormat"].toString() == "ogg";
-    QString loopName = QFileInfo(file).baseName();
     quint8 looperMode = root.contains("looperMode") ? root["looperMode"].toInt() : 0;
 
     LoopInfo loopInfo(bpm, bpi, loopName, audioIsEncoded, looperMode);
+    loopInfo.setSampleRate(root["sampleRate"].toInt(0));
 
     if (root.contains("layers")) {
         if (root["layers"].isArray()) { // new loop file format
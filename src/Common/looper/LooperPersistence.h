@@ -1,14 +1,20 @@
 #ifndef _LOOPER_PERSISTENCE_H_
 #define _LOOPER_PERSISTENCE_H_
 
+#include "audio/core/SamplesBuffer.h"
+
 #include <QString>
 #include <QSet>
 #include <QList>
+#include <QFuture>
+#include <QJsonObject>
+#include <QStringList>
+
+#include <atomic>
 
 namespace audio {
 
 class Looper;
-class SamplesBuffer;
 
 class LoopSaver
 {
@@ -16,19 +22,58 @@ class LoopSaver
 public:
 
     LoopSaver(const QString &savePath, Looper *looper);
-    void save(const QString &loopFileName, uint bpm, uint bpi, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth);
+
+    // layers are encoded and written in parallel in the global thread pool, the returned future has one result (success) per layer
+    QFuture<bool> save(const QString &loopFileName, uint bpm, uint bpi, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth);
+
+    // called in main thread when the future is finished. Publish the saved layers and the json file, or discard the saved layers if saving was canceled
+    bool finishSaving();
+
+    void cancel();
+    bool isCanceled() const;
+
+    void detachLooper(); // the saving continues, but the looper is not touched in finishSaving()
+
+    QString getLoopFileName() const;
+    int getLayersCount() const; // layers being saved
 
 private:
     QString savePath;
     Looper *looper;
 
-    static QList<quint8> getLockedLayers(Looper *looper);
-    static void saveSamplesToDisk(const QString &savePath, const QString &loopFileName, const SamplesBuffer &buffer, quint8 layerIndex, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth);
+    QString loopFileName;
+    QJsonObject loopJson; // looper settings and thumbnail captured when saving is started
+    QStringList layersFilePaths; // layers are written in temporary files and renamed in finishSaving()
+
+    QFuture<bool> future;
+    std::atomic<bool> canceled;
 
-    void saveJsonFile(const QString &loopFileName);
+    static QString getTemporaryFilePath(const QString &filePath);
+
+    static bool saveSamplesToDisk(const QString &filePath, const SamplesBuffer &buffer, bool encodeInOggVorbis, float vorbisQuality, uint sampleRate, quint8 bitDepth, const std::atomic<bool> &canceled);
 
 };
 
+inline QString LoopSaver::getLoopFileName() const
+{
+    return loopFileName;
+}
+
+inline int LoopSaver::getLayersCount() const
+{
+    return layersFilePaths.size();
+}
+
+inline bool LoopSaver::isCanceled() const
+{
+    return canceled;
+}
+
+inline void LoopSaver::detachLooper()
+{
+    looper = nullptr;
+}
+
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++=
 
 struct LoopLayerInfo
@@ -63,9 +108,13 @@ public:
     quint16 getBpi() const;
     quint32 getBpm() const;
 
+    quint32 getSampleRate() const; // zero when unknown (loops saved by older versions)
+    void setSampleRate(quint32 sampleRate);
+
 private:
     quint32 bpm;
     quint16 bpi;
+    quint32 sampleRate;
     QString name;
     bool usingEncodedAudio;
     QList<LoopLayerInfo> layers;
@@ -82,6 +131,16 @@ inline quint32 LoopInfo::getBpm() const
     return bpm;
 }
 
+inline quint32 LoopInfo::getSampleRate() const
+{
+    return sampleRate;
+}
+
+inline void LoopInfo::setSampleRate(quint32 sampleRate)
+{
+    this->sampleRate = sampleRate;
+}
+
 inline quint8 LoopInfo::getLooperMode() const
 {
     return looperMode;
@@ -114,19 +173,43 @@ class LoopLoader
 
 public:
     explicit LoopLoader(const QString &loadPath);
-    void load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval);
+
+    // layers are decoded (and resampled) in parallel in the global thread pool, the returned future has one result per layer. Empty buffers are failures.
+    QFuture<SamplesBuffer> load(const LoopInfo &loopInfo, uint currentSampleRate, quint32 samplesPerInterval);
+
+    // called in main thread when the future is finished, the loaded layers are copied to the looper
+    void finishLoading(Looper *looper);
+
+    void cancel();
+    bool isCanceled() const;
+
+    LoopInfo getLoopInfo() const;
 
     static LoopInfo loadLoopInfo(const QString &loopFilePath);
-    static QList<LoopInfo> loadLoopsInfo(const QString &loadPath, quint32 bpmToMatch);
+    static LoopInfo loadLoopInfo(const QJsonObject &loopJson, const QString &loopName);
     static bool loadAudioFile(const QString &filePath, uint currentSampleRate, SamplesBuffer &out);
 
     static bool loadLoopLayerSamples(const QString &loadPath, const QString &loopName, quint8 layerIndex, bool audioIsEncoded, uint currentSampleRate, SamplesBuffer &out);
 
 private:
     QString loadPath;
+    LoopInfo loopInfo;
+
+    QFuture<SamplesBuffer> future;
+    std::atomic<bool> canceled;
 
 };
 
+inline LoopInfo LoopLoader::getLoopInfo() const
+{
+    return loopInfo;
+}
+
+inline bool LoopLoader::isCanceled() const
+{
+    return canceled;
+}
+
 } // namespace
 
 #endif
@@ -78,9 +78,9 @@ void PlayingState::mixTo(SamplesBuffer &samples, uint samplesToProcess)
     {
         bool isPlayingLockedLayersOnly = looper->getOption(Looper::PlayLockedLayers);
         if (!isPlayingLockedLayersOnly)
-            looper->mixAllLayers(samples, samplesToProcess); // mix all layers, no excluded layers
+            looper->mixLayers(looper->getAllLayersMask(), samples, samplesToProcess); // mix all layers, no excluded layers
         else
-            looper->mixLockedLayers(samples, samplesToProcess); // mix locked only
+            looper->mixLayers(looper->getLockedLayersMask(), samples, samplesToProcess); // mix locked only
         break;
     }
     default:
@@ -132,15 +132,15 @@ void RecordingState::mixTo(SamplesBuffer &samples, uint samplesToProcess)
     const bool hearingAllLayers = looper->getMode() == Looper::AllLayers || looper->getOption(Looper::HearAllLayers);
     if (hearingAllLayers) {
         if (looper->getOption(Looper::PlayLockedLayers) && looper->hasLockedLayers()) {
-            looper->mixLockedLayers(samples, samplesToProcess);
-            looper->mixLayer(looper->currentLayerIndex, samples, samplesToProcess);
+            const auto layersMask = looper->getLockedLayersMask() | looper->getLayerMask(looper->currentLayerIndex);
+            looper->mixLayers(layersMask, samples, samplesToProcess);
         }
         else {
-            looper->mixAllLayers(samples, samplesToProcess); // user can hear other layers while recording
+            looper->mixLayers(looper->getAllLayersMask(), samples, samplesToProcess); // user can hear other layers while recording
         }
     }
     else {
-        looper->mixLayer(looper->currentLayerIndex, samples, samplesToProcess);
+        looper->mixCurrentLayerTo(samples, samplesToProcess);
     }
 }
 
@@ -175,12 +175,12 @@ void WaitingToRecordState::mixTo(SamplesBuffer &samples, uint samplesToProcess)
     const bool hearingAllLayers = looper->getMode() == Looper::AllLayers || looper->getOption(Looper::HearAllLayers);
     if (hearingAllLayers) {
         if (looper->getOption(Looper::PlayLockedLayers))
-            looper->mixLockedLayers(samples, samplesToProcess);
+            looper->mixLayers(looper->getLockedLayersMask(), samples, samplesToProcess);
         else
-            looper->mixAllLayers(samples, samplesToProcess); // user can hear other layers while recording
+            looper->mixLayers(looper->getAllLayersMask(), samples, samplesToProcess); // user can hear other layers while recording
     }
     else {
-        looper->mixLayer(looper->currentLayerIndex, samples, samplesToProcess);
+        looper->mixCurrentLayerTo(samples, samplesToProcess);
     }
 }
 
@@ -77,6 +77,7 @@ namespace client
 
         long getTotalUploadTransferRate() const;
         long getTotalDownloadTransferRate() const;
+        qint64 getUploadQueuedBytes() const; // bytes waiting in the socket send queue
         long getDownloadTransferRate(const QString userFullName, quint8 channelIndex) const;
 
     signals:
@@ -170,6 +171,11 @@ namespace client
         return totalUploadMeasurer.getTransferRate();
     }
 
+    inline qint64 Service::getUploadQueuedBytes() const
+    {
+        return socket ? socket->bytesToWrite() : 0;
+    }
+
     inline QStringList Service::getBotNamesList()
     {
         return botNames;
@@ -1,4 +1,5 @@
 #include "Settings.h"
+#include "SettingsWriter.h"
 #include <QDebug>
 #include <QApplication>
 #include <QStandardPaths>
@@ -12,6 +13,7 @@
 #include <QSettings>
 #include "log/Logging.h"
 #include "audio/vorbis/Vorbis.h"
+#include "looper/LooperPagePool.h"
 
 using namespace persistence;
 
@@ -92,13 +94,16 @@ QJsonObject SettingsObject::getValueFromJson(const QJsonObject &json, const QStr
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+static const quint32 MIN_LOOPER_MEMORY_BUDGET = 32; // in MB
+
 LooperSettings::LooperSettings() :
     SettingsObject("Looper"),
     preferredLayersCount(4),
     preferredMode(0),
     loopsFolder(""),
     encodingAudioWhenSaving(false),
-    waveFilesBitDepth(16) // 16 bits
+    waveFilesBitDepth(16), // 16 bits
+    memoryBudget(audio::LooperPagePool::DEFAULT_MEMORY_BUDGET)
 {
     qCDebug(jtSettings) << "LooperSettings ctor";
     setDefaultLooperFilesPath();
@@ -111,6 +116,16 @@ void LooperSettings::read(const QJsonObject &in)
     loopsFolder = getValueFromJson(in, "loopsFolder", QString());
     encodingAudioWhenSaving = getValueFromJson(in, "encodeAudio", false);
     waveFilesBitDepth = getValueFromJson(in, "bitDepth", quint8(16)); // 16 bit as default value
+    memoryBudget = getValueFromJson(in, "memoryBudget", static_cast<int>(audio::LooperPagePool::DEFAULT_MEMORY_BUDGET)); // in MB
+
+    if (memoryBudget < MIN_LOOPER_MEMORY_BUDGET) {
+        qWarning() << "Invalid looper memory budget " << memoryBudget << "MB, using " << MIN_LOOPER_MEMORY_BUDGET << "MB";
+        memoryBudget = MIN_LOOPER_MEMORY_BUDGET;
+    }
+    else if (memoryBudget > audio::LooperPagePool::MAX_MEMORY_BUDGET) {
+        qWarning() << "Invalid looper memory budget " << memoryBudget << "MB, using " << audio::LooperPagePool::MAX_MEMORY_BUDGET << "MB";
+        memoryBudget = audio::LooperPagePool::MAX_MEMORY_BUDGET;
+    }
 
     if (!(waveFilesBitDepth == 16 || waveFilesBitDepth == 32)) {
         qWarning() << "Invalid bit depth " << waveFilesBitDepth << ", using 16 bits as default value";
@@ -143,7 +158,8 @@ void LooperSettings::read(const QJsonObject &in)
                     << "; loopsFolder " << loopsFolder
                     << " (useDefaultSavePath " << useDefaultSavePath << ")"
                     << "; encodingAudioWhenSaving " << encodingAudioWhenSaving
-                    << "; waveFilesBitDepth " << waveFilesBitDepth;
+                    << "; waveFilesBitDepth " << waveFilesBitDepth
+                    << "; memoryBudget " << memoryBudget;
 
 }
 
@@ -172,6 +188,8 @@ void LooperSettings::write(QJsonObject &out) const
 
     if (!encodingAudioWhenSaving)
         out["bitDepth"] = waveFilesBitDepth;
+
+    out["memoryBudget"] = static_cast<int>(memoryBudget);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -231,6 +249,7 @@ void Settings::addPrivateServer(const QString &serverName, int serverPort, const
 {
     qCDebug(jtSettings) << "PrivateServerSettings addPrivateServer";
     privateServerSettings.addPrivateServerData(serverName, serverPort, password);
+    setChanged(privateServerSettings);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -334,7 +353,8 @@ MultiTrackRecordingSettings::MultiTrackRecordingSettings() :
     saveMultiTracksActivated(false),
     jamRecorderActivated(QMap<QString, bool>()),
     recordingPath(""),
-    dirNameDateFormat("Qt::TextDate")
+    dirNameDateFormat("Qt::TextDate"),
+    continuousTrackFiles(false)
 {
     qCDebug(jtSettings) << "MultiTrackRecordingSettings ctor";
     // TODO: populate jamRecorderActivated with {jamRecorderId, false} pairs for each known jamRecorder
@@ -346,6 +366,7 @@ void MultiTrackRecordingSettings::write(QJsonObject &out) const
     out["recordingPath"] = QDir::toNativeSeparators(recordingPath);
     out["dirNameDateFormat"] = dirNameDateFormat;
     out["recordActivated"] = saveMultiTracksActivated;
+    out["continuousTrackFiles"] = continuousTrackFiles;
     QJsonObject jamRecorders = QJsonObject();
     for (const QString &key : jamRecorderActivated.keys()) {
         QJsonObject jamRecorder = QJsonObject();
@@ -382,6 +403,7 @@ void MultiTrackRecordingSettings::read(const QJsonObject &in)
     }
 
     saveMultiTracksActivated = getValueFromJson(in, "recordActivated", false);
+    continuousTrackFiles = getValueFromJson(in, "continuousTrackFiles", false);
 
     QJsonObject jamRecorders = getValueFromJson(in, "jamRecorders", QJsonObject());
     for(const QString &key : jamRecorders.keys()) {
@@ -580,10 +602,7 @@ void VstSettings::read(const QJsonObject &in)
     if (in.contains("cachedPlugins")) {
         QJsonArray cacheArray = in["cachedPlugins"].toArray();
         for (int x = 0; x < cacheArray.size(); ++x) {
-            QString pluginFile = cacheArray.at(x).toString();
-            if (QFile(pluginFile).exists()) // if a cached plugin is removed from the disk we need skip this file
-
-                cachedPlugins.append(pluginFile);
+            cachedPlugins.append(cacheArray.at(x).toString()); // the removed plugins are skipped when the plugins list is loaded, after the main window is showed
         }
     }
     blackedPlugins.clear();
@@ -865,6 +884,14 @@ void Settings::addVstPlugin(const QString &pluginPath)
     qCDebug(jtSettings) << "Settings addVstPlugin: " << pluginPath;
     if (!vstSettings.cachedPlugins.contains(pluginPath))
         vstSettings.cachedPlugins.append(pluginPath);
+    setChanged(vstSettings);
+}
+
+void Settings::removeVstPlugin(const QString &pluginPath)
+{
+    qCDebug(jtSettings) << "Settings removeVstPlugin: " << pluginPath;
+    vstSettings.cachedPlugins.removeAll(pluginPath);
+    setChanged(vstSettings);
 }
 
 void Settings::addVstToBlackList(const QString &pluginPath)
@@ -872,12 +899,14 @@ void Settings::addVstToBlackList(const QString &pluginPath)
     qCDebug(jtSettings) << "Settings addVstToBlackList: " << pluginPath;
     if (!vstSettings.blackedPlugins.contains(pluginPath))
         vstSettings.blackedPlugins.append(pluginPath);
+    setChanged(vstSettings);
 }
 
 void Settings::removeVstFromBlackList(const QString &pluginPath)
 {
     qCDebug(jtSettings) << "Settings removeVstFromBlackList: " << pluginPath;
     vstSettings.blackedPlugins.removeOne(pluginPath);
+    setChanged(vstSettings);
 }
 
 QStringList Settings::getVstPluginsPaths() const
@@ -890,6 +919,7 @@ void Settings::clearVstCache()
 {
     qCDebug(jtSettings) << "Settings clearVstCache";
     vstSettings.cachedPlugins.clear();
+    setChanged(vstSettings);
 }
 
 // CLEAR VST BLACKBOX
@@ -897,6 +927,7 @@ void Settings::clearBlackBox()
 {
     qCDebug(jtSettings) << "Settings clearBlackBox";
     vstSettings.blackedPlugins.clear();
+    setChanged(vstSettings);
 }
 
 // VST paths to scan
@@ -904,12 +935,14 @@ void Settings::addVstScanPath(const QString &path)
 {
     qCDebug(jtSettings) << "Settings addVstScanPath: " << path;
     vstSettings.foldersToScan.append(path);
+    setChanged(vstSettings);
 }
 
 void Settings::removeVstScanPath(const QString &path)
 {
     qCDebug(jtSettings) << "Settings removeVstScanPath: " << path;
     vstSettings.foldersToScan.removeOne(path);
+    setChanged(vstSettings);
 }
 
 QStringList Settings::getVstScanFolders() const
@@ -933,12 +966,14 @@ void Settings::addAudioUnitPlugin(const QString &pluginPath)
     qCDebug(jtSettings) << "Settings addAudioUnitPlugin: " << pluginPath;
     if (!audioUnitSettings.cachedPlugins.contains(pluginPath))
         audioUnitSettings.cachedPlugins.append(pluginPath);
+    setChanged(audioUnitSettings);
 }
 
 void Settings::clearAudioUnitCache()
 {
     qCDebug(jtSettings) << "Settings clearAudioUnitCache";
     audioUnitSettings.cachedPlugins.clear();
+    setChanged(audioUnitSettings);
 }
 
 QStringList Settings::getAudioUnitsPaths() const
@@ -958,6 +993,7 @@ void Settings::setMetronomeSettings(float gain, float pan, bool muted)
     metronomeSettings.pan = pan;
     metronomeSettings.gain = gain;
     metronomeSettings.muted = muted;
+    setChanged(metronomeSettings);
 }
 
 void Settings::setBuiltInMetronome(const QString &metronomeAlias)
@@ -965,6 +1001,7 @@ void Settings::setBuiltInMetronome(const QString &metronomeAlias)
     qCDebug(jtSettings) << "Settings setBuiltInMetronome: from " << metronomeSettings.builtInMetronomeAlias << " to " << metronomeAlias << " (and not custom sounds)";
     metronomeSettings.builtInMetronomeAlias = metronomeAlias;
     metronomeSettings.usingCustomSounds = false;
+    setChanged(metronomeSettings);
 }
 
 void Settings::setCustomMetronome(const QString &primaryBeatAudioFile, const QString &offBeatAudioFile, const QString &accentBeatAudioFile)
@@ -984,6 +1021,7 @@ void Settings::setCustomMetronome(const QString &primaryBeatAudioFile, const QSt
         metronomeSettings.customAccentBeatAudioFile = "";
         metronomeSettings.usingCustomSounds = false;
     }
+    setChanged(metronomeSettings);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -992,6 +1030,7 @@ void Settings::setFullScreenView(bool v)
 {
     qCDebug(jtSettings) << "Settings setFullScreenView: from " << windowSettings.fullScreenMode << " to " << v;
     windowSettings.fullScreenMode = v;
+    setChanged(windowSettings);
 }
 
 // +++++++++   Window Location  +++++++++++++++++++++++
@@ -1011,6 +1050,7 @@ void Settings::setWindowSettings(bool windowIsMaximized, const QPointF &location
     windowSettings.location = newLocation;
     windowSettings.maximized = windowIsMaximized;
     windowSettings.size = size;
+    setChanged(windowSettings);
 }
 
 // ++++++++++++++++++++++++++++++++++++++++
@@ -1028,18 +1068,21 @@ void Settings::setAudioSettings(int firstIn, int lastIn, int firstOut, int lastO
     audioSettings.lastOut = lastOut;
     audioSettings.audioInputDevice = audioInputDevice;
     audioSettings.audioOutputDevice = audioOutputDevice;
+    setChanged(audioSettings);
 }
 
 void Settings::setSampleRate(int newSampleRate)
 {
     qCDebug(jtSettings) << "Settings setSampleRate: from " << audioSettings.sampleRate << " to " << newSampleRate;
     audioSettings.sampleRate = newSampleRate;
+    setChanged(audioSettings);
 }
 
 void Settings::setBufferSize(int bufferSize)
 {
     qCDebug(jtSettings) << "Settings setBufferSize: from " << audioSettings.bufferSize << " to " << bufferSize;
     audioSettings.bufferSize = bufferSize;
+    setChanged(audioSettings);
 }
 
 bool Settings::readFile(const QList<SettingsObject *> &sections)
@@ -1109,6 +1152,8 @@ bool Settings::readFile(const QList<SettingsObject *> &sections)
             chatFontSizeOffset = root["chatFontSizeOffset"].toInt();
         }
 
+        lastWrittenJson = root;
+
         return true;
     }
     else {
@@ -1123,58 +1168,105 @@ void Settings::setLooperPreferredLayersCount(quint8 layersCount)
 {
     qCDebug(jtSettings) << "Settings setLooperPreferredLayersCount: from " << looperSettings.preferredLayersCount << " to " << layersCount;
     looperSettings.preferredLayersCount = layersCount <= 8 ? layersCount : 8;
+    setChanged(looperSettings);
 }
 
 void Settings::setLooperAudioEncodingFlag(bool encodeAudioWhenSaving)
 {
     qCDebug(jtSettings) << "Settings setLooperAudioEncodingFlag: from " << looperSettings.encodingAudioWhenSaving << " to " << encodeAudioWhenSaving;
     looperSettings.encodingAudioWhenSaving = encodeAudioWhenSaving;
+    setChanged(looperSettings);
 }
 
 void Settings::setLooperPreferredMode(quint8 looperMode)
 {
     qCDebug(jtSettings) << "Settings setLooperPreferredMode: from " << looperSettings.preferredMode << " to " << looperMode;
     looperSettings.preferredMode = looperMode;
+    setChanged(looperSettings);
 }
 
 bool Settings::writeFile(const QList<SettingsObject *> &sections) // io ops ...
 {
     qCDebug(jtSettings) << "Settings writeFile...";
+
     QDir configFileDir = Configurator::getInstance()->getBaseDir();
-    QFile file(configFileDir.absoluteFilePath(fileName));
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonObject root;
-
-        // writing global settings
-        root["userName"] = lastUserName; // write user name
-        root["translation"] = translation; // write translate locale
-        root["theme"] = theme;
-        root["intervalProgressShape"] = ninjamIntervalProgressShape;
-        root["tracksLayoutOrientation"] = tracksLayoutOrientation;
-        root["usingNarrowTracks"] = usingNarrowedTracks;
-        root["masterGain"] = masterFaderGain;
-        root["intervalsBeforeInactivityWarning"] = static_cast<int>(intervalsBeforeInactivityWarning);
-        root["chatFontSizeOffset"] = static_cast<int>(chatFontSizeOffset);
-        root["publicChatActivated"] = publicChatIsActivated();
-
-        if (!recentEmojis.isEmpty()) {
-            root["recentEmojis"] = QJsonArray::fromStringList(recentEmojis);
-        }
+    const QString filePath = configFileDir.absoluteFilePath(fileName);
+
+    if (writer && writer->takeWriteFailure(filePath))
+        lastWrittenJson = QJsonObject(); // the last background write failed, all settings are written again
+
+    QJsonObject root = lastWrittenJson; // implicitly shared, the sections not changed are not serialized again
+    bool changed = false;
 
-        // write settings sections
-        for (SettingsObject *so : sections) {
-            QJsonObject sectionObject;
-            so->write(sectionObject);
-            root[so->getName()] = sectionObject;
+    auto setValue = [&root, &changed](const QString &key, const QJsonValue &value) {
+        if (root.value(key) != value) {
+            root[key] = value;
+            changed = true;
         }
-        QJsonDocument doc(root);
-        file.write(doc.toJson());
-        qCDebug(jtCore) << "Settings writeFile: " << doc;
+    };
+
+    // writing global settings
+    setValue("userName", lastUserName); // write user name
+    setValue("translation", translation); // write translate locale
+    setValue("theme", theme);
+    setValue("intervalProgressShape", ninjamIntervalProgressShape);
+    setValue("tracksLayoutOrientation", tracksLayoutOrientation);
+    setValue("usingNarrowTracks", usingNarrowedTracks);
+    setValue("masterGain", masterFaderGain);
+    setValue("intervalsBeforeInactivityWarning", static_cast<int>(intervalsBeforeInactivityWarning));
+    setValue("chatFontSizeOffset", static_cast<int>(chatFontSizeOffset));
+    setValue("publicChatActivated", publicChatIsActivated());
+
+    if (!recentEmojis.isEmpty()) {
+        setValue("recentEmojis", QJsonArray::fromStringList(recentEmojis));
+    }
+
+    // write the changed settings sections
+    for (SettingsObject *so : sections) {
+        if (!changedSections.contains(so) && root.contains(so->getName()))
+            continue;
+
+        QJsonObject sectionObject;
+        so->write(sectionObject);
+        setValue(so->getName(), sectionObject);
+    }
+
+    changedSections.clear();
+
+    if (!changed) {
+        qCDebug(jtSettings) << "Settings writeFile: settings not changed";
         return true;
-    } else {
-        qCritical() << file.errorString();
     }
-    return false;
+
+    if (!writeJson(filePath, root)) {
+        lastWrittenJson = QJsonObject(); // written again in the next save
+        return false;
+    }
+
+    lastWrittenJson = root; // a background write failure is checked in the next save
+
+    return true;
+}
+
+bool Settings::writeJson(const QString &filePath, const QJsonObject &json)
+{
+    if (writer) {
+        writer->write(filePath, json); // the JSON is serialized and written in background
+        return true;
+    }
+
+    return SettingsWriter::writeFile(filePath, json);
+}
+
+void Settings::waitForWrites()
+{
+    if (writer)
+        writer->waitForWrites();
+}
+
+void Settings::setWriter(SettingsWriter *writer)
+{
+    this->writer = writer;
 }
 
 // PRESETS
@@ -1182,22 +1274,14 @@ bool Settings::writePresetToFile(const Preset &preset)
 {
     qCDebug(jtSettings) << "Settings writePresetToFile...";
     QString absolutePath = Configurator::getInstance()->getPresetPath(preset.name);
-    QFile file(absolutePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        QJsonObject inputTracksJsonObject;
-        preset.inputTrackSettings.write(inputTracksJsonObject); // write the channels and subchannels in the json object
 
-        QJsonObject root;
-        root[preset.name] = inputTracksJsonObject;
+    QJsonObject inputTracksJsonObject;
+    preset.inputTrackSettings.write(inputTracksJsonObject); // write the channels and subchannels in the json object
 
-        QJsonDocument doc(root);
-        file.write(doc.toJson());
-        qCDebug(jtSettings) << "Settings writePresetToFile: " << doc;
-        return true;
-    } else {
-        qCritical() << file.errorString();
-    }
-    return false;
+    QJsonObject root;
+    root[preset.name] = inputTracksJsonObject;
+
+    return writeJson(absolutePath, root);
 }
 
 // ++++++++++++++++++++++++++++++
@@ -1212,6 +1296,9 @@ Preset::Preset(const QString &name, const LocalInputTrackSettings &inputSettings
 Preset Settings::readPresetFromFile(const QString &presetFileName, bool allowMultiSubchannels)
 {
     qCDebug(jtSettings) << "Preset readPresetFromFile";
+
+    waitForWrites(); // the preset can be saved just now
+
     QString absolutePath = Configurator::getInstance()->getPresetPath(presetFileName);
     QFile presetFile(absolutePath);
     if (presetFile.open(QIODevice::ReadOnly)) {
@@ -1265,7 +1352,8 @@ Settings::Settings() :
     usingNarrowedTracks(false),
     intervalsBeforeInactivityWarning(5), // 5 intervals by default,
     chatFontSizeOffset(0),
-    publicChatActivated(true)
+    publicChatActivated(true),
+    writer(nullptr)
 {
     qCDebug(jtSettings) << "Settings ctor";
     // qDebug() << "Settings in " << fileDir;
@@ -1275,6 +1363,7 @@ void Settings::save(const LocalInputTrackSettings &localInputsSettings)
 {
     qCDebug(jtSettings) << "Settings save";
     this->inputsSettings = localInputsSettings;
+    setChanged(inputsSettings);
     QList<persistence::SettingsObject *> sections;
     sections.append(&audioSettings);
     sections.append(&midiSettings);
@@ -1298,6 +1387,7 @@ void Settings::save(const LocalInputTrackSettings &localInputsSettings)
 void Settings::deletePreset(const QString &name)
 {
     qCDebug(jtSettings) << "Settings deletePreset " << name;
+    waitForWrites(); // avoiding a pending write recreating the deleted preset
     Configurator::getInstance()->deletePreset(name);
 }
 
@@ -1332,6 +1422,7 @@ void Settings::setRemoteUserRememberingSettings(bool boost, bool level, bool pan
     rememberSettings.rememberPan     = pan;
     rememberSettings.rememberLowCut  = lowCut;
     rememberSettings.rememberMute    = mute;
+    setChanged(rememberSettings);
 }
 
 void Settings::setCollapsileSectionsRememberingSettings(bool localChannels, bool bottomSection, bool chatSection)
@@ -1342,6 +1433,7 @@ void Settings::setCollapsileSectionsRememberingSettings(bool localChannels, bool
     rememberSettings.rememberLocalChannels = localChannels;
     rememberSettings.rememberBottomSection = bottomSection;
     rememberSettings.rememberChatSection = chatSection;
+    setChanged(rememberSettings);
 }
 
 //__________________________________________________________
@@ -6,6 +6,7 @@
 #include <QJsonObject>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <QStringList>
 #include <QFile>
 #include <QSize>
@@ -15,6 +16,7 @@
 namespace persistence {
 
 class Settings;
+class SettingsWriter;
 
 class SettingsObject // base class for the settings components
 {
@@ -167,6 +169,7 @@ public:
     bool saveMultiTracksActivated;
     QString recordingPath;
     QString dirNameDateFormat;
+    bool continuousTrackFiles; // append the intervals of each track in one file
 
     inline bool isJamRecorderActivated(const QString &key) const
     {
@@ -216,6 +219,7 @@ public:
     QString loopsFolder; // where looper audio files will be saved
     bool encodingAudioWhenSaving;
     quint8 waveFilesBitDepth;
+    quint32 memoryBudget; // in MB, shared by all loopers
 
 private:
     void setDefaultLooperFilesPath();
@@ -425,13 +429,24 @@ private:
 
     qint8 chatFontSizeOffset;
 
+    SettingsWriter *writer; // the files are written in background when a writer is used
+    QJsonObject lastWrittenJson; // the last read or written config file, the sections not changed are reused when writing
+    QSet<const SettingsObject *> changedSections; // sections changed since the last write
+
     bool readFile(const QList<SettingsObject *> &sections);
     bool writeFile(const QList<SettingsObject *> &sections);
 
+    void setChanged(const SettingsObject &section);
+
+    bool writeJson(const QString &filePath, const QJsonObject &json);
+    void waitForWrites();
+
 public:
     Settings();
     ~Settings();
 
+    void setWriter(SettingsWriter *writer);
+
     void storeWaveDrawingMode(quint8 mode);
     quint8 getLastWaveDrawingMode() const;
 
@@ -486,6 +501,8 @@ public:
     void setMultiTrackRecordingPath(const QString &newPath);
     QString getDirNameDateFormat() const;
     void setDirNameDateFormat(const QString &newDateFormat);
+    bool isRecordingContinuousTrackFiles() const;
+    void setRecordingContinuousTrackFiles(bool continuousTrackFiles);
 
     // user name
     QString getUserName() const;
@@ -497,6 +514,7 @@ public:
 
     // VST
     void addVstPlugin(const QString &pluginPath);
+    void removeVstPlugin(const QString &pluginPath);
     void addVstToBlackList(const QString &pluginPath);
     void removeVstFromBlackList(const QString &pluginPath);
     QStringList getVstPluginsPaths() const;
@@ -575,6 +593,7 @@ public:
     bool getLooperAudioEncodingFlag() const;
     QString getLooperFolder() const;
     quint8 getLooperBitDepth() const;
+    quint32 getLooperMemoryBudget() const;
 
     void setLooperPreferredLayersCount(quint8 layersCount);
     void setLooperPreferredMode(quint8 looperMode);
@@ -619,19 +638,27 @@ inline bool Settings::publicChatIsActivated() const
     return publicChatActivated;
 }
 
+inline void Settings::setChanged(const SettingsObject &section)
+{
+    changedSections.insert(&section);
+}
+
 inline void Settings::setLocalChannelsCollapsed(bool collapsed)
 {
     collapseSettings.localChannelsCollapsed = collapsed;
+    setChanged(collapseSettings);
 }
 
 inline void Settings::setBottomSectionCollapsed(bool collapsed)
 {
     collapseSettings.bottomSectionCollapsed = collapsed;
+    setChanged(collapseSettings);
 }
 
 inline void Settings::setChatSectionCollapsed(bool collapsed)
 {
     collapseSettings.chatSectionCollapsed = collapsed;
+    setChanged(collapseSettings);
 }
 
 inline bool Settings::isLocalChannelsCollapsed() const
@@ -719,6 +746,7 @@ inline bool Settings::isRememberingPan() const
 inline void Settings::setLooperBitDepth(quint8 bitDepth)
 {
     looperSettings.waveFilesBitDepth = bitDepth;
+    setChanged(looperSettings);
 }
 
 inline quint8 Settings::getLooperBitDepth() const
@@ -726,6 +754,11 @@ inline quint8 Settings::getLooperBitDepth() const
     return looperSettings.waveFilesBitDepth;
 }
 
+inline quint32 Settings::getLooperMemoryBudget() const
+{
+    return looperSettings.memoryBudget;
+}
+
 inline QString Settings::getLooperFolder() const
 {
     return looperSettings.loopsFolder;
@@ -734,6 +767,7 @@ inline QString Settings::getLooperFolder() const
 inline void Settings::setLooperFolder(const QString &folder)
 {
     looperSettings.loopsFolder = folder;
+    setChanged(looperSettings);
 }
 
 inline bool Settings::getLooperAudioEncodingFlag() const
@@ -774,16 +808,19 @@ inline quint8 Settings::getMeterRefreshRate() const
 inline void Settings::storeMeterOption(quint8 meterOption)
 {
     meteringSettings.meterOption = meterOption;
+    setChanged(meteringSettings);
 }
 
 inline void Settings::storeMeterShowingMaxPeaks(bool showingMaxPeaks)
 {
     meteringSettings.showingMaxPeakMarkers = showingMaxPeaks;
+    setChanged(meteringSettings);
 }
 
 inline void Settings::storeMeterRefreshRate(quint8 newRate)
 {
     meteringSettings.refreshRate = newRate;
+    setChanged(meteringSettings);
 }
 
 inline int Settings::getFirstGlobalAudioInput() const
@@ -819,6 +856,7 @@ inline QString Settings::getLastAudioOutputDevice() const
 inline void Settings::setMidiSettings(const QList<bool> &inputDevicesStatus)
 {
     midiSettings.inputDevicesStatus = inputDevicesStatus;
+    setChanged(midiSettings);
 }
 
 inline QList<bool> Settings::getMidiInputDevicesStatus() const
@@ -886,6 +924,7 @@ inline bool Settings::isSaveMultiTrackActivated() const
 inline void Settings::setSaveMultiTrack(bool saveMultiTracks)
 {
     recordingSettings.saveMultiTracksActivated = saveMultiTracks;
+    setChanged(recordingSettings);
 }
 
 inline bool Settings::isJamRecorderActivated(const QString &key) const
@@ -896,6 +935,7 @@ inline bool Settings::isJamRecorderActivated(const QString &key) const
 inline void Settings::setJamRecorderActivated(const QString &key, bool value)
 {
     recordingSettings.setJamRecorderActivated(key, value);
+    setChanged(recordingSettings);
 }
 
 inline QString Settings::getRecordingPath() const
@@ -906,6 +946,7 @@ inline QString Settings::getRecordingPath() const
 inline void Settings::setMultiTrackRecordingPath(const QString &newPath)
 {
     recordingSettings.recordingPath = newPath;
+    setChanged(recordingSettings);
 }
 
 inline QString Settings::getDirNameDateFormat() const
@@ -916,6 +957,18 @@ inline QString Settings::getDirNameDateFormat() const
 inline void Settings::setDirNameDateFormat(const QString &newDateFormat)
 {
     recordingSettings.dirNameDateFormat = newDateFormat;
+    setChanged(recordingSettings);
+}
+
+inline bool Settings::isRecordingContinuousTrackFiles() const
+{
+    return recordingSettings.continuousTrackFiles;
+}
+
+inline void Settings::setRecordingContinuousTrackFiles(bool continuousTrackFiles)
+{
+    recordingSettings.continuousTrackFiles = continuousTrackFiles;
+    setChanged(recordingSettings);
 }
 
 
@@ -1019,6 +1072,7 @@ inline QString Settings::getMetronomeFirstBeatFile() const
 inline void Settings::storeWaveDrawingMode(quint8 mode)
 {
     meteringSettings.waveDrawingMode = mode;
+    setChanged(meteringSettings);
 }
 
 inline quint8 Settings::getLastWaveDrawingMode() const
@@ -1034,6 +1088,7 @@ inline float Settings::getEncodingQuality() const
 inline void Settings::setEncodingQuality(float quality)
 {
     audioSettings.encodingQuality = quality;
+    setChanged(audioSettings);
 }
 
 } // namespace
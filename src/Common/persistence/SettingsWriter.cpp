@@ -0,0 +1,81 @@
+#include "SettingsWriter.h"
+#include "log/Logging.h"
+
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
+
+using persistence::SettingsWriter;
+
+SettingsWriter::SettingsWriter()
+{
+    threadPool.setMaxThreadCount(1);
+}
+
+SettingsWriter::~SettingsWriter()
+{
+    waitForWrites();
+}
+
+void SettingsWriter::write(const QString &filePath, const QJsonObject &json)
+{
+    QMutexLocker locker(&mutex);
+
+    bool alreadyScheduled = pendingFiles.contains(filePath);
+
+    pendingFiles.insert(filePath, json); // QJsonObject is implicitly shared, the copy is cheap
+
+    if (!alreadyScheduled)
+        QtConcurrent::run(&threadPool, [this, filePath]() {
+            writePendingFile(filePath);
+        });
+}
+
+void SettingsWriter::waitForWrites()
+{
+    threadPool.waitForDone();
+}
+
+void SettingsWriter::writePendingFile(const QString &filePath)
+{
+    QJsonObject json;
+    {
+        QMutexLocker locker(&mutex);
+        json = pendingFiles.take(filePath);
+    }
+
+    const bool written = writeFile(filePath, json);
+
+    QMutexLocker locker(&mutex);
+    if (written)
+        failedFiles.remove(filePath);
+    else
+        failedFiles.insert(filePath);
+}
+
+bool SettingsWriter::takeWriteFailure(const QString &filePath)
+{
+    QMutexLocker locker(&mutex);
+    return failedFiles.remove(filePath);
+}
+
+bool SettingsWriter::writeFile(const QString &filePath, const QJsonObject &json)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical(jtSettings) << "Can't write" << filePath << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(json).toJson());
+
+    if (!file.commit()) { // the old file is replaced only if all content was written
+        qCritical(jtSettings) << "Can't write" << filePath << file.errorString();
+        return false;
+    }
+
+    qCDebug(jtSettings) << "File written:" << filePath;
+
+    return true;
+}
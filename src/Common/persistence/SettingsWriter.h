@@ -0,0 +1,45 @@
+#ifndef SETTINGS_WRITER_H
+#define SETTINGS_WRITER_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+
+namespace persistence {
+
+/**
+    Write the config and preset JSON files in a background thread. The files are replaced atomically
+    (QSaveFile writes a temporary file and renames it), so a crash while writing doesn't corrupt the
+    previous file. Writes to the same file are coalesced while the background thread is busy, only
+    the last content is written.
+ */
+
+class SettingsWriter
+{
+public:
+    SettingsWriter();
+    ~SettingsWriter(); // the pending files are written before return
+
+    void write(const QString &filePath, const QJsonObject &json);
+    void waitForWrites();
+
+    bool takeWriteFailure(const QString &filePath); // true if the last background write of filePath failed, the failure is cleared
+
+    static bool writeFile(const QString &filePath, const QJsonObject &json); // synchronous
+
+private:
+    QMutex mutex;
+    QHash<QString, QJsonObject> pendingFiles; // the last content by file path
+    QSet<QString> failedFiles; // the last write of these files failed, the previous content was preserved
+
+    QThreadPool threadPool; // using one thread, the files are written in the same order of write() calls
+
+    void writePendingFile(const QString &filePath);
+};
+
+} // namespace
+
+#endif
@@ -1,10 +1,12 @@
 #include "ClipSortLogGenerator.h"
+#include "RecordingWriter.h"
 #include <QUuid>
 #include "../log/Logging.h"
 
 using recorder::ClipSortLogGenerator;
 using recorder::JamInterval;
 using recorder::Jam;
+using recorder::RecordingWriter;
 
 void ClipSortLogGenerator::write(const Jam &jam)
 {
@@ -35,15 +37,9 @@ void ClipSortLogGenerator::write(const Jam &jam)
             .append("\n");
     }
 
-    // save
+    // save in the recording writer thread, after the recorded intervals
     QDir jamDir = QDir(this->clipsortPath);
-    QFile projectFile(jamDir.absoluteFilePath("clipsort.log"));
-    if (!projectFile.open(QFile::WriteOnly)) {
-        qCritical() << "Can't write clipsort.log in " << jamDir;
-    }
-    QTextStream stream(&projectFile);
-    QByteArray byteArray(stringBuffer.toUtf8());
-    stream << byteArray;
+    RecordingWriter::getInstance()->writeMetadata(jamDir.absoluteFilePath("clipsort.log"), stringBuffer.toUtf8(), RecordingWriter::Replace);
 }
 
 void ClipSortLogGenerator::setJamDir(const QString &newJamName, const QString &recordBasePath)
@@ -72,3 +68,15 @@ QString ClipSortLogGenerator::getVideoAbsolutePath(const QString &videoFileName)
 
     return QString();
 }
+
+QString ClipSortLogGenerator::getJournalAbsolutePath()
+{
+    return QDir(this->clipsortPath).absoluteFilePath("jam.journal");
+}
+
+QString ClipSortLogGenerator::getTrackAbsolutePath(const QString &trackFileName)
+{
+    Q_UNUSED(trackFileName);
+
+    return QString(); // clipsort.log references one file per interval
+}
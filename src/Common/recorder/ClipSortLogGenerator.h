@@ -26,6 +26,8 @@ public:
 
     QString getAudioAbsolutePath(const QString &audioFileName) override;
     QString getVideoAbsolutePath(const QString &videoFileName) override;
+    QString getJournalAbsolutePath() override;
+    QString getTrackAbsolutePath(const QString &trackFileName) override;
 
 private:
     QString clipsortPath;
@@ -1,7 +1,12 @@
 #include "JamRecorder.h"
+#include "RecordingWriter.h"
 #include <QDateTime>
+#include <QFile>
+#include <QRegExp>
 #include <QDebug>
-#include <QtConcurrent/QtConcurrent>
+#include <QtEndian>
+
+#include <cstring>
 #include "../log/Logging.h"
 
 using namespace recorder;
@@ -10,17 +15,96 @@ const quint8 JamRecorder::VIDEO_CHANNEL_KEY = 255;
 
 JamAudioFile::JamAudioFile(const QString &path, uint intervalIndex) :
     path(path),
-    intervalIndex(intervalIndex)
+    intervalIndex(intervalIndex),
+    byteOffset(0),
+    byteSize(0),
+    startSample(0),
+    samples(0)
+{
+    //
+}
+
+JamAudioFile::JamAudioFile(const QString &trackFilePath, uint intervalIndex, qint64 byteOffset, qint64 byteSize, qint64 startSample, qint64 samples) :
+    path(trackFilePath),
+    intervalIndex(intervalIndex),
+    byteOffset(byteOffset),
+    byteSize(byteSize),
+    startSample(startSample),
+    samples(samples)
 {
     //
 }
 
 JamAudioFile::JamAudioFile() : // default construtor to use this class in QMap and QList without pointers
+    path(""),
+    intervalIndex(0),
+    byteOffset(0),
+    byteSize(0),
+    startSample(0),
+    samples(0)
+{
+    //
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+OggStreamInfo::OggStreamInfo(const QByteArray &oggStream) :
+    sampleRate(0),
+    samples(-1)
+{
+    // See the Ogg pages in https://xiph.org/ogg/doc/framing.html and the Vorbis identification header in https://xiph.org/vorbis/doc/Vorbis_I_spec.html
+
+    static const int PAGE_HEADER_SIZE = 27;
+
+    const uchar *data = reinterpret_cast<const uchar *>(oggStream.constData());
+    const qint64 size = oggStream.size();
+
+    qint64 pageOffset = 0;
+    while (pageOffset + PAGE_HEADER_SIZE <= size) {
+        if (std::memcmp(data + pageOffset, "OggS", 4) != 0)
+            break; // corrupted stream
+
+        const int segments = data[pageOffset + 26];
+        const qint64 payloadOffset = pageOffset + PAGE_HEADER_SIZE + segments;
+        if (payloadOffset > size)
+            break;
+
+        qint64 payloadSize = 0;
+        for (int s = 0; s < segments; ++s)
+            payloadSize += data[pageOffset + PAGE_HEADER_SIZE + s];
+
+        if (payloadOffset + payloadSize > size)
+            break; // truncated page
+
+        if (pageOffset == 0 && payloadSize >= 16 && std::memcmp(data + payloadOffset, "\x01vorbis", 7) == 0)
+            sampleRate = qFromLittleEndian<quint32>(data + payloadOffset + 12);
+
+        const qint64 granulePosition = qFromLittleEndian<qint64>(data + pageOffset + 6);
+        if (granulePosition >= 0) // -1 in pages without a finished packet
+            samples = granulePosition;
+
+        pageOffset = payloadOffset + payloadSize;
+    }
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+JamVideoFile::JamVideoFile(const QString &userName, const QString &path, uint intervalIndex) :
+    userName(userName),
+    path(path),
+    intervalIndex(intervalIndex)
+{
+    //
+}
+
+JamVideoFile::JamVideoFile() : // default construtor to use this class in QMap and QList without pointers
+    userName(""),
     path(""),
     intervalIndex(0)
 {
     //
 }
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
 JamTrack::JamTrack(const QString &userName, quint8 channelIndex) :
@@ -37,18 +121,18 @@ JamTrack::JamTrack() : // default construtor to use this class in QMap and QList
 
 }
 
-void JamTrack::addAudioFile(const QString &path, int intervalIndex)
+void JamTrack::addAudioFile(const JamAudioFile &audioFile)
 {
-    audioFiles.append( JamAudioFile(path, intervalIndex));
+    audioFiles.append(audioFile);
 }
 
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-JamInterval::JamInterval(const int intervalIndex, const int bpm, const int bpi, const QString &path, const QString &userName, const quint8 channelIndex) :
+JamInterval::JamInterval(const int intervalIndex, const int bpm, const int bpi, const JamAudioFile &audioFile, const QString &userName, const quint8 channelIndex) :
     intervalIndex(intervalIndex),
     bpm(bpm),
     bpi(bpi),
-    path(path),
+    audioFile(audioFile),
     userName(userName),
     channelIndex(channelIndex)
 {
@@ -59,7 +143,6 @@ JamInterval::JamInterval() :
     intervalIndex(0),
     bpm(-1),
     bpi(-1),
-    path(""),
     userName(""),
     channelIndex(0)
 {
@@ -97,8 +180,9 @@ QList<JamInterval> Jam::getJamIntervals() const
 }
 
 // called when a new file is writed in disk
-void Jam::addAudioFile(const QString &userName, quint8 channelIndex, const QString &filePath, int intervalIndex)
+void Jam::addAudioFile(const QString &userName, quint8 channelIndex, const JamAudioFile &audioFile)
 {
+    const int intervalIndex = audioFile.getIntervalIndex();
 
     if (!jamTracks.contains(userName)) {
         jamTracks.insert(userName, QMap<quint8, JamTrack>());
@@ -108,13 +192,146 @@ void Jam::addAudioFile(const QString &userName, quint8 channelIndex, const QStri
         jamTracks[userName].insert(channelIndex, JamTrack(userName, channelIndex));
     }
 
-    jamTracks[userName][channelIndex].addAudioFile(filePath, intervalIndex);
+    jamTracks[userName][channelIndex].addAudioFile(audioFile);
 
     if (!jamIntervals.contains(intervalIndex)) {
         jamIntervals.insert(intervalIndex, QList<JamInterval>());
     }
 
-    jamIntervals[intervalIndex].insert(intervalIndex, JamInterval(intervalIndex, getBpm(), getBpi(), filePath, userName, channelIndex));
+    jamIntervals[intervalIndex].append(JamInterval(intervalIndex, getBpm(), getBpi(), audioFile, userName, channelIndex));
+}
+
+void Jam::addVideoFile(const JamVideoFile &videoFile)
+{
+    videoFiles.append(videoFile);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+JamJournal::JamJournal()
+{
+    //
+}
+
+JamJournal::~JamJournal()
+{
+    close();
+}
+
+void JamJournal::open(const QString &filePath, int bpm, int bpi, int sampleRate)
+{
+    close();
+
+    this->filePath = filePath;
+
+    QByteArray header("jam " + QByteArray::number(bpm) + " " + QByteArray::number(bpi) + " " + QByteArray::number(sampleRate) + "\n");
+    RecordingWriter::getInstance()->writeMetadata(filePath, header, RecordingWriter::Overwrite);
+}
+
+void JamJournal::close()
+{
+    if (!isOpen())
+        return;
+
+    flush();
+
+    filePath.clear();
+}
+
+void JamJournal::appendAudioFile(const QString &userName, quint8 channelIndex, const JamAudioFile &audioFile)
+{
+    if (!isOpen())
+        return;
+
+    // file <interval index> <channel index> "<user name>" "<file path>" [<byte offset> <byte size> <start sample> <samples>]
+    QString entry = "file " + QString::number(audioFile.getIntervalIndex()) + " " + QString::number(channelIndex)
+            + " \"" + QString(userName).replace("\"", "_") + "\""
+            + " \"" + audioFile.getPath() + "\"";
+
+    if (audioFile.isInTrackFile())
+        entry += " " + QString::number(audioFile.getByteOffset()) + " " + QString::number(audioFile.getByteSize())
+                + " " + QString::number(audioFile.getStartSample()) + " " + QString::number(audioFile.getSamples());
+
+    entry += "\n";
+
+    pendingEntries.append(entry.toUtf8());
+}
+
+void JamJournal::appendVideoFile(const JamVideoFile &videoFile)
+{
+    if (!isOpen())
+        return;
+
+    // video <interval index> "<user name>" "<file path>"
+    QString entry = "video " + QString::number(videoFile.getIntervalIndex())
+            + " \"" + QString(videoFile.getUserName()).replace("\"", "_") + "\""
+            + " \"" + videoFile.getPath() + "\"\n";
+
+    pendingEntries.append(entry.toUtf8());
+}
+
+void JamJournal::flush()
+{
+    if (!isOpen() || pendingEntries.isEmpty())
+        return;
+
+    RecordingWriter::getInstance()->writeMetadata(filePath, pendingEntries, RecordingWriter::Append); // ordered after the journal header
+    pendingEntries.clear();
+}
+
+std::unique_ptr<Jam> JamJournal::load(const QString &filePath)
+{
+    QFile journalFile(filePath);
+    if (!journalFile.open(QFile::ReadOnly)) {
+        qCritical() << "Can't open the jam journal " << filePath;
+        return nullptr;
+    }
+
+    std::unique_ptr<Jam> jam;
+
+    static const QRegExp jamPattern("^jam (\\d+) (\\d+) (\\d+)$");
+    static const QRegExp filePattern("^file (\\d+) (\\d+) \"([^\"]*)\" \"(.*)\"( (\\d+) (\\d+) (\\d+) (\\d+))?$");
+
+    static const QRegExp videoPattern("^video (\\d+) \"([^\"]*)\" \"(.*)\"$");
+
+    QRegExp jamRegExp(jamPattern);
+    QRegExp fileRegExp(filePattern);
+    QRegExp videoRegExp(videoPattern);
+    while (!journalFile.atEnd()) {
+        QString line = QString::fromUtf8(journalFile.readLine()).trimmed();
+        if (!jam) {
+            if (jamRegExp.exactMatch(line))
+                jam.reset(new Jam(jamRegExp.cap(1).toInt(), jamRegExp.cap(2).toInt(), jamRegExp.cap(3).toInt()));
+
+            continue;
+        }
+
+        if (videoRegExp.exactMatch(line)) {
+            jam->addVideoFile(JamVideoFile(videoRegExp.cap(2), videoRegExp.cap(3), videoRegExp.cap(1).toUInt()));
+            continue;
+        }
+
+        if (!fileRegExp.exactMatch(line))
+            continue; // a partially written entry (crash while recording)
+
+        int intervalIndex = fileRegExp.cap(1).toInt();
+        quint8 channelIndex = fileRegExp.cap(2).toUInt();
+        QString userName = fileRegExp.cap(3);
+        QString path = fileRegExp.cap(4);
+
+        if (!fileRegExp.cap(5).isEmpty()) {
+            qint64 byteOffset = fileRegExp.cap(6).toLongLong();
+            qint64 byteSize = fileRegExp.cap(7).toLongLong();
+            qint64 startSample = fileRegExp.cap(8).toLongLong();
+            qint64 samples = fileRegExp.cap(9).toLongLong();
+            jam->addAudioFile(userName, channelIndex, JamAudioFile(path, intervalIndex, byteOffset, byteSize, startSample, samples));
+        }
+        else {
+            jam->addAudioFile(userName, channelIndex, JamAudioFile(path, intervalIndex));
+        }
+    }
+
+    return jam;
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -127,19 +344,14 @@ QString JamRecorder::getNewJamName()
     return "Jam-" + nowString;
 }
 
-void JamRecorder::writeEncodedFile(const QByteArray& encodedData, const QString &path)
+QString JamRecorder::buildVideoFileName(const QString &userName, int currentInterval, const QString &fileExtension)
 {
-    QFile audioFile(path);
-    if (!audioFile.open(QFile::WriteOnly)) {
-        qCritical() << "can't open file " << path;
-        return;
-    }
-    audioFile.write(encodedData.data(), encodedData.size());
+    return userName + "_video_" + QString::number(currentInterval) + "." + fileExtension;
 }
 
-QString JamRecorder::buildVideoFileName(const QString &userName, int currentInterval, const QString &fileExtension)
+QString JamRecorder::buildTrackFileName(const QString &userName, quint8 channelIndex)
 {
-    return userName + "_video_" + QString::number(currentInterval) + "." + fileExtension;
+    return userName + " (Channel " + QString::number(channelIndex + 1) + ").ogg";
 }
 
 QString JamRecorder::buildAudioFileName(const QString &userName, quint8 channelIndex, int currentInterval)
@@ -152,7 +364,9 @@ JamRecorder::JamRecorder(JamMetadataWriter* jamMetadataWritter) :
     jam(nullptr),
     jamMetadataWritter(jamMetadataWritter),
     globalIntervalIndex(0),
-    running(false)
+    running(false),
+    dirNameDateFormat(Qt::TextDate),
+    continuousTrackFiles(false)
 {
     //this->recordingActivated = true;//just to test
     qCDebug(jtJamRecorder) << "Creating JamRecorder!";
@@ -160,6 +374,8 @@ JamRecorder::JamRecorder(JamMetadataWriter* jamMetadataWritter) :
 
 JamRecorder::~JamRecorder()
 {
+    stopRecording(); // the project file is materialized when the recording is stopped
+
     qCDebug(jtJamRecorder) << "Deleting JamRecorder!";
 }
 
@@ -178,11 +394,7 @@ void JamRecorder::appendLocalUserAudio(const QByteArray &encodedAudio, quint8 ch
 
     bool needSave = isFirstPartOfInterval && !interval.isEmpty();
     if (needSave) {
-        QString audioFileName = buildAudioFileName(localUserName, channelIndex, interval.getIntervalIndex());
-        QString audioFilePath = jamMetadataWritter->getAudioAbsolutePath(audioFileName);
-        QByteArray encodedData(interval.getEncodedData());
-        QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedData, audioFilePath);
-        jam->addAudioFile(localUserName, channelIndex, audioFilePath, interval.getIntervalIndex());
+        writeAudioInterval(localUserName, channelIndex, interval.getEncodedData(), interval.getIntervalIndex());
         interval.clear();
     }
 
@@ -210,8 +422,13 @@ void JamRecorder::appendLocalUserVideo(const QByteArray &encodedVideo, bool isFi
         QString videoFileName = buildVideoFileName(localUserName, videoInterval.getIntervalIndex(), "mp4");
         QString videoFilePath = jamMetadataWritter->getVideoAbsolutePath(videoFileName);
 
-        if (!videoFilePath.isEmpty()) // some recorders (like ClipSort) can't save videos
-            QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedData, videoFilePath);
+        if (!videoFilePath.isEmpty()) { // some recorders (like ClipSort) can't save videos
+            if (RecordingWriter::getInstance()->write(videoFilePath, encodedData)) { // dropped videos are not journaled
+                JamVideoFile videoFile(localUserName, videoFilePath, videoInterval.getIntervalIndex());
+                jam->addVideoFile(videoFile);
+                journal.appendVideoFile(videoFile);
+            }
+        }
 
         videoInterval.clear();
     }
@@ -226,11 +443,62 @@ void JamRecorder::addRemoteUserAudio(const QString &userName, const QByteArray &
         return;
     }
 
-    int intervalIndex = globalIntervalIndex;
+    writeAudioInterval(userName, channelIndex, encodedAudio, globalIntervalIndex);
+}
+
+void JamRecorder::writeAudioInterval(const QString &userName, quint8 channelIndex, const QByteArray &encodedData, int intervalIndex)
+{
+    auto writer = RecordingWriter::getInstance();
+
+    if (continuousTrackFiles) {
+        QString trackFilePath = jamMetadataWritter->getTrackAbsolutePath(buildTrackFileName(userName, channelIndex));
+        if (!trackFilePath.isEmpty()) { // some recorders (like ClipSort) need one file per interval
+            TrackFile &trackFile = trackFiles[trackFilePath];
+            const qint64 byteOffset = trackFile.size;
+            const RecordingWriter::WriteMode writeMode = byteOffset > 0 ? RecordingWriter::Append : RecordingWriter::Overwrite;
+
+            // each NINJAM interval is a complete Ogg stream, appending the streams produce a chained Ogg file
+            if (!writer->write(trackFilePath, encodedData, writeMode))
+                return; // dropped (the disk is too slow), the offsets of the next intervals are not changed
+
+            const qint64 startSample = trackFile.samples;
+            const qint64 samples = getStreamSamples(encodedData);
+
+            // offset table: <interval index> <byte offset> <byte size> <start sample> <samples>
+            QByteArray offsetEntry = QByteArray::number(intervalIndex) + " " + QByteArray::number(byteOffset) + " " + QByteArray::number(encodedData.size())
+                    + " " + QByteArray::number(startSample) + " " + QByteArray::number(samples) + "\n";
+            writer->writeMetadata(trackFilePath + ".index", offsetEntry, writeMode);
+
+            addAudioFile(userName, channelIndex, JamAudioFile(trackFilePath, intervalIndex, byteOffset, encodedData.size(), startSample, samples));
+
+            trackFile.size += encodedData.size();
+            trackFile.samples += samples;
+            return;
+        }
+    }
+
     QString audioFileName = buildAudioFileName(userName, channelIndex, intervalIndex);
     QString audioFilePath = jamMetadataWritter->getAudioAbsolutePath(audioFileName);
-    QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedAudio, audioFilePath);
-    jam->addAudioFile(userName, channelIndex, audioFilePath, intervalIndex);
+    if (writer->write(audioFilePath, encodedData)) // dropped intervals are not journaled
+        addAudioFile(userName, channelIndex, JamAudioFile(audioFilePath, intervalIndex));
+}
+
+qint64 JamRecorder::getStreamSamples(const QByteArray &encodedData) const
+{
+    OggStreamInfo streamInfo(encodedData);
+    if (!streamInfo.isValid()) {
+        qCWarning(jtJamRecorder) << "Invalid Ogg stream, assuming a complete interval";
+        return static_cast<qint64>(jam->getSampleRate() * jam->getIntervalsLenght());
+    }
+
+    // the streams can be encoded in other sample rate (remote users, or the audio device changed while recording)
+    return streamInfo.getSamples() * jam->getSampleRate() / streamInfo.getSampleRate();
+}
+
+void JamRecorder::addAudioFile(const QString &userName, quint8 channelIndex, const JamAudioFile &audioFile)
+{
+    jam->addAudioFile(userName, channelIndex, audioFile);
+    journal.appendAudioFile(userName, channelIndex, audioFile);
 }
 
 void JamRecorder::startRecording(const QString &localUser, const QDir &recordBaseDir, int bpm, int bpi, int sampleRate)
@@ -243,6 +511,7 @@ void JamRecorder::startRecording(const QString &localUser, const QDir &recordBas
     this->jamMetadataWritter->setJamDir(getNewJamName(), recordBaseDir.absolutePath());
 
     jam.reset(new Jam(bpm, bpi, sampleRate));
+    journal.open(jamMetadataWritter->getJournalAbsolutePath(), bpm, bpi, sampleRate);
 
     running = true;
     qDebug(jtJamRecorder) << jamMetadataWritter->getWriterId() << "startRecording!";
@@ -283,6 +552,18 @@ void JamRecorder::setDirNameDateFormat(Qt::DateFormat newDateFormat)
     }
 }
 
+void JamRecorder::setContinuousTrackFiles(bool continuousTrackFiles)
+{
+    if (this->continuousTrackFiles == continuousTrackFiles)
+        return;
+
+    this->continuousTrackFiles = continuousTrackFiles;
+    if (running) {
+        stopRecording();
+        startRecording(localUserName, recordBaseDir, jam->getBpm(), jam->getBpi(), jam->getSampleRate() );
+    }
+}
+
 void JamRecorder::setSampleRate(int newSampleRate)
 {
     if (running) {
@@ -296,10 +577,14 @@ void JamRecorder::setSampleRate(int newSampleRate)
 void JamRecorder::stopRecording()
 {
     if (running) {
+        journal.close();
+        if (!trackFiles.isEmpty())
+            RecordingWriter::getInstance()->waitForPendingWrites(); // the project writers can read the intervals from the track files
         writeProjectFile();
         this->running = false;
         this->globalIntervalIndex = 0;
         this->localUserIntervals.clear();
+        this->trackFiles.clear();
     }
 }
 
@@ -316,7 +601,7 @@ void JamRecorder::newInterval()
 {
     if (running) {
         globalIntervalIndex++;
-        writeProjectFile();
+        journal.flush(); // only the new entries are written, the project file is materialized when the recording is stopped
     }
 
 }
@@ -14,6 +14,7 @@ class JamAudioFile
 
 public:
     JamAudioFile(const QString &path, uint intervalIndex);
+    JamAudioFile(const QString &trackFilePath, uint intervalIndex, qint64 byteOffset, qint64 byteSize, qint64 startSample, qint64 samples); // interval stored in a continuous track file
     JamAudioFile(); // default construtor to use this class in QMap and QList without pointers
 
     inline uint getIntervalIndex() const
@@ -26,9 +27,99 @@ public:
         return path;
     }
 
+    inline bool isInTrackFile() const
+    {
+        return byteSize > 0;
+    }
+
+    inline qint64 getStartSample() const // first sample of the interval in the track file, in the jam sample rate
+    {
+        return startSample;
+    }
+
+    inline qint64 getSamples() const // the stream lenght, in the jam sample rate
+    {
+        return samples;
+    }
+
+    inline qint64 getByteOffset() const
+    {
+        return byteOffset;
+    }
+
+    inline qint64 getByteSize() const
+    {
+        return byteSize;
+    }
+
 private:
     QString path;
     uint intervalIndex;
+    qint64 byteOffset;
+    qint64 byteSize;
+    qint64 startSample;
+    qint64 samples;
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+/**
+    Sample rate and lenght of an encoded Ogg Vorbis stream. Only the Ogg page headers are
+    parsed, the stream is not decoded.
+ */
+
+class OggStreamInfo
+{
+public:
+    explicit OggStreamInfo(const QByteArray &oggStream);
+
+    inline bool isValid() const
+    {
+        return sampleRate > 0 && samples >= 0;
+    }
+
+    inline int getSampleRate() const
+    {
+        return sampleRate;
+    }
+
+    inline qint64 getSamples() const
+    {
+        return samples;
+    }
+
+private:
+    int sampleRate;
+    qint64 samples; // the granule position of the last page
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+class JamVideoFile
+{
+public:
+    JamVideoFile(const QString &userName, const QString &path, uint intervalIndex);
+    JamVideoFile(); // default construtor to use this class in QMap and QList without pointers
+
+    inline QString getUserName() const
+    {
+        return userName;
+    }
+
+    inline QString getPath() const
+    {
+        return path;
+    }
+
+    inline uint getIntervalIndex() const
+    {
+        return intervalIndex;
+    }
+
+private:
+    QString userName;
+    QString path;
+    uint intervalIndex;
 };
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -39,7 +130,7 @@ public:
     JamTrack(const QString &userName, quint8 channelIndex);
     JamTrack(); // default construtor to use this class in QMap and QList without pointers
 
-    void addAudioFile(const QString &path, int intervalIndex);
+    void addAudioFile(const JamAudioFile &audioFile);
 
     inline QString getUserName() const
     {
@@ -68,7 +159,7 @@ class JamInterval
 {
 
 public:
-    JamInterval(const int intervalIndex, const int bpm, const int bpi, const QString &path, const QString &userName, const quint8 channelIndex);
+    JamInterval(const int intervalIndex, const int bpm, const int bpi, const JamAudioFile &audioFile, const QString &userName, const quint8 channelIndex);
     JamInterval();
 
     inline int getIntervalIndex() const
@@ -88,7 +179,12 @@ public:
 
     inline QString getPath() const
     {
-        return path;
+        return audioFile.getPath();
+    }
+
+    inline JamAudioFile getAudioFile() const
+    {
+        return audioFile;
     }
 
     inline QString getUserName() const
@@ -105,7 +201,7 @@ private:
     int intervalIndex;
     int bpm;
     int bpi;
-    QString path;
+    JamAudioFile audioFile;
     QString userName;
     quint8 channelIndex;
 };
@@ -139,11 +235,19 @@ public:
     }
 
     // called when a new file is writed in disk
-    void addAudioFile(const QString &userName, const quint8 channelIndex, const QString &filePath, const int intervalIndex);
+    void addAudioFile(const QString &userName, const quint8 channelIndex, const JamAudioFile &audioFile);
 
     QList<JamTrack> getJamTracks() const;
 
     QList<JamInterval> getJamIntervals() const;
+
+    void addVideoFile(const JamVideoFile &videoFile);
+
+    inline QList<JamVideoFile> getVideoFiles() const
+    {
+        return videoFiles;
+    }
+
 private:
     int bpm;
     int bpi;
@@ -154,6 +258,8 @@ private:
 
     // the map key is intervalIndex.
     QMap<int, QList<JamInterval> > jamIntervals;
+
+    QList<JamVideoFile> videoFiles;
 };
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -161,7 +267,7 @@ private:
 class JamMetadataWriter
 {
 public:
-    virtual void write(const Jam &metadata) = 0;
+    virtual void write(const Jam &metadata) = 0; // materialize the entire project file (written in the RecordingWriter thread), called when the recording is stopped or on demand
     virtual ~JamMetadataWriter(){}
 
     virtual QString getWriterId() const = 0;
@@ -172,6 +278,46 @@ public:
     virtual QString getAudioAbsolutePath(const QString &audioFileName) = 0;
 
     virtual QString getVideoAbsolutePath(const QString &videoFileName) = 0;
+
+    virtual QString getJournalAbsolutePath() = 0;
+
+    // path to a file storing all intervals of a track (a chained Ogg). Empty if the writer can't reference intervals inside a file
+    virtual QString getTrackAbsolutePath(const QString &trackFileName) = 0;
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+/**
+    Append-only log of the recorded files. The project files are materialized only when the recording
+    is stopped (or on demand), the journal keeps the jam metadata in disk in each interval (in a crash
+    the project can be rebuilt from the journal, see load()). New entries are buffered and flushed in
+    each interval by the RecordingWriter thread, the cost of each interval doesn't depend on the jam lenght.
+ */
+
+class JamJournal
+{
+public:
+    JamJournal();
+    ~JamJournal();
+
+    void open(const QString &filePath, int bpm, int bpi, int sampleRate);
+    void close(); // flush pending entries
+
+    void appendAudioFile(const QString &userName, quint8 channelIndex, const JamAudioFile &audioFile);
+    void appendVideoFile(const JamVideoFile &videoFile);
+
+    void flush(); // write pending entries in the recording writer thread
+
+    static std::unique_ptr<Jam> load(const QString &filePath); // rebuild the jam metadata from a journal file, used by offline tools
+
+    inline bool isOpen() const
+    {
+        return !filePath.isEmpty();
+    }
+
+private:
+    QString filePath;
+    QByteArray pendingEntries;
 };
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -241,21 +387,43 @@ public:
     void stopRecording();
     void newInterval();
 
+    void writeProjectFile(); // materialize the project file on demand, the recording is not stopped
+
     inline QString getWriterId() const { return jamMetadataWritter->getWriterId(); }
     inline QString getWriterName() const { return jamMetadataWritter->getWriterName(); }
 
     void setDirNameDateFormat(Qt::DateFormat newDateFormat);
 
+    void setContinuousTrackFiles(bool continuousTrackFiles);
+
 private:
     QString currentJamName;
     std::unique_ptr<Jam> jam;
     std::unique_ptr<JamMetadataWriter> jamMetadataWritter;
+    JamJournal journal;
     int globalIntervalIndex;
     QString localUserName;
     bool running;
     QDir recordBaseDir;
     Qt::DateFormat dirNameDateFormat;
 
+    /**
+        Continuous track files: the intervals of each user channel are appended in one chained Ogg file
+        instead of one file per interval. The byte offset and the first sample of each interval are stored
+        in an offset table file (the track file path + ".index") and in the jam metadata. The streams can
+        be shorter than the interval (the first interval after joining the server, for example), so the
+        first sample is accumulated from the real stream lenghts.
+     */
+    bool continuousTrackFiles;
+
+    struct TrackFile
+    {
+        qint64 size; // bytes enqueued to write
+        qint64 samples; // in the jam sample rate
+    };
+
+    QMap<QString, TrackFile> trackFiles; // track file path as key
+
     /**
         Audio Intervals: Using channel index as key and store encoded bytes. When a full interval is stored the encoded bytes are store in a ogg file.
         Video Intervals: Using 255 as default channel index.
@@ -265,12 +433,16 @@ private:
 
     QString getNewJamName();
 
-    void writeEncodedFile(const QByteArray &encodedData, const QString &path);
-
     static QString buildAudioFileName(const QString &userName, quint8 channelIndex, int currentInterval);
     static QString buildVideoFileName(const QString &userName, int currentInterval, const QString &fileExtension);
 
-    void writeProjectFile();
+    static QString buildTrackFileName(const QString &userName, quint8 channelIndex);
+
+    void writeAudioInterval(const QString &userName, quint8 channelIndex, const QByteArray &encodedData, int intervalIndex);
+
+    void addAudioFile(const QString &userName, quint8 channelIndex, const JamAudioFile &audioFile);
+
+    qint64 getStreamSamples(const QByteArray &encodedData) const;
 
 };
 
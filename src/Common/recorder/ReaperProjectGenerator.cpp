@@ -1,4 +1,5 @@
 #include "ReaperProjectGenerator.h"
+#include "RecordingWriter.h"
 #include <QUuid>
 #include "../log/Logging.h"
 
@@ -6,6 +7,8 @@ using recorder::ReaperProjectGenerator;
 using recorder::Jam;
 using recorder::JamTrack;
 using recorder::JamAudioFile;
+using recorder::JamVideoFile;
+using recorder::RecordingWriter;
 
 void ReaperProjectGenerator::write(const Jam &jam)
 {
@@ -30,10 +33,20 @@ void ReaperProjectGenerator::write(const Jam &jam)
 
         for (JamAudioFile audioFile : channelAudioFiles) {
             double position = (audioFile.getIntervalIndex()-1) * jam.getIntervalsLenght();
+            double lenght = jam.getIntervalsLenght();
+            double sourceOffset = 0.0;
+            if (audioFile.isInTrackFile()) {
+                // the interval is a stream inside a chained Ogg, the stream can be shorter than the interval (the first interval after joining, for example)
+                const double sampleRate = jam.getSampleRate();
+                lenght = qMin(lenght, audioFile.getSamples() / sampleRate);
+                sourceOffset = audioFile.getStartSample() / sampleRate;
+            }
             QString filePath = audioFile.getPath();
             stringBuffer.append("    <ITEM").append("\n");
             stringBuffer.append("      POSITION " + QString::number(position)).append("\n");
-            stringBuffer.append("      LENGTH " + QString::number(jam.getIntervalsLenght())).append("\n");
+            stringBuffer.append("      LENGTH " + QString::number(lenght)).append("\n");
+            if (audioFile.isInTrackFile())
+                stringBuffer.append("      SOFFS " + QString::number(sourceOffset, 'f', 6)) // sample precision in long jams.append("\n");
             stringBuffer.append("      FADEIN 1 0.01 0 1 0 0").append("\n");
             stringBuffer.append("      FADEOUT 1 0.01 0 1 0 0").append("\n");
             stringBuffer.append("      IID " + QString::number(part)).append("\n");
@@ -49,18 +62,37 @@ void ReaperProjectGenerator::write(const Jam &jam)
         stringBuffer.append("  >").append("\n"); // close track
     }
 
+    // video track
+    QList<JamVideoFile> videoFiles = jam.getVideoFiles();
+    if (!videoFiles.isEmpty()) {
+        QString trackGUID = QUuid::createUuid().toString();
+        stringBuffer.append("  <TRACK "+ trackGUID).append("\n");
+        stringBuffer.append("    NAME \"" + videoFiles.first().getUserName() + " (Video)\"").append("\n");
+        stringBuffer.append("    TRACKID " + trackGUID).append("\n");
+        int part = 1;
+        for (const JamVideoFile &videoFile : videoFiles) {
+            double position = (videoFile.getIntervalIndex()-1) * jam.getIntervalsLenght();
+            stringBuffer.append("    <ITEM").append("\n");
+            stringBuffer.append("      POSITION " + QString::number(position)).append("\n");
+            stringBuffer.append("      LENGTH " + QString::number(jam.getIntervalsLenght())).append("\n");
+            stringBuffer.append("      IID " + QString::number(part)).append("\n");
+            stringBuffer.append("      IGUID "+ QUuid::createUuid().toString()).append("\n");
+            stringBuffer.append("      NAME \"" + QFileInfo(videoFile.getPath()).baseName() + "\"").append("\n");
+            stringBuffer.append("      GUID "+ trackGUID).append("\n");
+            stringBuffer.append("      <SOURCE VIDEO").append("\n");
+            stringBuffer.append("        FILE \"" + videoFile.getPath() + "\"").append("\n");
+            stringBuffer.append("      >").append("\n");//close SOURCE VIDEO
+            stringBuffer.append("    >").append("\n");//close item
+            part++;
+        }
+        stringBuffer.append("  >").append("\n"); // close track
+    }
+
     stringBuffer.append(">"); // close the root tag
 
-    //save
+    // save in the recording writer thread, after the recorded intervals
     QDir jamDir = QDir(this->rppPath);
-    QFile projectFile(jamDir.absoluteFilePath("Reaper project.rpp"));
-    if (!projectFile.open(QFile::WriteOnly)) {
-        qCritical() << "Can't write the reaper project file in " << jamDir;
-    }
-    QTextStream stream(&projectFile);
-    QByteArray byteArray(stringBuffer.toUtf8());
-    stream << byteArray;
-    //projectFile.write(stringBuffer.toStdString().c_str(), stringBuffer.size());
+    RecordingWriter::getInstance()->writeMetadata(jamDir.absoluteFilePath("Reaper project.rpp"), stringBuffer.toUtf8(), RecordingWriter::Replace);
 }
 
 void ReaperProjectGenerator::setJamDir(const QString &newJamName, const QString &recordBasePath)
@@ -101,3 +133,13 @@ QString ReaperProjectGenerator::buildTrackName(const QString &userName, quint8 c
 {
     return userName + " (Channel " + QString::number(channelIndex+1) + ")";
 }
+
+QString ReaperProjectGenerator::getJournalAbsolutePath()
+{
+    return QDir(this->rppPath).absoluteFilePath("jam.journal");
+}
+
+QString ReaperProjectGenerator::getTrackAbsolutePath(const QString &trackFileName)
+{
+    return getAudioAbsolutePath(trackFileName);
+}
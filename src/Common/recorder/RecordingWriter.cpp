@@ -0,0 +1,229 @@
+#include "RecordingWriter.h"
+#include "../log/Logging.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QMutexLocker>
+
+#include <vector>
+
+using recorder::RecordingWriter;
+
+const qint64 RecordingWriter::MAX_QUEUED_BYTES = 32 * 1024 * 1024;
+
+RecordingWriter *RecordingWriter::getInstance()
+{
+    static RecordingWriter instance; // thread safe initialization in C++11
+    return &instance;
+}
+
+RecordingWriter::RecordingWriter() :
+    stopRequested(false),
+    writing(false),
+    queuedBytes(0),
+    queueDepth(0),
+    lastWriteLatency(0),
+    maxWriteLatency(0),
+    writtenBytes(0),
+    droppedWrites(0),
+    droppedBytes(0)
+{
+    clock.start();
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    stop();
+}
+
+bool RecordingWriter::write(const QString &filePath, const QByteArray &data, WriteMode mode)
+{
+    if (filePath.isEmpty())
+        return false;
+
+    QMutexLocker locker(&mutex);
+
+    // the main thread is not blocked waiting the disk, a request bigger than the limit is accepted when the queue is empty
+    if (queuedBytes > 0 && queuedBytes + data.size() > MAX_QUEUED_BYTES) {
+        droppedWrites++;
+        droppedBytes += data.size();
+        qCWarning(jtJamRecorder) << "Recording queue is full (" << queuedBytes << "bytes queued), dropping" << filePath
+                                 << "-" << droppedWrites << "writes dropped";
+        return false;
+    }
+
+    enqueue(filePath, data, mode);
+
+    return true;
+}
+
+void RecordingWriter::writeMetadata(const QString &filePath, const QByteArray &data, WriteMode mode)
+{
+    if (filePath.isEmpty())
+        return;
+
+    QMutexLocker locker(&mutex);
+
+    if (mode == Replace) { // only the last version is written when the disk is slow
+        for (auto request = requests.begin(); request != requests.end(); ++request) {
+            if (request->filePath == filePath && request->mode == Replace) {
+                queuedBytes -= request->data.size();
+                queueDepth--;
+                requests.erase(request); // the new version is written after the data enqueued in the meantime
+                break;
+            }
+        }
+    }
+
+    enqueue(filePath, data, mode);
+}
+
+void RecordingWriter::enqueue(const QString &filePath, const QByteArray &data, WriteMode mode)
+{
+    requests.push_back(WriteRequest{filePath, data, mode, clock.elapsed()});
+    queuedBytes += data.size();
+    queueDepth++;
+
+    if (!isRunning()) {
+        stopRequested = false;
+        start(QThread::LowPriority);
+    }
+
+    hasRequests.wakeAll(); // wakeup the writer thread (consumer thread)
+}
+
+void RecordingWriter::waitForPendingWrites()
+{
+    QMutexLocker locker(&mutex);
+    while ((!requests.empty() || writing) && isRunning())
+        batchWritten.wait(&mutex);
+}
+
+void RecordingWriter::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true;
+        hasRequests.wakeAll();
+    }
+
+    wait(); // the pending requests are written before the thread finish
+}
+
+RecordingWriter::Metrics RecordingWriter::getMetrics() const
+{
+    QMutexLocker locker(&mutex);
+
+    Metrics metrics;
+    metrics.queueDepth = queueDepth;
+    metrics.queuedBytes = queuedBytes;
+    metrics.lastWriteLatency = lastWriteLatency;
+    metrics.maxWriteLatency = maxWriteLatency;
+    metrics.writtenBytes = writtenBytes;
+    metrics.droppedWrites = droppedWrites;
+    metrics.droppedBytes = droppedBytes;
+
+    return metrics;
+}
+
+void RecordingWriter::run()
+{
+    std::deque<WriteRequest> batch;
+
+    forever {
+        {
+            QMutexLocker locker(&mutex);
+            while (requests.empty() && !stopRequested)
+                hasRequests.wait(&mutex);
+
+            if (requests.empty() && stopRequested)
+                break;
+
+            batch.swap(requests); // all pending requests are written in a single batch
+            writing = true;
+        }
+
+        qint64 batchBytes = 0;
+        int batchRequests = batch.size();
+        for (const auto &request : batch)
+            batchBytes += request.data.size();
+
+        writeBatch(batch);
+        batch.clear();
+
+        QMutexLocker locker(&mutex);
+        queuedBytes -= batchBytes;
+        queueDepth -= batchRequests;
+        writing = false;
+        batchWritten.wakeAll();
+    }
+
+    qCDebug(jtJamRecorder) << "Recording writer thread stopped!";
+}
+
+void RecordingWriter::writeBatch(std::deque<WriteRequest> &batch)
+{
+    if (batch.empty())
+        return;
+
+    const qint64 oldestRequestTime = batch.front().enqueueTime;
+
+    // coalescing consecutive requests to the same file (the journal entries, for example)
+    std::vector<WriteRequest> writes;
+    for (auto &request : batch) {
+        if (!writes.empty() && writes.back().filePath == request.filePath) {
+            WriteRequest &last = writes.back();
+            if (request.mode != Append) {
+                last.data = request.data;
+                last.mode = request.mode;
+            }
+            else {
+                last.data.append(request.data);
+            }
+            continue;
+        }
+
+        writes.push_back(request);
+    }
+
+    for (const auto &request : writes) {
+        if (request.mode == Replace) {
+            replaceFile(request.filePath, request.data);
+            continue;
+        }
+
+        QFile file(request.filePath);
+        QIODevice::OpenMode openMode = (request.mode == Append) ? (QFile::WriteOnly | QFile::Append) : QFile::WriteOnly;
+        if (!file.open(openMode)) {
+            qCritical() << "can't open file " << request.filePath;
+            continue;
+        }
+
+        if (file.write(request.data) != request.data.size())
+            qCritical() << "Error writing " << request.filePath << file.errorString();
+        else
+            writtenBytes += request.data.size();
+    }
+
+    const qint64 latency = clock.elapsed() - oldestRequestTime;
+    lastWriteLatency = latency;
+    if (latency > maxWriteLatency)
+        maxWriteLatency = latency;
+}
+
+void RecordingWriter::replaceFile(const QString &filePath, const QByteArray &data)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)) {
+        qCritical() << "can't open file " << filePath;
+        return;
+    }
+
+    file.write(data);
+    if (!file.commit()) { // the previous file is not touched
+        qCritical() << "Error writing " << filePath << file.errorString();
+        return;
+    }
+
+    writtenBytes += data.size();
+}
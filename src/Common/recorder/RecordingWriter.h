@@ -0,0 +1,104 @@
+#ifndef __RECORDING_WRITER__
+#define __RECORDING_WRITER__
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QString>
+
+#include <deque>
+#include <atomic>
+
+namespace recorder {
+
+/**
+    Dedicated thread writing the recorded intervals (and the jam journal) in disk.
+
+    The requests are written in the same order they are enqueued. All pending requests are
+    taken in a single batch and consecutive requests to the same file are coalesced in one write.
+
+    The recorded data queue is bounded by MAX_QUEUED_BYTES. The producer (the main thread) is
+    never blocked: when the disk is slower than the jam the recorded data is dropped (and counted
+    in the metrics) instead of piling up intervals in memory. The metadata (journal, offset tables
+    and project files) is small and always queued, a pending project file is replaced by the new one.
+ */
+
+class RecordingWriter : public QThread // same producer/consumer approach used in NinjamController::EncodingThread
+{
+public:
+    static RecordingWriter *getInstance();
+
+    ~RecordingWriter();
+
+    enum WriteMode
+    {
+        Overwrite,
+        Append,
+        Replace // written in a temporary file and renamed, the old file is kept if the write fails (used for the project files)
+    };
+
+    struct Metrics
+    {
+        int queueDepth; // pending requests
+        qint64 queuedBytes;
+        qint64 lastWriteLatency; // in milliseconds, from enqueue to written
+        qint64 maxWriteLatency;
+        qint64 writtenBytes;
+        qint64 droppedWrites; // recorded data dropped because the queue was full
+        qint64 droppedBytes;
+    };
+
+    bool write(const QString &filePath, const QByteArray &data, WriteMode mode = Overwrite); // recorded data, return false if the data is dropped (full queue)
+    void writeMetadata(const QString &filePath, const QByteArray &data, WriteMode mode); // never dropped
+
+    void waitForPendingWrites();
+    void stop(); // write the pending requests and finish the thread
+
+    Metrics getMetrics() const;
+
+    static const qint64 MAX_QUEUED_BYTES;
+
+protected:
+    void run() override;
+
+private:
+    RecordingWriter();
+
+    struct WriteRequest
+    {
+        QString filePath;
+        QByteArray data;
+        WriteMode mode;
+        qint64 enqueueTime;
+    };
+
+    void enqueue(const QString &filePath, const QByteArray &data, WriteMode mode); // called with the mutex locked
+
+    std::deque<WriteRequest> requests;
+    mutable QMutex mutex;
+    QWaitCondition hasRequests;
+    QWaitCondition batchWritten; // signaled when a batch is written
+    bool stopRequested;
+    bool writing; // a batch is being written
+
+    qint64 queuedBytes;
+    int queueDepth;
+
+    std::atomic<qint64> lastWriteLatency;
+    std::atomic<qint64> maxWriteLatency;
+    std::atomic<qint64> writtenBytes;
+
+    qint64 droppedWrites; // protected by the mutex
+    qint64 droppedBytes;
+
+    QElapsedTimer clock;
+
+    void writeBatch(std::deque<WriteRequest> &batch);
+    void replaceFile(const QString &filePath, const QByteArray &data);
+};
+
+} // namespace
+
+#endif
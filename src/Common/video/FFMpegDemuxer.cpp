@@ -4,29 +4,95 @@
 #include <QImage>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+const int FFMpegDemuxer::MAX_QUEUED_FRAMES = 4;
+
+namespace {
+
+// the decoding tasks are short (until the frames queue is full), one thread per core is enough for all users
+class DecodingThreadPool : public QThreadPool
+{
+public:
+    DecodingThreadPool()
+    {
+        setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    }
+};
+
+} // namespace
+
+// a dedicated pool, the video decoding is not delayed by the long tasks running in the global thread pool
+static QThreadPool *getDecodingThreadPool()
+{
+    static DecodingThreadPool threadPool;
+    return &threadPool;
+}
 
 FFMpegDemuxer::FFMpegDemuxer(QObject *parent, const QByteArray &encodedData) :
     QObject(parent),
     formatContext(nullptr),
     avioContext(nullptr),
-    swsContext(nullptr),
     frame(nullptr),
-    frameRGB(nullptr),
-    rgbBuffer(nullptr),
     buffer(nullptr),
-    encodedData(encodedData)
+    encodedData(encodedData),
+    stopRequested(false),
+    decodingScheduled(false),
+    decodingFinished(false),
+    decodedFramesCount(0),
+    opened(false),
+    flushing(false),
+    frameRate(0),
+    videoWidth(0),
+    videoHeight(0)
 {
     av_register_all();
     avcodec_register_all();
-
-    qRegisterMetaType<QList<QImage>>();
 }
 
 FFMpegDemuxer::~FFMpegDemuxer()
 {
+    stop();
+
     close();
 }
 
+void FFMpegDemuxer::start()
+{
+    QMutexLocker locker(&mutex);
+    scheduleDecoding();
+}
+
+void FFMpegDemuxer::stop()
+{
+    QFuture<void> runningDecoding;
+
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true; // decoding is not scheduled again
+        runningDecoding = decodingFuture;
+    }
+
+    runningDecoding.waitForFinished();
+}
+
+void FFMpegDemuxer::scheduleDecoding()
+{
+    if (decodingScheduled || decodingFinished || stopRequested)
+        return;
+
+    decodingFuture.waitForFinished(); // the previous task released the mutex and is returning, stop() waits only the last task
+    decodingScheduled = true;
+    decodingFuture = QtConcurrent::run(getDecodingThreadPool(), this, &FFMpegDemuxer::decode);
+}
+
+bool FFMpegDemuxer::queueIsFull() const
+{
+    return decodedFrames.size() >= static_cast<size_t>(MAX_QUEUED_FRAMES);
+}
+
 void FFMpegDemuxer::close()
 {
     if (formatContext) {
@@ -34,23 +100,17 @@ void FFMpegDemuxer::close()
         formatContext = nullptr;
         avioContext = nullptr;
         //codecContext = nullptr;
-        swsContext = nullptr;
     }
 
     if (frame) {
-        av_free(frame);
+        av_frame_free(&frame);
         frame = nullptr;
     }
 
-    if (frameRGB) {
-        av_free(frameRGB);
-        frameRGB = nullptr;
-    }
+    for (auto &decodedFrame : decodedFrames)
+        av_frame_free(&decodedFrame.frame);
 
-    if (rgbBuffer) {
-        delete [] rgbBuffer;
-        rgbBuffer = nullptr;
-    }
+    decodedFrames.clear();
 
     if (buffer) {
         //av_free(buffer);
@@ -142,7 +202,7 @@ bool FFMpegDemuxer::open()
     return true;
 }
 
-uint FFMpegDemuxer::getFrameRate() const
+uint FFMpegDemuxer::readFrameRate() const
 {
     if (formatContext && formatContext->nb_streams > 0) {
         auto firstStream = formatContext->streams[0];
@@ -154,99 +214,136 @@ uint FFMpegDemuxer::getFrameRate() const
     return 0;
 }
 
-void FFMpegDemuxer::decode()
+bool FFMpegDemuxer::isFinished() const
 {
-    QList<QImage> decodedImages;
+    QMutexLocker locker(&mutex);
+    return decodingFinished && decodedFrames.empty();
+}
 
-    if (!open()) {
-        qCritical() << "Can't open the video decoder!";
-        emit imagesDecoded(decodedImages, getFrameRate());
-        return;
-    }
+QImage FFMpegDemuxer::takeFrame(uint frameIndex, const QSize &targetSize)
+{
+    AVFrame *frameToShow = nullptr;
 
-    if (!formatContext || formatContext->nb_streams <= 0)
-        return;
+    {
+        QMutexLocker locker(&mutex);
 
-    auto codecContext = formatContext->streams[0]->codec;
+        // late frames are dropped, only the most recent frame is converted
+        while (!decodedFrames.empty() && decodedFrames.front().index <= frameIndex) {
+            if (frameToShow)
+                av_frame_free(&frameToShow);
 
-    if (!codecContext)
-        return;
+            frameToShow = decodedFrames.front().frame;
+            decodedFrames.pop_front();
+        }
 
-    /* initialize packet, set data to NULL, let the demuxer fill it */
-    AVPacket packet;
-    packet.data = nullptr;
-    packet.size = 0;
+        if (frameToShow)
+            scheduleDecoding(); // there is space to decode more frames
+    }
 
-    int ret = 0;
+    if (!frameToShow)
+        return QImage();
 
-    /* read frames */
-    while ((ret = av_read_frame(formatContext, &packet)) == 0)
-    {
+    QImage image = scaler.scale(frameToShow, targetSize);
 
-        int framesDecoded = 0;
+    av_frame_free(&frameToShow);
 
-        while (framesDecoded <= 0)
-        {
-            ret = avcodec_send_packet(codecContext, &packet);
+    return image;
+}
+
+void FFMpegDemuxer::finishDecoding()
+{
+    QMutexLocker locker(&mutex);
+    decodingFinished = true;
+    decodingScheduled = false;
+}
 
-            if (ret != 0) { // error
-                if (ret != AVERROR(EAGAIN)) {
-                    qCritical() << "error decoding video frame" << av_error_to_qt_string(ret) << ret;
-                    emit imagesDecoded(decodedImages, getFrameRate());
+/**
+ * Decode and enqueue the next frame, reading the packets from the stream when the decoder need more data.
+ * Return false when the decoding is finished (end of stream or error).
+ */
+bool FFMpegDemuxer::decodeNextFrame(AVCodecContext *codecContext)
+{
+    forever {
+        int ret = avcodec_receive_frame(codecContext, frame);
+        if (ret == 0) { // got a frame?
+            if (frame->width && frame->height) { // 0 size images are skipped
+                AVFrame *frameReference = av_frame_clone(frame); // the YUV data is referenced, not copied
+                if (frameReference) {
+                    QMutexLocker locker(&mutex);
+                    decodedFrames.push_back(DecodedFrame{frameReference, decodedFramesCount++});
                 }
-                return;
             }
 
-            while((ret = avcodec_receive_frame(codecContext, frame)) == 0)  // got a frame?
-            {
-                int width = (codecContext->width > 0) ? codecContext->width : frame->width;
-                int height = (codecContext->height > 0) ? codecContext->height : frame->height;
+            av_frame_unref(frame);
+            return true;
+        }
 
-                if (!frameRGB) {
-                    frameRGB = av_frame_alloc();
+        if (ret == AVERROR_EOF)
+            return false; // all frames decoded
 
-                    // Determine required buffer size and allocate buffer
-                    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_RGB24, width, height, 1);
-                    rgbBuffer = new uint8_t[numBytes];
+        if (ret != AVERROR(EAGAIN)) {
+            qCritical() << "error decoding video frame in avcodec_receive_frame" << av_error_to_qt_string(ret) << ret;
+            return false;
+        }
 
-                    // Assign appropriate parts of buffer to image planes in pFrameRGB
-                    av_image_fill_arrays(frameRGB->data, frameRGB->linesize, rgbBuffer, AV_PIX_FMT_RGB24, width, height, 1);
-                }
+        if (flushing)
+            return false;
 
-                // Convert the image format (init the context the first time)
-                AVPixelFormat sourcePixelFormat = codecContext->pix_fmt;
-                AVPixelFormat destinationPixelFormat = AV_PIX_FMT_RGB24;
+        // the decoder needs more packets
+        AVPacket packet;
+        av_init_packet(&packet);
+        packet.data = nullptr;
+        packet.size = 0;
 
-                if (!frame->width || !frame->height) // 0 size images are skipped
-                    continue;
+        if (av_read_frame(formatContext, &packet) == 0) {
+            ret = avcodec_send_packet(codecContext, &packet);
+            av_packet_unref(&packet);
 
-                swsContext = sws_getCachedContext(swsContext, width, height, sourcePixelFormat, width, height, destinationPixelFormat, SWS_BICUBIC, nullptr, nullptr, nullptr);
+            if (ret != 0 && ret != AVERROR(EAGAIN)) { // error
+                qCritical() << "error decoding video frame" << av_error_to_qt_string(ret) << ret;
+                return false;
+            }
+        }
+        else {
+            flushing = true; // flushing the frames buffered in decoder
+            if (avcodec_send_packet(codecContext, nullptr) != 0)
+                return false;
+        }
+    }
+}
 
-                if(!swsContext){
-                    qCritical() << "Cannot initialize the conversion context!";
-                    emit imagesDecoded(decodedImages, getFrameRate());
-                    return;
-                }
-                sws_scale(swsContext, frame->data, frame->linesize, 0, height, frameRGB->data, frameRGB->linesize);
+void FFMpegDemuxer::decode()
+{
+    if (!opened) {
+        opened = true;
 
-                // Convert the frame to QImage
-                QImage img(width, height, QImage::Format_RGB888);
+        if (!open()) {
+            qCritical() << "Can't open the video decoder!";
+            finishDecoding();
+            return;
+        }
 
-                for(int y=0; y < height; y++)
-                    memcpy(img.scanLine(y), frameRGB->data[0] + y * frameRGB->linesize[0], width * 3);
+        frameRate = readFrameRate();
 
-                decodedImages << img;
+        auto codecParameters = formatContext->streams[0]->codecpar;
+        videoWidth = codecParameters->width;
+        videoHeight = codecParameters->height;
+    }
 
-                framesDecoded++;
-            }
+    auto codecContext = formatContext->streams[0]->codec;
 
-            if (ret != 0 && ret != AVERROR(EAGAIN)) {
-                qCritical() << "error decoding video frame in avcodec_receive_frame" << av_error_to_qt_string(ret) << ret;
-                emit imagesDecoded(decodedImages, getFrameRate());
+    forever {
+        {
+            QMutexLocker locker(&mutex);
+            if (stopRequested || queueIsFull()) {
+                decodingScheduled = false; // scheduled again in takeFrame()
                 return;
             }
         }
-    }
 
-    emit imagesDecoded(decodedImages, getFrameRate());
+        if (!decodeNextFrame(codecContext)) {
+            finishDecoding();
+            return;
+        }
+    }
 }
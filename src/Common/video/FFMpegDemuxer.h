@@ -2,11 +2,26 @@
 #define FFMPEGDEMUXER_H
 
 #include "FFMpegCommon.h"
+#include "VideoScaler.h"
 
 #include <QByteArray>
 #include <QDataStream>
 #include <QBuffer>
 #include <QImage>
+#include <QMutex>
+#include <QFuture>
+
+#include <deque>
+#include <atomic>
+
+/**
+    Streaming decoder for the received video intervals. The interval is decoded incrementally in a
+    thread pool and the decoded frames are kept in the codec native format (YUV) in a small bounded
+    queue, so the memory used doesn't depend on the interval lenght. The decoding task never waits:
+    it returns when the queue is full and is scheduled again when a frame is taken, so the pool
+    threads are not blocked by the users' streams. The frames are converted to RGB only when
+    displayed (takeFrame).
+ */
 
 class FFMpegDemuxer : public QObject
 {
@@ -17,28 +32,77 @@ public:
     FFMpegDemuxer(QObject *parent, const QByteArray &encodedData);
     ~FFMpegDemuxer();
 
-    void decode();
+    void start(); // start decoding in the decoding thread pool
+    void stop();
+
+    // Called in the GUI thread. Return the most recent frame with index <= frameIndex, the older
+    // frames are discarded. A null image is returned when there is no new frame to show. The frame
+    // is converted and scaled to targetSize (the size painted in the video widget) in a single pass.
+    QImage takeFrame(uint frameIndex, const QSize &targetSize = QSize());
+
+    bool isFinished() const; // all frames decoded and consumed
+
+    uint getFrameRate() const; // zero until the stream is opened
+    QSize getVideoSize() const; // empty until the stream is opened
+
+    static const int MAX_QUEUED_FRAMES;
 
-signals:
-    void imagesDecoded(QList<QImage> images, uint frameRate);
 private:
     AVFormatContext *formatContext;
     AVIOContext *avioContext;
-    SwsContext *swsContext;
     AVFrame *frame;
-    AVFrame *frameRGB;
-    uint8_t *rgbBuffer;
 
     unsigned char *buffer; // avio buffer used in callback
 
     QByteArray encodedData;
     QBuffer encodedBuffer;
 
+    struct DecodedFrame
+    {
+        AVFrame *frame; // reference to the decoded YUV frame
+        uint index;
+    };
+
+    std::deque<DecodedFrame> decodedFrames;
+    mutable QMutex mutex;
+    bool stopRequested;
+    bool decodingScheduled; // a decoding task is queued or running
+    bool decodingFinished;
+    uint decodedFramesCount;
+
+    // decoder state, used only in the decoding task
+    bool opened;
+    bool flushing; // all packets were sent to the decoder
+
+    std::atomic<uint> frameRate;
+    std::atomic<int> videoWidth;
+    std::atomic<int> videoHeight;
+
+    VideoScaler scaler; // used only in the GUI thread to convert the displayed frames
+
+    QFuture<void> decodingFuture;
+
     static int readCallback(void *stream, uint8_t *buffer, int bufferSize);
 
+    void scheduleDecoding(); // called with the mutex locked
+    void decode(); // decode until the queue is full or the stream is finished
+    bool decodeNextFrame(AVCodecContext *codecContext); // false when the decoding is finished (end of stream or error)
+    void finishDecoding();
+    bool queueIsFull() const;
+
     void close();
     bool open();
-    uint getFrameRate() const;
+    uint readFrameRate() const;
 };
 
+inline uint FFMpegDemuxer::getFrameRate() const
+{
+    return frameRate;
+}
+
+inline QSize FFMpegDemuxer::getVideoSize() const
+{
+    return QSize(videoWidth, videoHeight);
+}
+
 #endif // FFMPEGDEMUXER_H
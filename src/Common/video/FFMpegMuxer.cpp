@@ -1,237 +1,316 @@
 #include "FFMpegMuxer.h"
+#include "VideoScaler.h"
+#include "log/Logging.h"
 
 #include <cstring>
 
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
-#include <QtConcurrent/QtConcurrent>
 #include <QMutex>
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-class BaseOutputStream
+
+class FFMpegMuxer::AudioOutputStream
 {
 public:
-    BaseOutputStream()
+    AudioOutputStream()
         : stream(nullptr),
           frame(nullptr),
-          tempFrame(nullptr)
+          tempFrame(nullptr),
+          swrContext(nullptr),
+          samplesCount(0)
     {
 
     }
 
-    virtual ~BaseOutputStream()
+    ~AudioOutputStream()
     {
+        qCDebug(jtVideo) << "closing audio outputstream";
         avcodec_free_context(&stream->codec);
-        //av_frame_free(&frame);
-        //av_frame_free(&tempFrame);
+
+        if (swrContext)
+            swr_free(&swrContext);
     }
 
     AVStream *stream;
     AVFrame *frame;
-    AVFrame *tempFrame;     // used to rescale/resample
+    AVFrame *tempFrame;     // used to resample
+    SwrContext *swrContext; // resampler
+    int samplesCount;
 };
 
-class FFMpegMuxer::VideoOutputStream : public BaseOutputStream
-{
-public:
-    VideoOutputStream()
-        : swsContext(nullptr)
-    {
-
-    }
-
-    ~VideoOutputStream()
-    {
-        if (swsContext)
-            sws_freeContext(swsContext);
-
-    }
-
-    SwsContext *swsContext; // used to rescale images
-};
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-class FFMpegMuxer::AudioOutputStream : public BaseOutputStream
+class FFMpegMuxer::EncodingThread : public QThread
 {
 public:
-    AudioOutputStream()
-        : swrContext(nullptr),
-          samplesCount(0)
+    explicit EncodingThread(FFMpegMuxer *muxer)
+        : muxer(muxer)
     {
 
     }
 
-    ~AudioOutputStream()
+protected:
+    void run() override
     {
-        qDebug() << "closing audio outputstream";
-        if (swrContext)
-            swr_free(&swrContext);
+        muxer->processCommands();
     }
 
-    SwrContext *swrContext; // resampler
-    int samplesCount;
+private:
+    FFMpegMuxer *muxer;
 };
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
 FFMpegMuxer::FFMpegMuxer(QObject *parent) :
       QObject(parent),
-      encodeVideo(false),
-      encodeAudio(false),
+      encodingThread(new EncodingThread(this)),
+      commands(MAX_QUEUED_FRAMES * 2),
+      queuedFrames(0),
+      droppedFrames(0),
       videoPts(0),
-      encodedFrames(0),
       audioStream(nullptr),
       codec(nullptr),
       codecContext(nullptr),
-      frame(nullptr),
-      tempFrame(nullptr),
       swsContext(nullptr),
+      nextPoolFrame(0),
+      forceKeyFrame(false),
+      firstPacketPending(false),
       videoResolution(QSize(320, 240)),
       videoFrameRate(25),
       videoBitRate(static_cast<uint>(FFMpegMuxer::VideoQualityLow)),
-      initialized(false),
-      startNewIntervalRequested(false)
+      encoderFrameRate(0),
+      encoderBitRate(0)
 {
     av_register_all();
 
     av_log_set_level(AV_LOG_QUIET); // disabling ffmpeg encoder messages
 
-    threadPool.setMaxThreadCount(1);
+    packetCallback = [this](const QByteArray &data, bool isFirstPacket) {
+        emit dataEncoded(data, isFirstPacket);
+    };
+
+    encodingThread->start();
 }
 
-void FFMpegMuxer::initialize()
+FFMpegMuxer::~FFMpegMuxer()
 {
-    //QMutexLocker locker(&mutex);
+    commands.enqueue(EncoderCommand{EncoderCommand::Stop, QImage(), QVideoFrame(), false});
 
-    encodeAudio = encodeVideo = false;
-    audioStream = nullptr;
+    encodingThread->wait(); // the codec is released in the encoding thread
 
-    videoPts = 0;
-    encodedFrames = 0;
+    releaseFramePool();
+
+    if (swsContext) {
+        sws_freeContext(swsContext);
+        swsContext = nullptr;
+    }
 }
 
-FFMpegMuxer::~FFMpegMuxer()
+void FFMpegMuxer::setPacketCallback(const PacketCallback &callback)
 {
-    finish();
+    packetCallback = callback;
 }
 
-void FFMpegMuxer::finish()
+void FFMpegMuxer::setVideoQuality(VideoQuality quality)
 {
-    QtConcurrent::run(&threadPool, this, &FFMpegMuxer::finishCurrentInterval);
+    setVideoBitRate(static_cast<uint>(quality));
+}
 
+void FFMpegMuxer::setVideoBitRate(uint bitRate)
+{
+    QMutexLocker locker(&settingsMutex);
+    videoBitRate = bitRate;
 }
 
-void FFMpegMuxer::encodeImage(const QImage &image, bool async)
+void FFMpegMuxer::setVideoFrameRate(qreal frameRate)
 {
-    // encoding in a separated thread
+    QMutexLocker locker(&settingsMutex);
+    videoFrameRate = frameRate;
+}
 
-    auto lambda = [=](){
+void FFMpegMuxer::setVideoResolution(const QSize &resolution)
+{
+    qCDebug(jtVideo) << "Setting video resolution to" << resolution;
 
-        if (startNewIntervalRequested) {
-            if (prepareToEncodeNewInterval())
-                startNewIntervalRequested = false;
-        }
+    QMutexLocker locker(&settingsMutex);
+    videoResolution = resolution;
+}
 
-        if (encodeVideo && !image.isNull())
-            encodeVideo = !doEncodeVideoFrame(image);
-    };
+QSize FFMpegMuxer::getVideoResolution() const
+{
+    QMutexLocker locker(&settingsMutex);
+    return videoResolution;
+}
 
-    if (async)
-        QtConcurrent::run(&threadPool, lambda);
-    else
-        lambda();
+void FFMpegMuxer::finish()
+{
+    commands.enqueue(EncoderCommand{EncoderCommand::Finish, QImage(), QVideoFrame(), false});
 }
 
-void FFMpegMuxer::encodeAudioFrame()
+void FFMpegMuxer::startNewInterval()
 {
-    //QMutexLocker locker(&mutex);
-    //if (!initialized)
-    //    return;
+    commands.enqueue(EncoderCommand{EncoderCommand::NewInterval, QImage(), QVideoFrame(), false});
+}
 
-    //if (encodeAudio)
-    //    encodeAudio = !doEncodeAudioFrame();
+void FFMpegMuxer::encodeImage(const QImage &image)
+{
+    if (!image.isNull())
+        enqueueFrame(EncoderCommand{EncoderCommand::EncodeImage, image, QVideoFrame(), false});
 }
 
-void FFMpegMuxer::startNewInterval()
+void FFMpegMuxer::encodeFrame(const QVideoFrame &videoFrame, bool flipVertically)
 {
-    startNewIntervalRequested = true;
+    // the camera frame is converted straight to the codec pixel format in the encoding thread
+    if (videoFrame.isValid())
+        enqueueFrame(EncoderCommand{EncoderCommand::EncodeVideoFrame, QImage(), videoFrame, flipVertically});
 }
 
-bool FFMpegMuxer::prepareToEncodeNewInterval()
+void FFMpegMuxer::enqueueFrame(EncoderCommand &&command)
 {
-    if(initialized)
-        finishCurrentInterval();
+    // dropping the frame instead of piling up camera buffers when the encoder is late
+    if (queuedFrames >= MAX_QUEUED_FRAMES) {
+        droppedFrames++; // logged once per interval
+        return;
+    }
 
-    initialized = false;
+    queuedFrames++;
+    commands.enqueue(std::move(command));
+}
 
-    initialize();
+void FFMpegMuxer::encodeAudioFrame()
+{
+    //if (encodeAudio)
+    //    encodeAudio = !doEncodeAudioFrame();
+}
 
-    // Add the audio and video streams using the default format codecs and initialize the codecs.
+void FFMpegMuxer::processCommands()
+{
+    EncoderCommand command;
+
+    forever {
+        commands.wait_dequeue(command);
+
+        switch (command.type) {
+        case EncoderCommand::EncodeImage:
+        case EncoderCommand::EncodeVideoFrame:
+            encodeQueuedFrame(command);
+            queuedFrames--;
+            break;
+        case EncoderCommand::NewInterval:
+            beginInterval();
+            break;
+        case EncoderCommand::Finish:
+            if (codecContext) {
+                closeVideoEncoder();
+                emit encodingFinished();
+            }
+            break;
+        case EncoderCommand::Stop:
+            closeVideoEncoder();
+            return;
+        }
 
-    AVDictionary * opts = nullptr;
-    AVCodecID codecID = AV_CODEC_ID_H264;
-    encodeVideo = addVideoStream(codecID, &opts);
+        command = EncoderCommand(); // releasing the image and camera buffer references
+    }
+}
 
-    encodeAudio = false;
+bool FFMpegMuxer::beginInterval()
+{
+    const uint framesDropped = droppedFrames.exchange(0);
+    if (framesDropped > 0)
+        qCDebug(jtVideo) << "Video encoder is late," << framesDropped << "frames dropped in the last interval";
 
-    // Now that all the parameters are set, we can open the audio and video codecs and allocate the necessary encode buffers.
-    if (encodeVideo)
-        if(!openVideoCodec(codec, &opts))
+    bool settingsChanged = false;
+    {
+        QMutexLocker locker(&settingsMutex);
+        settingsChanged = videoResolution != encoderResolution || videoFrameRate != encoderFrameRate || videoBitRate != encoderBitRate;
+    }
+
+    // the codec is kept open across intervals, opening it again only when the settings are changed
+    if (!codecContext || settingsChanged) {
+        closeVideoEncoder();
+        if (!openVideoEncoder())
             return false;
+    }
 
-    initialized = true;
+    forceKeyFrame = true;
 
-    return initialized;
+    return true;
 }
 
-void FFMpegMuxer::finishCurrentInterval()
+void FFMpegMuxer::encodeQueuedFrame(const EncoderCommand &command)
 {
-    if (!initialized)
-        return;
+    if (!codecContext)
+        return; // waiting the first interval
 
-    if (!codecContext || (codecContext && !avcodec_is_open(codecContext))) {
+    AVFrame *frame = nullptr;
+    if (command.type == EncoderCommand::EncodeVideoFrame)
+        frame = fillFrameWithVideoFrame(command.videoFrame, command.flipVertically);
+    else
+        frame = fillFrameWithImageData(command.image);
+
+    if (!frame)
         return;
-    }
 
-    if (audioStream) {
-        if (!audioStream->stream->codec || !avcodec_is_open(audioStream->stream->codec)) {
-            qCritical() << "audio codec is null or not opened!";
-            return;
-        }
+    // the pool frames are reused, the picture type is always rewritten
+    if (forceKeyFrame) {
+        frame->pict_type = AV_PICTURE_TYPE_I; // an IDR frame because the 'forced-idr' option
+        forceKeyFrame = false;
+        firstPacketPending = true;
     }
+    else {
+        frame->pict_type = AV_PICTURE_TYPE_NONE;
+    }
+
+    doEncodeVideoFrame(frame);
+}
 
-    // drain non encoded frames in last interval
-    bool finished = false;
-    do {
-        finished = doEncodeVideoFrame(QImage());
+bool FFMpegMuxer::openVideoEncoder()
+{
+    {
+        QMutexLocker locker(&settingsMutex);
+        encoderResolution = videoResolution;
+        encoderFrameRate = videoFrameRate;
+        encoderBitRate = videoBitRate;
     }
-    while(!finished);
 
-    audioStream.reset(nullptr);
+    videoPts = 0;
 
-    initialized = false;
-    encodedFrames = 0;
+    AVDictionary *opts = nullptr;
+    bool opened = addVideoStream(AV_CODEC_ID_H264, &opts) && openVideoCodec(codec, &opts);
 
-    if (frame) {
-        av_frame_free(&frame);
-        frame = nullptr;
-    }
+    av_dict_free(&opts);
 
-    if (tempFrame) {
-        av_frame_free(&tempFrame);
-        tempFrame = nullptr;
-    }
+    if (!opened) {
+        if (codecContext)
+            avcodec_free_context(&codecContext);
 
-    if (codecContext) {
-        avcodec_free_context(&codecContext);
         codecContext = nullptr;
-    }
-
-    if (codec) {
         codec = nullptr;
     }
 
-    emit encodingFinished();
+    return opened;
+}
+
+void FFMpegMuxer::closeVideoEncoder()
+{
+    if (!codecContext)
+        return;
+
+    // drain non encoded frames, the packets are delivered to the current interval
+    if (avcodec_is_open(codecContext) > 0)
+        doEncodeVideoFrame(nullptr);
+
+    audioStream.reset(nullptr);
+
+    avcodec_free_context(&codecContext);
+    codecContext = nullptr;
+    codec = nullptr;
+
+    forceKeyFrame = false;
+    firstPacketPending = false;
 }
 
 bool FFMpegMuxer::addVideoStream(AVCodecID codecID, AVDictionary **opts)
@@ -250,17 +329,17 @@ bool FFMpegMuxer::addVideoStream(AVCodecID codecID, AVDictionary **opts)
     }
 
     codecContext->codec_id = codecID;
-    codecContext->bit_rate = videoBitRate;
-    codecContext->rc_max_rate = videoBitRate;
-    codecContext->rc_buffer_size = videoBitRate;
-    codecContext->width    = videoResolution.width(); // Resolution must be a multiple of two.
-    codecContext->height   = videoResolution.height();
+    codecContext->bit_rate = encoderBitRate;
+    codecContext->rc_max_rate = encoderBitRate;
+    codecContext->rc_buffer_size = encoderBitRate;
+    codecContext->width    = encoderResolution.width(); // Resolution must be a multiple of two.
+    codecContext->height   = encoderResolution.height();
 
     /** timebase: This is the fundamental unit of time (in seconds) in terms
          * of which frame timestamps are represented. For fixed-fps content,
          * timebase should be 1/framerate and timestamp increments should be
          * identical to 1. */
-    codecContext->time_base = AVRational{ 1, static_cast<int>(videoFrameRate) };
+    codecContext->time_base = AVRational{ 1, static_cast<int>(encoderFrameRate) };
 
     codecContext->gop_size = 30; // emit one intra frame every N frames at most
     codecContext->pix_fmt = AV_PIX_FMT_YUV420P;
@@ -271,6 +350,12 @@ bool FFMpegMuxer::addVideoStream(AVCodecID codecID, AVDictionary **opts)
             qCritical() << "Error setting h264 preset" << av_error_to_qt_string(ret) << ret;
             return false;
         }
+
+        // no lookahead and no B frames, the packets are generated as soon as the frames are encoded
+        av_dict_set(opts, "tune", "zerolatency", 0);
+
+        // the key frames forced in new intervals are IDR frames, every interval can be decoded alone
+        av_dict_set(opts, "forced-idr", "1", 0);
     }
 
     return true;
@@ -434,6 +519,7 @@ AVFrame *FFMpegMuxer::allocPicture(enum AVPixelFormat pixelFormat, int width, in
     int ret = av_frame_get_buffer(picture, 32);
     if (ret < 0) {
         qCritical() << "Could not allocate frame data.";
+        av_frame_free(&picture);
         return nullptr;
     }
 
@@ -453,192 +539,189 @@ bool FFMpegMuxer::openVideoCodec(AVCodec *codec, AVDictionary **opts)
         return false;
     }
 
-    /* allocate and init a re-usable frame */
-    frame = allocPicture(codecContext->pix_fmt, codecContext->width, codecContext->height);
-
-    if (!frame) {
+    /* allocate and init the re-usable frames */
+    if (!allocFramePool(codecContext->pix_fmt, codecContext->width, codecContext->height)) {
         qCritical() << "Could not allocate video frame";
         return false;
     }
 
-    /* If the output format is not YUV420P, then a temporary YUV420P picture is needed too. It is then converted to the required output format. */
-    tempFrame = nullptr;
-    if (codecContext->pix_fmt != AV_PIX_FMT_YUV420P) {
-        tempFrame = allocPicture(AV_PIX_FMT_YUV420P, codecContext->width, codecContext->height);
-        if (!tempFrame) {
-            qCritical() << "Could not allocate temporary picture";
-            return false;
-        }
-    }
-
     return true;
 }
 
-void FFMpegMuxer::imageToYuvPicture(const QImage &image, AVFrame *picture, int width, int height)
+bool FFMpegMuxer::allocFramePool(enum AVPixelFormat pixelFormat, int width, int height)
 {
+    if (!framePool.empty()) {
+        const AVFrame *poolFrame = framePool.front();
+        if (poolFrame->format == pixelFormat && poolFrame->width == width && poolFrame->height == height)
+            return true; // reusing the frames allocated in previous intervals
 
-    if (!picture)
-        return;
+        releaseFramePool();
+    }
 
-    //avoiding crash when camera preview is resized
-    width = qMin(width, image.width());
-    height = qMin(height, image.height());
+    for (int i = 0; i < FRAME_POOL_SIZE; ++i) {
+        AVFrame *poolFrame = allocPicture(pixelFormat, width, height);
+        if (!poolFrame) {
+            releaseFramePool();
+            return false;
+        }
+        framePool.push_back(poolFrame);
+    }
 
-    // Preparing the buffer to get YUV420P data
-    auto size = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, width, height, 1);
-    auto pic_dat = (uint8_t *) av_malloc(size);
+    nextPoolFrame = 0;
 
-    // Transforming data from RGB to YUV420P
-    RGBtoYUV420P(image.bits(), pic_dat, image.depth()/8, true, width, height);
+    return true;
+}
 
-    picture->quality = 0;
+void FFMpegMuxer::releaseFramePool()
+{
+    for (AVFrame *poolFrame : framePool)
+        av_frame_free(&poolFrame);
 
-    // Filling AVFrame with YUV420P data
-    av_image_fill_arrays(picture->data, picture->linesize, pic_dat, AV_PIX_FMT_YUV420P, width, height, 1);
+    framePool.clear();
+    nextPoolFrame = 0;
 }
 
-void FFMpegMuxer::RGBtoYUV420P(const uint8_t *bufferRGB, uint8_t *bufferYUV, uint rgbIncrement, bool swapRGB, int width, int height)
+AVFrame *FFMpegMuxer::acquirePoolFrame()
 {
-    if (!bufferRGB || !bufferYUV)
-        return;
-
-    const unsigned iPlaneSize = width * height;
-    const unsigned iHalfWidth = width >> 1;
+    if (framePool.empty())
+        return nullptr;
 
-    // get pointers to the data
-    uint8_t *yplane  = bufferYUV;
-    uint8_t *uplane  = bufferYUV + iPlaneSize;
-    uint8_t *vplane  = bufferYUV + iPlaneSize + (iPlaneSize >> 2);
-    const uint8_t *bufferRGBIndex = bufferRGB;
+    // skipping the frames still referenced by the encoder
+    for (size_t i = 0; i < framePool.size(); ++i) {
+        AVFrame *poolFrame = framePool[(nextPoolFrame + i) % framePool.size()];
+        if (av_frame_is_writable(poolFrame)) {
+            nextPoolFrame = (nextPoolFrame + i + 1) % framePool.size();
+            return poolFrame;
+        }
+    }
 
-    int iRGBIdx[3];
-    iRGBIdx[0] = 0;
-    iRGBIdx[1] = 1;
-    iRGBIdx[2] = 2;
-    if (swapRGB)  {
-        iRGBIdx[0] = 2;
-        iRGBIdx[2] = 0;
+    /* when we pass a frame to the encoder, it may keep a reference to it internally; make sure we do not overwrite it here */
+    AVFrame *poolFrame = framePool[nextPoolFrame];
+    nextPoolFrame = (nextPoolFrame + 1) % framePool.size();
+    if (av_frame_make_writable(poolFrame) < 0) {
+        qCritical() << "frame not writable";
+        return nullptr;
     }
 
-    for (int y = 0; y < (int) height; y++) {
-         uint8_t *yline  = yplane + (y * width);
-         uint8_t *uline  = uplane + ((y >> 1) * iHalfWidth);
-         uint8_t *vline  = vplane + ((y >> 1) * iHalfWidth);
+    return poolFrame;
+}
 
-         for (int x=0; x<width; x+=2) {
-              RGBtoYUV(bufferRGBIndex[iRGBIdx[0]], bufferRGBIndex[iRGBIdx[1]], bufferRGBIndex[iRGBIdx[2]], *yline, *uline, *vline);
-              bufferRGBIndex += rgbIncrement;
-              yline++;
-              RGBtoYUV(bufferRGBIndex[iRGBIdx[0]], bufferRGBIndex[iRGBIdx[1]], bufferRGBIndex[iRGBIdx[2]], *yline, *uline, *vline);
-              bufferRGBIndex += rgbIncrement;
-              yline++;
-              uline++;
-              vline++;
-         }
+AVFrame *FFMpegMuxer::fillFrameWithImageData(const QImage &image)
+{
+    QImage sourceImage(image);
+    AVPixelFormat sourceFormat = VideoScaler::getPixelFormat(sourceImage.format());
+    if (sourceFormat == AV_PIX_FMT_NONE) { // uncommon camera formats
+        sourceImage = sourceImage.convertToFormat(QImage::Format_RGB32);
+        sourceFormat = AV_PIX_FMT_RGB32;
     }
+
+    const uint8_t *sourceData[1] = { sourceImage.constBits() };
+    const int sourceLineSize[1] = { sourceImage.bytesPerLine() };
+
+    return fillFrame(sourceData, sourceLineSize, sourceFormat, sourceImage.size());
 }
 
-void FFMpegMuxer::fillFrameWithImageData(const QImage &image)
+AVFrame *FFMpegMuxer::fillFrameWithVideoFrame(const QVideoFrame &videoFrame, bool flipVertically)
 {
-    /* when we pass a frame to the encoder, it may keep a reference to it internally; make sure we do not overwrite it here */
-    if (av_frame_make_writable(frame) < 0) {
-        qCritical() << "frame not writable";
-        return;
+    const AVPixelFormat sourceFormat = VideoScaler::getPixelFormat(videoFrame.pixelFormat());
+    if (sourceFormat == AV_PIX_FMT_NONE) {
+        qCritical() << "Unsupported camera pixel format" << videoFrame.pixelFormat();
+        return nullptr;
     }
 
-    if (!codecContext) {
-        qCritical() << "Error in FFMpegMuxer::fillFrameWithImageData, codecContext is null";
-        return;
-    }
+    QVideoFrame mappedFrame(videoFrame); // shallow copy, the camera buffer is not copied
+    if (!mappedFrame.map(QAbstractVideoBuffer::ReadOnly))
+        return nullptr;
 
-    if (codecContext->pix_fmt != AV_PIX_FMT_YUV420P) { /* need image convertion? as we only generate a YUV420P picture, we must convert it to the codec pixel format if needed */
-        if (!swsContext) {
-            swsContext = sws_getContext(image.width(), image.height(), AV_PIX_FMT_YUV420P, codecContext->width, codecContext->height, codecContext->pix_fmt, SWS_BICUBIC, NULL, NULL, NULL);
-            if (!swsContext) {
-                qCritical() << "Could not initialize the conversion context";
-                return;
-            }
-        }
+    const uint8_t *sourceData[4];
+    int sourceLineSize[4];
+    AVFrame *frame = nullptr;
+    if (VideoScaler::getPlanes(mappedFrame, flipVertically, sourceData, sourceLineSize))
+        frame = fillFrame(sourceData, sourceLineSize, sourceFormat, mappedFrame.size());
 
-        if (!tempFrame) {
-            qCritical() << "Error in FFMpegMuxer::fillFrameWithImageData, tempFrame is null";
-            return;
-        }
+    mappedFrame.unmap();
+
+    return frame;
+}
+
+AVFrame *FFMpegMuxer::fillFrame(const uint8_t * const sourceData[], const int sourceLineSize[], AVPixelFormat sourceFormat, const QSize &sourceSize)
+{
+    if (!codecContext)
+        return nullptr;
 
-        imageToYuvPicture(image, tempFrame, codecContext->width, codecContext->height);
-        sws_scale(swsContext, (const uint8_t * const *)tempFrame->data, tempFrame->linesize, 0, codecContext->height, frame->data, frame->linesize);
+    AVFrame *frame = acquirePoolFrame();
+    if (!frame) {
+        qCritical() << "Error in FFMpegMuxer::fillFrame, frame is null";
+        return nullptr;
     }
-    else {
-        if (!frame) {
-            qCritical() << "Error in FFMpegMuxer::fillFrameWithImageData, frame is null";
-            return;
-        }
-        imageToYuvPicture(image, frame, codecContext->width, codecContext->height);
+
+    /* the vectorized swscale color conversion (and scaling when the camera resolution is not the video resolution).
+       The context is reused while the image size and format are the same */
+    swsContext = sws_getCachedContext(swsContext, sourceSize.width(), sourceSize.height(), sourceFormat,
+                                      codecContext->width, codecContext->height, codecContext->pix_fmt,
+                                      SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsContext) {
+        qCritical() << "Could not initialize the conversion context";
+        return nullptr;
     }
 
+    sws_scale(swsContext, sourceData, sourceLineSize, 0, sourceSize.height(), frame->data, frame->linesize);
+
+    frame->quality = 0;
     frame->pts = videoPts++;
+
+    return frame;
 }
 
 /*
- * encode one video frame and send it to the muxer
- * return true when encoding is finished, false otherwise
+ * encode one video frame and deliver the encoded packets
+ * return false when an error occurs
  */
-bool FFMpegMuxer::doEncodeVideoFrame(const QImage &image)
+bool FFMpegMuxer::doEncodeVideoFrame(AVFrame *frame)
 {
-    if (!initialized)
-        return false;
-
     if (!codec || !codecContext)
         return false;
 
-    if (!frame)
-        return false;
-
-    if(avcodec_is_open(codecContext) <= 0) {
+    if (avcodec_is_open(codecContext) <= 0) {
         qCritical() << "Codec is not opened!";
         return false;
     }
 
-    if (!image.isNull())
-        fillFrameWithImageData(image);
-
-    // send the image to encoder, send nullpr if finishing
-    int ret = avcodec_send_frame(codecContext, (!image.isNull()) ? frame : nullptr);
-
-    if (!image.isNull()) {
-        // releasing the allocated memory - fix https://github.com/elieserdejesus/JamTaba/issues/951
-        av_freep(frame);
-
-        if (ret != 0 && ret != AVERROR_EOF) {
-            qCritical() << "Error encoding video frame: " << av_error_to_qt_string(ret) << ret;
-            return false;
-        }
+    // send the image to encoder, send nullptr if draining
+    int ret = avcodec_send_frame(codecContext, frame);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        qCritical() << "Error encoding video frame: " << av_error_to_qt_string(ret) << ret;
+        return false;
     }
 
-    // get the encoded packet
-    AVPacket packet = AVPacket();// avoiding {0} initializer because GCC is emitting warning;
-    packet.size = 0;
-    packet.data = nullptr;
-    packet.stream_index = 0; // always using the first stream
+    return receivePackets();
+}
 
+bool FFMpegMuxer::receivePackets()
+{
+    AVPacket packet = AVPacket(); // avoiding {0} initializer because GCC is emitting warning;
     av_init_packet(&packet);
+    packet.data = nullptr;
+    packet.size = 0;
 
-    ret = avcodec_receive_packet(codecContext, &packet);
+    forever {
+        int ret = avcodec_receive_packet(codecContext, &packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return true; // all available packets received
 
-    if (ret == 0 || ret == AVERROR(EAGAIN)) {
-        if (ret == 0) { // we have a decoded frame?
-            QByteArray encodedBytes(reinterpret_cast<const char*>(packet.data), packet.size);
-            bool isFirstPacket = encodedFrames == 0;
-            emit dataEncoded(encodedBytes, isFirstPacket);
-            encodedFrames++;
-            av_packet_unref(&packet);
+        if (ret < 0) {
+            qCritical() << "Error receiving encoded video packet: " << av_error_to_qt_string(ret) << ret;
+            return false;
         }
-        av_free_packet(&packet);
 
-        return false;
-    }
+        // the packets received before the forced key frame belong to the previous interval
+        bool isFirstPacket = firstPacketPending && (packet.flags & AV_PKT_FLAG_KEY);
+        if (isFirstPacket)
+            firstPacketPending = false;
 
-    av_free_packet(&packet);
+        QByteArray encodedBytes(reinterpret_cast<const char*>(packet.data), packet.size);
+        packetCallback(encodedBytes, isFirstPacket);
 
-    return true;
+        av_packet_unref(&packet);
+    }
 }
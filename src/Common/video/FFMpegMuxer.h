@@ -6,14 +6,34 @@
 #include <QSize>
 #include <QFile>
 #include <QDebug>
-#include <QThreadPool>
+#include <QThread>
+#include <QMutex>
+#include <QVideoFrame>
 
 #include "FFMpegCommon.h"
+#include "audio/readerwriterqueue.h"
 
 #include <memory>
+#include <vector>
+#include <atomic>
+#include <functional>
 
 // adapted from FFMpeg muxing.c example
 
+/**
+    H264 encoder running in a single dedicated thread.
+
+    The encoding thread is the only owner of the codec context. Frames and interval boundaries are
+    taken from a lock free queue, so the producer (the main thread) never waits for the encoder.
+    The codec context is opened in the first interval and kept alive across intervals, a new
+    interval just forces an IDR frame (with the SPS/PPS headers) and the first packet of that frame
+    is flagged as the first packet of the interval. The codec is opened again only when the
+    resolution, frame rate or bit rate are changed.
+
+    Encoded packets are delivered by the packet callback, called in the encoding thread. The
+    default callback emits dataEncoded (queued to the receiver thread).
+ */
+
 class FFMpegMuxer : public QObject
 {
     Q_OBJECT
@@ -22,9 +42,11 @@ public:
     FFMpegMuxer(QObject *parent = nullptr);
     ~FFMpegMuxer();
 
-    void finish();
+    void finish(); // drain the encoder and release the codec, emit encodingFinished
 
-    void encodeImage(const QImage &image, bool async = true);
+    // non blocking, frames are dropped when the encoder is late
+    void encodeImage(const QImage &image);
+    void encodeFrame(const QVideoFrame &videoFrame, bool flipVertically); // camera frame in native pixel format, no copies
     void encodeAudioFrame();
 
     void setVideoResolution(const QSize &resolution);
@@ -46,9 +68,15 @@ public:
      * @param quality - Pre-defined bit rate values in VideoQuality enum
      */
     void setVideoQuality(VideoQuality quality);
+    void setVideoBitRate(uint bitRate); // applied in the next interval
 
     int64_t getCurrentVideoPresentationTimeStamp() const;
 
+    typedef std::function<void(const QByteArray &data, bool isFirstPacket)> PacketCallback;
+    void setPacketCallback(const PacketCallback &callback); // set before start encoding, called in the encoding thread
+
+    static const int MAX_QUEUED_FRAMES = 4; // camera buffers are referenced while queued
+
 signals:
     void dataEncoded(const QByteArray &data, bool isFirstPacket);
     void encodingFinished();
@@ -58,79 +86,94 @@ public slots:
 
 private:
 
-    void finishCurrentInterval();
-    bool prepareToEncodeNewInterval();
+    struct EncoderCommand
+    {
+        enum Type
+        {
+            EncodeImage,
+            EncodeVideoFrame,
+            NewInterval,
+            Finish,
+            Stop
+        };
+
+        Type type;
+        QImage image;
+        QVideoFrame videoFrame; // shallow copy, the camera buffer is released after the encoding
+        bool flipVertically;
+    };
+
+    class EncodingThread;
+    std::unique_ptr<EncodingThread> encodingThread;
+
+    moodycamel::BlockingReaderWriterQueue<EncoderCommand> commands; // single producer: the main thread
+    std::atomic<int> queuedFrames;
+    std::atomic<uint> droppedFrames; // frames dropped because the encoder is late, logged in each new interval
+
+    void enqueueFrame(EncoderCommand &&command);
+    void processCommands(); // the encoding thread loop
+
+    // running in the encoding thread
+    bool beginInterval();
+    void encodeQueuedFrame(const EncoderCommand &command);
+    bool openVideoEncoder();
+    void closeVideoEncoder(); // drain the pending packets and release the codec
 
     bool addVideoStream(AVCodecID codecID, AVDictionary **opts);
 
     bool openVideoCodec(AVCodec *codec, AVDictionary **opts);
     void openAudioCodec(AVCodec *codec);
 
-    bool doEncodeVideoFrame(const QImage &image);
+    bool doEncodeVideoFrame(AVFrame *frame); // frame is null when draining the encoder
+    bool receivePackets();
     bool doEncodeAudioFrame(); // TODO add a SamplesBuffer parameter
 
     AVFrame *allocAudioFrame(enum AVSampleFormat sampleFormat, uint64_t channelLayout, int sampleRate, int nbSamples);
     AVFrame *allocPicture(enum AVPixelFormat pixelFormat, int width, int height);
-    void imageToYuvPicture(const QImage &image, AVFrame *picture, int width, int height);
-    void fillFrameWithImageData(const QImage &image);
-    void RGBtoYUV420P(const uint8_t *bufferRGB, uint8_t *bufferYUV, uint rgbIncrement, bool swapRGB, int width, int height);
-
-    void initialize();
+    AVFrame *fillFrameWithImageData(const QImage &image);
+    AVFrame *fillFrameWithVideoFrame(const QVideoFrame &videoFrame, bool flipVertically);
+    AVFrame *fillFrame(const uint8_t * const sourceData[], const int sourceLineSize[], AVPixelFormat sourceFormat, const QSize &sourceSize);
 
-    bool encodeVideo;
-    bool encodeAudio;
+    // pooled frames, allocated once and reused while the resolution and pixel format are the same
+    bool allocFramePool(enum AVPixelFormat pixelFormat, int width, int height);
+    AVFrame *acquirePoolFrame();
+    void releaseFramePool();
 
-    int64_t videoPts; // pts (presentation time stamp) of the next frame that will be generated
-    quint64 encodedFrames;
+    std::atomic<int64_t> videoPts; // pts (presentation time stamp) of the next frame that will be generated
 
     // internal streams
-    class VideoOutputStream;
     class AudioOutputStream;
 
-    //std::unique_ptr<VideoOutputStream> videoStream;
     std::unique_ptr<AudioOutputStream> audioStream;
 
     AVCodec *codec;
-    AVCodecContext *codecContext;
-    AVFrame *frame;
-    AVFrame *tempFrame;
-    SwsContext *swsContext;
+    AVCodecContext *codecContext; // owned by the encoding thread, kept open across intervals
+    SwsContext *swsContext; // cached by sws_getCachedContext, recreated only when the image size or format change
+
+    std::vector<AVFrame *> framePool; // the encoder can keep references to the last sent frames
+    size_t nextPoolFrame;
+    static const int FRAME_POOL_SIZE = 4;
+
+    bool forceKeyFrame; // the next frame starts a new interval
+    bool firstPacketPending; // the next key frame packet is the first packet of the interval
+
+    PacketCallback packetCallback;
 
+    // requested settings, changed in the main thread and applied in the next interval
+    mutable QMutex settingsMutex;
     QSize videoResolution;
     qreal videoFrameRate;
     uint videoBitRate;
 
-    bool initialized;
-    bool startNewIntervalRequested;
-
-    QThreadPool threadPool;
+    // settings used to open the current codec context
+    QSize encoderResolution;
+    qreal encoderFrameRate;
+    uint encoderBitRate;
 };
 
-inline void FFMpegMuxer::setVideoQuality(VideoQuality quality)
-{
-    this->videoBitRate = static_cast<uint>(quality);
-}
-
-inline void FFMpegMuxer::setVideoFrameRate(qreal frameRate)
-{
-    this->videoFrameRate = frameRate;
-}
-
 inline int64_t FFMpegMuxer::getCurrentVideoPresentationTimeStamp() const
 {
     return videoPts;
 }
 
-inline void FFMpegMuxer::setVideoResolution(const QSize &resolution)
-{
-    qDebug() << "Setting video resolution to" << resolution;
-
-    this->videoResolution = resolution;
-}
-
-inline QSize FFMpegMuxer::getVideoResolution() const
-{
-    return videoResolution;
-}
-
 #endif // FFMPEGMUXER_H
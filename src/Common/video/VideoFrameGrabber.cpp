@@ -2,40 +2,79 @@
 
 #include <QPainter>
 #include <QDateTime>
+#include <QVideoSurfaceFormat>
 
 CameraFrameGrabber::CameraFrameGrabber(QObject * parent) :
-    QAbstractVideoSurface(parent)
+    QAbstractVideoSurface(parent),
+    lastFrameIsFlipped(false),
+    lastFrameIndex(0),
+    lastImageFrameIndex(0),
+    lastNotificationTime(0),
+    frameRate(10)
 {
-
+    clock.start();
 }
 
 bool CameraFrameGrabber::present(const QVideoFrame& frame)
 {
-    if (frame.isValid()) {
-
-        QVideoFrame cloneFrame(frame);
+    if (!frame.isValid())
+        return false;
 
-        if (cloneFrame.map(QAbstractVideoBuffer::ReadOnly)) {
+    {
+        QMutexLocker locker(&mutex);
 
-            QImage::Format imageFormat = QVideoFrame::imageFormatFromPixelFormat(cloneFrame.pixelFormat());
-            if (imageFormat != QImage::Format_Invalid) {
-                lastImage = QImage(cloneFrame.bits(), cloneFrame.width(), cloneFrame.height(), imageFormat)
-                        .copy(); // necessary
+        lastFrame = frame; // just a reference, the frame is mapped and converted only when used
 
 #ifdef Q_OS_WIN
-                lastImage = lastImage.mirrored(false, true);
+        lastFrameIsFlipped = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat()) != QImage::Format_Invalid; // RGB frames are bottom-up
+#else
+        lastFrameIsFlipped = surfaceFormat().scanLineDirection() == QVideoSurfaceFormat::BottomToTop;
 #endif
 
-                emit frameAvailable(lastImage);
-            }
-
-            cloneFrame.unmap();
-        }
+        lastFrameIndex++;
+    }
 
+    // frames arriving faster than the frame rate are dropped before any conversion
+    const qint64 now = clock.elapsed();
+    if (frameRate > 0 && now - lastNotificationTime < 1000/frameRate)
         return true;
+
+    lastNotificationTime = now;
+
+    emit frameAvailable();
+
+    return true;
+}
+
+QVideoFrame CameraFrameGrabber::grabFrame() const
+{
+    QMutexLocker locker(&mutex);
+    return lastFrame;
+}
+
+bool CameraFrameGrabber::isFlippedVertically() const
+{
+    QMutexLocker locker(&mutex);
+    return lastFrameIsFlipped;
+}
+
+QImage CameraFrameGrabber::grab(const QSize &size)
+{
+    QVideoFrame frame;
+    bool flipped;
+    {
+        QMutexLocker locker(&mutex);
+        if (lastImageFrameIndex == lastFrameIndex && (!size.isValid() || lastImage.size() == size))
+            return lastImage; // already converted
+
+        frame = lastFrame;
+        flipped = lastFrameIsFlipped;
+        lastImageFrameIndex = lastFrameIndex;
     }
 
-    return false;
+    lastImage = scaler.scale(frame, size, flipped);
+
+    return lastImage;
 }
 
 // +++++++++++++++++++=
@@ -5,6 +5,10 @@
 #include <QAbstractVideoSurface>
 #include <QWidget>
 #include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include "VideoScaler.h"
 
 class VideoFrameGrabber
 {
@@ -33,7 +37,12 @@ public:
     inline QList<QVideoFrame::PixelFormat>supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const override
     {
         if (type == QAbstractVideoBuffer::NoHandle) {
-             return QList<QVideoFrame::PixelFormat>()
+             return QList<QVideoFrame::PixelFormat>() // native camera formats first, encoded without RGB conversion
+                         << QVideoFrame::Format_YUV420P
+                         << QVideoFrame::Format_YV12
+                         << QVideoFrame::Format_NV12
+                         << QVideoFrame::Format_YUYV
+                         << QVideoFrame::Format_UYVY
                          << QVideoFrame::Format_RGB32
                          << QVideoFrame::Format_ARGB32
                          << QVideoFrame::Format_ARGB32_Premultiplied
@@ -46,19 +55,39 @@ public:
 
     bool present(const QVideoFrame& frame) override;
 
-    inline QImage grab(const QSize &size = QSize()) override
-    {
-        Q_UNUSED(size);
-        return lastImage;
-    }
+    // the last frame converted to RGB (used in camera preview). The converted image is cached, the frame is converted once
+    QImage grab(const QSize &size = QSize()) override;
+
+    // the last frame in the camera native pixel format, the frame buffer is shared (reference counted)
+    QVideoFrame grabFrame() const;
+
+    bool isFlippedVertically() const; // the frame lines are stored from bottom to top
+
+    void setFrameRate(uint frameRate); // frames arriving faster than the frame rate are not notified
 
 signals:
-    void frameAvailable(const QImage &frame);
+    void frameAvailable();
 
 
 private:
+    mutable QMutex mutex;
+    QVideoFrame lastFrame;
+    bool lastFrameIsFlipped;
+    quint64 lastFrameIndex;
+
     QImage lastImage;
+    quint64 lastImageFrameIndex; // the frame converted in lastImage
+
+    VideoScaler scaler;
 
+    QElapsedTimer clock;
+    qint64 lastNotificationTime;
+    uint frameRate;
 };
 
+inline void CameraFrameGrabber::setFrameRate(uint frameRate)
+{
+    this->frameRate = frameRate;
+}
+
 #endif
@@ -0,0 +1,167 @@
+#include "VideoScaler.h"
+
+#include <QDebug>
+
+#include <utility>
+
+extern "C" {
+    #include <libavutil/pixdesc.h>
+}
+
+VideoScaler::VideoScaler() :
+    swsContext(nullptr)
+{
+
+}
+
+VideoScaler::~VideoScaler()
+{
+    if (swsContext)
+        sws_freeContext(swsContext);
+}
+
+AVPixelFormat VideoScaler::getPixelFormat(QImage::Format imageFormat)
+{
+    switch (imageFormat) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return AV_PIX_FMT_RGB32; // 0xAARRGGBB in native endianness, same layout used by QImage
+    case QImage::Format_RGB888:
+        return AV_PIX_FMT_RGB24;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return AV_PIX_FMT_RGBA;
+    case QImage::Format_RGB16:
+        return AV_PIX_FMT_RGB565;
+    case QImage::Format_RGB555:
+        return AV_PIX_FMT_RGB555;
+    default:
+        return AV_PIX_FMT_NONE;
+    }
+}
+
+AVPixelFormat VideoScaler::getPixelFormat(QVideoFrame::PixelFormat pixelFormat)
+{
+    switch (pixelFormat) {
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_ARGB32:
+    case QVideoFrame::Format_ARGB32_Premultiplied:
+        return AV_PIX_FMT_RGB32;
+    case QVideoFrame::Format_RGB24:
+        return AV_PIX_FMT_RGB24;
+    case QVideoFrame::Format_RGB565:
+        return AV_PIX_FMT_RGB565;
+    case QVideoFrame::Format_RGB555:
+        return AV_PIX_FMT_RGB555;
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12: // U and V planes are swapped in getPlanes()
+        return AV_PIX_FMT_YUV420P;
+    case QVideoFrame::Format_NV12:
+        return AV_PIX_FMT_NV12;
+    case QVideoFrame::Format_NV21:
+        return AV_PIX_FMT_NV21;
+    case QVideoFrame::Format_YUYV:
+        return AV_PIX_FMT_YUYV422;
+    case QVideoFrame::Format_UYVY:
+        return AV_PIX_FMT_UYVY422;
+    default:
+        return AV_PIX_FMT_NONE;
+    }
+}
+
+bool VideoScaler::getPlanes(const QVideoFrame &mappedFrame, bool flipVertically, const uint8_t *data[4], int lineSize[4])
+{
+    const AVPixelFormat pixelFormat = getPixelFormat(mappedFrame.pixelFormat());
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(pixelFormat);
+    if (!descriptor || !mappedFrame.isMapped())
+        return false;
+
+    const int planes = qMin(mappedFrame.planeCount(), 4);
+    for (int p = 0; p < 4; ++p) {
+        data[p] = p < planes ? mappedFrame.bits(p) : nullptr;
+        lineSize[p] = p < planes ? mappedFrame.bytesPerLine(p) : 0;
+
+        if (flipVertically && data[p]) { // starting in the last line and walking backwards
+            const int planeHeight = p == 0 ? mappedFrame.height() : -((-mappedFrame.height()) >> descriptor->log2_chroma_h);
+            data[p] += (planeHeight - 1) * lineSize[p];
+            lineSize[p] = -lineSize[p];
+        }
+    }
+
+    if (mappedFrame.pixelFormat() == QVideoFrame::Format_YV12) {
+        std::swap(data[1], data[2]);
+        std::swap(lineSize[1], lineSize[2]);
+    }
+
+    return true;
+}
+
+QImage VideoScaler::scale(const QVideoFrame &videoFrame, const QSize &targetSize, bool flipVertically)
+{
+    const AVPixelFormat sourceFormat = getPixelFormat(videoFrame.pixelFormat());
+    if (sourceFormat == AV_PIX_FMT_NONE)
+        return QImage();
+
+    QVideoFrame mappedFrame(videoFrame); // shallow copy, the frame buffer is shared
+    if (!mappedFrame.map(QAbstractVideoBuffer::ReadOnly))
+        return QImage();
+
+    QImage image;
+    const uint8_t *sourceData[4];
+    int sourceLineSize[4];
+    if (getPlanes(mappedFrame, flipVertically, sourceData, sourceLineSize))
+        image = scale(sourceData, sourceLineSize, sourceFormat, mappedFrame.size(), targetSize);
+
+    mappedFrame.unmap();
+
+    return image;
+}
+
+QImage VideoScaler::scale(const QImage &image, const QSize &targetSize)
+{
+    if (image.isNull())
+        return QImage();
+
+    QImage sourceImage(image);
+    AVPixelFormat sourceFormat = getPixelFormat(sourceImage.format());
+    if (sourceFormat == AV_PIX_FMT_NONE) { // uncommon formats
+        sourceImage = sourceImage.convertToFormat(QImage::Format_RGB32);
+        sourceFormat = AV_PIX_FMT_RGB32;
+    }
+
+    const uint8_t *sourceData[1] = { sourceImage.constBits() };
+    const int sourceLineSize[1] = { sourceImage.bytesPerLine() };
+
+    return scale(sourceData, sourceLineSize, sourceFormat, sourceImage.size(), targetSize);
+}
+
+QImage VideoScaler::scale(const AVFrame *frame, const QSize &targetSize)
+{
+    if (!frame || !frame->width || !frame->height)
+        return QImage();
+
+    return scale(frame->data, frame->linesize, static_cast<AVPixelFormat>(frame->format), QSize(frame->width, frame->height), targetSize);
+}
+
+QImage VideoScaler::scale(const uint8_t * const sourceData[], const int sourceLineSize[], AVPixelFormat sourceFormat, const QSize &sourceSize, const QSize &targetSize)
+{
+    const QSize size = targetSize.isValid() && !targetSize.isEmpty() ? targetSize : sourceSize;
+
+    swsContext = sws_getCachedContext(swsContext, sourceSize.width(), sourceSize.height(), sourceFormat,
+                                      size.width(), size.height(), AV_PIX_FMT_RGB32,
+                                      SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsContext) {
+        qCritical() << "Cannot initialize the conversion context!";
+        return QImage();
+    }
+
+    // scaling directly in the image memory
+    QImage image(size, QImage::Format_RGB32);
+    uint8_t *imageData[1] = { image.bits() };
+    int imageLineSize[1] = { image.bytesPerLine() };
+    sws_scale(swsContext, sourceData, sourceLineSize, 0, sourceSize.height(), imageData, imageLineSize);
+
+    return image;
+}
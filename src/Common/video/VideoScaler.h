@@ -0,0 +1,41 @@
+#ifndef VIDEOSCALER_H
+#define VIDEOSCALER_H
+
+#include "FFMpegCommon.h"
+
+#include <QImage>
+#include <QSize>
+#include <QVideoFrame>
+
+/**
+    Color conversion and scaling using swscale (SIMD code paths). The scaler context is
+    cached and recreated only when the source or target size/format change, so each video
+    view should keep its own scaler.
+ */
+
+class VideoScaler
+{
+public:
+    VideoScaler();
+    ~VideoScaler();
+
+    // the returned images are Format_RGB32, the QImage format painted without conversions
+    QImage scale(const QImage &image, const QSize &targetSize);
+    QImage scale(const AVFrame *frame, const QSize &targetSize);
+    QImage scale(const QVideoFrame &videoFrame, const QSize &targetSize, bool flipVertically = false);
+
+    static AVPixelFormat getPixelFormat(QImage::Format imageFormat); // AV_PIX_FMT_NONE for unsupported formats
+    static AVPixelFormat getPixelFormat(QVideoFrame::PixelFormat pixelFormat);
+
+    // planes of a mapped video frame. Negative line sizes are used to flip the image without copies
+    static bool getPlanes(const QVideoFrame &mappedFrame, bool flipVertically, const uint8_t *data[4], int lineSize[4]);
+
+private:
+    SwsContext *swsContext;
+
+    QImage scale(const uint8_t * const sourceData[], const int sourceLineSize[], AVPixelFormat sourceFormat, const QSize &sourceSize, const QSize &targetSize);
+
+    Q_DISABLE_COPY(VideoScaler)
+};
+
+#endif // VIDEOSCALER_H
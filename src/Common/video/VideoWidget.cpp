@@ -46,26 +46,45 @@ void VideoWidget::setCurrentFrame(const QImage &image)
         update();
 }
 
-void VideoWidget::updateScaledImage()
+QRect VideoWidget::computeTargetRect(const QSize &frameSize) const
 {
-    QRect sourceRect = currentImage.rect();
+    if (frameSize.isEmpty())
+        return rect();
 
     qreal ratio = 1.0;
 
     bool small = height() < width();
     if (small)
-        ratio =  static_cast<float>(height())/sourceRect.height();
+        ratio =  static_cast<float>(height())/frameSize.height();
     else
-        ratio =  static_cast<float>(width())/sourceRect.width();
+        ratio =  static_cast<float>(width())/frameSize.width();
 
-    qreal targetHeight = small ? height() : currentImage.height() * ratio;
-    qreal targetWidth = small ? currentImage.width() * ratio : width();
+    qreal targetHeight = small ? height() : frameSize.height() * ratio;
+    qreal targetWidth = small ? frameSize.width() * ratio : width();
     qreal targetX = (width() - targetWidth) / 2.0;
     qreal targetY = (height() - targetHeight) / 2.0;
 
-    targetRect = QRect(targetX, targetY, targetWidth, targetHeight);
+    return QRect(targetX, targetY, targetWidth, targetHeight);
+}
 
-    scaledImage = currentImage.scaled(targetRect.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+QSize VideoWidget::getScaledFrameSize(const QSize &frameSize) const
+{
+    return computeTargetRect(frameSize).size();
+}
+
+void VideoWidget::updateScaledImage()
+{
+    targetRect = computeTargetRect(currentImage.size());
+
+    if (targetRect.isEmpty()) {
+        scaledPixmap = QPixmap();
+        return;
+    }
+
+    if (currentImage.size() == targetRect.size()) // pre-scaled frame
+        scaledPixmap = QPixmap::fromImage(currentImage);
+    else
+        scaledPixmap = QPixmap::fromImage(scaler.scale(currentImage, targetRect.size()));
 }
 
 void VideoWidget::resizeEvent(QResizeEvent *ev)
@@ -136,8 +155,8 @@ void VideoWidget::paintEvent(QPaintEvent *ev)
     static const QColor bgColor(0, 0, 0, 30);
     painter.fillRect(rect(), bgColor);
 
-    if (!currentImage.isNull() && activated) {
-        painter.drawImage(targetRect, scaledImage, scaledImage.rect());
+    if (!currentImage.isNull() && activated && !scaledPixmap.isNull()) {
+        painter.drawPixmap(targetRect.topLeft(), scaledPixmap);
     }
 
     bool paintIcon = !activated || underMouse();
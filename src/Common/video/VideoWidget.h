@@ -5,7 +5,9 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QIcon>
+#include <QPixmap>
 
+#include "VideoScaler.h"
 
 class VideoWidget : public QWidget
 {
@@ -14,7 +16,9 @@ class VideoWidget : public QWidget
 public:
     explicit VideoWidget(QWidget *parent, const QIcon &icon, bool activated = true);
 
-    void setCurrentFrame(const QImage &image);
+    void setCurrentFrame(const QImage &image); // images already in the painted size (see getScaledFrameSize) are not scaled again
+
+    QSize getScaledFrameSize(const QSize &frameSize) const; // the video decoders scale the frames straight to this size
 
     void activate(bool status);
 
@@ -41,10 +45,13 @@ protected:
 
 private:
     QImage currentImage;
-    QImage scaledImage;
+    QPixmap scaledPixmap; // cached for the current target rect, the frame is scaled again only when the widget is resized
     QRect targetRect;
     qreal imageRatio;
 
+    VideoScaler scaler;
+
+    QRect computeTargetRect(const QSize &frameSize) const;
     void updateScaledImage();
 
     bool activated;
@@ -4,10 +4,12 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QCoreApplication>
+#include <QThread>
 #include <QList>
 #include <QMap>
 #include <cmath>
 #include "log/Logging.h"
+#include "audio/TransportClock.h"
 
 using vst::VstHost;
 
@@ -21,7 +23,8 @@ VstHost *VstHost::getInstance()
 }
 
 VstHost::VstHost() :
-    blockSize(0)
+    blockSize(0),
+    audioThread(nullptr)
 {
     clearVstTimeInfoFlags();
 }
@@ -63,47 +66,89 @@ std::vector<midi::MidiMessage> VstHost::pullReceivedMidiMessages()
     return messages;
 }
 
-void VstHost::setPositionInSamples(int intervalPosition)
+void VstHost::setAudioThread()
 {
-    vstTimeInfo.samplePos = intervalPosition;
+    audioThread.store(QThread::currentThreadId(), std::memory_order_relaxed);
+}
 
-    int measure = (int)vstTimeInfo.ppqPos/vstTimeInfo.timeSigNumerator;
-    vstTimeInfo.barStartPos = measure * vstTimeInfo.timeSigNumerator;
+VstTimeInfo *VstHost::updateTimeInfo()
+{
+    // reading the transport published by the audio thread
+    const audio::TransportState transport = audio::TransportClock::getInstance()->read();
+
+    if (QThread::currentThreadId() != audioThread.load(std::memory_order_relaxed)) {
+        // plugins asking the time in GUI or plugin threads receive a copy built from the transport, vstTimeInfo is not touched
+        static thread_local VstTimeInfo timeInfoCopy;
+        timeInfoCopy = VstTimeInfo();
+        timeInfoCopy.sampleRate = transport.sampleRate > 0 ? transport.sampleRate : getSampleRate();
+        timeInfoCopy.tempo = transport.bpm > 0 ? transport.bpm : 120.0;
+        timeInfoCopy.timeSigNumerator = 4;
+        timeInfoCopy.timeSigDenominator = 4;
+        timeInfoCopy.smpteFrameRate = 1;
+        timeInfoCopy.flags = kVstTempoValid | kVstTimeSigValid;
+        if (transport.playing)
+            fillTimeInfo(timeInfoCopy, transport);
+
+        return &timeInfoCopy;
+    }
 
-    vstTimeInfo.smpteOffset = measure + 1;
+    if (!transport.playing) {
+        if (vstTimeInfo.flags & kVstTransportPlaying)
+            vstTimeInfo.flags = (vstTimeInfo.flags & ~kVstTransportPlaying) | kVstTransportChanged; // the plugins are notified when the transport stop
+        else
+            vstTimeInfo.flags &= ~kVstTransportChanged;
 
-    vstTimeInfo.samplesToNextClock = 0;
-    vstTimeInfo.timeSigDenominator = 4;
-    vstTimeInfo.timeSigDenominator = 4;
+        return &vstTimeInfo;
+    }
 
-    vstTimeInfo.nanoSeconds = QDateTime::currentDateTime().currentMSecsSinceEpoch() * 1000000.0;
+    fillTimeInfo(vstTimeInfo, transport);
 
-    // ++++++++++++++
-    // bar length in quarter notes
-    float barLengthq = (float)(4*vstTimeInfo.timeSigNumerator)/vstTimeInfo.timeSigDenominator;
+    return &vstTimeInfo;
+}
 
-    vstTimeInfo.cycleEndPos = 0; // barLengthq*loopLenght;
-    vstTimeInfo.cycleStartPos = 0;
+void VstHost::fillTimeInfo(VstTimeInfo &timeInfo, const audio::TransportState &transport)
+{
+    timeInfo.samplePos = transport.samplePosition;
+    if (transport.bpm > 0)
+        timeInfo.tempo = transport.bpm;
 
-    double dPos = vstTimeInfo.samplePos / vstTimeInfo.sampleRate;
-    vstTimeInfo.ppqPos = dPos * vstTimeInfo.tempo / 60.L;
+    int measure = (int)timeInfo.ppqPos/timeInfo.timeSigNumerator;
+    timeInfo.barStartPos = measure * timeInfo.timeSigNumerator;
 
-    int currentBar = std::floor(vstTimeInfo.ppqPos/barLengthq);
-    vstTimeInfo.barStartPos = barLengthq*currentBar;
+    timeInfo.smpteOffset = measure + 1;
 
-    vstTimeInfo.flags = 0;
-    vstTimeInfo.flags |= kVstTransportChanged;  /// indicates that play, cycle or record state has changed
-    vstTimeInfo.flags |= kVstTransportPlaying;  /// set if Host sequencer is currently playing
-    // vstTimeInfo.flags |= kVstTransportCycleActive;// = 1 << 2,	///< set if Host sequencer is in cycle mode
-    // vstTimeInfo.flags |= kVstAutomationReading;//    = 1 << 7,	///< set if automation read mode active (play parameter changes)
-    vstTimeInfo.flags |= kVstNanosValid;        /// VstTimeInfo::nanoSeconds valid
-    vstTimeInfo.flags |= kVstPpqPosValid;       /// VstTimeInfo::ppqPos valid
-    vstTimeInfo.flags |= kVstTempoValid;        /// VstTimeInfo::tempo valid
-    vstTimeInfo.flags |= kVstBarsValid;     	/// VstTimeInfo::barStartPos valid
-    // vstTimeInfo.flags |= kVstCyclePosValid;//        = 1 << 12,	///< VstTimeInfo::cycleStartPos and VstTimeInfo::cycleEndPos valid
-    vstTimeInfo.flags |= kVstTimeSigValid;      /// VstTimeInfo::timeSigNumerator and VstTimeInfo::timeSigDenominator valid
-    // vstTimeInfo.flags |= kVstSmpteValid;//           = 1 << 14,	///< VstTimeInfo::smpteOffset and VstTimeInfo::smpteFrameRate valid
-    vstTimeInfo.flags |= kVstClockValid;
+    timeInfo.samplesToNextClock = 0;
+    timeInfo.timeSigDenominator = 4;
+    timeInfo.timeSigDenominator = 4;
+
+    timeInfo.nanoSeconds = transport.timestamp;
+
+    // ++++++++++++++
+    // bar length in quarter notes
+    float barLengthq = (float)(4*timeInfo.timeSigNumerator)/timeInfo.timeSigDenominator;
+
+    timeInfo.cycleEndPos = 0; // barLengthq*loopLenght;
+    timeInfo.cycleStartPos = 0;
+
+    double dPos = timeInfo.samplePos / timeInfo.sampleRate;
+    timeInfo.ppqPos = dPos * timeInfo.tempo / 60.L;
+
+    int currentBar = std::floor(timeInfo.ppqPos/barLengthq);
+    timeInfo.barStartPos = barLengthq*currentBar;
+
+    timeInfo.flags = 0;
+    timeInfo.flags |= kVstTransportChanged;  /// indicates that play, cycle or record state has changed
+    timeInfo.flags |= kVstTransportPlaying;  /// set if Host sequencer is currently playing
+    // timeInfo.flags |= kVstTransportCycleActive;// = 1 << 2,	///< set if Host sequencer is in cycle mode
+    // timeInfo.flags |= kVstAutomationReading;//    = 1 << 7,	///< set if automation read mode active (play parameter changes)
+    timeInfo.flags |= kVstNanosValid;        /// VstTimeInfo::nanoSeconds valid
+    timeInfo.flags |= kVstPpqPosValid;       /// VstTimeInfo::ppqPos valid
+    timeInfo.flags |= kVstTempoValid;        /// VstTimeInfo::tempo valid
+    timeInfo.flags |= kVstBarsValid;     	/// VstTimeInfo::barStartPos valid
+    // timeInfo.flags |= kVstCyclePosValid;//        = 1 << 12,	///< VstTimeInfo::cycleStartPos and VstTimeInfo::cycleEndPos valid
+    timeInfo.flags |= kVstTimeSigValid;      /// VstTimeInfo::timeSigNumerator and VstTimeInfo::timeSigDenominator valid
+    // timeInfo.flags |= kVstSmpteValid;//           = 1 << 14,	///< VstTimeInfo::smpteOffset and VstTimeInfo::smpteFrameRate valid
+    timeInfo.flags |= kVstClockValid;
 }
 
 VstHost::~VstHost()
@@ -136,7 +181,7 @@ bool VstHost::tempoIsValid() const
     return this->vstTimeInfo.flags & kVstTempoValid;
 }
 
-long VSTCALLBACK VstHost::hostCallback(AEffect *effect, long opcode, long index, long value, void *ptr, float opt)
+VstIntPtr VSTCALLBACK VstHost::hostCallback(AEffect *effect, VstInt32 opcode, VstInt32 index, VstIntPtr value, void *ptr, float opt)
 {
     Q_UNUSED(effect)
     Q_UNUSED(index)
@@ -173,7 +218,7 @@ long VSTCALLBACK VstHost::hostCallback(AEffect *effect, long opcode, long index,
         return true;
 
     case audioMasterGetTime:  // 7
-        return (long)(&VstHost::getInstance()->vstTimeInfo);
+        return reinterpret_cast<VstIntPtr>(VstHost::getInstance()->updateTimeInfo()); // sample accurate, read from the transport clock
 
     case audioMasterGetCurrentProcessLevel:  // 23
         return 2L;
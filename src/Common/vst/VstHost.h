@@ -7,6 +7,12 @@
 #include "midi/MidiMessage.h"
 #include "../audio/Host.h"
 
+#include <atomic>
+
+namespace audio {
+struct TransportState;
+}
+
 namespace vst {
 
 class VstPlugin;
@@ -36,21 +42,28 @@ public:
     void setBlockSize(int blockSize) override;
     void setTempo(int bpm) override;
     void setPlayingFlag(bool playing) override;
-    void setPositionInSamples(int intervalPosition) override;
+
+    void setAudioThread(); // called by the plugins when processing, only the audio thread updates the shared time info
 
 protected:
-    static long VSTCALLBACK hostCallback(AEffect *effect, long opcode, long index, long value,
-                                         void *ptr, float opt);
+    // using the VST SDK types, 'long' is 64 bits in Linux and 32 bits in Windows 64
+    static VstIntPtr VSTCALLBACK hostCallback(AEffect *effect, VstInt32 opcode, VstInt32 index, VstIntPtr value,
+                                              void *ptr, float opt);
 
 signals:
     void pluginRequestingWindowResize(const QString &pluginName, int newWidth, int newHeight);
 
 private:
-    VstTimeInfo vstTimeInfo;
+    VstTimeInfo vstTimeInfo; // the transport is copied here only in the audio thread
 
     int blockSize;
 
+    std::atomic<Qt::HANDLE> audioThread; // the thread processing the plugins
+
     void clearVstTimeInfoFlags();
+    VstTimeInfo *updateTimeInfo(); // the plugins calling from other threads receive a copy
+
+    static void fillTimeInfo(VstTimeInfo &timeInfo, const audio::TransportState &transport);
 
     static QScopedPointer<VstHost> hostInstance;
     VstHost();
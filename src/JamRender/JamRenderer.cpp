@@ -0,0 +1,245 @@
+#include "JamRenderer.h"
+#include "audio/vorbis/VorbisDecoder.h"
+#include "audio/SamplesBufferResampler.h"
+#include "file/WaveFileWriter.h"
+#include "log/Logging.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDir>
+#include <QMap>
+#include <QSet>
+#include <QThread>
+#include <QRegExp>
+
+#include <memory>
+
+using recorder::JamRenderer;
+using recorder::JamJournal;
+using recorder::Jam;
+using audio::SamplesBuffer;
+using audio::WaveFileWriter;
+
+namespace {
+
+struct DecodeFunctor // used in QtConcurrent::blockingMapped
+{
+    typedef JamRenderer::DecodedInterval result_type;
+
+    DecodeFunctor(int sampleRate, uint samplesPerInterval) :
+        sampleRate(sampleRate),
+        samplesPerInterval(samplesPerInterval)
+    {
+    }
+
+    JamRenderer::DecodedInterval operator()(const JamRenderer::RenderJob &job) const
+    {
+        return JamRenderer::decode(job, sampleRate, samplesPerInterval);
+    }
+
+    int sampleRate;
+    uint samplesPerInterval;
+};
+
+} // namespace
+
+JamRenderer::JamRenderer(QObject *parent) :
+    QObject(parent),
+    bitDepth(16),
+    renderStems(true),
+    renderMixdown(true)
+{
+
+}
+
+QList<JamRenderer::RenderJob> JamRenderer::createRenderJobs(const Jam &jam)
+{
+    QList<RenderJob> jobs;
+    for (const JamTrack &track : jam.getJamTracks()) {
+        for (const JamAudioFile &audioFile : track.getAudioFiles()) {
+            RenderJob job;
+            job.userName = track.getUserName();
+            job.intervalIndex = audioFile.getIntervalIndex();
+            job.filePath = audioFile.getPath();
+            job.byteOffset = audioFile.getByteOffset();
+            job.byteSize = audioFile.isInTrackFile() ? audioFile.getByteSize() : 0;
+            jobs.append(job);
+        }
+    }
+    return jobs;
+}
+
+JamRenderer::DecodedInterval JamRenderer::decode(const RenderJob &job, int sampleRate, uint samplesPerInterval)
+{
+    DecodedInterval decodedInterval { job.userName, job.intervalIndex, SamplesBuffer(2, 0) };
+
+    QFile file(job.filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "Can't open the recorded interval" << job.filePath;
+        return decodedInterval;
+    }
+
+    vorbis::Decoder decoder;
+    if (job.byteSize > 0) { // interval stored in a continuous track file, decoding just the interval bytes
+        if (!file.seek(job.byteOffset)) {
+            qCritical() << "Invalid interval offset" << job.byteOffset << "in" << job.filePath;
+            return decodedInterval;
+        }
+        decoder.setInputData(file.read(job.byteSize));
+    }
+    else {
+        decoder.setInputDevice(&file);
+    }
+
+    if (!decoder.initialize()) {
+        qCritical() << "Can't decode the recorded interval" << job.filePath << job.intervalIndex;
+        return decodedInterval;
+    }
+
+    SamplesBuffer &samples = decodedInterval.samples;
+    const int MAX_SAMPLES_PER_DECODE = 4096;
+    forever {
+        const auto &decodedBuffer = decoder.decode(MAX_SAMPLES_PER_DECODE);
+        if (decodedBuffer.isEmpty())
+            break;
+
+        samples.append(decodedBuffer);
+    }
+
+    // vorbis intervals can be encoded in other sample rate (user changed the audio device while recording)
+    if (decoder.getSampleRate() > 0 && decoder.getSampleRate() != sampleRate && !samples.isEmpty()) {
+        const uint resampledLenght = static_cast<qint64>(samples.getFrameLenght()) * sampleRate / decoder.getSampleRate();
+        SamplesBufferResampler resampler;
+        samples = resampler.resample(samples, resampledLenght);
+    }
+
+    // the interval lenght is defined by bpm/bpi, the extra encoded samples are discarded
+    if (samples.getFrameLenght() > samplesPerInterval)
+        samples.setFrameLenght(samplesPerInterval);
+
+    return decodedInterval;
+}
+
+QString JamRenderer::getStemFileName(const QString &userName)
+{
+    QString fileName(userName);
+    fileName.replace(QRegExp("[\\\\/:*?\"<>|]"), "_");
+    return fileName + ".wav";
+}
+
+bool JamRenderer::render(const QString &journalFilePath, const QString &outputDir)
+{
+    std::unique_ptr<Jam> jam = JamJournal::load(journalFilePath);
+    if (!jam) {
+        qCritical() << "Invalid jam journal" << journalFilePath;
+        return false;
+    }
+
+    QList<RenderJob> jobs = createRenderJobs(*jam);
+    if (jobs.isEmpty()) {
+        qCritical() << "No recorded intervals in" << journalFilePath;
+        return false;
+    }
+
+    QDir dir(outputDir);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qCritical() << "Can't create the output folder" << outputDir;
+        return false;
+    }
+
+    const int sampleRate = jam->getSampleRate();
+    const uint samplesPerInterval = static_cast<uint>(sampleRate * jam->getIntervalsLenght());
+
+    // jobs grouped by interval, sorted by interval index
+    QMap<int, QList<RenderJob>> intervals;
+    QSet<QString> userNames;
+    for (const RenderJob &job : jobs) {
+        intervals[job.intervalIndex].append(job);
+        userNames.insert(job.userName);
+    }
+
+    const int firstInterval = intervals.firstKey();
+    const int lastInterval = intervals.lastKey();
+    const int totalIntervals = lastInterval - firstInterval + 1;
+
+    // the files length is known, so they are regular WAV files (no JUNK chunk) when smaller than 4 GB
+    const qint64 totalFrames = static_cast<qint64>(totalIntervals) * samplesPerInterval;
+
+    QMap<QString, std::shared_ptr<WaveFileWriter>> stems;
+    if (renderStems) {
+        for (const QString &userName : userNames) {
+            std::shared_ptr<WaveFileWriter> writer(new WaveFileWriter());
+            if (!writer->open(dir.absoluteFilePath(getStemFileName(userName)), 2, sampleRate, bitDepth, totalFrames))
+                return false;
+            stems.insert(userName, writer);
+        }
+    }
+
+    WaveFileWriter mixdown;
+    if (renderMixdown && !mixdown.open(dir.absoluteFilePath("mixdown.wav"), 2, sampleRate, bitDepth, totalFrames))
+        return false;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    SamplesBuffer intervalBuffer(2, samplesPerInterval);
+    SamplesBuffer mixdownBuffer(2, samplesPerInterval);
+
+    // a window of intervals is decoded in parallel, the intervals are written in order
+    const int windowSize = qMax(1, QThread::idealThreadCount());
+    for (int windowStart = firstInterval; windowStart <= lastInterval; windowStart += windowSize) {
+        const int windowEnd = qMin(windowStart + windowSize - 1, lastInterval);
+
+        QList<RenderJob> windowJobs;
+        for (auto it = intervals.lowerBound(windowStart); it != intervals.end() && it.key() <= windowEnd; ++it)
+            windowJobs.append(it.value());
+
+        QList<DecodedInterval> decodedIntervals = QtConcurrent::blockingMapped(windowJobs, DecodeFunctor(sampleRate, samplesPerInterval));
+
+        for (int intervalIndex = windowStart; intervalIndex <= windowEnd; ++intervalIndex) {
+            mixdownBuffer.zero();
+
+            QMap<QString, SamplesBuffer> userBuffers; // many channels of the same user are summed in the user stem
+            for (const DecodedInterval &decodedInterval : decodedIntervals) {
+                if (decodedInterval.intervalIndex != intervalIndex || decodedInterval.samples.isEmpty())
+                    continue;
+
+                if (!userBuffers.contains(decodedInterval.userName)) {
+                    intervalBuffer.zero();
+                    userBuffers.insert(decodedInterval.userName, intervalBuffer);
+                }
+
+                userBuffers[decodedInterval.userName].add(decodedInterval.samples);
+                mixdownBuffer.add(decodedInterval.samples);
+            }
+
+            // users without audio in this interval receive silence, the stems are always aligned
+            intervalBuffer.zero();
+            for (auto it = stems.begin(); it != stems.end(); ++it) {
+                auto userBuffer = userBuffers.constFind(it.key());
+                if (!it.value()->append(userBuffer != userBuffers.constEnd() ? userBuffer.value() : intervalBuffer))
+                    return false; // disk full?
+            }
+
+            if (renderMixdown && !mixdown.append(mixdownBuffer))
+                return false;
+
+            const int renderedIntervals = intervalIndex - firstInterval + 1;
+            const double renderedSeconds = renderedIntervals * jam->getIntervalsLenght();
+            const double elapsedSeconds = qMax<qint64>(1, clock.elapsed()) / 1000.0;
+            emit progress(renderedIntervals, totalIntervals, renderedSeconds / elapsedSeconds);
+        }
+    }
+
+    bool filesClosed = true;
+    for (auto &stem : stems)
+        filesClosed = stem->close() && filesClosed;
+
+    if (renderMixdown)
+        filesClosed = mixdown.close() && filesClosed;
+
+    qCDebug(jtJamRecorder) << "Jam rendered in" << clock.elapsed() << "ms," << totalIntervals << "intervals," << userNames.size() << "users";
+
+    return filesClosed;
+}
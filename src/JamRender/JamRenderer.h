@@ -0,0 +1,83 @@
+#ifndef _JAM_RENDERER_H_
+#define _JAM_RENDERER_H_
+
+#include "recorder/JamRecorder.h"
+#include "audio/core/SamplesBuffer.h"
+
+#include <QObject>
+#include <QString>
+#include <QList>
+
+namespace recorder {
+
+/**
+    Offline renderer for recorded jams. The jam journal is loaded, the recorded intervals are
+    decoded in parallel (a window of intervals per batch, using the global thread pool) and
+    placed in the timeline using the jam BPM/BPI, so each interval starts exactly in
+    (intervalIndex - firstIntervalIndex) * samplesPerInterval. Each user is rendered in a stem
+    WAV file and all users are summed in a mixdown WAV file. The WAV files are streamed to disk
+    interval by interval, the memory used doesn't depend on the jam lenght.
+ */
+
+class JamRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JamRenderer(QObject *parent = nullptr);
+
+    bool render(const QString &journalFilePath, const QString &outputDir);
+
+    void setBitDepth(quint8 bitDepth); // 16 or 32 bits
+    void setRenderStems(bool renderStems);
+    void setRenderMixdown(bool renderMixdown);
+
+    struct RenderJob // an interval of a recorded track
+    {
+        QString userName;
+        int intervalIndex;
+        QString filePath;
+        qint64 byteOffset; // used when the interval is stored in a continuous track file
+        qint64 byteSize;
+    };
+
+    struct DecodedInterval
+    {
+        QString userName;
+        int intervalIndex;
+        audio::SamplesBuffer samples;
+    };
+
+    static DecodedInterval decode(const RenderJob &job, int sampleRate, uint samplesPerInterval);
+
+signals:
+    // realTimeFactor is rendered audio time / elapsed time
+    void progress(int renderedIntervals, int totalIntervals, double realTimeFactor);
+
+private:
+    quint8 bitDepth;
+    bool renderStems;
+    bool renderMixdown;
+
+    static QList<RenderJob> createRenderJobs(const Jam &jam);
+    static QString getStemFileName(const QString &userName);
+};
+
+inline void JamRenderer::setBitDepth(quint8 bitDepth)
+{
+    this->bitDepth = bitDepth == 32 ? 32 : 16;
+}
+
+inline void JamRenderer::setRenderStems(bool renderStems)
+{
+    this->renderStems = renderStems;
+}
+
+inline void JamRenderer::setRenderMixdown(bool renderMixdown)
+{
+    this->renderMixdown = renderMixdown;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,81 @@
+#include "JamRenderer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTextStream>
+
+using recorder::JamRenderer;
+
+// the journal is in the jam folder (ClipSort) or in a sub folder (Reaper)
+static QString findJournalFile(const QString &path)
+{
+    QFileInfo info(path);
+    if (info.isFile())
+        return info.absoluteFilePath();
+
+    QDirIterator it(path, QStringList("jam.journal"), QDir::Files, QDirIterator::Subdirectories);
+    return it.hasNext() ? it.next() : QString();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("jamtaba-render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render the recorded jams in per user stems and a mixdown (WAV files).");
+    parser.addHelpOption();
+    parser.addPositionalArgument("jam", "Recorded jam folder or jam.journal file.");
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output folder (default is <jam folder>/render).", "folder");
+    QCommandLineOption bitDepthOption(QStringList() << "b" << "bit-depth", "WAV bit depth: 16 or 32 (float).", "bits", "16");
+    QCommandLineOption noStemsOption("no-stems", "Render only the mixdown.");
+    QCommandLineOption noMixdownOption("no-mixdown", "Render only the stems.");
+    parser.addOption(outputOption);
+    parser.addOption(bitDepthOption);
+    parser.addOption(noStemsOption);
+    parser.addOption(noMixdownOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1)
+        parser.showHelp(1);
+
+    const QString journalFile = findJournalFile(args.first());
+    if (journalFile.isEmpty()) {
+        err << "jam.journal not found in " << args.first() << endl;
+        return 1;
+    }
+
+    QString outputDir = parser.value(outputOption);
+    if (outputDir.isEmpty())
+        outputDir = QFileInfo(journalFile).absoluteDir().absoluteFilePath("render");
+
+    JamRenderer renderer;
+    renderer.setBitDepth(parser.value(bitDepthOption).toUInt());
+    renderer.setRenderStems(!parser.isSet(noStemsOption));
+    renderer.setRenderMixdown(!parser.isSet(noMixdownOption));
+
+    QObject::connect(&renderer, &JamRenderer::progress, [&out](int renderedIntervals, int totalIntervals, double realTimeFactor) {
+        out << "\rRendering interval " << renderedIntervals << "/" << totalIntervals
+            << " (" << QString::number(realTimeFactor, 'f', 1) << "x real time)" << flush;
+    });
+
+    const bool rendered = renderer.render(journalFile, outputDir);
+    out << endl;
+
+    if (!rendered) {
+        err << "Error rendering " << journalFile << endl;
+        return 1;
+    }
+
+    out << "Jam rendered in " << outputDir << endl;
+
+    return 0;
+}
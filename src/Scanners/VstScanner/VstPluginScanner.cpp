@@ -10,8 +10,12 @@
 #include <QDirIterator>
 #include <QLibrary>
 
+#include <iostream>
+#include <string>
+
 VstPluginScanner::VstPluginScanner()
-    : BaseScanner()
+    : BaseScanner(),
+      readingPluginsFromInput(false)
 {
     qCDebug(jtStandalonePluginFinder) << "Creating vst plugin scanner!";
 }
@@ -41,8 +45,42 @@ audio::PluginDescriptor VstPluginScanner::getPluginDescriptor(const QFileInfo &p
     return audio::PluginDescriptor(); // invalid descriptor
 }
 
+void VstPluginScanner::scanPlugin(const QFileInfo &pluginFileInfo)
+{
+    writeToProcessOutput("JT-Scanner-Scanning: " + pluginFileInfo.absoluteFilePath());
+    auto descriptor = getPluginDescriptor(pluginFileInfo);
+    if (descriptor.isValid())
+        writeToProcessOutput("JT-Scanner-Scan-Finished: " + descriptor.getPath());
+    else
+        writeToProcessOutput("JT-Scanner-Scan-Invalid: " + pluginFileInfo.absoluteFilePath());
+}
+
+void VstPluginScanner::scanInputPlugins()
+{
+    /**
+      The Jamtaba process write the next plugin path when the previous plugin is scanned, so many scanner
+      processes can share the plugins list. The standard input is closed when all plugins are scanned.
+    */
+
+    writeToProcessOutput("JT-Scanner-Starting");
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        QString pluginPath = QString::fromUtf8(line.c_str()).trimmed();
+        if (!pluginPath.isEmpty())
+            scanPlugin(QFileInfo(pluginPath));
+    }
+
+    writeToProcessOutput("JT-Scanner-Finished");
+}
+
 void VstPluginScanner::scan()
 {
+    if (readingPluginsFromInput) {
+        scanInputPlugins();
+        return;
+    }
+
     if (foldersToScan.isEmpty()) {
         qCInfo(jtStandalonePluginFinder) << "Folders to scan is empty!";
         return;
@@ -61,12 +99,8 @@ void VstPluginScanner::scan()
 
             if (!skipList.contains(pluginFileInfo.absoluteFilePath()))
             {
-                if (canScan(pluginFileInfo)) {
-                    writeToProcessOutput("JT-Scanner-Scanning: "+ pluginFileInfo.absoluteFilePath());
-                    auto descriptor = getPluginDescriptor(pluginFileInfo);
-                    if (descriptor.isValid())
-                        writeToProcessOutput("JT-Scanner-Scan-Finished: " + descriptor.getPath());
-                }
+                if (canScan(pluginFileInfo))
+                    scanPlugin(pluginFileInfo);
             }
         }
     }
@@ -77,17 +111,21 @@ void VstPluginScanner::scan()
 bool VstPluginScanner::canScan(const QFileInfo &pluginFileInfo) const
 {
     /**
-      In Mac VST plugins are bundles, in windows these plugins are DLLs.
+      In Mac VST plugins are bundles, in windows these plugins are DLLs and in Linux shared objects.
     */
 
+#ifdef Q_OS_LINUX
+    return pluginFileInfo.suffix() == "so";
+#else
     return pluginFileInfo.isBundle() || pluginFileInfo.suffix() == "dll";
+#endif
 }
 
 void VstPluginScanner::initialize(int argc, char *argv[])
 {
     /**
      The first arg is always the executable path. We need at least the folders strinb (2nd arg).
-     The blacklist can be empty.
+     The blacklist can be empty. When the 2nd arg is '-' the plugin paths are read from the standard input.
     */
 
     qCInfo(jtStandalonePluginFinder) << "Initializing scan folders list and blackList!";
@@ -97,6 +135,11 @@ void VstPluginScanner::initialize(int argc, char *argv[])
 
     QString foldersString = QString::fromUtf8(argv[1]);
 
+    if (foldersString == "-") {
+        readingPluginsFromInput = true;
+        return;
+    }
+
     if (!foldersString.isEmpty())
         this->foldersToScan = foldersString.split(";"); // the folders are separated using ';'
 
@@ -15,6 +15,11 @@ private:
     QStringList foldersToScan;
     QStringList skipList; // contain blackListed and cached plugins
 
+    bool readingPluginsFromInput; // the plugin paths are received in the standard input, one path per line
+
+    void scanPlugin(const QFileInfo &pluginFileInfo);
+    void scanInputPlugins();
+
     void initialize(int argc, char *argv[]) override;
 
     audio::PluginDescriptor getPluginDescriptor(const QFileInfo &pluginFile);
@@ -1,5 +1,7 @@
 #include "AudioUnitHost.h"
 
+#include "audio/TransportClock.h"
+
 #include <CoreAudio/CoreAudio.h>
 #include <QDebug>
 
@@ -55,7 +57,7 @@ void AudioUnitHost::setPlayingFlag(bool playing)
 }
 
 
-void AudioUnitHost::setPositionInSamples(int intervalPosition)
+int AudioUnitHost::getPosition() const
 {
-    this->position = intervalPosition;
+    return audio::TransportClock::getInstance()->read().samplePosition; // called in the audio thread
 }
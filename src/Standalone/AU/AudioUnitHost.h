@@ -23,7 +23,6 @@ public:
     void setBlockSize(int blockSize) override;
     void setTempo(int bpm) override;
     void setPlayingFlag(bool playing) override;
-    void setPositionInSamples(int intervalPosition) override;
 
     int getBeat() const;
     int getTempo() const;
@@ -45,14 +44,8 @@ private:
     int timeSignatureNumerator;
     int timeSignatureDenominator;
     bool playing;
-    int position;
 };
 
-inline int AudioUnitHost::getPosition() const
-{
-    return position;
-}
-
 inline bool AudioUnitHost::isPlaying() const
 {
     return playing;
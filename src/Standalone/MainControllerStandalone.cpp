@@ -9,7 +9,6 @@
 #include "vst/VstPluginFinder.h"
 #include "audio/core/PluginDescriptor.h"
 #include "NinjamController.h"
-#include "vst/VstPluginChecker.h"
 #include "gui/MainWindowStandalone.h"
 #include "ninjam/client/Service.h"
 
@@ -27,10 +26,10 @@
 
 #include <QDataStream>
 #include <QFile>
-#include <QDirIterator>
 #include <QSettings>
 #include <QtConcurrent/QtConcurrent>
 #include "log/Logging.h"
+#include "log/StartupProfiler.h"
 #include "Configurator.h"
 
 using ninjam::client::ServerInfo;
@@ -320,14 +319,7 @@ void MainControllerStandalone::setupNinjamControllerSignals()
 {
     MainController::setupNinjamControllerSignals();
 
-    connect(ninjamController.data(), SIGNAL(startProcessing(int)), this,
-            SLOT(on_ninjamStartProcessing(int)));
-}
-
-void MainControllerStandalone::on_ninjamStartProcessing(int intervalPosition)
-{
-    for (auto host : hosts)
-        host->setPositionInSamples(intervalPosition); // update the vst host time line in every audio callback.
+    // the hosts are reading the sample position from audio::TransportClock inside the audio callback
 }
 
 void MainControllerStandalone::addFoundedVstPlugin(const QString &name, const QString &path)
@@ -443,12 +435,14 @@ void MainControllerStandalone::start()
     if (!midiDriver)
     {
         qCInfo(jtCore) << "Creating midi driver...";
+        StartupSpan span("midi driver creation");
         midiDriver.reset(createMidiDriver());
     }
 
     if (!audioDriver)
     {
         qCInfo(jtCore) << "Creating audio driver...";
+        StartupSpan span("audio driver creation");
         audio::AudioDriver *driver = nullptr;
         try
         {
@@ -478,16 +472,22 @@ void MainControllerStandalone::start()
 
     if (audioDriver)
     {
+        StartupSpan span("audio driver start");
         if (!audioDriver->canBeStarted())
             useNullAudioDriver();
         audioDriver->start();
     }
 
+    StartupProfiler::getInstance()->mark("audio started");
+
     if (midiDriver)
+    {
+        StartupSpan span("midi driver start");
         midiDriver->start(settings.getMidiInputDevicesStatus());
+    }
 
     qCInfo(jtCore) << "Creating plugin finder...";
-    vstPluginFinder.reset(new audio::VSTPluginFinder());
+    vstPluginFinder.reset(new audio::VSTPluginFinder(Configurator::getInstance()->getCacheDir()));
 
 #ifdef Q_OS_MAC
 
@@ -594,11 +594,16 @@ QStringList MainControllerStandalone::getSteinbergRecommendedPaths()
 #endif
 
 #ifdef Q_OS_LINUX
-    // Steinberg VST 2.4 docs are saying nothing about default paths for VST plugins in Linux. But I see these paths
-    // in a Linux plugin documentation...
+    // Steinberg VST 2.4 docs are saying nothing about default paths for VST plugins in Linux. The
+    // VST_PATH environment variable and these paths are used by the Linux hosts and plugin installers.
 
-    vstPaths.append("~/.vst/");
-    vstPaths.append("/user/lib/vst");
+    QString vstPathVariable = QString::fromLocal8Bit(qgetenv("VST_PATH"));
+    if (!vstPathVariable.isEmpty())
+        vstPaths.append(vstPathVariable.split(":", QString::SkipEmptyParts));
+
+    vstPaths.append(QDir::homePath() + "/.vst");
+    vstPaths.append("/usr/local/lib/vst");
+    vstPaths.append("/usr/lib/vst");
 #endif
 
     return vstPaths;
@@ -625,45 +630,6 @@ void MainControllerStandalone::addDefaultPluginsScanPath()
     }
 }
 
-/**
- * We need scan plugins when plugins cache is empty OR we have new plugins in scan folders
- * This code is executed whem Jamtaba is started.
-*/
-
-bool MainControllerStandalone::vstScanIsNeeded() const
-{
-    bool vstCacheIsEmpty = settings.getVstPluginsPaths().isEmpty();
-    if (vstCacheIsEmpty)
-        return true;
-
-    // checking for new vst plugins in scan folders
-    QStringList foldersToScan = settings.getVstScanFolders();
-
-    QStringList skipList(settings.getBlackListedPlugins());
-    skipList.append(settings.getVstPluginsPaths());
-
-    bool newVstFounded = false;
-    for (const QString &scanFolder : foldersToScan)
-    {
-        QDirIterator folderIterator(scanFolder, QDir::AllDirs | QDir::NoDotAndDotDot,
-                                    QDirIterator::Subdirectories);
-        while (folderIterator.hasNext())
-        {
-            folderIterator.next(); // point to next file inside current folder
-            QString filePath = folderIterator.filePath();
-            if (!skipList.contains(filePath) && Vst::PluginChecker::isValidPluginFile(filePath))
-            {
-                newVstFounded = true;
-                break;
-            }
-        }
-        if (newVstFounded)
-            break;
-    }
-
-    return newVstFounded;
-}
-
 #ifdef Q_OS_MAC
 
 void MainControllerStandalone::initializeAudioUnitPluginsList(const QStringList &paths)
@@ -679,13 +645,39 @@ void MainControllerStandalone::initializeVstPluginsList(const QStringList &paths
     auto category = audio::PluginDescriptor::VST_Plugin;
     for (const QString &path : paths)
     {
-        QFile file(path);
-        if (file.exists())
+        QString pluginName = audio::PluginDescriptor::getVstPluginNameFromPath(path);
+        QString manufacturer = "";
+        pluginsDescriptors.append(audio::PluginDescriptor(pluginName, category, manufacturer,
+                                                          path));
+    }
+
+    // the plugin files are checked in background (slow or disconnected drives don't block the GUI thread)
+    auto watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [=]() {
+        removeMissingVstPlugins(watcher->result());
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run([paths]() {
+        QStringList missingPlugins;
+        for (const QString &path : paths) {
+            if (!QFile::exists(path))
+                missingPlugins.append(path);
+        }
+        return missingPlugins;
+    }));
+}
+
+void MainControllerStandalone::removeMissingVstPlugins(const QStringList &paths)
+{
+    for (const QString &path : paths)
+    {
+        settings.removeVstPlugin(path); // the cached plugin was removed from the disk
+
+        for (int i = pluginsDescriptors.size() - 1; i >= 0; --i)
         {
-            QString pluginName = audio::PluginDescriptor::getVstPluginNameFromPath(path);
-            QString manufacturer = "";
-            pluginsDescriptors.append(audio::PluginDescriptor(pluginName, category, manufacturer,
-                                                              path));
+            if (pluginsDescriptors.at(i).isVST() && pluginsDescriptors.at(i).getPath() == path)
+                pluginsDescriptors.removeAt(i);
         }
     }
 }
@@ -707,14 +699,14 @@ void MainControllerStandalone::scanVstPlugins(bool scanOnlyNewPlugins)
 {
     if (vstPluginFinder)
     {
-        if (!scanOnlyNewPlugins)
+        if (!scanOnlyNewPlugins) {
             pluginsDescriptors.clear();
+            vstPluginFinder->clearCache(); // all plugins are loaded again
+        }
 
-        // The skipList contains the paths for black listed plugins by default.
-        // If the parameter 'scanOnlyNewPlugins' is 'true' the cached plugins are added in the skipList too.
+        // The skipList contains the paths for black listed plugins. The plugins not changed since
+        // the last scan are not loaded again, the plugin finder is using a fingerprints cache.
         QStringList skipList(settings.getBlackListedPlugins());
-        if (scanOnlyNewPlugins)
-            skipList.append(settings.getVstPluginsPaths());
 
         QStringList foldersToScan = settings.getVstScanFolders();
         vstPluginFinder->scan(foldersToScan, skipList);
@@ -62,7 +62,6 @@ namespace controller
 
         void clearPluginsCache();
         QStringList getSteinbergRecommendedPaths();
-        bool vstScanIsNeeded() const; // plugins cache is empty OR we have new plugins in scan folders?
 
         void quit();
 
@@ -151,10 +150,9 @@ namespace controller
 
         void handleNewNinjamInterval() override;
 
-        // TODO After the big refatoration these 3 slots can be private slots
+        // TODO After the big refatoration these slots can be private slots
         void on_audioDriverStopped();
         void on_audioDriverStarted();
-        void on_ninjamStartProcessing(int intervalPosition);
 
         void addFoundedVstPlugin(const QString &name, const QString &path);
 #ifdef Q_OS_MAC
@@ -190,6 +188,7 @@ namespace controller
         Plugin *createPluginInstance(const PluginDescriptor &descriptor);
 
         void scanVstPlugins(bool scanOnlyNewVstPlugins);
+        void removeMissingVstPlugins(const QStringList &paths); // cached plugins removed from the disk
     };
 } // namespace
 
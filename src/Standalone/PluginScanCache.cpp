@@ -0,0 +1,146 @@
+#include "PluginScanCache.h"
+#include "log/Logging.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+using audio::PluginScanCache;
+using audio::PluginFingerprint;
+
+const int PluginScanCache::REVISION = 1;
+
+bool PluginFingerprint::operator==(const PluginFingerprint &other) const
+{
+    return size == other.size && lastModified == other.lastModified && hash == other.hash;
+}
+
+PluginScanCache::PluginScanCache(const QString &filePath) :
+    filePath(filePath)
+{
+
+}
+
+bool PluginScanCache::load()
+{
+    entries.clear();
+
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly))
+        return false; // the cache is created in the first scan
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["revision"].toInt() != REVISION) {
+        qCDebug(jtStandalonePluginFinder) << "Discarding the plugins scan cache, the revision is changed";
+        return false;
+    }
+
+    for (const auto &value : root["plugins"].toArray()) {
+        QJsonObject object = value.toObject();
+
+        Entry entry;
+        entry.fingerprint.size = static_cast<qint64>(object["size"].toDouble());
+        entry.fingerprint.lastModified = static_cast<qint64>(object["modified"].toDouble());
+        entry.fingerprint.hash = QByteArray::fromHex(object["hash"].toString().toLatin1());
+        entry.validPlugin = object["valid"].toBool();
+
+        QString path = object["path"].toString();
+        if (!path.isEmpty() && !entry.fingerprint.isNull())
+            entries.insert(path, entry);
+    }
+
+    return true;
+}
+
+bool PluginScanCache::save() const
+{
+    QJsonArray plugins;
+    for (auto i = entries.constBegin(); i != entries.constEnd(); ++i) {
+        QJsonObject object;
+        object["path"] = i.key();
+        object["size"] = static_cast<double>(i.value().fingerprint.size);
+        object["modified"] = static_cast<double>(i.value().fingerprint.lastModified);
+        object["hash"] = QString::fromLatin1(i.value().fingerprint.hash.toHex());
+        object["valid"] = i.value().validPlugin;
+        plugins.append(object);
+    }
+
+    QJsonObject root;
+    root["revision"] = REVISION;
+    root["plugins"] = plugins;
+
+    QSaveFile file(filePath); // the old cache is replaced only when the new file is completely written
+    if (!file.open(QFile::WriteOnly)) {
+        qCritical() << "Can't write the plugins scan cache in" << filePath;
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    return file.commit();
+}
+
+void PluginScanCache::clear()
+{
+    entries.clear();
+}
+
+void PluginScanCache::setEntries(const Entries &entries)
+{
+    this->entries = entries;
+}
+
+void PluginScanCache::addEntry(const QString &pluginPath, const PluginFingerprint &fingerprint, bool validPlugin)
+{
+    Entry entry;
+    entry.fingerprint = fingerprint;
+    entry.validPlugin = validPlugin;
+
+    entries.insert(pluginPath, entry);
+}
+
+PluginFingerprint PluginScanCache::computeFingerprint(const QString &pluginPath, const PluginFingerprint &previous)
+{
+    PluginFingerprint fingerprint;
+
+    // Mac plugins are bundles (folders), all the files inside the bundle are used
+    QStringList files;
+    QFileInfo pluginInfo(pluginPath);
+    if (pluginInfo.isDir()) {
+        QDirIterator iterator(pluginPath, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (iterator.hasNext())
+            files.append(iterator.next());
+        files.sort(); // hashing in the same order
+    }
+    else {
+        files.append(pluginPath);
+    }
+
+    for (const QString &file : files) {
+        QFileInfo info(file);
+        fingerprint.size += info.size();
+        fingerprint.lastModified = qMax(fingerprint.lastModified, info.lastModified().toMSecsSinceEpoch());
+    }
+
+    if (!previous.isNull() && previous.size == fingerprint.size && previous.lastModified == fingerprint.lastModified) {
+        fingerprint.hash = previous.hash; // not changed, avoiding read the file
+        return fingerprint;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const QString &file : files) {
+        hash.addData(file.mid(pluginPath.size()).toUtf8()); // the relative path of the bundle files
+        QFile data(file);
+        if (data.open(QFile::ReadOnly))
+            hash.addData(&data);
+    }
+    fingerprint.hash = hash.result();
+
+    return fingerprint;
+}
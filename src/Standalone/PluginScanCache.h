@@ -0,0 +1,73 @@
+#ifndef PLUGIN_SCAN_CACHE_H
+#define PLUGIN_SCAN_CACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+
+namespace audio {
+
+struct PluginFingerprint
+{
+    qint64 size = 0;
+    qint64 lastModified = 0; // msecs since epoch
+    QByteArray hash; // binary hash, the file is not scanned again when only the modification time is changed
+
+    bool isNull() const;
+    bool operator==(const PluginFingerprint &other) const;
+};
+
+/**
+    Persistent cache of the scanned plugin files, indexed by path. The files are scanned again
+    only when the fingerprint (size, modification time and binary hash) is changed. The invalid
+    files (not loaded by the scanner) are cached too, so they are not loaded in each scan.
+
+    The file contents are hashed only when the size or the modification time are changed.
+ */
+
+class PluginScanCache
+{
+public:
+    struct Entry
+    {
+        PluginFingerprint fingerprint;
+        bool validPlugin = false;
+    };
+
+    typedef QHash<QString, Entry> Entries;
+
+    explicit PluginScanCache(const QString &filePath);
+
+    bool load();
+    bool save() const;
+
+    void clear();
+
+    Entries getEntries() const;
+    void setEntries(const Entries &entries);
+
+    void addEntry(const QString &pluginPath, const PluginFingerprint &fingerprint, bool validPlugin);
+
+    // the previous fingerprint hash is reused if size and modification time are not changed
+    static PluginFingerprint computeFingerprint(const QString &pluginPath, const PluginFingerprint &previous = PluginFingerprint());
+
+private:
+    QString filePath;
+    Entries entries;
+
+    static const int REVISION;
+};
+
+inline bool PluginFingerprint::isNull() const
+{
+    return hash.isEmpty();
+}
+
+inline PluginScanCache::Entries PluginScanCache::getEntries() const
+{
+    return entries;
+}
+
+} // namespace
+
+#endif
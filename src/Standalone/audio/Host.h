@@ -18,8 +18,7 @@ public:
     virtual void setSampleRate(int sampleRate) = 0;
     virtual void setBlockSize(int blockSize) = 0;
     virtual void setTempo(int bpm) = 0;
-    virtual void setPlayingFlag(bool playing) = 0;
-    virtual void setPositionInSamples(int position) = 0;
+    virtual void setPlayingFlag(bool playing) = 0; // the position in samples is read from audio::TransportClock
 
 protected:
     std::vector<midi::MidiMessage> receivedMidiMessages;
@@ -196,8 +196,7 @@ void LocalTrackViewStandalone::updateGuiElements()
         inputNode->resetMidiActivity();
     }
 
-    if (midiPeakMeter->isVisible())
-        midiPeakMeter->update();
+    midiPeakMeter->updateActivity(); // decay, only the changed segments are repainted
 }
 
 void LocalTrackViewStandalone::reset()
@@ -5,6 +5,7 @@
 #include "gui/CrashReportDialog.h"
 #include "gui/PluginScanDialog.h"
 #include "log/Logging.h"
+#include "log/StartupProfiler.h"
 #include "audio/core/PluginDescriptor.h"
 #include "vst/VstPluginFinder.h"
 #include "vst/VstPlugin.h"
@@ -24,13 +25,16 @@ MainWindowStandalone::MainWindowStandalone(MainControllerStandalone *mainControl
     controller(mainController),
     fullScreenViewMode(false),
     pluginScanDialog(nullptr),
-    preferencesDialog(nullptr)
+    preferencesDialog(nullptr),
+    windowPainted(false),
+    pluginsListInitialized(false)
 {
     setupSignals();
 
     setupShortcuts();
 
-    initializePluginFinder();
+    // the cached plugins are checked and the scan folders are inspected after the window is showed
+    QTimer::singleShot(0, this, &MainWindowStandalone::initializePluginFinder);
 }
 
 void MainWindowStandalone::initialize()
@@ -443,25 +447,47 @@ void MainWindowStandalone::restartAudioAndMidi()
 
 void MainWindowStandalone::initializePluginFinder()
 {
-    const auto &settings = controller->getSettings();
+    {
+        StartupSpan span("plugins list");
 
-    controller->clearPluginsList();
+        const auto &settings = controller->getSettings();
 
-    controller->initializeVstPluginsList(settings.getVstPluginsPaths()); // load the cached plugins. The cache can be empty.
+        controller->clearPluginsList();
+
+        controller->initializeVstPluginsList(settings.getVstPluginsPaths()); // load the cached plugins. The cache can be empty.
 
 #ifdef Q_OS_MAC
-    controller->initializeAudioUnitPluginsList(settings.getAudioUnitsPaths());
+        controller->initializeAudioUnitPluginsList(settings.getAudioUnitsPaths());
 
-    // always checking for new AU plugins
-    controller->scanAudioUnitPlugins();
+        // always checking for new AU plugins
+        controller->scanAudioUnitPlugins();
 #endif
 
-    // checking for new plugins...
-    if (controller->vstScanIsNeeded()) { // no vsts in database cache or new plugins detected in scan folders?
+        // checking for new or changed plugins in background, the scan dialog is showed only if some plugin need be loaded
         if (settings.getVstScanFolders().isEmpty())
             controller->addDefaultPluginsScanPath();
         controller->scanOnlyNewVstPlugins();
     }
+
+    pluginsListInitialized = true;
+    finishStartupProfile();
+}
+
+void MainWindowStandalone::paintEvent(QPaintEvent *event)
+{
+    MainWindow::paintEvent(event);
+
+    if (!windowPainted) {
+        windowPainted = true;
+        StartupProfiler::getInstance()->mark("first window shown");
+        finishStartupProfile();
+    }
+}
+
+void MainWindowStandalone::finishStartupProfile()
+{
+    if (windowPainted && pluginsListInitialized)
+        StartupProfiler::getInstance()->finish();
 }
 
 void MainWindowStandalone::setGlobalPreferences(const QList<bool> &midiInputsStatus, QString audioInputDevice, QString audioOutputDevice, int firstIn, int lastIn,
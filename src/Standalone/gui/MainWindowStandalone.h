@@ -38,6 +38,7 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *) override;
+    void paintEvent(QPaintEvent *) override;
 
     TextEditorModifier *createTextEditorModifier() override;
 
@@ -95,6 +96,11 @@ private:
 
     void initializePluginFinder();
 
+    // the startup profile is finished when the window is painted and the deferred plugins list is loaded
+    bool windowPainted;
+    bool pluginsListInitialized;
+    void finishStartupProfile();
+
     // standalone settings persistency management
     void readWindowSettings(bool isWindowMaximized);
     void writeWindowSettings();
@@ -175,7 +175,11 @@ void PreferencesDialogStandalone::clearVstList()
 void PreferencesDialogStandalone::addBlackListedPlugins()
 {
     QFileDialog vstDialog(this, tr("Add Vst(s) to Black list ..."));
+#ifdef Q_OS_LINUX
+    vstDialog.setNameFilter("Shared objects(*.so)");
+#else
     vstDialog.setNameFilter("Dll(*.dll)"); // TODO in mac the extension is .vst
+#endif
 
     if (!settings->getVstScanFolders().isEmpty())
         vstDialog.setDirectory(settings->getVstScanFolders().first());
@@ -6,11 +6,14 @@
 #include "gui/MainWindowStandalone.h"
 #include "persistence/Settings.h"
 #include "log/Logging.h"
+#include "log/StartupProfiler.h"
 #include "SingleApplication/singleapplication.h"
 #include "Configurator.h"
 
 int main(int argc, char *args[])
 {
+    auto startupProfiler = StartupProfiler::getInstance(); // the startup time is measured from here
+
     QApplication::setApplicationName("JamTaba 2");
     QApplication::setApplicationVersion(APP_VERSION);
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling); // fixing issue https://github.com/elieserdejesus/JamTaba/issues/1216
@@ -29,18 +32,33 @@ int main(int argc, char *args[])
     application.setStyle("fusion"); // same visual in all platforms
 
     persistence::Settings settings;
-    settings.load();
+    {
+        StartupSpan span("settings");
+        settings.load();
+    }
 
+    qint64 spanStart = startupProfiler->elapsed();
     controller::MainControllerStandalone mainController(settings, &application);
-    mainController.start();
+    startupProfiler->addSpan("main controller creation", spanStart, startupProfiler->elapsed());
+
+    {
+        StartupSpan span("main controller start");
+        mainController.start();
+    }
 
     if (mainController.isUsingNullAudioDriver())
         QMessageBox::about(nullptr, "Fatal error!", "Jamtaba can't detect any audio device in your machine!");
 
+    spanStart = startupProfiler->elapsed();
     MainWindowStandalone mainWindow(&mainController);
     mainController.setMainWindow(&mainWindow);
+    startupProfiler->addSpan("main window creation", spanStart, startupProfiler->elapsed());
+
+    {
+        StartupSpan span("main window initialization");
+        mainWindow.initialize();
+    }
 
-    mainWindow.initialize();
     mainWindow.show();
 
 #ifdef Q_OS_WIN
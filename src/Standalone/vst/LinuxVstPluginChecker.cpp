@@ -3,6 +3,33 @@
 #include <QFileInfo>
 #include <QLibrary>
 
+#include <elf.h>
+#include <cstring>
+
+class ElfFormatChecker
+{
+public:
+    static bool isHostSharedLibrary(QFile &file); // ELF shared object compiled for the Jamtaba architecture
+    static bool exportsVstEntryPoint(QFile &file);
+
+private:
+#if defined(__LP64__)
+    typedef Elf64_Ehdr Header;
+    typedef Elf64_Shdr SectionHeader;
+    typedef Elf64_Sym Symbol;
+#else
+    typedef Elf32_Ehdr Header;
+    typedef Elf32_Shdr SectionHeader;
+    typedef Elf32_Sym Symbol;
+#endif
+
+    static bool readHeader(QFile &file, Header &header);
+    static QByteArray readSection(QFile &file, const SectionHeader &section);
+
+    static quint16 getHostMachine();
+};
+
+
 //implementation for the Linux version of this function. Another version are implemented in the MacVstPluginChecker.cpp and WindowsVstPluginChecker files.
 bool Vst::PluginChecker::isValidPluginFile(const QString &pluginPath)
 {
@@ -15,5 +42,125 @@ bool Vst::PluginChecker::isValidPluginFile(const QString &pluginPath)
     if(QFileInfo(pluginPath).fileName().contains("Jamtaba"))//avoid Jamtaba standalone loading Jamtaba plugin. This is just a basic check, when the VSt plugin is loaded the real (compiled) name of the plugin is checked again.
         return false;
 
-   return true;
+    QFile file(pluginPath);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    // the plugins folders can contain other shared libraries (used by the plugins), only the VST plugins are loaded by the scanner
+    return ElfFormatChecker::isHostSharedLibrary(file) && ElfFormatChecker::exportsVstEntryPoint(file);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+quint16 ElfFormatChecker::getHostMachine()
+{
+#if defined(__x86_64__)
+    return EM_X86_64;
+#elif defined(__i386__)
+    return EM_386;
+#elif defined(__aarch64__)
+    return EM_AARCH64;
+#elif defined(__arm__)
+    return EM_ARM;
+#else
+    return EM_NONE; // the architecture is not checked
+#endif
+}
+
+bool ElfFormatChecker::readHeader(QFile &file, Header &header)
+{
+    if (!file.seek(0))
+        return false;
+
+    return file.read(reinterpret_cast<char *>(&header), sizeof(Header)) == sizeof(Header);
+}
+
+bool ElfFormatChecker::isHostSharedLibrary(QFile &file)
+{
+    // See the ELF specification in http://refspecs.linuxfoundation.org/elf/elf.pdf
+
+    Header header;
+    if (!readHeader(file, header))
+        return false;
+
+    if (std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0)
+        return false; // not an ELF file
+
+#if defined(__LP64__)
+    const unsigned char hostClass = ELFCLASS64;
+#else
+    const unsigned char hostClass = ELFCLASS32;
+#endif
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const unsigned char hostByteOrder = ELFDATA2LSB;
+#else
+    const unsigned char hostByteOrder = ELFDATA2MSB;
+#endif
+
+    if (header.e_ident[EI_CLASS] != hostClass || header.e_ident[EI_DATA] != hostByteOrder)
+        return false; // 32 bits plugin in 64 bits Jamtaba, or vice versa
+
+    if (header.e_type != ET_DYN)
+        return false; // not a shared library
+
+    const quint16 hostMachine = getHostMachine();
+    return hostMachine == EM_NONE || header.e_machine == hostMachine;
+}
+
+QByteArray ElfFormatChecker::readSection(QFile &file, const SectionHeader &section)
+{
+    static const quint64 MAX_SECTION_SIZE = 64 * 1024 * 1024; // protection against corrupted files
+
+    if (section.sh_size > MAX_SECTION_SIZE || section.sh_offset + section.sh_size > static_cast<quint64>(file.size()))
+        return QByteArray();
+
+    if (!file.seek(section.sh_offset))
+        return QByteArray();
+
+    return file.read(section.sh_size);
+}
+
+bool ElfFormatChecker::exportsVstEntryPoint(QFile &file)
+{
+    Header header;
+    if (!readHeader(file, header))
+        return false;
+
+    if (header.e_shoff == 0 || header.e_shentsize != sizeof(SectionHeader) || header.e_shnum == 0)
+        return true; // the section headers are stripped, the entry point is checked when the plugin is loaded
+
+    if (!file.seek(header.e_shoff))
+        return false;
+
+    QByteArray sectionsData = file.read(static_cast<qint64>(header.e_shnum) * sizeof(SectionHeader));
+    if (sectionsData.size() != header.e_shnum * static_cast<int>(sizeof(SectionHeader)))
+        return false;
+
+    const SectionHeader *sections = reinterpret_cast<const SectionHeader *>(sectionsData.constData());
+
+    for (int s = 0; s < header.e_shnum; ++s) {
+        const SectionHeader &symbolsSection = sections[s];
+        if (symbolsSection.sh_type != SHT_DYNSYM || symbolsSection.sh_link >= header.e_shnum)
+            continue;
+
+        QByteArray symbols = readSection(file, symbolsSection);
+        QByteArray names = readSection(file, sections[symbolsSection.sh_link]);
+
+        const int symbolsCount = symbols.size() / sizeof(Symbol);
+        const Symbol *symbol = reinterpret_cast<const Symbol *>(symbols.constData());
+        for (int i = 0; i < symbolsCount; ++i, ++symbol) {
+            if (symbol->st_shndx == SHN_UNDEF || (symbol->st_info & 0xf) != STT_FUNC)
+                continue; // imported symbol or not a function
+
+            if (symbol->st_name >= static_cast<quint32>(names.size()))
+                continue;
+
+            const char *name = names.constData() + symbol->st_name;
+            if (std::strcmp(name, "VSTPluginMain") == 0 || std::strcmp(name, "main") == 0) // the same entry points used in VstLoader
+                return true;
+        }
+    }
+
+    return false;
 }
@@ -242,6 +242,8 @@ void VstPlugin::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &ou
         turnedOn = true;
     }
 
+    host->setAudioThread(); // the plugins can ask the time info while processing
+
     if (wantMidi) {
         fillVstEventsList(midiBuffer); // translate midiBuffer messages in VstEvents
         effect->dispatcher(effect, effProcessEvents, 0, 0, (void*)&vstMidiEvents, 0);
@@ -1,27 +1,46 @@
 #include "VstPluginFinder.h"
+#include "VstPluginChecker.h"
 
 #include <QApplication>
 #include <QLibraryInfo>
+#include <QDirIterator>
+#include <QThread>
+#include <QSet>
+#include <QtConcurrent/QtConcurrent>
 
 #include "log/Logging.h"
 
 using audio::VSTPluginFinder;
 
-VSTPluginFinder::VSTPluginFinder()
+const int VSTPluginFinder::MAX_WORKERS = 8;
+
+VSTPluginFinder::VSTPluginFinder(const QDir &cacheDir) :
+    cache(cacheDir.absoluteFilePath("vst_scan_cache.json")),
+    scanning(false),
+    canceled(false),
+    workerCrashed(false)
 {
-    //
+    cache.load();
+
+    connect(&findingWatcher, &QFutureWatcher<FoundPlugins>::finished, this, &VSTPluginFinder::startScanning);
 }
 
 VSTPluginFinder::~VSTPluginFinder()
 {
-    //
+    findingWatcher.waitForFinished();
+
+    for (auto worker : workers) {
+        disconnect(worker->process, nullptr, this, nullptr);
+        worker->process->kill();
+        worker->process->waitForFinished();
+        delete worker;
+    }
 }
 
-audio::PluginDescriptor VSTPluginFinder::getPluginDescriptor(const QFileInfo &f)
+void VSTPluginFinder::clearCache()
 {
-    QString name = audio::PluginDescriptor::getVstPluginNameFromPath(f.absoluteFilePath());
-    auto category = audio::PluginDescriptor::VST_Plugin;
-    return audio::PluginDescriptor(name, category, f.absoluteFilePath());
+    cache.clear();
+    cache.save();
 }
 
 QString VSTPluginFinder::getScannerExecutablePath() const
@@ -38,6 +57,245 @@ QString VSTPluginFinder::getScannerExecutablePath() const
     return "";
 }
 
+void VSTPluginFinder::scan(const QStringList &foldersToScan, const QStringList &skipList)
+{
+    if (scanning) {
+        qCritical() << "plugins scan is already running!";
+        return;
+    }
+
+    if (getScannerExecutablePath().isEmpty())
+        return; // scanner executable not found!
+
+    scanning = true;
+    canceled = false;
+    workerCrashed = false;
+
+    // the scan folders are walked and the plugin files hashed in a background thread
+    findingWatcher.setFuture(QtConcurrent::run(&VSTPluginFinder::findPlugins, foldersToScan, skipList, cache.getEntries()));
+}
+
+VSTPluginFinder::FoundPlugins VSTPluginFinder::findPlugins(const QStringList &foldersToScan, const QStringList &skipList, const PluginScanCache::Entries &cachedEntries)
+{
+    FoundPlugins found;
+
+    const QSet<QString> skippedPlugins = skipList.toSet();
+    QSet<QString> visitedPaths; // the scan folders can be nested
+
+    for (const QString &scanFolder : foldersToScan) {
+        QDirIterator folderIterator(scanFolder, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (folderIterator.hasNext()) {
+            folderIterator.next(); // point to next file inside current folder
+            QString pluginPath = folderIterator.fileInfo().absoluteFilePath();
+
+            if (skippedPlugins.contains(pluginPath) || visitedPaths.contains(pluginPath))
+                continue;
+
+            visitedPaths.insert(pluginPath);
+
+            if (!Vst::PluginChecker::isValidPluginFile(pluginPath))
+                continue;
+
+            const PluginScanCache::Entry cachedEntry = cachedEntries.value(pluginPath);
+            PluginFingerprint fingerprint = PluginScanCache::computeFingerprint(pluginPath, cachedEntry.fingerprint);
+
+            if (!cachedEntry.fingerprint.isNull() && fingerprint.hash == cachedEntry.fingerprint.hash) {
+                PluginScanCache::Entry entry;
+                entry.fingerprint = fingerprint; // the modification time can be changed
+                entry.validPlugin = cachedEntry.validPlugin;
+                found.cachedEntries.insert(pluginPath, entry);
+
+                if (cachedEntry.validPlugin)
+                    found.cachedPlugins.append(pluginPath);
+            }
+            else {
+                found.pluginsToScan.append(pluginPath);
+                found.fingerprints.insert(pluginPath, fingerprint);
+            }
+        }
+    }
+
+    return found;
+}
+
+void VSTPluginFinder::startScanning()
+{
+    if (canceled) {
+        finishScanning();
+        return;
+    }
+
+    FoundPlugins found = findingWatcher.result();
+
+    cache.setEntries(found.cachedEntries); // the removed plugin files are discarded
+
+    pluginsQueue = found.pluginsToScan;
+    pendingFingerprints = found.fingerprints;
+
+    if (!pluginsQueue.isEmpty())
+        emit scanStarted(); // the listeners clear the plugins list, the cached plugins are reported after this signal
+
+    for (const QString &pluginPath : found.cachedPlugins)
+        emit pluginScanFinished(audio::PluginDescriptor::getVstPluginNameFromPath(pluginPath), pluginPath);
+
+    if (pluginsQueue.isEmpty()) {
+        qCDebug(jtStandalonePluginFinder) << "No new or changed VST plugins," << found.cachedPlugins.size() << "cached plugins";
+        finishScanning();
+        return;
+    }
+
+    const int workersCount = qMin(qBound(1, QThread::idealThreadCount(), MAX_WORKERS), pluginsQueue.size());
+
+    qCDebug(jtStandalonePluginFinder) << "Scanning" << pluginsQueue.size() << "VST plugins using" << workersCount << "scanner processes," << found.cachedPlugins.size() << "cached plugins";
+
+    for (int i = 0; i < workersCount && !pluginsQueue.isEmpty(); ++i)
+        startWorker();
+}
+
+void VSTPluginFinder::startWorker()
+{
+    // execute the scanner in another process to avoid crash Jamtaba process
+    auto worker = new ScanWorker();
+    worker->process = new QProcess(this);
+    workers.append(worker);
+
+    connect(worker->process, &QProcess::readyReadStandardOutput, this, [=]() {
+        consumeWorkerOutput(worker);
+    });
+
+    connect(worker->process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+        handleWorkerFinished(worker, exitStatus == QProcess::CrashExit || exitCode != 0);
+    });
+
+    connect(worker->process, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), this, [=](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qCritical() << error << worker->process->errorString();
+            workerCrashed = true;
+            pluginsQueue.clear(); // avoid start other scanner processes
+            handleWorkerFinished(worker, false);
+        }
+    });
+
+    worker->process->start(getScannerExecutablePath(), QStringList("-")); // the plugin paths are written in the scanner standard input
+
+    if (!workers.contains(worker))
+        return; // failed to start
+
+    qCDebug(jtStandalonePluginFinder) << "Scan process started (PID:" << worker->process->processId() << ")";
+
+    scanNextPlugin(worker);
+}
+
+void VSTPluginFinder::scanNextPlugin(ScanWorker *worker)
+{
+    worker->currentPlugin.clear();
+
+    if (worker->process->state() == QProcess::NotRunning)
+        return;
+
+    if (pluginsQueue.isEmpty()) {
+        worker->process->closeWriteChannel(); // the scanner process is finished when the standard input is closed
+        return;
+    }
+
+    worker->currentPlugin = pluginsQueue.takeFirst();
+    worker->process->write(worker->currentPlugin.toUtf8() + '\n');
+}
+
+void VSTPluginFinder::consumeWorkerOutput(ScanWorker *worker)
+{
+    worker->pendingOutput.append(worker->process->readAllStandardOutput());
+
+    int lineEnd = worker->pendingOutput.indexOf('\n');
+    while (lineEnd >= 0) {
+        QString readedLine = QString::fromUtf8(worker->pendingOutput.left(lineEnd)).trimmed();
+        worker->pendingOutput.remove(0, lineEnd + 1);
+
+        if (readedLine.startsWith("JT-Scanner-Scanning:")) {
+            handleScanningStart(readedLine);
+        }
+        else if (readedLine.startsWith("JT-Scanner-Scan-Finished")) {
+            handleScanningFinished(readedLine);
+            handleScannedPlugin(worker->currentPlugin, true);
+            scanNextPlugin(worker);
+        }
+        else if (readedLine.startsWith("JT-Scanner-Scan-Invalid")) {
+            handleScannedPlugin(worker->currentPlugin, false);
+            scanNextPlugin(worker);
+        }
+
+        lineEnd = worker->pendingOutput.indexOf('\n');
+    }
+}
+
+void VSTPluginFinder::handleScannedPlugin(const QString &pluginPath, bool validPlugin)
+{
+    if (pendingFingerprints.contains(pluginPath))
+        cache.addEntry(pluginPath, pendingFingerprints.take(pluginPath), validPlugin);
+}
+
+void VSTPluginFinder::handleWorkerFinished(ScanWorker *worker, bool crashed)
+{
+    if (!workers.contains(worker))
+        return; // already finished
+
+    consumeWorkerOutput(worker); // the last scanned plugins
+
+    workers.removeOne(worker);
+
+    QString crashedPlugin;
+    if (crashed && !canceled)
+        crashedPlugin = worker->currentPlugin;
+
+    qCDebug(jtStandalonePluginFinder) << "Scan process finished, crashed:" << crashed;
+
+    worker->process->deleteLater();
+    delete worker;
+
+    if (!crashedPlugin.isEmpty()) {
+        workerCrashed = true;
+        pendingFingerprints.remove(crashedPlugin); // the plugin is black listed, not cached
+    }
+
+    if (!canceled && !pluginsQueue.isEmpty())
+        startWorker(); // the remaining plugins are scanned in a new process
+    else if (workers.isEmpty())
+        finishScanning();
+
+    if (!crashedPlugin.isEmpty())
+        emit badPluginDetected(crashedPlugin);
+}
+
+void VSTPluginFinder::finishScanning()
+{
+    scanning = false;
+
+    pluginsQueue.clear();
+    pendingFingerprints.clear(); // the not scanned plugins are scanned in the next time
+
+    cache.save();
+
+    bool finishedWithoutError = !canceled && !workerCrashed;
+
+    qCDebug(jtStandalonePluginFinder) << "VST plugins scan finished without error:" << finishedWithoutError;
+
+    emit scanFinished(finishedWithoutError);
+}
+
+void VSTPluginFinder::cancel()
+{
+    if (!scanning || canceled)
+        return;
+
+    qCDebug(jtStandalonePluginFinder) << "Terminating scan processes!";
+
+    canceled = true;
+    pluginsQueue.clear();
+
+    for (auto worker : QList<ScanWorker *>(workers))
+        worker->process->kill();
+}
+
 void VSTPluginFinder::handleScanningStart(const QString &scannedLine)
 {
     QStringList parts = scannedLine.split(": ");
@@ -47,7 +305,6 @@ void VSTPluginFinder::handleScanningStart(const QString &scannedLine)
     }
 
     QString pluginPath = parts.at(1);
-    lastScannedPlugin = pluginPath;// store the plugin path, if the scanner process crash we can add this bad plugin in the black list
     emit pluginScanStarted(pluginPath);
 }
 
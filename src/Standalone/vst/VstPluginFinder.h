@@ -2,17 +2,36 @@
 #define VSTPLUGINFINDER_H
 
 #include "PluginFinder.h"
+#include "PluginScanCache.h"
 #include "audio/core/PluginDescriptor.h"
 
+#include <QFutureWatcher>
+#include <QDir>
+
 namespace audio {
 
+/**
+    The VST plugins are scanned in many VstScanner processes running in parallel, a plugin crashing
+    a scanner is black listed and a new scanner process continue scanning the remaining plugins.
+
+    The plugin files are found in a background thread and only the new or changed files (checked using
+    the PluginScanCache) are loaded by the scanners. The unchanged plugins are reported from the cache.
+ */
+
 class VSTPluginFinder : public PluginFinder
 {
 
 public:
-    VSTPluginFinder();
+    explicit VSTPluginFinder(const QDir &cacheDir);
     virtual ~VSTPluginFinder();
 
+    void scan(const QStringList &foldersToScan, const QStringList &skipList) override; // the skipList contains the black listed plugins
+    void cancel() override;
+
+    void clearCache(); // all plugins are loaded in the next scan
+
+    bool isScanning() const;
+
 protected:
     QString getScannerExecutablePath() const override;
 
@@ -20,13 +39,52 @@ protected:
     void handleScanningFinished(const QString &scannedLine) override;
 
 private:
-    QProcess scanProcess;
-    QString lastScannedPlugin; // used to recover the last plugin path when the scanner process crash
+    struct FoundPlugins
+    {
+        QStringList pluginsToScan; // new and changed plugins
+        QHash<QString, PluginFingerprint> fingerprints; // the fingerprints of pluginsToScan
+        QStringList cachedPlugins; // valid and not changed plugins
+        PluginScanCache::Entries cachedEntries; // the cache entries for the unchanged files
+    };
+
+    struct ScanWorker
+    {
+        QProcess *process;
+        QString currentPlugin; // used to black list the plugin when the scanner process crash
+        QByteArray pendingOutput; // incomplete output line
+    };
+
+    PluginScanCache cache;
 
-    audio::PluginDescriptor getPluginDescriptor(const QFileInfo &f);
+    QFutureWatcher<FoundPlugins> findingWatcher;
 
+    QStringList pluginsQueue;
+    QHash<QString, PluginFingerprint> pendingFingerprints;
+    QList<ScanWorker *> workers;
+
+    bool scanning;
+    bool canceled;
+    bool workerCrashed;
+
+    static FoundPlugins findPlugins(const QStringList &foldersToScan, const QStringList &skipList, const PluginScanCache::Entries &cachedEntries);
+
+    void startScanning();
+    void startWorker();
+    void scanNextPlugin(ScanWorker *worker);
+    void consumeWorkerOutput(ScanWorker *worker);
+    void handleWorkerFinished(ScanWorker *worker, bool crashed);
+    void finishScanning();
+
+    void handleScannedPlugin(const QString &pluginPath, bool validPlugin);
+
+    static const int MAX_WORKERS;
 };
 
+inline bool VSTPluginFinder::isScanning() const
+{
+    return scanning;
+}
+
 } // namespace
 
 #endif // VSTPLUGINFINDER_H
@@ -6,9 +6,340 @@
 #include <QtGlobal>
 
 #include "looper/Looper.h"
+#include "looper/LooperPagePool.h"
+#include "audio/core/PeaksPyramid.h"
+
+#include <cmath>
+#include <thread>
+#include <atomic>
 
 using namespace audio;
 
+void TestLooper::recordingAcrossPageBoundaries()
+{
+    QFETCH(uint, cycleLenght);
+    QFETCH(uint, bufferSize);
+
+    auto pool = LooperPagePool::getInstance();
+    const quint64 initialUsedMemory = pool->getUsedMemory();
+
+    Looper looper;
+    looper.setLayers(1, true);
+    looper.setLayerPan(0, -1); // 100% left to not apply pan law in expected values
+
+    looper.toggleRecording();
+    startNewCycle(looper, cycleLenght);
+    Q_ASSERT(looper.isRecording());
+
+    // recording a ramp
+    for (uint position = 0; position < cycleLenght; position += bufferSize) {
+        const uint samples = qMin(bufferSize, cycleLenght - position);
+        SamplesBuffer in(1, samples);
+        for (uint s = 0; s < samples; ++s)
+            in.set(0, s, static_cast<float>(position + s));
+
+        looper.addBuffer(in);
+        SamplesBuffer out(1, samples);
+        looper.mixToBuffer(out);
+    }
+
+    startNewCycle(looper, cycleLenght); // stop recording and play
+    Q_ASSERT(looper.isPlaying());
+
+    // mono material is stored in shared pages
+    const quint64 expectedUsedMemory = LooperPagePool::getPagesCount(cycleLenght) * LooperPagePool::PAGE_SIZE_IN_BYTES;
+    QCOMPARE(pool->getUsedMemory() - initialUsedMemory, expectedUsedMemory);
+
+    for (uint position = 0; position < cycleLenght; position += bufferSize) {
+        const uint samples = qMin(bufferSize, cycleLenght - position);
+        SamplesBuffer out(1, samples);
+        looper.mixToBuffer(out);
+        for (uint s = 0; s < samples; ++s)
+            QCOMPARE(out.get(0, s), static_cast<float>(position + s));
+    }
+
+    looper.stop();
+    looper.clearLayer(0);
+    SamplesBuffer out(1, bufferSize);
+    looper.mixToBuffer(out); // the layer is cleared in the audio thread
+    QCOMPARE(pool->getUsedMemory(), initialUsedMemory); // pages are released when the layer is cleared
+}
+
+void TestLooper::recordingAcrossPageBoundaries_data()
+{
+    QTest::addColumn<uint>("cycleLenght");
+    QTest::addColumn<uint>("bufferSize");
+
+    const uint pageSize = LooperPagePool::SAMPLES_PER_PAGE;
+
+    QTest::newRow("One page, 256 samples buffer") << pageSize << uint(256);
+    QTest::newRow("Two pages and half, 256 samples buffer") << (pageSize * 2 + pageSize/2) << uint(256);
+    QTest::newRow("Two pages and half, 1000 samples buffer") << (pageSize * 2 + pageSize/2) << uint(1000);
+    QTest::newRow("Three pages plus 1 sample, 333 samples buffer") << (pageSize * 3 + 1) << uint(333);
+}
+
+void TestLooper::releasedPagesAreRecycledAfterTheAudioCycle()
+{
+    auto pool = LooperPagePool::getInstance();
+
+    pool->finishAudioCycle(); // the audio is running
+    pool->maintain();
+
+    float *page = pool->acquirePage();
+    QVERIFY(page);
+    page[0] = 1.0f;
+
+    pool->releasePage(page); // released while the audio thread is in the middle of a cycle
+    pool->maintain();
+
+    std::vector<float *> acquiredPages;
+    bool recycled = false;
+    for (uint p = 0; p < LooperPagePool::RESERVED_PAGES; ++p) {
+        float *reservedPage = pool->acquirePage();
+        if (!reservedPage)
+            break;
+
+        recycled = recycled || reservedPage == page;
+        acquiredPages.push_back(reservedPage);
+    }
+
+    for (float *acquiredPage : acquiredPages)
+        pool->releasePage(acquiredPage);
+
+    QVERIFY(!recycled);
+
+    pool->finishAudioCycle();
+    pool->maintain(); // the page released before the audio cycle end is recycled
+
+    acquiredPages.clear();
+    for (uint p = 0; p < LooperPagePool::RESERVED_PAGES * 4 && !recycled; ++p) {
+        float *reservedPage = pool->acquirePage();
+        if (!reservedPage)
+            break;
+
+        recycled = reservedPage == page;
+        acquiredPages.push_back(reservedPage);
+    }
+
+    QVERIFY(recycled);
+    QCOMPARE(page[0], 0.0f); // zeroed when recycled
+
+    for (float *acquiredPage : acquiredPages)
+        pool->releasePage(acquiredPage);
+}
+
+void TestLooper::layerPeaks()
+{
+    QFETCH(uint, cycleLenght);
+    QFETCH(uint, samplesPerPeak);
+
+    Looper looper;
+    looper.setLayers(1, true);
+    startNewCycle(looper, cycleLenght);
+
+    // a sine-like signal with negative and positive values
+    SamplesBuffer samples(1, cycleLenght);
+    for (uint s = 0; s < cycleLenght; ++s)
+        samples.set(0, s, std::sin(s * 0.001f) * ((s % 7) / 7.0f));
+
+    looper.setLayerSamples(0, samples, true);
+
+    auto peaks = looper.getLayerPeaks(0, samplesPerPeak);
+
+    const uint expectedPeaks = (cycleLenght + samplesPerPeak - 1) / samplesPerPeak;
+    QCOMPARE(static_cast<uint>(peaks.size()), expectedPeaks);
+
+    for (uint p = 0; p < expectedPeaks; ++p) {
+        float expectedPeak = 0;
+        for (uint s = p * samplesPerPeak; s < qMin((p + 1) * samplesPerPeak, cycleLenght); ++s)
+            expectedPeak = qMax(expectedPeak, qAbs(samples.get(0, s)));
+
+        QCOMPARE(peaks[p], expectedPeak);
+    }
+
+    // overdubbed material must be visible in peaks
+    looper.selectLayer(0);
+    looper.setOption(Looper::Overdub, true);
+    looper.toggleRecording();
+    startNewCycle(looper, cycleLenght);
+    Q_ASSERT(looper.isRecording());
+
+    SamplesBuffer in(1, cycleLenght);
+    in.set(0, cycleLenght - 1, 10.0f);
+    looper.addBuffer(in);
+
+    peaks = looper.getLayerPeaks(0, samplesPerPeak);
+    QCOMPARE(peaks.back(), 10.0f + samples.get(0, cycleLenght - 1));
+}
+
+void TestLooper::layerPeaks_data()
+{
+    QTest::addColumn<uint>("cycleLenght");
+    QTest::addColumn<uint>("samplesPerPeak");
+
+    const uint pageSize = LooperPagePool::SAMPLES_PER_PAGE;
+    const uint blockSize = PeaksPyramid::SAMPLES_PER_BLOCK;
+    const uint cycleLenght = pageSize * 5 + 320;
+
+    QTest::newRow("1 block per peak") << cycleLenght << blockSize;
+    QTest::newRow("3 blocks per peak") << cycleLenght << (blockSize * 3);
+    QTest::newRow("1 page per peak") << cycleLenght << pageSize;
+    QTest::newRow("Whole layer in 1 peak") << cycleLenght << (blockSize * 500);
+
+    // peaks starting or ending in the middle of a block
+    QTest::newRow("Less than 1 block per peak") << cycleLenght << (blockSize / 2 + 5);
+    QTest::newRow("100 samples per peak") << cycleLenght << 100u;
+    QTest::newRow("1000 samples per peak") << cycleLenght << 1000u;
+    QTest::newRow("Peaks crossing pages") << cycleLenght << (pageSize + blockSize + 1);
+}
+
+void TestLooper::layerPeaksWhileCycleIsGrowing()
+{
+    Looper looper;
+    looper.setLayers(1, true);
+    startNewCycle(looper, 1000);
+
+    SamplesBuffer in(1, 256);
+    for (uint s = 0; s < in.getFrameLenght(); ++s)
+        in.set(0, s, 0.5f);
+
+    looper.selectLayer(0);
+    looper.setOption(Looper::Overdub, true);
+    looper.toggleRecording();
+    startNewCycle(looper, 1000);
+    Q_ASSERT(looper.isRecording());
+    looper.addBuffer(in);
+
+    // the GUI thread reads the peaks while the audio thread grows the layer in each new cycle
+    std::atomic<bool> finished(false);
+    std::thread guiThread([&]() {
+        while (!finished)
+            looper.getLayerPeaks(0, 100);
+    });
+
+    for (uint cycleLenght = 2000; cycleLenght < 200000; cycleLenght += 1000) {
+        startNewCycle(looper, cycleLenght);
+        looper.addBuffer(in);
+    }
+
+    finished = true;
+    guiThread.join();
+
+    auto peaks = looper.getLayerPeaks(0, 100);
+    QVERIFY(!peaks.empty());
+    QVERIFY(peaks.front() > 0);
+}
+
+void TestLooper::mixingLayers()
+{
+    QFETCH(quint8, layers);
+    QFETCH(uint, bufferSize);
+    QFETCH(bool, playLockedLayersOnly);
+
+    const uint cycleLenght = LooperPagePool::SAMPLES_PER_PAGE * 2 + 100;
+    const float mainGain = 0.8f;
+    const float input = 0.25f; // the looper is mixed over the incomming audio
+
+    Looper looper(Looper::AllLayers, layers);
+    startNewCycle(looper, cycleLenght);
+    looper.setMainGain(mainGain);
+    looper.setOption(Looper::PlayLockedLayers, playLockedLayersOnly);
+
+    QList<SamplesBuffer> layersSamples;
+    for (quint8 l = 0; l < layers; ++l) {
+        layersSamples.append(createLayerSamples(l, cycleLenght));
+        looper.setLayerSamples(l, layersSamples.last(), true);
+        looper.setLayerGain(l, 0.5f + l * 0.1f);
+        looper.setLayerPan(l, (l % 2) ? 1 : -1); // 100% left or right to not apply pan law in expected values
+        looper.setLayerLockedState(l, l % 3 == 0);
+    }
+
+    const quint8 mutedLayer = 1;
+    looper.nextMuteState(mutedLayer);
+
+    looper.play();
+
+    for (uint position = 0; position < cycleLenght; position += bufferSize) {
+        const uint samples = qMin(bufferSize, cycleLenght - position);
+        SamplesBuffer out(2, samples);
+        for (uint s = 0; s < samples; ++s) {
+            out.set(0, s, input);
+            out.set(1, s, input);
+        }
+
+        looper.mixToBuffer(out);
+
+        float expectedPeaks[2] = {0, 0};
+        for (uint s = 0; s < samples; ++s) {
+            float expected[2] = {0, 0};
+            for (quint8 l = 0; l < layers; ++l) {
+                const bool mixed = l != mutedLayer && (!playLockedLayersOnly || looper.layerIsLocked(l));
+                if (!mixed)
+                    continue;
+
+                const uint channel = (l % 2) ? 1 : 0; // panned to left or right
+                expected[channel] += layersSamples.at(l).get(channel, position + s) * looper.getLayerGain(l) * mainGain;
+            }
+
+            for (uint c = 0; c < 2; ++c) {
+                QVERIFY(qAbs(out.get(c, s) - (input + expected[c])) < 0.00001f);
+                expectedPeaks[c] = qMax(expectedPeaks[c], qAbs(expected[c]));
+            }
+        }
+
+        // the looper peak is not including the incomming audio
+        const AudioPeak peak = looper.getLastPeak();
+        QVERIFY(qAbs(peak.getLeftPeak() - expectedPeaks[0]) < 0.00001f);
+        QVERIFY(qAbs(peak.getRightPeak() - expectedPeaks[1]) < 0.00001f);
+    }
+}
+
+void TestLooper::mixingLayers_data()
+{
+    QTest::addColumn<quint8>("layers");
+    QTest::addColumn<uint>("bufferSize");
+    QTest::addColumn<bool>("playLockedLayersOnly");
+
+    for (quint8 layers : {1, 2, 4, 8}) {
+        for (uint bufferSize : {64, 333, 1024}) {
+            for (bool lockedOnly : {false, true}) {
+                QString name = QString("%1 layers, buffer size %2%3").arg(layers).arg(bufferSize).arg(lockedOnly ? ", locked layers only" : "");
+                QTest::newRow(name.toUtf8().constData()) << layers << bufferSize << lockedOnly;
+            }
+        }
+    }
+}
+
+void TestLooper::mixingEightLayersBenchmark()
+{
+    const uint cycleLenght = 44100 * 4;
+    const uint bufferSize = 256;
+    const quint8 layers = 8;
+
+    Looper looper(Looper::AllLayers, layers);
+    startNewCycle(looper, cycleLenght);
+    for (quint8 l = 0; l < layers; ++l)
+        looper.setLayerSamples(l, createLayerSamples(l, cycleLenght), true);
+
+    looper.play();
+
+    SamplesBuffer out(2, bufferSize);
+    QBENCHMARK {
+        looper.mixToBuffer(out);
+    }
+}
+
+SamplesBuffer TestLooper::createLayerSamples(quint8 layer, uint samples)
+{
+    SamplesBuffer buffer(2, samples);
+    for (uint s = 0; s < samples; ++s) {
+        buffer.set(0, s, ((s + layer) % 13) / 13.0f - 0.5f);
+        buffer.set(1, s, ((s * (layer + 1)) % 7) / -7.0f);
+    }
+
+    return buffer;
+}
+
 void TestLooper::monitoringWhenPlayLockedAndHearAllAreChecked() // testing second problem described in #823
 {
     const uint cycleLenght = 2;
@@ -29,10 +360,10 @@ void TestLooper::monitoringWhenPlayLockedAndHearAllAreChecked() // testing secon
         looper.setLayerLockedState(0, true); // locking first layer
 
         // simulate pre-recorded material
-        looper.startNewCycle(cycleLenght);
+        startNewCycle(looper, cycleLenght);
         for (uint l = 0; l < layers; ++l) {
             QString value = QString::number(l+1);
-            looper.setLayerSamples(l, createBuffer(value + ", " + value));
+            looper.setLayerSamples(l, createBuffer(value + ", " + value), true);
             looper.setLayerPan(l, -1); // avoiding pan law in expected values
         }
 
@@ -44,7 +375,7 @@ void TestLooper::monitoringWhenPlayLockedAndHearAllAreChecked() // testing secon
         Q_ASSERT(looper.isWaitingToRecord());
 
         // recording
-        looper.startNewCycle(cycleLenght);
+        startNewCycle(looper, cycleLenght);
         Q_ASSERT(looper.isRecording());
         QVERIFY(looper.getCurrentLayerIndex() == 1);
 
@@ -56,7 +387,7 @@ void TestLooper::monitoringWhenPlayLockedAndHearAllAreChecked() // testing secon
 
         checkExpectedValues("3, 3", samples);
 
-        looper.startNewCycle(cycleLenght); // stop
+        startNewCycle(looper, cycleLenght); // stop
     }
 }
 
@@ -72,10 +403,10 @@ void TestLooper::hearLockedLayersOnlyAfterRecord()
     looper.setMode(Looper::Sequence);
 
     // simulate pre-recorded material in first 3 layers
-    looper.startNewCycle(cycleLenght);
+    startNewCycle(looper, cycleLenght);
     for (uint l = 0; l < layers; ++l) {
         QString value = QString::number(l+1);
-        looper.setLayerSamples(l, createBuffer(value + ", " + value));
+        looper.setLayerSamples(l, createBuffer(value + ", " + value), true);
         looper.setLayerPan(l, -1); // avoiding pan law in expected values
     }
 
@@ -93,14 +424,14 @@ void TestLooper::hearLockedLayersOnlyAfterRecord()
     looper.toggleRecording();
     Q_ASSERT(looper.isWaitingToRecord());
 
-    looper.startNewCycle(cycleLenght);
+    startNewCycle(looper, cycleLenght);
     Q_ASSERT(looper.isRecording());
     QVERIFY(looper.getCurrentLayerIndex() == 2);
 
     looper.addBuffer(createBuffer("1, 1"));
 
     // auto stop recording when start new cycle
-    looper.startNewCycle(cycleLenght);
+    startNewCycle(looper, cycleLenght);
     Q_ASSERT(looper.isPlaying());
 
     // check if the first layer content (the first locked layer) will be played correctly
@@ -110,7 +441,7 @@ void TestLooper::hearLockedLayersOnlyAfterRecord()
     looper.mixToBuffer(out);
     checkExpectedValues("1, 1", out); // checking if the first locked layer is rendered correctly
 
-    looper.startNewCycle(cycleLenght); // go to next (2nd) locked layer
+    startNewCycle(looper, cycleLenght); // go to next (2nd) locked layer
 
     out.zero();
     looper.mixToBuffer(out);
@@ -118,7 +449,7 @@ void TestLooper::hearLockedLayersOnlyAfterRecord()
 
     // checking if the next layer will be the first (because we playing locked layers only)
     out.zero();
-    looper.startNewCycle(cycleLenght); // now the current layer is 0
+    startNewCycle(looper, cycleLenght); // now the current layer is 0
     QVERIFY(looper.getCurrentLayerIndex() == static_cast<quint8>(0));
     looper.mixToBuffer(out);
     checkExpectedValues("1, 1", out);
@@ -142,8 +473,8 @@ void TestLooper::waitingToRecordAndPreserveRecordedMaterialWhenSkipRecording()
     }
 
     //create pre recorded content
-    looper.startNewCycle(2);
-    looper.setLayerSamples(0, createBuffer(preRecordedSamples));
+    startNewCycle(looper, 2);
+    looper.setLayerSamples(0, createBuffer(preRecordedSamples), true);
 
     checkExpectedValues(preRecordedSamples, looper.getLayersSamples().first());
 
@@ -158,7 +489,7 @@ void TestLooper::waitingToRecordAndPreserveRecordedMaterialWhenSkipRecording()
 
     looper.toggleRecording(); // abort recording
 
-    looper.startNewCycle(2);
+    startNewCycle(looper, 2);
     looper.togglePlay();
 
     checkExpectedValues(preRecordedSamples, out);
@@ -194,10 +525,10 @@ void TestLooper::autoPlayAfterRecording()
     looper.toggleRecording(); // waiting state
 
     for (quint8 i = 0; i < expectedRecLayers.size(); ++i) {
-        looper.startNewCycle(2);
+        startNewCycle(looper, 2);
         QCOMPARE(looper.getCurrentLayerIndex(), expectedRecLayers.at(i));
     }
-    looper.startNewCycle(2); // start a new cycle to stop recording
+    startNewCycle(looper, 2); // start a new cycle to stop recording
 
     QVERIFY(looper.isPlaying());
 }
@@ -345,7 +676,7 @@ void TestLooper::playing()
     looper.play();
 
     for (int l = 0; l < expectedCurrentLayers.size(); ++l) {
-        looper.startNewCycle(2); // start new cycle and increment layer index
+        startNewCycle(looper, 2); // start new cycle and increment layer index
         Q_ASSERT(looper.getCurrentLayerIndex() == expectedCurrentLayers.at(l));
     }
 }
@@ -396,12 +727,12 @@ void TestLooper::recordAndHearingIncommingAudioThroughLooperLayerSettings()
 
     looper.selectLayer(recLayer);
 
-    looper.startNewCycle(incommingSamples.size());
+    startNewCycle(looper, incommingSamples.size());
     looper.toggleRecording(); // waiting to record
     QVERIFY(looper.isWaitingToRecord());
 
     // recording
-    looper.startNewCycle(incommingSamples.size());
+    startNewCycle(looper, incommingSamples.size());
     Q_ASSERT(looper.isRecording());
 
     SamplesBuffer buffer = createBuffer(incommingSamples);
@@ -470,7 +801,7 @@ void TestLooper::waitingToRecordAndHearingIncommingAudioThroughLooperLayerSettin
 
     looper.setLayerGain(0, layerGain);
 
-    looper.startNewCycle(incommingSamples.size());
+    startNewCycle(looper, incommingSamples.size());
     looper.toggleRecording(); // waiting to record
     Q_ASSERT(looper.isWaitingToRecord());
 
@@ -515,7 +846,7 @@ void TestLooper::waitingToRecordAndHearingPreRecordedMaterial()
     looper.toggleRecording();
     for (int l = 0; l < layers; ++l) {
         looper.setLayerPan(l, -1); // avoiding pan law in expected values
-        looper.startNewCycle(2);
+        startNewCycle(looper, 2);
         Q_ASSERT(looper.isRecording());
         QString value(QString::number(1)); // (1, 1) in all layers
         looper.addBuffer(createBuffer(value + ", " + value));
@@ -575,7 +906,7 @@ void TestLooper::recording()
     looper.setMode(Looper::Sequence);
     looper.toggleRecording();
     for (int l = 0; l < layers; ++l) {
-        looper.startNewCycle(2);
+        startNewCycle(looper, 2);
         looper.addBuffer(createBuffer(defaultLayersContent));
     }
     looper.stop(); // finish recording default layers content
@@ -591,7 +922,7 @@ void TestLooper::recording()
     QString expectedOutputs[] = {expectedFirstOutput, expectedSecondOutput};
 
     for (int i = 0; i < 2; ++i) {
-        looper.startNewCycle(2);
+        startNewCycle(looper, 2);
         Q_ASSERT(looper.getCurrentLayerIndex() == recordingLayers.at(i));
         SamplesBuffer buffer = createBuffer(inputSamples);
         looper.addBuffer(buffer);
@@ -697,12 +1028,12 @@ void TestLooper::resizeLayersAndCopySamples()
 
     // simulate recording
     looper.toggleRecording();
-    looper.startNewCycle(initialBuffer.count());
+    startNewCycle(looper, initialBuffer.count());
     Q_ASSERT(looper.isRecording());
     looper.addBuffer(createBuffer(initialBuffer.join(',')));
 
     uint newSamplesPerCycle = finalBuffer.count();
-    looper.startNewCycle(newSamplesPerCycle); // force recording stop, resize and copy samples
+    startNewCycle(looper, newSamplesPerCycle); // force recording stop, resize and copy samples
 
     SamplesBuffer out(1, newSamplesPerCycle);
     looper.setLayerPan(0, -1); // 100% left to not apply pan law in expected values
@@ -785,7 +1116,7 @@ void TestLooper::multiBufferTest()
 
     const uint cycleLenghtInSamples = 6;
 
-    looper.startNewCycle(cycleLenghtInSamples);
+    startNewCycle(looper, cycleLenghtInSamples);
     Q_ASSERT(looper.isRecording());
 
     looper.setLayerPan(0, -1); // 100% left to not apply pan law in expected values
@@ -798,7 +1129,7 @@ void TestLooper::multiBufferTest()
     looper.mixToBuffer(outBuffer);
 
     SamplesBuffer out(1, 3);
-    looper.startNewCycle(cycleLenghtInSamples);
+    startNewCycle(looper, cycleLenghtInSamples);
 
     Q_ASSERT(looper.isPlaying());
 
@@ -810,7 +1141,7 @@ void TestLooper::multiBufferTest()
 
     out.zero();
 
-    looper.startNewCycle(cycleLenghtInSamples);
+    startNewCycle(looper, cycleLenghtInSamples);
     looper.mixToBuffer(out);
     checkExpectedValues("1, 2, 3", out);
     out.zero();
@@ -818,6 +1149,12 @@ void TestLooper::multiBufferTest()
     checkExpectedValues("4, 5, 6", out);
 }
 
+void TestLooper::startNewCycle(Looper &looper, uint samplesInCycle)
+{
+    looper.prepareLayers(samplesInCycle); // the layers storage is not allocated in the audio thread
+    looper.startNewCycle(samplesInCycle);
+}
+
 SamplesBuffer TestLooper::createBuffer(QString comaSeparatedValues)
 {
     QStringList values;
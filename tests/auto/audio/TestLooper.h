@@ -13,6 +13,20 @@ private slots:
 
     void multiBufferTest();
 
+    void recordingAcrossPageBoundaries();
+    void recordingAcrossPageBoundaries_data();
+
+    void releasedPagesAreRecycledAfterTheAudioCycle();
+
+    void layerPeaks();
+    void layerPeaks_data();
+    void layerPeaksWhileCycleIsGrowing();
+
+    void mixingLayers();
+    void mixingLayers_data();
+
+    void mixingEightLayersBenchmark();
+
     void firstUnlockedLayer();
     void firstUnlockedLayer_data();
 
@@ -47,8 +61,10 @@ private slots:
     void monitoringWhenPlayLockedAndHearAllAreChecked(); // second problem in issue #823
 
 private:
+    void startNewCycle(audio::Looper &looper, uint samplesInCycle);
     audio::SamplesBuffer createBuffer(QString comaSeparatedValues);
     void checkExpectedValues(QString comaSeparatedExpectedValues, const audio::SamplesBuffer &buffer);
+    audio::SamplesBuffer createLayerSamples(quint8 layer, uint samples);
 };
 
 Q_DECLARE_METATYPE(audio::Looper::RecordingOption)
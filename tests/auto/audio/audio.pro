@@ -13,14 +13,18 @@ HEADERS += TestSamplesBuffer.h
 HEADERS += TestLooper.h
 HEADERS += audio/core/SamplesBuffer.h
 HEADERS += audio/core/AudioPeak.h
+HEADERS += audio/core/PeaksPyramid.h
 HEADERS += looper/Looper.h
+HEADERS += looper/LooperPagePool.h
 
 SOURCES += TestSamplesBuffer.cpp
 SOURCES += TestLooper.cpp
 SOURCES += audio/core/SamplesBuffer.cpp
 SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/PeaksPyramid.cpp
 SOURCES += looper/Looper.cpp
 SOURCES += looper/LooperStates.cpp
 SOURCES += looper/LooperLayer.cpp
+SOURCES += looper/LooperPagePool.cpp
 
 SOURCES += test_Audio.cpp
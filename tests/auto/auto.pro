@@ -6,6 +6,19 @@ SUBDIRS += chat
 SUBDIRS += chords
 SUBDIRS += file
 SUBDIRS += geo
+SUBDIRS += loops
 SUBDIRS += midi
 SUBDIRS += ninjam
 SUBDIRS += persistence
+SUBDIRS += persistence/settingsWriter
+SUBDIRS += plugins
+SUBDIRS += recorder
+SUBDIRS += render
+SUBDIRS += theme
+
+# the VST tests need the Steinberg VST SDK, not distributed with Jamtaba. The same VST_SDK folder used to build Jamtaba
+exists($$PWD/../../VST_SDK/VST2_SDK/pluginterfaces/vst2.x/aeffect.h) {
+    SUBDIRS += vst
+} else {
+    message("VST_SDK not found, the VST tests are not built")
+}
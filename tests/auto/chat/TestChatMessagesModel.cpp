@@ -0,0 +1,74 @@
+#include "TestChatMessagesModel.h"
+#include "gui/chat/ChatMessagesModel.h"
+#include <QTest>
+
+static ChatMessage createMessage(const QString &author, const QString &text)
+{
+    ChatMessage message;
+    message.authorFullName = author;
+    message.text = text;
+    return message;
+}
+
+void TestChatMessagesModel::oldestMessagesAreDiscarded()
+{
+    const int maxMessages = 3;
+    ChatMessagesModel model(maxMessages, nullptr);
+
+    for (int i = 0; i < 10; ++i)
+        model.addMessage(createMessage("user@1.1.1.x", QString::number(i)));
+
+    QCOMPARE(model.rowCount(), maxMessages);
+    QCOMPARE(model.getMessage(0).text, QString("7"));
+    QCOMPARE(model.getMessage(maxMessages - 1).text, QString("9"));
+}
+
+void TestChatMessagesModel::discardedMessagesAreNotFound()
+{
+    ChatMessagesModel model(2, nullptr);
+
+    int row = model.addMessage(createMessage("user@1.1.1.x", "first"));
+    const quint64 firstMessageId = model.getMessage(row).id;
+
+    model.addMessage(createMessage("user@1.1.1.x", "second"));
+    QCOMPARE(model.findRow(firstMessageId), 0);
+
+    row = model.addMessage(createMessage("user@1.1.1.x", "third"));
+    QCOMPARE(model.findRow(firstMessageId), -1);
+    QCOMPARE(model.findRow(model.getMessage(row).id), 1);
+}
+
+void TestChatMessagesModel::removeMessagesFromUser()
+{
+    ChatMessagesModel model(10, nullptr);
+
+    model.addMessage(createMessage("blocked@1.1.1.x", "spam"));
+    model.addMessage(createMessage("user@2.2.2.x", "hello"));
+    model.addMessage(createMessage("blocked@1.1.1.x", "more spam"));
+
+    model.removeMessagesFrom("blocked@1.1.1.x");
+
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(model.getMessage(0).text, QString("hello"));
+}
+
+void TestChatMessagesModel::clearMessages()
+{
+    ChatMessagesModel model(10, nullptr);
+
+    model.addMessage(createMessage("user@1.1.1.x", "hello"));
+    model.addMessage(createMessage("user@1.1.1.x", "world"));
+
+    model.clear();
+
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void TestChatMessagesModel::linksAreRendered()
+{
+    ChatMessagesModel model(10, nullptr);
+
+    int row = model.addMessage(createMessage("user@1.1.1.x", "see http://www.jamtaba.com"));
+
+    QCOMPARE(model.data(model.index(row)).toString(), QString("see <a href=\"http://www.jamtaba.com\">http://www.jamtaba.com</a>"));
+}
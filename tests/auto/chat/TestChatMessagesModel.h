@@ -0,0 +1,18 @@
+#ifndef TEST_CHAT_MESSAGES_MODEL_H
+#define TEST_CHAT_MESSAGES_MODEL_H
+
+#include <QObject>
+
+class TestChatMessagesModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void oldestMessagesAreDiscarded();
+    void discardedMessagesAreNotFound();
+    void removeMessagesFromUser();
+    void clearMessages();
+    void linksAreRendered();
+};
+
+#endif
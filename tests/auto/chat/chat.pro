@@ -15,6 +15,8 @@ HEADERS += log/logging.h
 HEADERS += TestChatMessages.h
 HEADERS += TestChatVotingMessages.h
 HEADERS += gui/chat/NinjamChatMessageParser.h
+HEADERS += TestChatMessagesModel.h
+HEADERS += gui/chat/ChatMessagesModel.h
 
 SOURCES += log/logging.cpp
 SOURCES += TestChatMessages.cpp
@@ -25,5 +27,7 @@ SOURCES += gui/chords/ChordProgression.cpp
 SOURCES += gui/BpiUtils.cpp
 SOURCES += TestChatVotingMessages.cpp
 SOURCES += gui/chat/NinjamChatMessageParser.cpp
+SOURCES += TestChatMessagesModel.cpp
+SOURCES += gui/chat/ChatMessagesModel.cpp
 
 SOURCES += test_Chat.cpp
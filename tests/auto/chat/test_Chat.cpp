@@ -2,18 +2,21 @@
 #include <QApplication>
 #include "TestChatVotingMessages.h"
 #include "TestChatMessages.h"
+#include "TestChatMessagesModel.h"
 
 int main(int argc, char *argv[])
 {
     TestChatVotingMessages testVotingMessage;
     TestAdminCommands testAdminCommands;
     TestNinbotCommands testNinbotCommands;
+    TestChatMessagesModel testChatMessagesModel;
 
     int result = 0;
 
     result += QTest::qExec(&testVotingMessage, argc, argv);
     result += QTest::qExec(&testAdminCommands, argc, argv);
     result += QTest::qExec(&testNinbotCommands, argc, argv);
+    result += QTest::qExec(&testChatMessagesModel, argc, argv);
 
     return result > 0 ? -result : 0;
 }
@@ -1,6 +1,9 @@
 #include <QTest>
 #include "TestEmojiParser.h"
 #include "gui/chat/EmojiManager.h"
+#include "gui/chat/EmojiMatcher.h"
+
+#include <QRegularExpression>
 
 void TestEmojiParser::combinationEmojisInsideMessages_data()
 {
@@ -111,3 +114,116 @@ void TestEmojiParser::combinationEmojis()
     QString result = manager->emojify(message);
     QCOMPARE(result, emojifiedMessage);
 }
+
+void TestEmojiParser::standaloneShortcuts_data()
+{
+    QTest::addColumn<QString>("message");
+    QTest::addColumn<QString>("emojifiedMessage");
+
+    QTest::newRow("+1 in number")  << QString("bpm 120+1") << QString("bpm 120+1");
+    QTest::newRow("-10")  << QString("-10 db") << QString("-10 db");
+    QTest::newRow("-1 in word")  << QString("track-1") << QString("track-1");
+    QTest::newRow("+1 after punctuation")  << QString("nice!+1") << QString("nice!👍");
+    QTest::newRow(":-1 is not -1")  << QString(":-1") << QString("👎");
+}
+
+void TestEmojiParser::standaloneShortcuts()
+{
+    QFETCH(QString, message);
+    QFETCH(QString, emojifiedMessage);
+
+    EmojiManager manager(QString(), QString());
+
+    QCOMPARE(manager.emojify(message), emojifiedMessage);
+}
+
+void TestEmojiParser::emojiCodesAreReplacedByIcons()
+{
+    QMap<uint, QString> icons;
+    icons.insert(0x1F600, "<img src=grinning.png>");
+    icons.insert(0x2669, "<img src=quarter_note.png>");
+
+    QList<EmojiMatcher::Shortcut> shortcuts;
+    shortcuts << EmojiMatcher::Shortcut{":)", "1F600", false};
+
+    EmojiMatcher matcher;
+    matcher.build(shortcuts, icons);
+
+    QCOMPARE(matcher.emojify(QString("hi :) ") + QString::fromUcs4(U"\U0001F600") + QString(" ") + QChar(0x2669)),
+             QString("hi <img src=grinning.png> <img src=grinning.png> <img src=quarter_note.png>"));
+
+    QCOMPARE(matcher.emojify("no emojis here"), QString("no emojis here"));
+}
+
+void TestEmojiParser::emojifyBenchmark_data()
+{
+    combinationEmojisInsideMessages_data();
+}
+
+void TestEmojiParser::emojifyBenchmark()
+{
+    QFETCH(QString, message);
+
+    EmojiManager manager(QString(), QString());
+
+    QString result;
+    QBENCHMARK {
+        result = manager.emojify(message);
+    }
+}
+
+void TestEmojiParser::regexEmojifyBenchmark_data()
+{
+    combinationEmojisInsideMessages_data();
+}
+
+void TestEmojiParser::regexEmojifyBenchmark()
+{
+    QFETCH(QString, message);
+
+    QMap<QString, QString> combinations;
+    combinations.insert(":\\)",   "1F600");
+    combinations.insert(":-\\)",  "1F600");
+    combinations.insert(":\\(",   "1F61E");
+    combinations.insert(":-\\(",  "1F61E");
+    combinations.insert(";\\)",   "1F609");
+    combinations.insert(";-\\)",  "1F609");
+    combinations.insert(":-o\\)", "1F632");
+    combinations.insert(":-O\\)", "1F632");
+    combinations.insert(":p",   "1F61B");
+    combinations.insert(":-p",  "1F61B");
+    combinations.insert(":P",   "1F61B");
+    combinations.insert(":-P",  "1F61B");
+    combinations.insert(":/\\)",  "1F615");
+    combinations.insert(":-/\\)", "1F615");
+    combinations.insert(":D",   "1F603");
+    combinations.insert(":-D\\)", "1F603");
+    combinations.insert(":@",   "1F620");
+    combinations.insert(":-@\\)", "1F620");
+    combinations.insert(":y",   "1F44D");
+    combinations.insert(":n",   "1F44E");
+    combinations.insert(":\\+1",  "1F44D");
+    combinations.insert(":-1",  "1F44E");
+    combinations.insert(":\\*",   "1F617");
+    combinations.insert(":-\\*",  "1F617");
+    combinations.insert(":'\\(",  "1F622");
+    combinations.insert(":'-\\(", "1F622");
+
+    QMap<uint, QString> icons; // empty, like the EmojiManager used in emojifyBenchmark
+
+    QString result;
+    QBENCHMARK {
+        QString replacedString(message);
+        for (const QString &combination : combinations.keys())
+            replacedString.replace(QRegularExpression(combination), EmojiManager::emojiCodeToUtf8(combinations[combination]));
+
+        QVector<uint> codes = replacedString.toUcs4();
+        result.clear();
+        for (uint code : codes) {
+            if (!icons.contains(code))
+                result.append(QString::fromUcs4(&code, 1));
+            else
+                result.append(icons[code]);
+        }
+    }
+}
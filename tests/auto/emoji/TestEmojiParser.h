@@ -15,6 +15,17 @@ private slots:
     void combinationEmojisInsideMessages_data();
     void combinationEmojisInsideMessages();
 
+    void standaloneShortcuts_data();
+    void standaloneShortcuts();
+
+    void emojiCodesAreReplacedByIcons();
+
+    // benchmarks using the messages above, the regex based parser is the old implementation
+    void emojifyBenchmark_data();
+    void emojifyBenchmark();
+    void regexEmojifyBenchmark_data();
+    void regexEmojifyBenchmark();
+
 };
 
 #endif // TEST_EMOJI_PARSER
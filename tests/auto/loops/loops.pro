@@ -0,0 +1,70 @@
+QT += testlib concurrent
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = testLoops
+
+ROOT_PATH = ../../..
+
+INCLUDEPATH += .
+INCLUDEPATH += $$ROOT_PATH/src/Common
+INCLUDEPATH += $$ROOT_PATH/libs/includes/ogg
+INCLUDEPATH += $$ROOT_PATH/libs/includes/vorbis
+INCLUDEPATH += $$ROOT_PATH/libs/includes/minimp3
+
+VPATH += $$ROOT_PATH/src/Common
+
+DEFINES += OV_EXCLUDE_STATIC_CALLBACKS  #avoid ogg static callback warnings
+
+HEADERS += looper/Looper.h
+HEADERS += looper/LooperPersistence.h
+HEADERS += looper/LoopLibrary.h
+HEADERS += file/WaveFileWriter.h
+HEADERS += file/FileReaderFactory.h
+HEADERS += file/FileUtils.h
+HEADERS += log/Logging.h
+
+SOURCES += looper/Looper.cpp
+SOURCES += looper/LooperStates.cpp
+SOURCES += looper/LooperLayer.cpp
+SOURCES += looper/LooperPagePool.cpp
+SOURCES += looper/LooperPersistence.cpp
+SOURCES += looper/LoopLibrary.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/PeaksPyramid.cpp
+SOURCES += audio/vorbis/VorbisDecoder.cpp
+SOURCES += audio/vorbis/VorbisEncoder.cpp
+SOURCES += audio/Mp3Decoder.cpp
+SOURCES += audio/SamplesBufferResampler.cpp
+SOURCES += audio/Resampler.cpp
+SOURCES += file/WaveFileWriter.cpp
+SOURCES += file/WaveFileReader.cpp
+SOURCES += file/OggFileReader.cpp
+SOURCES += file/Mp3FileReader.cpp
+SOURCES += file/FileReaderFactory.cpp
+SOURCES += file/FileUtils.cpp
+SOURCES += persistence/CacheHeader.cpp
+SOURCES += log/logging.cpp
+SOURCES += test_Loops.cpp
+
+win32{
+    !contains(QMAKE_TARGET.arch, x86_64) {
+        LIBS_PATH = "static/win32-msvc"
+    } else {
+        LIBS_PATH = "static/win64-msvc"
+    }
+}
+
+macx:LIBS_PATH = "static/mac64"
+
+linux{
+    contains(QMAKE_HOST.arch, x86_64) {
+        LIBS_PATH = "static/linux64"
+    } else {
+        LIBS_PATH = "static/linux32"
+    }
+}
+
+LIBS += -L$$PWD/$$ROOT_PATH/libs/$$LIBS_PATH -lminimp3 -lvorbisfile -lvorbisenc -lvorbis -logg
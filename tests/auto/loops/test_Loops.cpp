@@ -0,0 +1,272 @@
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QtTest/QtTest>
+#include "looper/Looper.h"
+#include "looper/LooperPersistence.h"
+#include "looper/LoopLibrary.h"
+
+using audio::Looper;
+using audio::LoopSaver;
+using audio::LoopLoader;
+using audio::LoopInfo;
+using audio::LoopLibrary;
+using audio::LoopLibraryEntry;
+using audio::SamplesBuffer;
+
+class TestLoops: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void saveAndLoad();
+    void canceledSaveKeepsPreviousLoop();
+    void failedSaveReturnsFalse();
+    void canceledLoadKeepsLooperContent();
+    void libraryIndexIsWrittenAfterChanges();
+    void libraryIndexIsNotRewrittenWhenLoaded();
+
+private:
+    static const uint SAMPLE_RATE = 44100;
+    static const uint CYCLE_LENGHT = 100000; // more than one chunk per layer
+
+    static SamplesBuffer createSamples(float value);
+    static void fillLooper(Looper &looper, float firstLayerValue, float secondLayerValue);
+    static void processAudioCycle(Looper &looper);
+    static bool save(const QString &savePath, Looper &looper, bool cancelSaving = false);
+    static float getLayerValue(const Looper &looper, int layer, uint sample);
+    static QStringList getTemporaryFiles(const QString &loopPath);
+    static bool waitLibraryIndexWrite(const LoopLibrary &library);
+};
+
+SamplesBuffer TestLoops::createSamples(float value)
+{
+    SamplesBuffer samples(2, CYCLE_LENGHT);
+    for (uint s = 0; s < CYCLE_LENGHT; ++s) {
+        samples.set(0, s, value);
+        samples.set(1, s, -value);
+    }
+
+    return samples;
+}
+
+void TestLoops::fillLooper(Looper &looper, float firstLayerValue, float secondLayerValue)
+{
+    looper.setLayers(2, true);
+    looper.startNewCycle(CYCLE_LENGHT);
+    looper.setLayerSamples(0, createSamples(firstLayerValue), true);
+    looper.setLayerSamples(1, createSamples(secondLayerValue), true);
+}
+
+void TestLoops::processAudioCycle(Looper &looper)
+{
+    SamplesBuffer out(2, 256);
+    looper.mixToBuffer(out); // the loaded layers are published in the audio thread
+}
+
+bool TestLoops::save(const QString &savePath, Looper &looper, bool cancelSaving)
+{
+    LoopSaver saver(savePath, &looper);
+    saver.save("loop", 120, 16, false, 0.0f, SAMPLE_RATE, 16);
+
+    if (cancelSaving)
+        saver.cancel();
+
+    return saver.finishSaving();
+}
+
+float TestLoops::getLayerValue(const Looper &looper, int layer, uint sample)
+{
+    const QList<SamplesBuffer> layers = looper.getLayersSamples();
+    if (layer >= layers.size() || sample >= layers.at(layer).getFrameLenght())
+        return 0.0f;
+
+    return layers.at(layer).get(0, sample);
+}
+
+QStringList TestLoops::getTemporaryFiles(const QString &loopPath)
+{
+    return QDir(loopPath).entryList(QStringList() << "*.part", QDir::Files);
+}
+
+void TestLoops::saveAndLoad()
+{
+    QTemporaryDir dir;
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+
+    QVERIFY(save(dir.path(), looper));
+    QVERIFY(QFile::exists(dir.filePath("loop.json")));
+    QVERIFY(QFile::exists(dir.filePath("loop/layer_0.wav")));
+    QVERIFY(QFile::exists(dir.filePath("loop/layer_1.wav")));
+    QVERIFY(getTemporaryFiles(dir.filePath("loop")).isEmpty());
+
+    const LoopInfo loopInfo = LoopLoader::loadLoopInfo(dir.filePath("loop.json"));
+    QVERIFY(loopInfo.isValid());
+    QCOMPARE(loopInfo.getLayersCount(), quint8(2));
+    QCOMPARE(loopInfo.getSampleRate(), quint32(SAMPLE_RATE));
+
+    Looper loadedLooper;
+    loadedLooper.startNewCycle(CYCLE_LENGHT);
+
+    LoopLoader loader(dir.path());
+    QFuture<SamplesBuffer> future = loader.load(loopInfo, SAMPLE_RATE, CYCLE_LENGHT);
+    future.waitForFinished();
+    QCOMPARE(future.resultCount(), 2);
+    QCOMPARE(future.resultAt(0).getFrameLenght(), CYCLE_LENGHT);
+
+    loader.finishLoading(&loadedLooper);
+    processAudioCycle(loadedLooper);
+
+    QCOMPARE(loadedLooper.getLoopName(), QString("loop"));
+    QVERIFY(!loadedLooper.isChanged());
+
+    const float tolerance = 1.0f / 16384; // 16 bits
+    QVERIFY(qAbs(getLayerValue(loadedLooper, 0, 0) - 0.5f) < tolerance);
+    QVERIFY(qAbs(getLayerValue(loadedLooper, 0, CYCLE_LENGHT - 1) - 0.5f) < tolerance); // the last chunk
+    QVERIFY(qAbs(getLayerValue(loadedLooper, 1, CYCLE_LENGHT / 2) - 0.25f) < tolerance);
+}
+
+void TestLoops::canceledSaveKeepsPreviousLoop()
+{
+    QTemporaryDir dir;
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+    QVERIFY(save(dir.path(), looper));
+
+    const QByteArray previousLayer = [&]() {
+        QFile file(dir.filePath("loop/layer_0.wav"));
+        return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+    }();
+    QVERIFY(!previousLayer.isEmpty());
+
+    fillLooper(looper, 0.1f, 0.1f);
+    QVERIFY(!save(dir.path(), looper, true));
+
+    QFile layerFile(dir.filePath("loop/layer_0.wav"));
+    QVERIFY(layerFile.open(QFile::ReadOnly));
+    QCOMPARE(layerFile.readAll(), previousLayer);
+    QVERIFY(getTemporaryFiles(dir.filePath("loop")).isEmpty());
+}
+
+void TestLoops::failedSaveReturnsFalse()
+{
+    QTemporaryDir dir;
+
+    // a directory with the layer file name, the saved layer can't replace it
+    QVERIFY(QDir(dir.path()).mkpath("loop/layer_0.wav"));
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+    QVERIFY(!save(dir.path(), looper));
+
+    QVERIFY(!QFile::exists(dir.filePath("loop.json")));
+    QVERIFY(getTemporaryFiles(dir.filePath("loop")).isEmpty());
+}
+
+void TestLoops::canceledLoadKeepsLooperContent()
+{
+    QTemporaryDir dir;
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+    QVERIFY(save(dir.path(), looper));
+
+    Looper otherLooper;
+    fillLooper(otherLooper, 0.1f, 0.1f);
+
+    LoopLoader loader(dir.path());
+    loader.load(LoopLoader::loadLoopInfo(dir.filePath("loop.json")), SAMPLE_RATE, CYCLE_LENGHT);
+    loader.cancel();
+    loader.finishLoading(&otherLooper);
+    processAudioCycle(otherLooper);
+
+    QVERIFY(qAbs(getLayerValue(otherLooper, 0, 0) - 0.1f) < 0.0001f);
+    QVERIFY(otherLooper.getLoopName().isEmpty());
+}
+
+bool TestLoops::waitLibraryIndexWrite(const LoopLibrary &library)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (library.isWritingIndex() && timer.elapsed() < LoopLibrary::INDEX_WRITE_DELAY * 5)
+        QTest::qWait(50);
+
+    return !library.isWritingIndex();
+}
+
+void TestLoops::libraryIndexIsWrittenAfterChanges()
+{
+    QTemporaryDir loopsDir;
+    QTemporaryDir cacheDir;
+    const QString indexFilePath = QDir(cacheDir.path()).absoluteFilePath("loops_library.bin");
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+    QVERIFY(save(loopsDir.path(), looper));
+
+    {
+        LoopLibrary library(QDir(cacheDir.path()));
+        QSignalSpy changedSpy(&library, &LoopLibrary::libraryChanged);
+
+        library.setLoopsDir(loopsDir.path());
+        QVERIFY(changedSpy.wait(5000));
+        QCOMPARE(library.getLoops(120).size(), 1);
+
+        // the index is written in background, the library is still alive
+        QVERIFY(waitLibraryIndexWrite(library));
+        QVERIFY(QFile::exists(indexFilePath));
+    }
+
+    // the index is loaded without indexing the loops folder again
+    LoopLibrary library(QDir(cacheDir.path()));
+    const QList<LoopLibraryEntry> loops = library.getAllLoops();
+    QCOMPARE(loops.size(), 1);
+    QCOMPARE(loops.first().getLoopInfo().getName(), QString("loop"));
+    QCOMPARE(loops.first().getLoopInfo().getBpm(), quint32(120));
+    QCOMPARE(loops.first().getLoopInfo().getLayersCount(), quint8(2));
+    QCOMPARE(loops.first().getThumbnail().size(), LoopLibrary::THUMBNAIL_PEAKS);
+    QCOMPARE(library.getLoops(120).size(), 1);
+    QVERIFY(library.getLoops(90).isEmpty());
+}
+
+void TestLoops::libraryIndexIsNotRewrittenWhenLoaded()
+{
+    QTemporaryDir loopsDir;
+    QTemporaryDir cacheDir;
+    const QString indexFilePath = QDir(cacheDir.path()).absoluteFilePath("loops_library.bin");
+
+    Looper looper;
+    fillLooper(looper, 0.5f, 0.25f);
+    QVERIFY(save(loopsDir.path(), looper));
+
+    {
+        LoopLibrary library(QDir(cacheDir.path()));
+        QSignalSpy changedSpy(&library, &LoopLibrary::libraryChanged);
+        library.setLoopsDir(loopsDir.path());
+        QVERIFY(changedSpy.wait(5000));
+    } // the pending index write is finished in the destructor
+
+    QVERIFY(QFile::exists(indexFilePath));
+    const QDateTime lastModified = QFileInfo(indexFilePath).lastModified();
+
+    LoopLibrary library(QDir(cacheDir.path()));
+    QCOMPARE(library.getAllLoops().size(), 1);
+    QVERIFY(!library.isWritingIndex());
+    QCOMPARE(QFileInfo(indexFilePath).lastModified(), lastModified);
+}
+
+int main(int argc, char *argv[])
+{
+    TestLoops test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_Loops.moc"
@@ -0,0 +1,92 @@
+#include "TestUploadBitrateController.h"
+#include "UploadBitrateController.h"
+#include <QTest>
+
+void TestUploadBitrateController::congestedQueueDecreaseQuality()
+{
+    UploadBitrateController controller;
+
+    const qint64 uploadRate = 16000; // bytes per second
+
+    QCOMPARE(controller.update(0, uploadRate), UploadBitrateController::KeepQuality);
+    QCOMPARE(controller.getLevel(), 0);
+
+    // 2 seconds waiting in the send queue
+    QCOMPARE(controller.update(uploadRate * 2, uploadRate), UploadBitrateController::DecreaseQuality);
+    QCOMPARE(controller.getLevel(), 1);
+    QVERIFY(controller.isQualityReduced());
+
+    // nothing uploaded is congestion too
+    QCOMPARE(controller.update(1024, 0), UploadBitrateController::DecreaseQuality);
+
+    for (int i = 0; i < 10; ++i)
+        controller.update(uploadRate * 2, uploadRate);
+
+    QCOMPARE(controller.getLevel(), static_cast<int>(UploadBitrateController::MAX_LEVEL));
+}
+
+void TestUploadBitrateController::growingQueueDecreaseQuality()
+{
+    UploadBitrateController controller;
+
+    const qint64 uploadRate = 16000;
+
+    // the queue delay is between the clear and congested limits and growing
+    QCOMPARE(controller.update(uploadRate * 2 / 10, uploadRate), UploadBitrateController::KeepQuality);
+    QCOMPARE(controller.update(uploadRate * 4 / 10, uploadRate), UploadBitrateController::DecreaseQuality);
+    QCOMPARE(controller.getLevel(), 1);
+
+    // a stable queue is not decreasing the quality
+    QCOMPARE(controller.update(uploadRate * 4 / 10, uploadRate), UploadBitrateController::KeepQuality);
+    QCOMPARE(controller.update(uploadRate * 4 / 10, uploadRate), UploadBitrateController::KeepQuality);
+    QCOMPARE(controller.getLevel(), 1);
+}
+
+void TestUploadBitrateController::clearQueueIncreaseQuality()
+{
+    UploadBitrateController controller;
+
+    const qint64 uploadRate = 16000;
+
+    controller.update(uploadRate * 2, uploadRate);
+    controller.update(uploadRate * 2, uploadRate);
+    QCOMPARE(controller.getLevel(), 2);
+
+    const int intervals = UploadBitrateController::CLEAR_INTERVALS_TO_INCREASE;
+    for (int i = 0; i < intervals - 1; ++i)
+        QCOMPARE(controller.update(0, uploadRate), UploadBitrateController::KeepQuality);
+
+    QCOMPARE(controller.update(0, uploadRate), UploadBitrateController::IncreaseQuality);
+    QCOMPARE(controller.getLevel(), 1);
+
+    for (int i = 0; i < intervals; ++i)
+        controller.update(0, uploadRate);
+
+    QCOMPARE(controller.getLevel(), 0);
+    QCOMPARE(controller.update(0, uploadRate), UploadBitrateController::KeepQuality);
+}
+
+void TestUploadBitrateController::qualityIsNeverAboveUserQuality()
+{
+    UploadBitrateController controller;
+
+    const UploadQuality userQuality{-0.1f, 64000, 10};
+
+    UploadQuality quality = controller.getQuality(userQuality);
+    QCOMPARE(quality.vorbisQuality, userQuality.vorbisQuality);
+    QCOMPARE(quality.videoBitRate, userQuality.videoBitRate);
+    QCOMPARE(quality.cameraFps, userQuality.cameraFps);
+
+    UploadQuality previousQuality = quality;
+    while (controller.getLevel() < UploadBitrateController::MAX_LEVEL) {
+        controller.update(1024, 0);
+        quality = controller.getQuality(userQuality);
+
+        QVERIFY(quality.vorbisQuality <= previousQuality.vorbisQuality);
+        QVERIFY(quality.videoBitRate < previousQuality.videoBitRate);
+        QVERIFY(quality.cameraFps <= previousQuality.cameraFps);
+        QVERIFY(quality.cameraFps > 0);
+
+        previousQuality = quality;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef TEST_UPLOAD_BITRATE_CONTROLLER_H
+#define TEST_UPLOAD_BITRATE_CONTROLLER_H
+
+#include <QObject>
+
+class TestUploadBitrateController : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void congestedQueueDecreaseQuality();
+    void growingQueueDecreaseQuality();
+    void clearQueueIncreaseQuality();
+    void qualityIsNeverAboveUserQuality();
+};
+
+#endif
@@ -16,6 +16,8 @@ HEADERS += TestServerClientCommunication.h
 
 HEADERS += log/logging.h
 HEADERS += TestServerInfo.h
+HEADERS += TestUploadBitrateController.h
+HEADERS += UploadBitrateController.h
 HEADERS += ninjam/client/ServerInfo.h
 HEADERS += ninjam/client/User.h
 HEADERS += ninjam/client/UserChannel.h
@@ -26,6 +28,8 @@ HEADERS += ninjam/server/Server.h
 SOURCES += log/logging.cpp
 SOURCES += ninjam/Ninjam.cpp
 SOURCES += TestServerInfo.cpp
+SOURCES += TestUploadBitrateController.cpp
+SOURCES += UploadBitrateController.cpp
 SOURCES += ninjam/client/ServerInfo.cpp
 SOURCES += ninjam/client/User.cpp
 SOURCES += ninjam/client/UserChannel.cpp
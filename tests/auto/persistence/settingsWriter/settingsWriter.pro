@@ -0,0 +1,18 @@
+
+QT += testlib concurrent
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = settingsWriter
+INCLUDEPATH += .
+INCLUDEPATH += ../../../../src/Common
+VPATH += ../../../../src/Common
+
+# Input
+HEADERS += log/logging.h
+HEADERS += persistence/SettingsWriter.h
+
+SOURCES += log/logging.cpp
+SOURCES += persistence/SettingsWriter.cpp
+SOURCES += tst_SettingsWriter.cpp
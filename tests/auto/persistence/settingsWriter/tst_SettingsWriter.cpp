@@ -0,0 +1,129 @@
+#include <QObject>
+#include <QString>
+#include <QtTest/QtTest>
+#include "persistence/SettingsWriter.h"
+
+#include <QTemporaryDir>
+#include <QJsonDocument>
+
+using namespace persistence;
+
+class TestSettingsWriter: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeFileReplacesContent();
+    void failedWriteKeepsPreviousFile();
+    void writesAreCoalesced();
+    void backgroundWriteFailure();
+
+private:
+    static QJsonObject readJson(const QString &filePath);
+};
+
+QJsonObject TestSettingsWriter::readJson(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly))
+        return QJsonObject();
+
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void TestSettingsWriter::writeFileReplacesContent()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("Jamtaba.json");
+
+    QJsonObject json;
+    json["userName"] = "first";
+    QVERIFY(SettingsWriter::writeFile(filePath, json));
+
+    json["userName"] = "second";
+    QVERIFY(SettingsWriter::writeFile(filePath, json));
+
+    QCOMPARE(readJson(filePath)["userName"].toString(), QString("second"));
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files), QStringList("Jamtaba.json")); // no temporary files
+}
+
+void TestSettingsWriter::failedWriteKeepsPreviousFile()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("missingDir/Jamtaba.json");
+
+    QJsonObject json;
+    json["userName"] = "user";
+    QVERIFY(!SettingsWriter::writeFile(filePath, json));
+    QVERIFY(!QFile::exists(filePath));
+
+    // the previous file is replaced only when the new content is committed
+    const QString existingFilePath = dir.filePath("preset.json");
+    QVERIFY(SettingsWriter::writeFile(existingFilePath, json));
+    QVERIFY(QFile::setPermissions(dir.path(), QFile::ReadOwner | QFile::ExeOwner)); // the temporary file can't be created
+
+    json["userName"] = "other user";
+    const bool written = SettingsWriter::writeFile(existingFilePath, json);
+
+    QFile::setPermissions(dir.path(), QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    if (written)
+        QSKIP("The directory permissions are not enforced (running as root?)");
+
+    QCOMPARE(readJson(existingFilePath)["userName"].toString(), QString("user"));
+}
+
+void TestSettingsWriter::writesAreCoalesced()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("Jamtaba.json");
+    const QString presetPath = dir.filePath("preset.json");
+
+    SettingsWriter writer;
+    for (int i = 0; i <= 1000; ++i) {
+        QJsonObject json;
+        json["value"] = i;
+        writer.write(filePath, json);
+
+        if (i % 100 == 0)
+            writer.write(presetPath, json);
+    }
+
+    writer.waitForWrites();
+
+    // only the last content of each file is written
+    QCOMPARE(readJson(filePath)["value"].toInt(), 1000);
+    QCOMPARE(readJson(presetPath)["value"].toInt(), 1000);
+    QVERIFY(!writer.takeWriteFailure(filePath));
+
+    QStringList files = QDir(dir.path()).entryList(QDir::Files);
+    files.sort();
+    QCOMPARE(files, QStringList() << "Jamtaba.json" << "preset.json");
+}
+
+void TestSettingsWriter::backgroundWriteFailure()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("missingDir/Jamtaba.json");
+
+    SettingsWriter writer;
+    writer.write(filePath, QJsonObject());
+    writer.waitForWrites();
+
+    QVERIFY(writer.takeWriteFailure(filePath));
+    QVERIFY(!writer.takeWriteFailure(filePath)); // the failure is reported once
+
+    QVERIFY(QDir(dir.path()).mkdir("missingDir"));
+    writer.write(filePath, QJsonObject());
+    writer.waitForWrites();
+    QVERIFY(!writer.takeWriteFailure(filePath));
+    QVERIFY(QFile::exists(filePath));
+}
+
+int main(int argc, char *argv[])
+{
+    TestSettingsWriter test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_SettingsWriter.moc"
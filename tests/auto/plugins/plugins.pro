@@ -0,0 +1,18 @@
+QT += testlib
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = testPlugins
+INCLUDEPATH += .
+INCLUDEPATH += ../../../src/Common
+INCLUDEPATH += ../../../src/Standalone
+VPATH += ../../../src/Common
+VPATH += ../../../src/Standalone
+
+HEADERS += PluginScanCache.h
+HEADERS += log/Logging.h
+
+SOURCES += PluginScanCache.cpp
+SOURCES += log/logging.cpp
+SOURCES += test_PluginScanCache.cpp
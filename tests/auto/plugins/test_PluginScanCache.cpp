@@ -0,0 +1,120 @@
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QtTest/QtTest>
+#include "PluginScanCache.h"
+
+using audio::PluginScanCache;
+using audio::PluginFingerprint;
+
+class TestPluginScanCache: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void changedContentChangeTheFingerprint();
+    void notChangedFileIsNotHashedAgain();
+    void touchedFileKeepTheHash();
+    void saveAndLoad();
+    void loadMissingCache();
+
+private:
+    static void writeFile(const QString &path, const QByteArray &content);
+};
+
+void TestPluginScanCache::writeFile(const QString &path, const QByteArray &content)
+{
+    QFile file(path);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(content);
+}
+
+void TestPluginScanCache::changedContentChangeTheFingerprint()
+{
+    QTemporaryDir dir;
+    QString pluginPath = dir.filePath("plugin.dll");
+
+    writeFile(pluginPath, "plugin version 1");
+    PluginFingerprint first = PluginScanCache::computeFingerprint(pluginPath);
+
+    writeFile(pluginPath, "plugin version 2"); // same size
+    PluginFingerprint second = PluginScanCache::computeFingerprint(pluginPath);
+
+    QVERIFY(!first.isNull());
+    QCOMPARE(first.size, second.size);
+    QVERIFY(first.hash != second.hash);
+}
+
+void TestPluginScanCache::notChangedFileIsNotHashedAgain()
+{
+    QTemporaryDir dir;
+    QString pluginPath = dir.filePath("plugin.dll");
+    writeFile(pluginPath, "plugin");
+
+    PluginFingerprint previous = PluginScanCache::computeFingerprint(pluginPath);
+    previous.hash = "cached hash";
+
+    PluginFingerprint fingerprint = PluginScanCache::computeFingerprint(pluginPath, previous);
+
+    QCOMPARE(fingerprint.hash, QByteArray("cached hash"));
+    QVERIFY(fingerprint == previous);
+}
+
+void TestPluginScanCache::touchedFileKeepTheHash()
+{
+    QTemporaryDir dir;
+    QString pluginPath = dir.filePath("plugin.dll");
+    writeFile(pluginPath, "plugin");
+
+    PluginFingerprint previous = PluginScanCache::computeFingerprint(pluginPath);
+    previous.lastModified -= 1000; // the file was copied or touched, the content is not changed
+
+    PluginFingerprint fingerprint = PluginScanCache::computeFingerprint(pluginPath, previous);
+
+    QVERIFY(fingerprint.lastModified != previous.lastModified);
+    QCOMPARE(fingerprint.hash, previous.hash);
+}
+
+void TestPluginScanCache::saveAndLoad()
+{
+    QTemporaryDir dir;
+    QString cachePath = dir.filePath("cache.json");
+
+    PluginFingerprint fingerprint;
+    fingerprint.size = 1234;
+    fingerprint.lastModified = 1500000000000;
+    fingerprint.hash = QByteArray::fromHex("00112233445566778899aabbccddeeff");
+
+    PluginScanCache cache(cachePath);
+    cache.addEntry("/plugins/valid.dll", fingerprint, true);
+    cache.addEntry("/plugins/invalid.dll", fingerprint, false);
+    QVERIFY(cache.save());
+
+    PluginScanCache loadedCache(cachePath);
+    QVERIFY(loadedCache.load());
+
+    auto entries = loadedCache.getEntries();
+    QCOMPARE(entries.size(), 2);
+    QVERIFY(entries["/plugins/valid.dll"].fingerprint == fingerprint);
+    QVERIFY(entries["/plugins/valid.dll"].validPlugin);
+    QVERIFY(!entries["/plugins/invalid.dll"].validPlugin);
+}
+
+void TestPluginScanCache::loadMissingCache()
+{
+    QTemporaryDir dir;
+
+    PluginScanCache cache(dir.filePath("missing.json"));
+
+    QVERIFY(!cache.load());
+    QVERIFY(cache.getEntries().isEmpty());
+}
+
+int main(int argc, char *argv[])
+{
+    TestPluginScanCache test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_PluginScanCache.moc"
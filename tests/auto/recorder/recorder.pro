@@ -0,0 +1,22 @@
+QT += testlib
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = testRecorder
+INCLUDEPATH += .
+INCLUDEPATH += ../../../src/Common
+VPATH += ../../../src/Common
+
+HEADERS += recorder/JamRecorder.h
+HEADERS += recorder/RecordingWriter.h
+HEADERS += recorder/ReaperProjectGenerator.h
+HEADERS += recorder/ClipSortLogGenerator.h
+HEADERS += log/Logging.h
+
+SOURCES += recorder/JamRecorder.cpp
+SOURCES += recorder/RecordingWriter.cpp
+SOURCES += recorder/ReaperProjectGenerator.cpp
+SOURCES += recorder/ClipSortLogGenerator.cpp
+SOURCES += log/logging.cpp
+SOURCES += test_Recorder.cpp
@@ -0,0 +1,336 @@
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QtEndian>
+#include <QtTest/QtTest>
+#include "recorder/JamRecorder.h"
+#include "recorder/RecordingWriter.h"
+#include "recorder/ReaperProjectGenerator.h"
+#include "recorder/ClipSortLogGenerator.h"
+
+using namespace recorder;
+
+class TestRecorder: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void oggStreamInfo();
+    void oggStreamInfoInTruncatedStream();
+    void oggStreamInfoInInvalidData();
+    void reaperTrackFileWithPartialFirstInterval();
+    void journalStoresTheTrackFileSamples();
+    void clipSortKeepsOneFilePerInterval();
+    void projectFileWrittenOnDemand();
+    void videoFilesAreJournaled();
+    void replaceWriteMode();
+    void writerMetrics();
+
+private:
+    static QByteArray createOggPage(qint64 granulePosition, const QByteArray &payload);
+    static QByteArray createOggStream(quint32 sampleRate, qint64 samples);
+    static QString findFile(const QString &dir, const QString &fileName);
+    static QList<double> readItemValues(const QString &rppPath, const QString &key);
+    static QByteArray readFile(const QString &path);
+};
+
+QByteArray TestRecorder::createOggPage(qint64 granulePosition, const QByteArray &payload)
+{
+    uchar granule[8];
+    qToLittleEndian(granulePosition, granule);
+
+    QByteArray page("OggS");
+    page.append(char(0)); // version
+    page.append(char(0)); // header type
+    page.append(reinterpret_cast<const char *>(granule), 8);
+    page.append(QByteArray(12, 0)); // serial number, sequence number and CRC are not checked
+    page.append(char(1)); // one segment
+    page.append(char(payload.size()));
+    page.append(payload);
+    return page;
+}
+
+QByteArray TestRecorder::createOggStream(quint32 sampleRate, qint64 samples)
+{
+    uchar rate[4];
+    qToLittleEndian(sampleRate, rate);
+
+    QByteArray identificationHeader("\x01vorbis", 7);
+    identificationHeader.append(QByteArray(4, 0)); // vorbis version
+    identificationHeader.append(char(2)); // channels
+    identificationHeader.append(reinterpret_cast<const char *>(rate), 4);
+    identificationHeader.append(QByteArray(14, 0)); // bitrates, block sizes and framing
+
+    return createOggPage(0, identificationHeader)
+            + createOggPage(-1, QByteArray(200, 'a')) // packet continued in the next page
+            + createOggPage(samples, QByteArray(100, 'b'));
+}
+
+QString TestRecorder::findFile(const QString &dir, const QString &fileName)
+{
+    QDirIterator it(dir, QStringList(fileName), QDir::Files, QDirIterator::Subdirectories);
+    return it.hasNext() ? it.next() : QString();
+}
+
+QByteArray TestRecorder::readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+
+    return file.readAll();
+}
+
+QList<double> TestRecorder::readItemValues(const QString &rppPath, const QString &key)
+{
+    QList<double> values;
+    for (const QString &line : QString::fromUtf8(readFile(rppPath)).split("\n")) {
+        QString trimmedLine = line.trimmed();
+        if (trimmedLine.startsWith(key + " "))
+            values.append(trimmedLine.mid(key.size() + 1).toDouble());
+    }
+    return values;
+}
+
+void TestRecorder::oggStreamInfo()
+{
+    OggStreamInfo info(createOggStream(48000, 123456));
+
+    QVERIFY(info.isValid());
+    QCOMPARE(info.getSampleRate(), 48000);
+    QCOMPARE(info.getSamples(), qint64(123456));
+}
+
+void TestRecorder::oggStreamInfoInTruncatedStream()
+{
+    QByteArray stream = createOggStream(44100, 1000);
+    stream.chop(10); // the last page is incomplete
+
+    OggStreamInfo info(stream);
+
+    QCOMPARE(info.getSampleRate(), 44100);
+    QCOMPARE(info.getSamples(), qint64(0)); // the granule position of the headers page
+}
+
+void TestRecorder::oggStreamInfoInInvalidData()
+{
+    OggStreamInfo info(QByteArray(1024, 'x'));
+
+    QVERIFY(!info.isValid());
+}
+
+void TestRecorder::reaperTrackFileWithPartialFirstInterval()
+{
+    QTemporaryDir dir;
+
+    {
+        JamRecorder recorder(new ReaperProjectGenerator());
+        recorder.setContinuousTrackFiles(true);
+        recorder.startRecording("local user", QDir(dir.path()), 120, 16, 44100); // 8 seconds intervals
+
+        recorder.addRemoteUserAudio("user", createOggStream(44100, 44100), 0); // joined 1 second before the interval end
+        recorder.newInterval();
+        recorder.addRemoteUserAudio("user", createOggStream(44100, 352800), 0);
+        recorder.newInterval();
+        recorder.addRemoteUserAudio("user", createOggStream(48000, 384000), 0); // 8 seconds in other sample rate
+
+        recorder.stopRecording();
+    }
+
+    RecordingWriter::getInstance()->waitForPendingWrites();
+
+    QString rppPath = findFile(dir.path(), "Reaper project.rpp");
+    QVERIFY(!rppPath.isEmpty());
+
+    QList<double> sourceOffsets = readItemValues(rppPath, "SOFFS");
+    QCOMPARE(sourceOffsets.size(), 3);
+    QCOMPARE(sourceOffsets.at(0), 0.0);
+    QCOMPARE(sourceOffsets.at(1), 1.0); // after the partial interval, not after a complete interval
+    QCOMPARE(sourceOffsets.at(2), 9.0);
+
+    QList<double> lenghts = readItemValues(rppPath, "LENGTH");
+    QCOMPARE(lenghts.size(), 3);
+    QCOMPARE(lenghts.at(0), 1.0);
+    QCOMPARE(lenghts.at(1), 8.0);
+    QCOMPARE(lenghts.at(2), 8.0);
+}
+
+void TestRecorder::journalStoresTheTrackFileSamples()
+{
+    QTemporaryDir dir;
+
+    {
+        JamRecorder recorder(new ReaperProjectGenerator());
+        recorder.setContinuousTrackFiles(true);
+        recorder.startRecording("local user", QDir(dir.path()), 120, 16, 44100);
+
+        recorder.addRemoteUserAudio("user", createOggStream(44100, 22050), 0);
+        recorder.newInterval();
+        recorder.addRemoteUserAudio("user", createOggStream(44100, 352800), 0);
+
+        recorder.stopRecording();
+    }
+
+    RecordingWriter::getInstance()->waitForPendingWrites();
+
+    std::unique_ptr<Jam> jam = JamJournal::load(findFile(dir.path(), "jam.journal"));
+    QVERIFY(jam != nullptr);
+
+    QList<JamTrack> tracks = jam->getJamTracks();
+    QCOMPARE(tracks.size(), 1);
+
+    QList<JamAudioFile> audioFiles = tracks.first().getAudioFiles();
+    QCOMPARE(audioFiles.size(), 2);
+    QVERIFY(audioFiles.at(0).isInTrackFile());
+    QCOMPARE(audioFiles.at(0).getStartSample(), qint64(0));
+    QCOMPARE(audioFiles.at(0).getSamples(), qint64(22050));
+    QCOMPARE(audioFiles.at(1).getStartSample(), qint64(22050));
+    QCOMPARE(audioFiles.at(1).getSamples(), qint64(352800));
+    QCOMPARE(audioFiles.at(1).getByteOffset(), audioFiles.at(0).getByteSize());
+
+    QByteArray offsetTable = readFile(audioFiles.at(0).getPath() + ".index");
+    QCOMPARE(offsetTable.split('\n').at(1), QByteArray("1 ") + QByteArray::number(audioFiles.at(1).getByteOffset()) + " "
+             + QByteArray::number(audioFiles.at(1).getByteSize()) + " 22050 352800");
+}
+
+void TestRecorder::clipSortKeepsOneFilePerInterval()
+{
+    QTemporaryDir dir;
+
+    QByteArray firstStream = createOggStream(44100, 1000);
+    QByteArray secondStream = createOggStream(44100, 352800);
+
+    {
+        JamRecorder recorder(new ClipSortLogGenerator());
+        recorder.setContinuousTrackFiles(true); // ignored, clipsort.log can't reference intervals inside a file
+        recorder.startRecording("local user", QDir(dir.path()), 120, 16, 44100);
+
+        recorder.addRemoteUserAudio("user", firstStream, 0);
+        recorder.newInterval();
+        recorder.addRemoteUserAudio("user", secondStream, 0);
+
+        recorder.stopRecording();
+    }
+
+    RecordingWriter::getInstance()->waitForPendingWrites();
+
+    QVERIFY(findFile(dir.path(), "user (Channel 1).ogg").isEmpty()); // no track file
+
+    QString logPath = findFile(dir.path(), "clipsort.log");
+    QVERIFY(!logPath.isEmpty());
+
+    QStringList clipNames;
+    for (const QString &line : QString::fromUtf8(readFile(logPath)).split("\n")) {
+        if (line.startsWith("user "))
+            clipNames.append(line.split(" ").at(1));
+    }
+
+    QCOMPARE(clipNames.size(), 2);
+    QVERIFY(!clipNames.at(0).isEmpty());
+
+    QCOMPARE(readFile(findFile(dir.path(), clipNames.at(0) + ".ogg")), firstStream);
+    QCOMPARE(readFile(findFile(dir.path(), clipNames.at(1) + ".ogg")), secondStream);
+}
+
+void TestRecorder::projectFileWrittenOnDemand()
+{
+    QTemporaryDir dir;
+
+    JamRecorder recorder(new ReaperProjectGenerator());
+    recorder.startRecording("local user", QDir(dir.path()), 120, 16, 44100);
+
+    for (int i = 0; i < 4; ++i) {
+        recorder.addRemoteUserAudio("user", createOggStream(44100, 352800), 0);
+        recorder.newInterval();
+    }
+
+    RecordingWriter::getInstance()->waitForPendingWrites();
+    QVERIFY(findFile(dir.path(), "Reaper project.rpp").isEmpty()); // only the journal is written in each interval
+
+    recorder.writeProjectFile(); // the recording is not stopped
+    RecordingWriter::getInstance()->waitForPendingWrites();
+
+    QString rppPath = findFile(dir.path(), "Reaper project.rpp");
+    QVERIFY(!rppPath.isEmpty());
+    QCOMPARE(readItemValues(rppPath, "POSITION"), QList<double>() << -8.0 << 0.0 << 8.0 << 16.0);
+}
+
+void TestRecorder::videoFilesAreJournaled()
+{
+    QTemporaryDir dir;
+
+    {
+        JamRecorder recorder(new ReaperProjectGenerator());
+        recorder.startRecording("local user", QDir(dir.path()), 120, 16, 44100);
+
+        recorder.appendLocalUserVideo("first interval video", true);
+        recorder.newInterval();
+        recorder.appendLocalUserVideo("second interval video", true); // the first interval video is saved
+
+        recorder.stopRecording();
+    }
+
+    RecordingWriter::getInstance()->waitForPendingWrites();
+
+    std::unique_ptr<Jam> jam = JamJournal::load(findFile(dir.path(), "jam.journal"));
+    QVERIFY(jam != nullptr);
+
+    QList<JamVideoFile> videoFiles = jam->getVideoFiles();
+    QCOMPARE(videoFiles.size(), 1);
+    QCOMPARE(videoFiles.first().getUserName(), QString("local user"));
+    QCOMPARE(videoFiles.first().getIntervalIndex(), 0u);
+    QCOMPARE(readFile(videoFiles.first().getPath()), QByteArray("first interval video"));
+
+    QString rpp = QString::fromUtf8(readFile(findFile(dir.path(), "Reaper project.rpp")));
+    QVERIFY(rpp.contains("FILE \"" + videoFiles.first().getPath() + "\""));
+}
+
+void TestRecorder::replaceWriteMode()
+{
+    QTemporaryDir dir;
+    QString filePath = dir.filePath("project.rpp");
+
+    auto writer = RecordingWriter::getInstance();
+    writer->write(filePath, "old project");
+    writer->write(filePath, "new", RecordingWriter::Replace);
+    writer->write(filePath, " project", RecordingWriter::Append);
+    writer->waitForPendingWrites();
+
+    QCOMPARE(readFile(filePath), QByteArray("new project"));
+
+    writer->write(dir.path() + "/invalid/project.rpp", "project", RecordingWriter::Replace); // the folder doesn't exist
+    writer->waitForPendingWrites();
+
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files), QStringList("project.rpp")); // no temporary files
+}
+
+void TestRecorder::writerMetrics()
+{
+    QTemporaryDir dir;
+
+    auto writer = RecordingWriter::getInstance();
+    writer->waitForPendingWrites();
+
+    const RecordingWriter::Metrics initialMetrics = writer->getMetrics();
+
+    QVERIFY(writer->write(dir.filePath("interval.ogg"), QByteArray(1000, 'a')));
+    writer->writeMetadata(dir.filePath("jam.journal"), "journal entry\n", RecordingWriter::Append);
+    writer->waitForPendingWrites();
+
+    const RecordingWriter::Metrics metrics = writer->getMetrics();
+    QCOMPARE(metrics.queueDepth, 0);
+    QCOMPARE(metrics.queuedBytes, qint64(0));
+    QCOMPARE(metrics.writtenBytes - initialMetrics.writtenBytes, qint64(1014));
+    QCOMPARE(metrics.droppedWrites, initialMetrics.droppedWrites);
+    QVERIFY(metrics.maxWriteLatency >= metrics.lastWriteLatency);
+}
+
+int main(int argc, char *argv[])
+{
+    TestRecorder test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_Recorder.moc"
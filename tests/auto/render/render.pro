@@ -0,0 +1,64 @@
+QT += testlib concurrent
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = testRender
+
+ROOT_PATH = ../../..
+
+INCLUDEPATH += .
+INCLUDEPATH += $$ROOT_PATH/src/Common
+INCLUDEPATH += $$ROOT_PATH/src/JamRender
+INCLUDEPATH += $$ROOT_PATH/libs/includes/ogg
+INCLUDEPATH += $$ROOT_PATH/libs/includes/vorbis
+
+VPATH += $$ROOT_PATH/src/Common
+VPATH += $$ROOT_PATH/src
+
+DEFINES += OV_EXCLUDE_STATIC_CALLBACKS  #avoid ogg static callback warnings
+
+HEADERS += JamRender/JamRenderer.h
+HEADERS += recorder/JamRecorder.h
+HEADERS += recorder/RecordingWriter.h
+HEADERS += audio/vorbis/VorbisDecoder.h
+HEADERS += audio/vorbis/VorbisEncoder.h
+HEADERS += audio/SamplesBufferResampler.h
+HEADERS += file/WaveFileWriter.h
+HEADERS += file/WaveFileReader.h
+HEADERS += log/Logging.h
+
+SOURCES += JamRender/JamRenderer.cpp
+SOURCES += recorder/JamRecorder.cpp
+SOURCES += recorder/RecordingWriter.cpp
+SOURCES += audio/vorbis/VorbisDecoder.cpp
+SOURCES += audio/vorbis/VorbisEncoder.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/SamplesBufferResampler.cpp
+SOURCES += audio/Resampler.cpp
+SOURCES += file/WaveFileWriter.cpp
+SOURCES += file/WaveFileReader.cpp
+SOURCES += log/logging.cpp
+SOURCES += test_Render.cpp
+
+# the same static libs used in jamtaba-render, plus the vorbis encoder used to create the recorded intervals
+win32{
+    !contains(QMAKE_TARGET.arch, x86_64) {
+        LIBS_PATH = "static/win32-msvc"
+    } else {
+        LIBS_PATH = "static/win64-msvc"
+    }
+}
+
+macx:LIBS_PATH = "static/mac64"
+
+linux{
+    contains(QMAKE_HOST.arch, x86_64) {
+        LIBS_PATH = "static/linux64"
+    } else {
+        LIBS_PATH = "static/linux32"
+    }
+}
+
+LIBS += -L$$PWD/$$ROOT_PATH/libs/$$LIBS_PATH -lvorbisfile -lvorbisenc -lvorbis -logg
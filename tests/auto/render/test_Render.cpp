@@ -0,0 +1,250 @@
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QtEndian>
+#include <QtTest/QtTest>
+#include "JamRenderer.h"
+#include "audio/vorbis/VorbisEncoder.h"
+#include "audio/vorbis/Vorbis.h"
+#include "file/WaveFileWriter.h"
+#include "file/WaveFileReader.h"
+
+#include <cmath>
+
+using recorder::JamRenderer;
+using audio::SamplesBuffer;
+using audio::WaveFileWriter;
+using audio::WaveFileReader;
+
+class TestRender: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void renderSyntheticJournal();
+    void streamedWaveFileHeader();
+    void regularWaveFileHeader();
+    void readStreamedWaveFile();
+
+private:
+    static const int SAMPLE_RATE = 44100;
+    static const int BPM = 120;
+    static const int BPI = 4; // 2 seconds intervals
+    static const uint SAMPLES_PER_INTERVAL = SAMPLE_RATE * BPI * 60 / BPM;
+
+    static QByteArray encodeInterval(float amplitude);
+    static bool writeFile(const QString &path, const QByteArray &data);
+    static QByteArray readFile(const QString &path);
+    static int findChunk(const QByteArray &wave, const QByteArray &chunkId); // offset of the chunk header, -1 if not found
+    static QVector<qint16> readSamples(const QByteArray &wave);
+    static float getMaxPeak(const QVector<qint16> &samples, uint firstFrame, uint frames);
+};
+
+QByteArray TestRender::encodeInterval(float amplitude)
+{
+    const double PI = 3.141592653589793;
+
+    SamplesBuffer samples(2, SAMPLES_PER_INTERVAL);
+    for (uint s = 0; s < SAMPLES_PER_INTERVAL; ++s) {
+        const float value = amplitude * std::sin(2 * PI * 440 * s / SAMPLE_RATE);
+        samples.set(0, s, value);
+        samples.set(1, s, value);
+    }
+
+    vorbis::Encoder encoder(2, SAMPLE_RATE, vorbis::EncoderQualityNormal);
+    QByteArray encodedData = encoder.encode(samples);
+    encodedData.append(encoder.finishIntervalEncoding());
+    return encodedData;
+}
+
+bool TestRender::writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QFile::WriteOnly) && file.write(data) == data.size();
+}
+
+QByteArray TestRender::readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly))
+        return QByteArray();
+
+    return file.readAll();
+}
+
+int TestRender::findChunk(const QByteArray &wave, const QByteArray &chunkId)
+{
+    int offset = 12; // after the RIFF header
+    while (offset + 8 <= wave.size()) {
+        if (wave.mid(offset, 4) == chunkId)
+            return offset;
+
+        const quint32 chunkSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(wave.constData() + offset + 4));
+        offset += 8 + chunkSize;
+    }
+
+    return -1;
+}
+
+QVector<qint16> TestRender::readSamples(const QByteArray &wave)
+{
+    QVector<qint16> samples;
+
+    const int dataChunk = findChunk(wave, "data");
+    if (dataChunk < 0)
+        return samples;
+
+    const quint32 dataSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(wave.constData() + dataChunk + 4));
+    const uchar *data = reinterpret_cast<const uchar *>(wave.constData() + dataChunk + 8);
+    for (quint32 i = 0; i + 1 < dataSize && dataChunk + 8 + i + 1 < static_cast<quint32>(wave.size()); i += 2)
+        samples.append(qFromLittleEndian<qint16>(data + i));
+
+    return samples;
+}
+
+float TestRender::getMaxPeak(const QVector<qint16> &samples, uint firstFrame, uint frames)
+{
+    int maxPeak = 0;
+    for (uint s = firstFrame * 2; s < (firstFrame + frames) * 2 && s < static_cast<uint>(samples.size()); ++s)
+        maxPeak = qMax(maxPeak, qAbs(static_cast<int>(samples.at(s))));
+
+    return maxPeak / 32767.0f;
+}
+
+void TestRender::renderSyntheticJournal()
+{
+    QTemporaryDir dir;
+
+    // 'first user' recorded in interval files, 'second user' joined in the second interval and is recorded in a track file
+    const QByteArray firstInterval = encodeInterval(0.5f);
+    const QByteArray secondInterval = encodeInterval(0.5f);
+    const QByteArray trackFileInterval = encodeInterval(0.25f);
+    const QByteArray otherTrackFileInterval = encodeInterval(0.1f); // before the rendered interval in the track file
+
+    QVERIFY(writeFile(dir.filePath("first_0.ogg"), firstInterval));
+    QVERIFY(writeFile(dir.filePath("first_1.ogg"), secondInterval));
+    QVERIFY(writeFile(dir.filePath("second.ogg"), otherTrackFileInterval + trackFileInterval));
+
+    QByteArray journal("jam " + QByteArray::number(BPM) + " " + QByteArray::number(BPI) + " " + QByteArray::number(SAMPLE_RATE) + "\n");
+    journal += "file 0 0 \"first user\" \"" + dir.filePath("first_0.ogg").toUtf8() + "\"\n";
+    journal += "file 1 0 \"first user\" \"" + dir.filePath("first_1.ogg").toUtf8() + "\"\n";
+    journal += "file 1 0 \"second user\" \"" + dir.filePath("second.ogg").toUtf8() + "\" "
+            + QByteArray::number(otherTrackFileInterval.size()) + " " + QByteArray::number(trackFileInterval.size())
+            + " " + QByteArray::number(SAMPLES_PER_INTERVAL) + " " + QByteArray::number(SAMPLES_PER_INTERVAL) + "\n";
+    journal += "file 2 0 \"first user\" \"missing"; // partially written entry, ignored
+    QVERIFY(writeFile(dir.filePath("jam.journal"), journal));
+
+    JamRenderer renderer;
+    QSignalSpy progressSpy(&renderer, &JamRenderer::progress);
+
+    const QString outputDir = dir.filePath("render");
+    QVERIFY(renderer.render(dir.filePath("jam.journal"), outputDir));
+
+    QCOMPARE(progressSpy.count(), 2);
+    QCOMPARE(progressSpy.last().at(0).toInt(), 2);
+    QCOMPARE(progressSpy.last().at(1).toInt(), 2);
+
+    const uint expectedDataSize = 2 * SAMPLES_PER_INTERVAL * 2 * sizeof(qint16); // 2 stereo intervals in 16 bits
+
+    const QStringList outputFiles = QStringList() << "first user.wav" << "second user.wav" << "mixdown.wav";
+    for (const QString &outputFile : outputFiles) {
+        const QByteArray wave = readFile(QDir(outputDir).absoluteFilePath(outputFile));
+        QVERIFY2(wave.startsWith("RIFF"), qPrintable(outputFile));
+        QCOMPARE(wave.mid(12, 4), QByteArray("fmt ")); // the length is known, no JUNK chunk
+        QCOMPARE(readSamples(wave).size(), static_cast<int>(expectedDataSize / sizeof(qint16)));
+    }
+
+    // the stems are aligned, the second user is silent in the first interval
+    const QVector<qint16> secondUser = readSamples(readFile(QDir(outputDir).absoluteFilePath("second user.wav")));
+    QCOMPARE(getMaxPeak(secondUser, 0, SAMPLES_PER_INTERVAL), 0.0f);
+
+    const float trackFilePeak = getMaxPeak(secondUser, SAMPLES_PER_INTERVAL, SAMPLES_PER_INTERVAL);
+    QVERIFY(trackFilePeak > 0.2f && trackFilePeak < 0.3f); // the interval bytes are decoded, not the previous stream
+
+    const QVector<qint16> mixdown = readSamples(readFile(QDir(outputDir).absoluteFilePath("mixdown.wav")));
+    QVERIFY(getMaxPeak(mixdown, 0, SAMPLES_PER_INTERVAL) < 0.6f);
+    QVERIFY(getMaxPeak(mixdown, SAMPLES_PER_INTERVAL, SAMPLES_PER_INTERVAL) > 0.6f); // both users are summed
+}
+
+void TestRender::streamedWaveFileHeader()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("stem.wav");
+
+    SamplesBuffer buffer(2, 1000);
+    buffer.set(0, 0, 0.5f);
+
+    WaveFileWriter writer;
+    QVERIFY(writer.open(filePath, 2, SAMPLE_RATE, 16));
+    writer.append(buffer);
+    writer.append(buffer);
+    writer.close();
+
+    const QByteArray wave = readFile(filePath);
+
+    // a JUNK chunk is reserved for the RF64 header, but files smaller than 4 GB are regular WAV files
+    QVERIFY(wave.startsWith("RIFF"));
+    QCOMPARE(qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(wave.constData() + 4)), quint32(wave.size() - 8));
+    QCOMPARE(findChunk(wave, "JUNK"), 12);
+    QVERIFY(findChunk(wave, "fmt ") > 12);
+
+    const int dataChunk = findChunk(wave, "data");
+    QVERIFY(dataChunk > 0);
+    QCOMPARE(qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(wave.constData() + dataChunk + 4)), quint32(2 * 1000 * 2 * 2));
+    QCOMPARE(wave.size(), dataChunk + 8 + 2 * 1000 * 2 * 2);
+
+    QVector<qint16> samples = readSamples(wave);
+    QCOMPARE(samples.at(0), qint16(0.5f * 32767));
+    QCOMPARE(samples.at(2000), qint16(0.5f * 32767)); // first sample in the second buffer
+}
+
+void TestRender::regularWaveFileHeader()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("loop.wav");
+
+    SamplesBuffer buffer(2, 1000);
+
+    WaveFileWriter writer;
+    writer.write(filePath, buffer, SAMPLE_RATE, 16);
+
+    // the size is known, the 44 bytes header used by the previous versions (loops are shared between users)
+    const QByteArray wave = readFile(filePath);
+    QCOMPARE(wave.size(), 44 + 1000 * 2 * 2);
+    QCOMPARE(wave.mid(12, 4), QByteArray("fmt "));
+    QCOMPARE(wave.mid(36, 4), QByteArray("data"));
+    QCOMPARE(qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(wave.constData() + 40)), quint32(1000 * 2 * 2));
+}
+
+void TestRender::readStreamedWaveFile()
+{
+    QTemporaryDir dir;
+    const QString filePath = dir.filePath("stem.wav");
+
+    SamplesBuffer buffer(2, 1000);
+    buffer.set(0, 0, 0.5f);
+    buffer.set(1, 999, -0.5f);
+
+    WaveFileWriter writer;
+    QVERIFY(writer.open(filePath, 2, SAMPLE_RATE, 16)); // unknown length, the JUNK chunk is skipped by the reader
+    writer.append(buffer);
+    writer.close();
+
+    SamplesBuffer samples(2);
+    quint32 sampleRate = 0;
+    WaveFileReader reader;
+    QVERIFY(reader.read(filePath, samples, sampleRate));
+    QCOMPARE(sampleRate, quint32(SAMPLE_RATE));
+    QCOMPARE(samples.getFrameLenght(), 1000u);
+    QVERIFY(qAbs(samples.get(0, 0) - 0.5f) < 0.001f);
+    QVERIFY(qAbs(samples.get(1, 999) + 0.5f) < 0.001f);
+}
+
+int main(int argc, char *argv[])
+{
+    TestRender test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_Render.moc"
@@ -0,0 +1,151 @@
+#include <QTest>
+#include "TestThemeLoader.h"
+#include "gui/ThemeLoader.h"
+#include "gui/GuiUtils.h"
+
+#include <QApplication>
+#include <QStyle>
+#include <QFrame>
+#include <QSlider>
+#include <QPushButton>
+#include <QToolButton>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <QScopedPointer>
+#include <QFile>
+
+using theme::Loader;
+
+void TestThemeLoader::minimizeCSS_data()
+{
+    QTest::addColumn<QString>("css");
+    QTest::addColumn<QString>("minimizedCSS");
+
+    QTest::newRow("Spaces") << QString("QWidget\n{\n    color: red;\n}\n") << QString("QWidget{color: red;}");
+    QTest::newRow("Comments") << QString("/* comment */QLabel { color: red; } /* another */") << QString("QLabel{color: red;}");
+    QTest::newRow("Comment between words") << QString("QWidget/**/#name{}") << QString("QWidget #name{}");
+    QTest::newRow("Descendant selector") << QString("QWidget   #name  QLabel {}") << QString("QWidget #name QLabel{}");
+    QTest::newRow("Pseudo state") << QString("QPushButton :hover {}") << QString("QPushButton :hover{}");
+    QTest::newRow("Selector list") << QString("QLabel ,\n QPushButton {}") << QString("QLabel,QPushButton{}");
+    QTest::newRow("Function arguments") << QString("QWidget { color: rgb(1, 2, 3); }") << QString("QWidget{color: rgb(1,2,3);}");
+    QTest::newRow("Strings") << QString("QLabel[text=\"a  /* b */\"] { image: url('a  b.png'); }") << QString("QLabel[text=\"a  /* b */\"]{image: url('a  b.png');}");
+    QTest::newRow("Unterminated comment") << QString("QLabel{} /* comment") << QString("QLabel{}");
+}
+
+void TestThemeLoader::minimizeCSS()
+{
+    QFETCH(QString, css);
+    QFETCH(QString, minimizedCSS);
+
+    QCOMPARE(Loader::minimizeCSS(css), minimizedCSS);
+}
+
+void TestThemeLoader::loadedThemeIsCached()
+{
+    Loader::clearCache();
+
+    QString css = Loader::loadCSS(THEMES_DIR, "Navy_nm");
+    QVERIFY(!css.isEmpty());
+    QVERIFY(!css.contains("/*"));
+
+    QCOMPARE(Loader::loadCSS(THEMES_DIR, "Navy_nm"), css);
+
+    QVERIFY(Loader::loadCSS(THEMES_DIR, "Flat") != css);
+}
+
+static QWidget *createTrackView(QWidget *parent)
+{
+    auto trackView = new QFrame(parent);
+    trackView->setObjectName("BaseTrackView");
+
+    auto layout = new QVBoxLayout(trackView);
+
+    auto panSlider = new QSlider(Qt::Horizontal);
+    panSlider->setObjectName("panSlider");
+    layout->addWidget(panSlider);
+
+    auto levelSlider = new QSlider(Qt::Vertical);
+    levelSlider->setObjectName("levelSlider");
+    layout->addWidget(levelSlider);
+
+    auto muteButton = new QPushButton("M");
+    muteButton->setObjectName("muteButton");
+    layout->addWidget(muteButton);
+
+    auto soloButton = new QPushButton("S");
+    soloButton->setObjectName("soloButton");
+    layout->addWidget(soloButton);
+
+    auto boostLayout = new QHBoxLayout();
+    boostLayout->addWidget(new QToolButton());
+    boostLayout->addWidget(new QLabel("0 dB"));
+    boostLayout->addWidget(new QToolButton());
+    layout->addLayout(boostLayout);
+
+    return trackView;
+}
+
+static void repolishAlways(QWidget *widget) // the previous implementation, used to compare
+{
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+}
+
+void TestThemeLoader::createTrackViewsBenchmark_data()
+{
+    QTest::addColumn<bool>("minimizedCSS");
+    QTest::addColumn<bool>("skipUnpolishedWidgets");
+
+    QTest::newRow("original CSS, repolish always") << false << false;
+    QTest::newRow("minimized CSS, repolish always") << true << false;
+    QTest::newRow("minimized CSS, skip unpolished widgets") << true << true;
+}
+
+void TestThemeLoader::createTrackViewsBenchmark()
+{
+    QFETCH(bool, minimizedCSS);
+    QFETCH(bool, skipUnpolishedWidgets);
+
+    static const int TRACK_VIEWS = 30;
+
+    Loader::clearCache();
+    QString css = Loader::loadCSS(THEMES_DIR, "Navy_nm");
+    QVERIFY(!css.isEmpty());
+
+    if (!minimizedCSS) { // reading the theme files without cache and minimization
+        css.clear();
+        QStringList sections;
+        sections << "General.css" << "MainWindow.css" << "Dialogs.css" << "PublicRooms.css" << "BaseTrack.css"
+                 << "LocalTrack.css" << "NinjamWindow.css" << "Chat.css" << "Chords.css";
+
+        for (const QString &section : sections) {
+            QFile file(QString(THEMES_DIR) + "/Navy_nm/" + section);
+            QVERIFY(file.open(QFile::ReadOnly));
+            css += file.readAll();
+        }
+    }
+
+    qApp->setStyleSheet(css);
+
+    QBENCHMARK {
+        QScopedPointer<QWidget> tracksPanel(new QWidget());
+        auto layout = new QHBoxLayout(tracksPanel.data());
+
+        for (int i = 0; i < TRACK_VIEWS; ++i) {
+            auto trackView = createTrackView(tracksPanel.data());
+            layout->addWidget(trackView);
+
+            trackView->setProperty("unlighted", true); // the track is deactivated until receive the first interval
+            for (auto widget : trackView->findChildren<QWidget *>()) {
+                if (skipUnpolishedWidgets)
+                    gui::repolish(widget);
+                else
+                    repolishAlways(widget);
+            }
+        }
+
+        tracksPanel->show();
+    }
+
+    qApp->setStyleSheet(QString());
+}
@@ -0,0 +1,23 @@
+#ifndef TEST_THEME_LOADER_H
+#define TEST_THEME_LOADER_H
+
+#include <QObject>
+
+class TestThemeLoader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void minimizeCSS_data();
+    void minimizeCSS();
+
+    void loadedThemeIsCached();
+
+    // creating 30 track views (the widgets styled by BaseTrack.css) in the application stylesheet
+    void createTrackViewsBenchmark_data();
+    void createTrackViewsBenchmark();
+
+};
+
+#endif // TEST_THEME_LOADER_H
@@ -0,0 +1,16 @@
+#include <QTest>
+#include <QApplication>
+#include "TestThemeLoader.h"
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv); // the stylesheets are applied in widgets
+
+    TestThemeLoader test;
+
+    int result = 0;
+
+    result += QTest::qExec(&test, argc, argv);
+
+    return result > 0 ? -result : 0;
+}
@@ -0,0 +1,24 @@
+
+#TODO create a test-common.pri to share common tests configuration
+
+QT += testlib core gui widgets
+
+CONFIG += testcase c++11
+TEMPLATE = app
+TARGET = testTheme
+INCLUDEPATH += .
+INCLUDEPATH += ../../../src/Common
+
+VPATH += ../../../src/Common
+
+DEFINES += THEMES_DIR=\\\"$$PWD/../../../src/resources/css/themes\\\"
+
+HEADERS += TestThemeLoader.h
+HEADERS += gui/ThemeLoader.h
+HEADERS += gui/GuiUtils.h
+
+SOURCES += TestThemeLoader.cpp
+SOURCES += gui/ThemeLoader.cpp
+SOURCES += gui/GuiUtils.cpp
+
+SOURCES += test_Theme.cpp
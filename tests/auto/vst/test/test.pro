@@ -0,0 +1,60 @@
+QT += testlib widgets concurrent
+CONFIG += testcase c++11
+TEMPLATE = app
+TARGET = testVst
+
+ROOT_PATH = ../../../..
+SOURCE_PATH = $$ROOT_PATH/src
+VST_SDK_PATH = $$PWD/$$ROOT_PATH/VST_SDK
+
+!exists($$VST_SDK_PATH/VST2_SDK/pluginterfaces/vst2.x/aeffect.h): error("The VST tests need the VST SDK in $$VST_SDK_PATH")
+
+INCLUDEPATH += .
+INCLUDEPATH += $$SOURCE_PATH/Common
+INCLUDEPATH += $$SOURCE_PATH/Standalone
+INCLUDEPATH += $$SOURCE_PATH/Standalone/vst
+INCLUDEPATH += $$SOURCE_PATH/Scanners
+INCLUDEPATH += $$VST_SDK_PATH/VST2_SDK/pluginterfaces/vst2.x
+
+VPATH += $$SOURCE_PATH/Common
+VPATH += $$SOURCE_PATH/Standalone
+VPATH += $$SOURCE_PATH/Scanners
+
+DEFINES += __cdecl=""
+DEFINES += TEST_PLUGIN_DIR=\\\"$$OUT_PWD/../testPlugin\\\"
+
+HEADERS += vst/VstHost.h
+HEADERS += vst/VstLoader.h
+HEADERS += vst/Utils.h
+HEADERS += vst/VstPlugin.h
+HEADERS += vst/VstPluginChecker.h
+HEADERS += audio/core/Plugins.h
+HEADERS += audio/core/AudioNodeProcessor.h
+HEADERS += BaseScanner.h
+HEADERS += PluginFinder.h
+HEADERS += PluginScanCache.h
+HEADERS += vst/VstPluginFinder.h
+HEADERS += VstScanner/VstPluginScanner.h
+
+SOURCES += vst/VstHost.cpp
+SOURCES += vst/VstLoader.cpp
+SOURCES += vst/Utils.cpp
+SOURCES += vst/VstPlugin.cpp
+SOURCES += vst/LinuxVstPluginChecker.cpp
+SOURCES += audio/core/Plugins.cpp
+SOURCES += audio/core/AudioNodeProcessor.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/PluginDescriptor.cpp
+SOURCES += audio/TransportClock.cpp
+SOURCES += midi/MidiMessage.cpp
+SOURCES += log/logging.cpp
+SOURCES += BaseScanner.cpp
+SOURCES += PluginFinder.cpp
+SOURCES += PluginScanCache.cpp
+SOURCES += vst/VstPluginFinder.cpp
+SOURCES += VstScanner/VstPluginScanner.cpp
+
+SOURCES += test_Vst.cpp
+
+LIBS += -ldl
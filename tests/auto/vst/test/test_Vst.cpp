@@ -0,0 +1,507 @@
+#include <QObject>
+#include <QString>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QLibraryInfo>
+#include <QtTest/QtTest>
+
+#include "vst/VstPluginChecker.h"
+#include "vst/VstHost.h"
+#include "vst/VstLoader.h"
+#include "vst/VstPlugin.h"
+#include "vst/Utils.h"
+#include "audio/core/SamplesBuffer.h"
+#include "VstScanner/VstPluginScanner.h"
+#include "vst/VstPluginFinder.h"
+#include "audio/TransportClock.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <thread>
+
+/**
+ * VSTPluginFinder using a shell script as scanner, the plugins are "scanned" using their file names:
+ * the scanner process crash when loading "crash.so" and the "invalid.so" plugin is invalid.
+ * Each scanner process write his PID in the "scanners" file.
+ */
+
+class FakeScannerPluginFinder : public audio::VSTPluginFinder
+{
+public:
+    FakeScannerPluginFinder(const QDir &cacheDir, const QString &scannerPath) :
+        VSTPluginFinder(cacheDir),
+        scannerPath(scannerPath)
+    {
+
+    }
+
+protected:
+    QString getScannerExecutablePath() const override
+    {
+        return scannerPath;
+    }
+
+private:
+    QString scannerPath;
+};
+
+/**
+ * Expose the host callback used by the plugins, the host is never instantiated by this class.
+ */
+
+class HostCallback : public vst::VstHost
+{
+public:
+    using VstHost::hostCallback;
+};
+
+class TestVst: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void pluginIsValid();
+    void textFileIsNotValid();
+    void sharedLibraryWithoutEntryPointIsNotValid();
+
+    void scanPlugin();
+    void processAudio();
+    void timeInfoFollowsTheTransport();
+    void timeInfoIsCopiedInOtherThreads();
+
+    void scannerScansSharedObjectsInFolders();
+    void scannerSkipsListedPlugins();
+    void scannerReadsPluginsFromInput();
+
+    void finderUsesManyScanners();
+    void finderBlackListsCrashedPlugin();
+    void finderCachesInvalidPlugins();
+    void finderReportsCachedPluginsAfterScanStarted();
+
+private:
+    QString pluginPath;
+
+    static QString createFakeScanner(const QDir &dir);
+    static QStringList scanWithFinder(const QDir &cacheDir, const QString &scannerPath, const QString &folder, const QStringList &skipList = QStringList()); // the finder signals
+    static QStringList getScannerProcesses(const QDir &dir);
+
+    static QStringList runScanner(const QStringList &args, const QByteArray &input = QByteArray()); // the scanner output lines
+    static bool writeFile(const QString &path, const QByteArray &data);
+};
+
+QStringList TestVst::runScanner(const QStringList &args, const QByteArray &input)
+{
+    // the scanner is running in this process, the standard input and output are redirected
+    std::istringstream in(input.toStdString());
+    std::ostringstream out;
+    std::streambuf *cinBuffer = std::cin.rdbuf(in.rdbuf());
+    std::streambuf *coutBuffer = std::cout.rdbuf(out.rdbuf());
+
+    QList<QByteArray> arguments;
+    arguments << "VstScanner";
+    for (const QString &arg : args)
+        arguments << arg.toUtf8();
+
+    std::vector<char *> argv;
+    for (QByteArray &arg : arguments)
+        argv.push_back(arg.data());
+
+    VstPluginScanner scanner;
+    scanner.start(static_cast<int>(argv.size()), argv.data());
+
+    std::cin.rdbuf(cinBuffer);
+    std::cout.rdbuf(coutBuffer);
+
+    return QString::fromStdString(out.str()).split('\n', QString::SkipEmptyParts);
+}
+
+QString TestVst::createFakeScanner(const QDir &dir)
+{
+    static const QByteArray script =
+            "#!/bin/sh\n"
+            "echo $$ >> \"$(dirname \"$0\")/scanners\"\n"
+            "echo JT-Scanner-Starting\n"
+            "while read plugin; do\n"
+            "    echo \"JT-Scanner-Scanning: $plugin\"\n"
+            "    case \"$(basename \"$plugin\")\" in\n"
+            "        crash.so) kill -SEGV $$ ;;\n"
+            "        invalid.so) echo \"JT-Scanner-Scan-Invalid: $plugin\" ;;\n"
+            "        *) echo \"JT-Scanner-Scan-Finished: $plugin\" ;;\n"
+            "    esac\n"
+            "done\n"
+            "echo JT-Scanner-Finished\n";
+
+    const QString scannerPath = dir.absoluteFilePath("VstScanner");
+    if (!writeFile(scannerPath, script))
+        return QString();
+
+    QFile::setPermissions(scannerPath, QFile::permissions(scannerPath) | QFile::ExeOwner);
+
+    return scannerPath;
+}
+
+QStringList TestVst::scanWithFinder(const QDir &cacheDir, const QString &scannerPath, const QString &folder, const QStringList &skipList)
+{
+    QStringList events;
+
+    FakeScannerPluginFinder finder(cacheDir, scannerPath);
+    connect(&finder, &audio::VSTPluginFinder::scanStarted, [&]() {
+        events << "started";
+    });
+    connect(&finder, &audio::VSTPluginFinder::pluginScanFinished, [&](const QString &, const QString &path) {
+        events << "found " + QFileInfo(path).fileName();
+    });
+    connect(&finder, &audio::VSTPluginFinder::badPluginDetected, [&](const QString &path) {
+        events << "bad " + QFileInfo(path).fileName();
+    });
+
+    QSignalSpy finishedSpy(&finder, &audio::VSTPluginFinder::scanFinished);
+    finder.scan(QStringList(folder), skipList);
+    if (!finishedSpy.wait(10000))
+        return QStringList("timeout");
+
+    events << (finishedSpy.first().at(0).toBool() ? "finished" : "finished with error");
+
+    return events;
+}
+
+QStringList TestVst::getScannerProcesses(const QDir &dir)
+{
+    QFile file(dir.absoluteFilePath("scanners"));
+    if (!file.open(QFile::ReadOnly))
+        return QStringList();
+
+    return QString::fromUtf8(file.readAll()).split('\n', QString::SkipEmptyParts);
+}
+
+bool TestVst::writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QFile::WriteOnly) && file.write(data) == data.size();
+}
+
+void TestVst::initTestCase()
+{
+    QDir pluginDir(TEST_PLUGIN_DIR);
+    QStringList plugins = pluginDir.entryList(QStringList("*.so"), QDir::Files);
+    QVERIFY2(!plugins.isEmpty(), "The test plugin is not builded");
+
+    pluginPath = pluginDir.absoluteFilePath(plugins.first());
+
+    auto host = vst::VstHost::getInstance();
+    host->setSampleRate(44100);
+    host->setBlockSize(256);
+}
+
+void TestVst::pluginIsValid()
+{
+    QVERIFY(Vst::PluginChecker::isValidPluginFile(pluginPath));
+}
+
+void TestVst::textFileIsNotValid()
+{
+    QTemporaryDir dir;
+    QString fakePlugin = dir.filePath("fake.so");
+
+    QFile file(fakePlugin);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write("not a shared object");
+    file.close();
+
+    QVERIFY(!Vst::PluginChecker::isValidPluginFile(fakePlugin));
+}
+
+void TestVst::sharedLibraryWithoutEntryPointIsNotValid()
+{
+    QString qtCore = QLibraryInfo::location(QLibraryInfo::LibrariesPath) + "/libQt5Core.so";
+    if (!QFile::exists(qtCore))
+        QSKIP("QtCore shared library not found");
+
+    QTemporaryDir dir;
+    QString library = dir.filePath("library.so");
+    QVERIFY(QFile::copy(qtCore, library));
+
+    QVERIFY(!Vst::PluginChecker::isValidPluginFile(library));
+}
+
+void TestVst::scanPlugin()
+{
+    // the same steps used in VstScanner
+    AEffect *effect = vst::VstLoader::load(pluginPath, vst::VstHost::getInstance());
+    QVERIFY(effect);
+
+    QCOMPARE(vst::utils::getPluginName(effect), QString("Test Gain"));
+    QCOMPARE(vst::utils::getPluginVendor(effect), QString("Test Vendor"));
+
+    vst::VstLoader::unload(effect);
+}
+
+void TestVst::processAudio()
+{
+    vst::VstPlugin plugin(vst::VstHost::getInstance(), pluginPath);
+    QVERIFY(plugin.load(pluginPath));
+
+    plugin.start();
+
+    audio::SamplesBuffer in(2, 256);
+    audio::SamplesBuffer out(2, 256);
+    for (uint c = 0; c < 2; ++c) {
+        for (uint s = 0; s < 256; ++s)
+            in.set(c, s, 0.8f);
+    }
+
+    std::vector<midi::MidiMessage> midiBuffer;
+    plugin.process(in, out, midiBuffer);
+
+    for (uint c = 0; c < 2; ++c) {
+        for (uint s = 0; s < 256; ++s)
+            QCOMPARE(out.get(c, s), 0.4f);
+    }
+}
+
+void TestVst::timeInfoFollowsTheTransport()
+{
+    audio::TransportState state;
+    state.playing = true;
+    state.bpm = 90;
+    state.bpi = 16;
+    state.sampleRate = 44100;
+    state.samplePosition = 44100;
+
+    auto clock = audio::TransportClock::getInstance();
+    clock->publish(state);
+
+    vst::VstHost::getInstance()->setAudioThread(); // the test thread is processing the plugins
+
+    auto timeInfo = reinterpret_cast<VstTimeInfo *>(HostCallback::hostCallback(nullptr, audioMasterGetTime, 0, 0, nullptr, 0));
+    QVERIFY(timeInfo);
+    QVERIFY(timeInfo->flags & kVstTransportPlaying);
+    QCOMPARE(timeInfo->tempo, 90.0);
+    QCOMPARE(timeInfo->samplePos, 44100.0);
+
+    // the playing flag is cleared when the transport stop
+    clock->stop();
+
+    timeInfo = reinterpret_cast<VstTimeInfo *>(HostCallback::hostCallback(nullptr, audioMasterGetTime, 0, 0, nullptr, 0));
+    QVERIFY(!(timeInfo->flags & kVstTransportPlaying));
+    QVERIFY(timeInfo->flags & kVstTransportChanged);
+
+    timeInfo = reinterpret_cast<VstTimeInfo *>(HostCallback::hostCallback(nullptr, audioMasterGetTime, 0, 0, nullptr, 0));
+    QVERIFY(!(timeInfo->flags & kVstTransportPlaying));
+    QVERIFY(!(timeInfo->flags & kVstTransportChanged)); // the transport state is not changed
+}
+
+void TestVst::timeInfoIsCopiedInOtherThreads()
+{
+    audio::TransportState state;
+    state.playing = true;
+    state.bpm = 120;
+    state.sampleRate = 44100;
+    state.samplePosition = 0;
+
+    auto clock = audio::TransportClock::getInstance();
+    clock->publish(state);
+
+    vst::VstHost::getInstance()->setAudioThread();
+    auto audioTimeInfo = reinterpret_cast<VstTimeInfo *>(HostCallback::hostCallback(nullptr, audioMasterGetTime, 0, 0, nullptr, 0));
+    QCOMPARE(audioTimeInfo->samplePos, 0.0);
+
+    state.samplePosition = 22050;
+    clock->publish(state);
+
+    VstTimeInfo *otherThreadTimeInfo = nullptr;
+    VstTimeInfo otherThreadCopy;
+    std::thread otherThread([&]() {
+        otherThreadTimeInfo = reinterpret_cast<VstTimeInfo *>(HostCallback::hostCallback(nullptr, audioMasterGetTime, 0, 0, nullptr, 0));
+        otherThreadCopy = *otherThreadTimeInfo;
+    });
+    otherThread.join();
+
+    QVERIFY(otherThreadTimeInfo != audioTimeInfo);
+    QVERIFY(otherThreadCopy.flags & kVstTransportPlaying);
+    QCOMPARE(otherThreadCopy.samplePos, 22050.0);
+    QCOMPARE(otherThreadCopy.ppqPos, 1.0); // half second in 120 BPM
+
+    QCOMPARE(audioTimeInfo->samplePos, 0.0); // updated only in the audio thread
+
+    clock->stop();
+}
+
+void TestVst::scannerScansSharedObjectsInFolders()
+{
+    QTemporaryDir dir;
+    QVERIFY(QDir(dir.path()).mkdir("subfolder"));
+
+    const QString plugin = QDir(dir.path()).absoluteFilePath("subfolder/TestGain.so");
+    const QString fakePlugin = QDir(dir.path()).absoluteFilePath("fake.so");
+    QVERIFY(QFile::copy(pluginPath, plugin));
+    QVERIFY(writeFile(fakePlugin, "not a shared object"));
+    QVERIFY(writeFile(dir.filePath("readme.txt"), "not a plugin"));
+
+    const QStringList output = runScanner(QStringList(dir.path()));
+
+    // only the shared objects are scanned
+    QCOMPARE(output.size(), 6);
+    QCOMPARE(output.first(), QString("JT-Scanner-Starting"));
+    QVERIFY(output.contains("JT-Scanner-Scanning: " + plugin));
+    QVERIFY(output.contains("JT-Scanner-Scan-Finished: " + plugin));
+    QVERIFY(output.contains("JT-Scanner-Scanning: " + fakePlugin));
+    QVERIFY(output.contains("JT-Scanner-Scan-Invalid: " + fakePlugin));
+    QCOMPARE(output.last(), QString("JT-Scanner-Finished"));
+}
+
+void TestVst::scannerSkipsListedPlugins()
+{
+    QTemporaryDir dir;
+
+    const QString plugin = dir.filePath("TestGain.so");
+    const QString otherPlugin = dir.filePath("OtherGain.so");
+    QVERIFY(QFile::copy(pluginPath, plugin));
+    QVERIFY(QFile::copy(pluginPath, otherPlugin));
+
+    const QStringList output = runScanner(QStringList() << dir.path() << plugin); // cached or blacklisted plugin
+
+    QCOMPARE(output, QStringList() << "JT-Scanner-Starting"
+                                   << "JT-Scanner-Scanning: " + otherPlugin
+                                   << "JT-Scanner-Scan-Finished: " + otherPlugin
+                                   << "JT-Scanner-Finished");
+}
+
+void TestVst::scannerReadsPluginsFromInput()
+{
+    QTemporaryDir dir;
+    const QString missingPlugin = dir.filePath("missing.so");
+
+    QByteArray input;
+    input += pluginPath.toUtf8() + "\n";
+    input += "\n"; // empty lines are ignored
+    input += missingPlugin.toUtf8() + "\n";
+
+    const QStringList output = runScanner(QStringList("-"), input);
+
+    const QString plugin = QFileInfo(pluginPath).absoluteFilePath(); // the path reported by the scanner
+    QCOMPARE(output, QStringList() << "JT-Scanner-Starting"
+                                   << "JT-Scanner-Scanning: " + plugin
+                                   << "JT-Scanner-Scan-Finished: " + plugin
+                                   << "JT-Scanner-Scanning: " + missingPlugin
+                                   << "JT-Scanner-Scan-Invalid: " + missingPlugin
+                                   << "JT-Scanner-Finished");
+}
+
+void TestVst::finderUsesManyScanners()
+{
+    if (QThread::idealThreadCount() < 2)
+        QSKIP("Only one scanner process is used in this machine");
+
+    QTemporaryDir dir;
+    QDir root(dir.path());
+    QVERIFY(root.mkdir("plugins"));
+
+    QStringList expectedEvents("started");
+    for (int i = 0; i < 6; ++i) {
+        const QString pluginName = QString("plugin%1.so").arg(i);
+        QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/" + pluginName)));
+        expectedEvents << "found " + pluginName;
+    }
+    expectedEvents << "finished";
+
+    const QString scanner = createFakeScanner(root);
+    QStringList events = scanWithFinder(root, scanner, root.absoluteFilePath("plugins"));
+
+    QCOMPARE(events.size(), expectedEvents.size());
+    QCOMPARE(events.first(), expectedEvents.first());
+    QCOMPARE(events.last(), expectedEvents.last());
+    for (const QString &event : expectedEvents)
+        QVERIFY2(events.contains(event), qPrintable(event)); // the scanner processes are running in parallel, any order
+
+    const int scanners = getScannerProcesses(root).size();
+    QVERIFY(scanners > 1);
+    QVERIFY(scanners <= 6);
+}
+
+void TestVst::finderBlackListsCrashedPlugin()
+{
+    QTemporaryDir dir;
+    QDir root(dir.path());
+    QVERIFY(root.mkdir("plugins"));
+
+    const QStringList plugins = QStringList() << "a.so" << "crash.so" << "b.so" << "c.so";
+    for (const QString &plugin : plugins)
+        QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/" + plugin)));
+
+    const QString scanner = createFakeScanner(root);
+    const QString crashedPlugin = root.absoluteFilePath("plugins/crash.so");
+
+    QStringList events = scanWithFinder(root, scanner, root.absoluteFilePath("plugins"));
+    QCOMPARE(events.count("bad crash.so"), 1); // only the plugin loaded by the crashed scanner
+    QVERIFY(events.contains("found a.so"));
+    QVERIFY(events.contains("found b.so"));
+    QVERIFY(events.contains("found c.so"));
+    QVERIFY(!events.contains("found crash.so"));
+    QCOMPARE(events.last(), QString("finished with error"));
+
+    // the crashed plugin is not cached, the other plugins are not loaded again
+    const int scanners = getScannerProcesses(root).size();
+    events = scanWithFinder(root, scanner, root.absoluteFilePath("plugins"), QStringList(crashedPlugin));
+    QCOMPARE(events.size(), 4);
+    QVERIFY(!events.contains("started"));
+    QVERIFY(events.contains("found a.so"));
+    QVERIFY(events.contains("found b.so"));
+    QVERIFY(events.contains("found c.so"));
+    QCOMPARE(events.last(), QString("finished"));
+    QCOMPARE(getScannerProcesses(root).size(), scanners);
+}
+
+void TestVst::finderCachesInvalidPlugins()
+{
+    QTemporaryDir dir;
+    QDir root(dir.path());
+    QVERIFY(root.mkdir("plugins"));
+
+    QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/valid.so")));
+    QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/invalid.so")));
+
+    const QString scanner = createFakeScanner(root);
+
+    QStringList events = scanWithFinder(root, scanner, root.absoluteFilePath("plugins"));
+    QCOMPARE(events, QStringList() << "started" << "found valid.so" << "finished");
+
+    const int scanners = getScannerProcesses(root).size();
+    QVERIFY(scanners > 0);
+
+    // the invalid plugin is not loaded again
+    events = scanWithFinder(root, scanner, root.absoluteFilePath("plugins"));
+    QCOMPARE(events, QStringList() << "found valid.so" << "finished");
+    QCOMPARE(getScannerProcesses(root).size(), scanners);
+}
+
+void TestVst::finderReportsCachedPluginsAfterScanStarted()
+{
+    QTemporaryDir dir;
+    QDir root(dir.path());
+    QVERIFY(root.mkdir("plugins"));
+
+    QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/cached.so")));
+
+    const QString scanner = createFakeScanner(root);
+    QCOMPARE(scanWithFinder(root, scanner, root.absoluteFilePath("plugins")), QStringList() << "started" << "found cached.so" << "finished");
+
+    // the plugins list is cleared when the scan starts, the cached plugins are reported after the scanStarted signal
+    QVERIFY(QFile::copy(pluginPath, root.absoluteFilePath("plugins/new.so")));
+    QCOMPARE(scanWithFinder(root, scanner, root.absoluteFilePath("plugins")), QStringList() << "started" << "found cached.so" << "found new.so" << "finished");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv); // the scanner processes and the plugin finder need an event loop
+
+    TestVst test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "test_Vst.moc"
@@ -0,0 +1,88 @@
+#include "aeffectx.h"
+
+#include <cstring>
+
+/**
+    Tiny VST2 effect used in the tests. The input samples are multiplied by GAIN.
+ */
+
+namespace {
+
+const float GAIN = 0.5f;
+
+VstIntPtr VSTCALLBACK dispatcher(AEffect *effect, VstInt32 opcode, VstInt32 index, VstIntPtr value, void *ptr, float opt)
+{
+    (void)index;
+    (void)value;
+    (void)opt;
+
+    switch (opcode) {
+    case effGetEffectName:
+    case effGetProductString:
+        std::strncpy(static_cast<char *>(ptr), "Test Gain", kVstMaxEffectNameLen);
+        return 1;
+
+    case effGetVendorString:
+        std::strncpy(static_cast<char *>(ptr), "Test Vendor", kVstMaxVendorStrLen);
+        return 1;
+
+    case effGetVstVersion:
+        return kVstVersion;
+
+    case effGetPlugCategory:
+        return kPlugCategEffect;
+
+    case effClose:
+        delete effect;
+        return 1;
+    }
+
+    return 0;
+}
+
+void VSTCALLBACK processReplacing(AEffect *effect, float **inputs, float **outputs, VstInt32 sampleFrames)
+{
+    for (int c = 0; c < effect->numOutputs; ++c) {
+        for (int s = 0; s < sampleFrames; ++s)
+            outputs[c][s] = inputs[c][s] * GAIN;
+    }
+}
+
+void VSTCALLBACK setParameter(AEffect *effect, VstInt32 index, float parameter)
+{
+    (void)effect;
+    (void)index;
+    (void)parameter;
+}
+
+float VSTCALLBACK getParameter(AEffect *effect, VstInt32 index)
+{
+    (void)effect;
+    (void)index;
+
+    return 0;
+}
+
+} // namespace
+
+extern "C" __attribute__((visibility("default"))) AEffect *VSTPluginMain(audioMasterCallback host)
+{
+    if (!host(nullptr, audioMasterVersion, 0, 0, nullptr, 0))
+        return nullptr;
+
+    AEffect *effect = new AEffect();
+    std::memset(effect, 0, sizeof(AEffect));
+
+    effect->magic = kEffectMagic;
+    effect->dispatcher = dispatcher;
+    effect->processReplacing = processReplacing;
+    effect->setParameter = setParameter;
+    effect->getParameter = getParameter;
+    effect->numInputs = 2;
+    effect->numOutputs = 2;
+    effect->flags = effFlagsCanReplacing;
+    effect->uniqueID = CCONST('J', 'T', 'g', 'n');
+    effect->version = 1;
+
+    return effect;
+}
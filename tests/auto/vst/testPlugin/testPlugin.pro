@@ -0,0 +1,18 @@
+# Tiny VST2 plugin used to test the Linux plugins scanning and processing.
+
+QT -= core gui
+CONFIG += plugin c++11
+CONFIG -= qt
+TEMPLATE = lib
+TARGET = TestGainVst
+
+VST_SDK_PATH = $$PWD/../../../../VST_SDK
+!exists($$VST_SDK_PATH/VST2_SDK/pluginterfaces/vst2.x/aeffect.h): error("The VST tests need the VST SDK in $$VST_SDK_PATH")
+
+INCLUDEPATH += $$VST_SDK_PATH/VST2_SDK/pluginterfaces/vst2.x
+
+DEFINES += __cdecl=""
+
+QMAKE_CXXFLAGS += -fvisibility=hidden # only the entry point is exported
+
+SOURCES += TestGainPlugin.cpp
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+
+# the test plugin is a Linux VST2 shared object, the Windows and Mac plugins are not tested
+linux {
+    SUBDIRS += testPlugin
+    SUBDIRS += test
+
+    test.depends = testPlugin
+}
@@ -1,4 +1,4 @@
-QT += core gui widgets network
+QT += core gui widgets network concurrent
 
 CONFIG += testcase
 TEMPLATE = app
@@ -10,19 +10,27 @@ INCLUDEPATH += ../../../src/Common/gui/chat
 VPATH += ../../../src/Common
 
 HEADERS += log/logging.h
+HEADERS += log/StartupProfiler.h
 HEADERS += gui/chat/ChatMessagePanel.h
 HEADERS += gui/chat/ChatPanel.h
 HEADERS += gui/chat/EmojiWidget.h
+HEADERS += gui/chat/EmojiMatcher.h
+HEADERS += gui/chat/ChatMessagesModel.h
+HEADERS += gui/chat/ChatMessagesView.h
 HEADERS += gui/chat/ChatTextEditor.h
 HEADERS += gui/UsersColorsPool.h
 HEADERS += geo/IpToLocationResolver.h
 
 SOURCES += log/logging.cpp
+SOURCES += log/StartupProfiler.cpp
 SOURCES += gui/chat/ChatMessagePanel.cpp
 SOURCES += gui/chat/ChatPanel.cpp
 SOURCES += gui/chat/ChatTextEditor.cpp
 SOURCES += gui/chat/EmojiWidget.cpp
 SOURCES += gui/chat/EmojiManager.cpp
+SOURCES += gui/chat/EmojiMatcher.cpp
+SOURCES += gui/chat/ChatMessagesModel.cpp
+SOURCES += gui/chat/ChatMessagesView.cpp
 SOURCES += gui/IconFactory.cpp
 SOURCES += gui/UsersColorsPool.cpp
 SOURCES += ninjam/client/User.cpp
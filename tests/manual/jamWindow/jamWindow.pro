@@ -199,6 +199,7 @@ RESOURCES += resources/jamtaba.qrc
 #SOURCES += Common/geo/WebIpToLocationResolver.cpp
 
 SOURCES += Common/persistence/Settings.cpp
+SOURCES += Common/persistence/SettingsWriter.cpp
 SOURCES += Common/persistence/UsersDataCache.cpp
 SOURCES += Common/persistence/CacheHeader.cpp
 
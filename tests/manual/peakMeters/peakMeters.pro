@@ -9,7 +9,9 @@ INCLUDEPATH += ../../../src/Common
 VPATH += ../../../src/Common
 
 HEADERS += gui/widgets/PeakMeter.h
+HEADERS += gui/GuiUtils.h
 
 SOURCES += gui/widgets/PeakMeter.cpp
+SOURCES += gui/GuiUtils.cpp
 
 SOURCES += test_PeakMeters.cpp
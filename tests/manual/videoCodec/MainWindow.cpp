@@ -14,7 +14,8 @@
 
 MainWindow::MainWindow() :
     demuxer(nullptr),
-    muxer(nullptr)
+    muxer(nullptr),
+    decodedFrameIndex(0)
 {
     QGridLayout *mainLayout = createWidgets();
 
@@ -38,21 +39,15 @@ MainWindow::MainWindow() :
 
         if (isFirstPacket && !encodedData.isEmpty()) {
             if (demuxer)
-                demuxer->deleteLater();
+                delete demuxer;
 
             demuxer = new FFMpegDemuxer(nullptr, encodedData);
+            demuxer->start(); // decoding in a worker thread
 
-            connect(demuxer, &FFMpegDemuxer::imagesDecoded, this, [=](const QList<QImage> &images, uint frameRate) {
-                qDebug() << "decoded images:" << images.size() << " rate:" << frameRate;
-                decodedImages << images;
+            decodedFrameIndex = 0;
+            timer->setInterval(100); // updated when the frame rate is known
+            timer->start();
 
-                if (frameRate > 0) {
-                    timer->setInterval(1000/frameRate);
-                    timer->start();
-                }
-            });
-
-            demuxer->decode();
             encodedData.clear();
         }
 
@@ -61,10 +56,13 @@ MainWindow::MainWindow() :
 
     connect(timer, &QTimer::timeout, [=](){
 
-        if (decodedImages.isEmpty())
+        if (!demuxer)
             return;
 
-        QImage image = decodedImages.takeFirst();
+        if (demuxer->getFrameRate() > 0)
+            timer->setInterval(1000/demuxer->getFrameRate());
+
+        QImage image = demuxer->takeFrame(decodedFrameIndex++);
         if (!image.isNull()) {
 
             //static uint index = 0;
@@ -74,7 +72,7 @@ MainWindow::MainWindow() :
             QPixmap pixMap = QPixmap::fromImage(image);
             outputLabel->setPixmap(pixMap);
         }
-        else
+        else if (demuxer->isFinished())
             timer->stop();
 
     });
@@ -38,7 +38,7 @@ private:
 
     QByteArray encodedData;
 
-    QList<QImage> decodedImages;
+    uint decodedFrameIndex;
 
 };
 
@@ -17,9 +17,11 @@ TEMPLATE = app
 SOURCES += main.cpp
 SOURCES += video/FFMpegDemuxer.cpp
 SOURCES += video/FFMpegMuxer.cpp
+SOURCES += video/VideoScaler.cpp
 SOURCES += MainWindow.cpp
 
 HEADERS += video/FFMpegMuxer.h
 HEADERS += video/FFMpegCommon.h
 HEADERS += video/FFMpegDemuxer.h
+HEADERS += video/VideoScaler.h
 HEADERS += MainWindow.h
@@ -45,13 +45,19 @@ void TestVideoCodec::encodeDecode()
             //    file.close();
 
             FFMpegDemuxer demuxer(nullptr, encodedData);
-            QObject::connect(&demuxer, &FFMpegDemuxer::imagesDecoded, [&](QList<QImage> images, uint fps){
-                qDebug() << "images decoded:" << images.size() << " fps:" << fps;
-                QCOMPARE((uint)frameRate, fps);
-                QCOMPARE((quint64)images.size(), framesToEncode);
-            });
-
-            demuxer.decode();
+            demuxer.start();
+
+            quint64 decodedFrames = 0;
+            while (!demuxer.isFinished()) {
+                if (!demuxer.takeFrame(decodedFrames).isNull())
+                    decodedFrames++;
+                else
+                    QThread::msleep(1);
+            }
+
+            qDebug() << "images decoded:" << decodedFrames << " fps:" << demuxer.getFrameRate();
+            QCOMPARE((uint)frameRate, demuxer.getFrameRate());
+            QCOMPARE(decodedFrames, framesToEncode);
         }
     });
 
@@ -69,14 +75,15 @@ void TestVideoCodec::encodeDecode()
     for (int i = 0; i < framesToEncode; ++i) {
         QImage img(resolution, QImage::Format_RGB32);
         img.fill(QColor(rand() % 255, rand() % 255, rand() % 255));
-        muxer->encodeImage(img, false); // encoding without threads
+        muxer->encodeImage(img);
+        QThread::msleep(1000 / frameRate); // the encoder drops frames when it is late
     }
 
     // finish the interval
-    muxer->startNewInterval();
-    muxer->encodeImage(QImage(), false); // encoding without threads
-}
+    muxer->finish();
 
+    QTRY_VERIFY_WITH_TIMEOUT(!encoding, 10000);
+}
 
 int main(int argc, char *argv[])
 {
@@ -6,6 +6,7 @@ TARGET = TestVideoCodec
 
 INCLUDEPATH += "../../../libs/includes/ffmpeg"
 INCLUDEPATH += ../../../src/Common/video
+INCLUDEPATH += ../../../src/Common
 
 VPATH += ../../../src/Common
 
@@ -18,6 +19,7 @@ SOURCES += tst_VideoCodec.cpp
 
 SOURCES += video/FFMpegDemuxer.cpp
 SOURCES += video/FFMpegMuxer.cpp
+SOURCES += log/logging.cpp
 
 HEADERS += video/FFMpegMuxer.h
 HEADERS += video/FFMpegDemuxer.h